@@ -0,0 +1,65 @@
+#ifndef P3CLOCK_TOOLS_GDI_COUNTING_H
+#define P3CLOCK_TOOLS_GDI_COUNTING_H
+
+// GDI objects counted instead of created: the resource cache and the font fit
+// of the Win32 programs, run on handles that are only numbers, so the tools can
+// tell how many CreateFont / CreateSolidBrush calls a sequence of sizes makes.
+
+#include <stdint.h>
+#include <vector>
+
+#include "../p3clock/font_fit.h"
+#include "../p3clock/resource_cache.h"
+#include "../p3clock/soft_clock.h"
+
+namespace p3clock {
+
+// Stands in for CreateSolidBrush / CreateFont / DeleteObject: hands out numbered handles
+// and keeps GDI's view of how many objects exist
+struct CountingFactory {
+    int nextHandle;
+    int live;
+    long long creates;
+    long long badDestroys; // Handles destroyed twice or never created
+    std::vector<bool> alive;
+
+    CountingFactory() : nextHandle(1), live(0), creates(0), badDestroys(0) {}
+
+    int Create(const ResourceKey&) {
+        alive.push_back(true);
+        creates++;
+        live++;
+        return nextHandle++;
+    }
+
+    void Destroy(int handle) {
+        if (handle < 1 || handle >= nextHandle || !alive[handle - 1]) {
+            badDestroys++;
+            return;
+        }
+        alive[handle - 1] = false;
+        live--;
+    }
+};
+
+typedef ResourceCache<int, CountingFactory> CountingCache;
+
+const int kFwNormal = 400;
+const int kFwBold = 700;
+const uint32_t kColorRefBlack = 0;
+
+// GdiTextMeasurer of p3timec-32-moni-1: every size it measures asks the cache for its font
+struct CachedFontMeasurer {
+    CountingCache* cache;
+
+    TextExtent Measure(int size) {
+        cache->Get(FontKey(size, kFwBold));
+        StrokeTextMeasurer stroke;
+        return stroke.Measure(size);
+    }
+};
+
+
+} // namespace p3clock
+
+#endif // P3CLOCK_TOOLS_GDI_COUNTING_H
@@ -0,0 +1,61 @@
+#ifndef P3CLOCK_TOOLS_HEAP_COUNTER_H
+#define P3CLOCK_TOOLS_HEAP_COUNTER_H
+
+// Heap accounting for the Linux tools: every operator new / delete of the
+// program goes through these counters. Each block carries its size in a
+// 16-byte header. Tile workers and the stream's writer thread allocate too, so
+// the counters are atomic; relaxed is enough, since they only count and order
+// nothing. The operators replace the global ones, so include this header from
+// the program's one source file only.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+namespace p3clock {
+
+static std::atomic<unsigned long long> g_heapAllocations(0);
+static std::atomic<unsigned long long> g_heapBytesAllocated(0);
+static std::atomic<size_t> g_heapLiveBytes(0);
+static std::atomic<size_t> g_heapPeakBytes(0);
+
+inline unsigned long long HeapAllocations() { return g_heapAllocations.load(std::memory_order_relaxed); }
+inline unsigned long long HeapBytesAllocated() { return g_heapBytesAllocated.load(std::memory_order_relaxed); }
+inline size_t HeapLiveBytes() { return g_heapLiveBytes.load(std::memory_order_relaxed); }
+inline size_t HeapPeakBytes() { return g_heapPeakBytes.load(std::memory_order_relaxed); }
+
+// Start measuring the peak from what is live now
+inline void ResetHeapPeak() { g_heapPeakBytes.store(HeapLiveBytes(), std::memory_order_relaxed); }
+
+} // namespace p3clock
+
+void* operator new(size_t size) {
+    void* block = malloc(size + 16);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *(size_t*)block = size;
+    p3clock::g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    p3clock::g_heapBytesAllocated.fetch_add(size, std::memory_order_relaxed);
+    size_t live = p3clock::g_heapLiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = p3clock::g_heapPeakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !p3clock::g_heapPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        // peak now holds the value another thread stored: retry while ours is still larger
+    }
+    return (char*)block + 16;
+}
+
+void operator delete(void* p) noexcept {
+    if (p) {
+        void* block = (void*)((uintptr_t)p - 16);
+        p3clock::g_heapLiveBytes.fetch_sub(*(size_t*)block, std::memory_order_relaxed);
+        free(block);
+    }
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+#endif // P3CLOCK_TOOLS_HEAP_COUNTER_H
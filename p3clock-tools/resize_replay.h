@@ -0,0 +1,261 @@
+#ifndef P3CLOCK_TOOLS_RESIZE_REPLAY_H
+#define P3CLOCK_TOOLS_RESIZE_REPLAY_H
+
+// A drag-resize replayed on the software renderer, the way the Win32 programs
+// handled WM_SIZE before ResizeCoalescer and the way they handle it now, with
+// the fonts each way creates and measures counted (gdi_counting.h).
+
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+
+#include "../p3clock/bench_stats.h"
+#include "../p3clock/font_fit.h"
+#include "../p3clock/resize_coalescer.h"
+#include "../p3clock/soft_clock.h"
+#include "gdi_counting.h"
+#include "tool_support.h"
+
+namespace p3clock {
+
+// One WM_SIZE of a drag-resize: when it arrived and the new client size
+struct ResizeEvent {
+    double atMs;
+    int width;
+    int height;
+};
+
+// A corner dragged by hand: mouse input at 125 Hz, the window pulled out from 800x400 towards
+// 1920x1080 and pushed back twice, fast in the middle of each stroke and slow at its ends,
+// with a pixel or two of hand jitter
+inline std::vector<ResizeEvent> RecordedDrag(int events) {
+    std::vector<ResizeEvent> trace;
+    unsigned int jitter = 1;
+    for (int i = 0; i < events; ++i) {
+        double phase = (double)i / events * 2.0;               // Two out-and-back strokes
+        double reach = 0.5 - 0.5 * cos(phase * 2.0 * kPi); // 0 -> 1 -> 0, eased
+        jitter = jitter * 1103515245u + 12345u;
+        int dx = (int)((jitter >> 16) % 5) - 2;
+        int dy = (int)((jitter >> 20) % 3) - 1;
+        ResizeEvent e = {i * 8.0, 800 + (int)(reach * 1120.0) + dx, 400 + (int)(reach * 680.0) + dy};
+        trace.push_back(e);
+    }
+    return trace;
+}
+
+// Lines of "MS WIDTH HEIGHT" (a WM_SIZE log), '#' starts a comment. Returns false on a bad line.
+inline bool ReadResizeTrace(const char* path, std::vector<ResizeEvent>* trace) {
+    FILE* in = fopen(path, "r");
+    if (!in) {
+        return false;
+    }
+    trace->clear();
+    char line[256];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), in)) {
+        char* p = line;
+        while (*p == ' ' || *p == '\t') ++p;
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') {
+            continue;
+        }
+        ResizeEvent e;
+        ok = sscanf(p, "%lf %d %d", &e.atMs, &e.width, &e.height) == 3 && e.width > 0 && e.height > 0 &&
+             (trace->empty() || e.atMs >= trace->back().atMs);
+        if (ok) trace->push_back(e);
+    }
+    fclose(in);
+    return ok && !trace->empty();
+}
+
+struct ResizeRunResult {
+    long long events;
+    long long frames;       // Paints
+    long long rebuilds;     // Layout, glyph atlas and face layer rebuilt for a new size
+    long long fontCreates;  // CreateFont calls, the ones made for measuring included
+    long long measurements; // Text extents measured for the font fit
+    double rebuildMs;       // Rebuilds and the full repaints after them, summed
+    double worstFrameMs;    // Most rebuild and repaint time that fell into one frame
+};
+
+// A window going through a WM_SIZE log. Before: every WM_SIZE rebuilds at once with a new
+// font of size min(h / 1.5, w / 4.5), and the next WM_PAINT repaints. After: WM_SIZE only
+// records the size (ResizeCoalescer) and WM_PAINT rebuilds once for the latest size, with the
+// fitted font from FontFitCache and the fonts kept in the resource cache (RebuildForSize).
+// WM_PAINT comes at the first frame boundary after a WM_SIZE. Times are those of the software
+// renderer; font creations and measurements are counted the way GDI would make them.
+class ResizeReplay {
+public:
+    ResizeReplay(ClockLayout layout, bool coalesce, double hz)
+        : renderer_(layout), coalesce_(coalesce), frameMs_(1000.0 / hz) {}
+
+    ResizeRunResult Run(const std::vector<ResizeEvent>& trace) {
+        ResizeRunResult r = {0, 0, 0, 0, 0, 0.0, 0.0};
+        long long createsBefore = fonts_.GetFactory().creates;
+        unsigned long long measuredBefore = fit_.Stats().measurements;
+        ClockTime t = {10, 8, 30};
+        double frameEndMs = 0.0;
+        double frameWorkMs = 0.0;
+        bool invalid = false;
+        for (size_t i = 0; i <= trace.size(); ++i) {
+            // WM_PAINT once the frame the last WM_SIZE fell into is over
+            if (invalid && (i == trace.size() || trace[i].atMs >= frameEndMs)) {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                int width, height;
+                if (coalesce_ && resize_.TakePending(&width, &height)) {
+                    Rebuild(width, height, &r);
+                }
+                renderer_.Render(t);
+                frameWorkMs += MsSince(start);
+                r.rebuildMs += MsSince(start);
+                if (frameWorkMs > r.worstFrameMs) r.worstFrameMs = frameWorkMs;
+                frameWorkMs = 0.0;
+                r.frames++;
+                invalid = false;
+            }
+            if (i == trace.size()) {
+                break;
+            }
+            const ResizeEvent& e = trace[i];
+            if (!invalid) {
+                frameEndMs = (floor(e.atMs / frameMs_) + 1.0) * frameMs_;
+            }
+            r.events++;
+            if (coalesce_) {
+                resize_.OnSize(e.width, e.height);
+            } else {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                fonts_.GetFactory().creates++; // DeleteObject + CreateFont at the heuristic size
+                renderer_.Resize(e.width, e.height);
+                r.rebuilds++;
+                frameWorkMs += MsSince(start);
+                r.rebuildMs += MsSince(start);
+            }
+            invalid = true;
+        }
+        r.fontCreates = fonts_.GetFactory().creates - createsBefore;
+        r.measurements = (long long)(fit_.Stats().measurements - measuredBefore);
+        return r;
+    }
+
+    const FontFitStats& FitStats() const { return fit_.Stats(); }
+
+private:
+    // RebuildForSize
+    void Rebuild(int width, int height, ResizeRunResult* r) {
+        renderer_.Resize(width, height);
+        r->rebuilds++;
+        const ClockGeometry& g = renderer_.Geometry();
+        if (g.hasDigital) {
+            CachedFontMeasurer measurer = {&fonts_};
+            fonts_.Get(FontKey(fit_.Get(measurer, g.digitalRect.right - g.digitalRect.left, height), kFwBold));
+        }
+    }
+
+    SoftClockRenderer renderer_;
+    bool coalesce_;
+    double frameMs_;
+    ResizeCoalescer resize_;
+    FontFitCache fit_;
+    CountingCache fonts_;
+};
+
+// How much of the digital area "88:88:88" takes at the fitted size and at min(h / 1.5, w / 4.5),
+// over every size of a trace. Fill is the larger of the width and height shares, 1.0 = touching.
+struct FontFillResult {
+    int sizes;
+    int clippedFitted; // Text wider or taller than the digital area
+    int clippedHeuristic;
+    double minFillFitted;
+    double meanFillFitted;
+    double minFillHeuristic;
+    double meanFillHeuristic;
+};
+
+inline double TextFill(int fontSize, int width, int height, bool* clipped) {
+    StrokeTextMeasurer stroke;
+    TextExtent e = stroke.Measure(fontSize);
+    *clipped = e.width > width || e.height > height;
+    double fx = (double)e.width / width, fy = (double)e.height / height;
+    return fx > fy ? fx : fy;
+}
+
+inline FontFillResult MeasureFontFill(ClockLayout layout, const std::vector<ResizeEvent>& trace) {
+    FontFillResult r = {0, 0, 0, 1e9, 0.0, 1e9, 0.0};
+    for (size_t i = 0; i < trace.size(); ++i) {
+        ClockGeometry g = ComputeClockGeometry(layout, trace[i].width, trace[i].height);
+        if (!g.hasDigital) {
+            continue;
+        }
+        int width = g.digitalRect.right - g.digitalRect.left, height = g.height;
+        int heuristic = (int)(height / 1.5) < (int)(width / 4.5) ? (int)(height / 1.5) : (int)(width / 4.5);
+        if (heuristic < 1) heuristic = 1;
+        bool clipped;
+        double fill = TextFill(g.fontSize, width, height, &clipped);
+        r.clippedFitted += clipped ? 1 : 0;
+        r.meanFillFitted += fill;
+        if (fill < r.minFillFitted) r.minFillFitted = fill;
+        fill = TextFill(heuristic, width, height, &clipped);
+        r.clippedHeuristic += clipped ? 1 : 0;
+        r.meanFillHeuristic += fill;
+        if (fill < r.minFillHeuristic) r.minFillHeuristic = fill;
+        r.sizes++;
+    }
+    if (r.sizes) {
+        r.meanFillFitted /= r.sizes;
+        r.meanFillHeuristic /= r.sizes;
+    } else {
+        r.minFillFitted = r.minFillHeuristic = 0.0;
+    }
+    return r;
+}
+
+struct ResizeCaseResult {
+    ClockLayout layout;
+    ResizeRunResult before;
+    ResizeRunResult after;
+    ResizeRunResult replay; // The same drag again: every size has been fitted before
+    ResizeRunResult toggle; // Maximize / restore, once both sizes are known
+    FontFillResult fill;
+};
+
+inline ResizeCaseResult RunResizeCase(ClockLayout layout, const std::vector<ResizeEvent>& trace, double hz) {
+    ResizeCaseResult result;
+    result.layout = layout;
+    ResizeReplay before(layout, false, hz);
+    result.before = before.Run(trace);
+
+    ResizeReplay after(layout, true, hz);
+    result.after = after.Run(trace);
+    result.replay = after.Run(trace);
+
+    // 100 maximize / restore toggles, a frame apart, after one of each
+    std::vector<ResizeEvent> toggles;
+    double atMs = trace.empty() ? 0.0 : trace.back().atMs + 1000.0;
+    for (int i = 0; i < 102; ++i) {
+        ResizeEvent e = {atMs + i * 100.0, i % 2 ? 800 : 1920, i % 2 ? 400 : 1080};
+        toggles.push_back(e);
+    }
+    after.Run(std::vector<ResizeEvent>(toggles.begin(), toggles.begin() + 2));
+    result.toggle = after.Run(std::vector<ResizeEvent>(toggles.begin() + 2, toggles.end()));
+
+    result.fill = MeasureFontFill(layout, trace);
+    return result;
+}
+
+inline void WriteResizeRun(JsonWriter* json, const char* name, const ResizeRunResult& r) {
+    json->Key(name);
+    json->BeginObject();
+    json->Field("events", r.events);
+    json->Field("frames", r.frames);
+    json->Field("rebuilds", r.rebuilds);
+    json->Field("font_creates", r.fontCreates);
+    json->Field("measurements", r.measurements);
+    json->Field("rebuild_ms", r.rebuildMs);
+    json->Field("worst_frame_ms", r.worstFrameMs);
+    json->EndObject();
+}
+
+} // namespace p3clock
+
+#endif // P3CLOCK_TOOLS_RESIZE_REPLAY_H
@@ -0,0 +1,176 @@
+#ifndef P3CLOCK_TOOLS_SIM_WINDOW_H
+#define P3CLOCK_TOOLS_SIM_WINDOW_H
+
+// ClockCore, the shared window code of the Win32 programs, on a simulated
+// window and a simulated clock: what p3timec-check's core and hud checks and
+// p3timec-headless bench-pixels drive instead of a real window.
+
+#include "../p3clock/clock_core.h"
+#include "../p3clock/pixel_backend.h"
+#include "../p3clock/time_source.h"
+
+namespace p3clock {
+
+struct CoreSimClock : FakeClock {
+    CoreSimClock(long long utcMs, int standardMinutes) : FakeClock(utcMs, standardMinutes), elapsedMs(0) {}
+
+    // Time passes for the counter, the wall clock and the window's timers
+    void Step(long long ms) {
+        Advance(ms);
+        elapsedMs += ms;
+    }
+
+    // Steady milliseconds, for the paint tracer and the frame pacer
+    double NowMs() { return (double)elapsedMs; }
+
+    long long elapsedMs;
+};
+
+const Argb kSimWindowBrush = 0xFFFFFFFFu; // COLOR_WINDOW, what the window erases with
+
+// The window in Framebuffers: the update region is kept as its bounding box (what BeginPaint
+// reports in rcPaint), timers as a due time, and the rest as counts. The drawing is DibBackend's:
+// the same PixelPainter, writing into the back buffer Framebuffer instead of a DIB section.
+class SimBackend {
+public:
+    typedef CoreSimClock Clock;
+    typedef Framebuffer* Screen;
+    typedef PixelTarget Surface;
+
+    SimBackend(CoreSimClock* clock, bool erase)
+        : timerArmed(false), timerDueMs(0), covered(false), updateRequested(false), paints(0), paintedFraction(0.0),
+          erasedPixels(0), resizes(0), backBufferAllocations(0), visibilityChanges(0), hudDraws(0), clock_(clock),
+          erase_(erase), jitter_(1) {
+        invalid_.left = invalid_.top = invalid_.right = invalid_.bottom = 0;
+        paint_ = invalid_;
+    }
+
+    // WM_SIZE: the client area has a new size, all of it invalid
+    void SetClientSize(int width, int height) {
+        screen.Resize(width, height);
+        Clear(&screen, kSimWindowBrush);
+        InvalidateAll();
+    }
+
+    bool HasInvalid() const { return !IsEmpty(invalid_); }
+
+    // Timer messages arrive 0-15 ms after they are due, like the system timer
+    void ArmTimer(int delayMs) {
+        jitter_ = jitter_ * 1103515245u + 12345u;
+        timerArmed = true;
+        timerDueMs = clock_->elapsedMs + delayMs + (jitter_ >> 16) % 16;
+    }
+
+    void KillTimer() { timerArmed = false; }
+
+    void Invalidate(const DamageRect& r) {
+        DamageRect client = {0, 0, screen.width, screen.height};
+        invalid_ = Union(invalid_, Intersect(r, client));
+    }
+
+    void InvalidateAll() {
+        DamageRect client = {0, 0, screen.width, screen.height};
+        invalid_ = client;
+    }
+
+    void UpdateNow() { updateRequested = true; } // The driver paints right after the sweep step
+    bool ClientAreaCovered() { return covered; }
+    long long UtcNowMs() { return clock_->Utc(); }
+    double CounterMs() { return clock_->NowMs(); }
+    void VisibilityChanged(const VisibilityTracker&) { visibilityChanges++; }
+    void SweepStats(const FramePacer&) {}
+
+    DigitalLayout Resize(const ClockGeometry& g, bool backBufferWanted) {
+        resizes++;
+        if (backBufferWanted && (backBuffer.width != g.width || backBuffer.height != g.height)) {
+            // ResizeSurface: a new bitmap only when the size changed
+            backBuffer.Resize(g.width, g.height);
+            backBufferAllocations++;
+        }
+        return painter.Resize(g);
+    }
+
+    bool FaceReady(const ClockGeometry& g, Argb color) const { return painter.FaceReady(g, color); }
+
+    template <class Tracer>
+    void BuildFace(const ClockGeometry& g, Argb color, Tracer* tracer) {
+        painter.BuildFace(g, color, tracer);
+    }
+
+    Screen BeginPaint(DamageRect* paint) {
+        paint_ = *paint = invalid_;
+        invalid_.left = invalid_.top = invalid_.right = invalid_.bottom = 0;
+        if (erase_) {
+            // WM_ERASEBKGND through DefWindowProc: the class brush, seen until the paint covers it
+            FillRect(&screen, paint->left, paint->top, paint->right, paint->bottom, kSimWindowBrush);
+            erasedPixels += Area(*paint);
+        }
+        paints++;
+        if (!screen.pixels.empty()) {
+            paintedFraction += (double)Area(*paint) / screen.pixels.size();
+        }
+        return &screen;
+    }
+
+    void EndPaint(Screen) {}
+
+    Surface ScreenSurface(Screen s) { return MakePixelTarget(ViewOf(s), paint_); }
+
+    bool BeginBackBuffer(const ClockGeometry& g, const DamageRect& paint, Surface* target) {
+        if (backBuffer.width != g.width || backBuffer.height != g.height) {
+            return false;
+        }
+        *target = MakePixelTarget(ViewOf(&backBuffer), paint);
+        return true;
+    }
+
+    void EndBackBuffer(Surface) {}
+
+    void Present(Screen s, Surface target, const DamageRect& paint) {
+        Blit(ViewOf(s), paint.left, paint.top, target.view, paint.left, paint.top,
+                      paint.right - paint.left, paint.bottom - paint.top);
+    }
+
+    void Fill(Surface target, const DamageRect& r) { painter.Fill(target, r); }
+    void CopyFace(Surface target, const DamageRect& r) { painter.CopyFace(target, r); }
+
+    void DrawHands(Surface target, const ClockGeometry& g, const DamageRect& clip,
+                   const LocalTime& t, bool sweep, Argb color) {
+        painter.DrawHands(target, g, clip, t, sweep, color);
+    }
+
+    void DrawDigits(Surface target, const ClockGeometry& g, const LocalTime& t, Argb color) {
+        painter.DrawDigits(target, g, t, color);
+    }
+
+    void DrawHud(Surface target, const DamageRect& r, const char* text) {
+        hudDraws++;
+        painter.DrawHud(target, r, text);
+    }
+
+    Framebuffer screen;
+    Framebuffer backBuffer;
+    PixelPainter painter;
+    bool timerArmed;
+    long long timerDueMs; // On CoreSimClock::elapsedMs
+    bool covered;
+    bool updateRequested;
+    long long paints;
+    double paintedFraction; // Sum over the paints of the part of the client area each covered
+    long long erasedPixels; // Pixels shown in the window brush before the paint covered them: flicker
+    long long resizes;
+    long long backBufferAllocations; // OffscreenSurface::allocations
+    long long visibilityChanges;
+    long long hudDraws;
+
+private:
+    CoreSimClock* clock_;
+    bool erase_;
+    DamageRect invalid_;
+    DamageRect paint_;
+    unsigned int jitter_;
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_TOOLS_SIM_WINDOW_H
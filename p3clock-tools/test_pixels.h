@@ -0,0 +1,65 @@
+#ifndef P3CLOCK_TOOLS_TEST_PIXELS_H
+#define P3CLOCK_TOOLS_TEST_PIXELS_H
+
+// Pixels for the compositing and conversion tools: a fixed pseudo-random
+// sequence, premultiplied colours drawn from it, and the overlay layer the
+// Win32 programs composite over the clock face.
+
+#include <stdint.h>
+#include <string.h>
+
+#include "../p3clock/composite.h"
+#include "../p3clock/pixel_backend.h"
+#include "tool_support.h"
+
+namespace p3clock {
+
+inline uint32_t NextRandom(uint32_t* seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 8;
+}
+
+// A valid premultiplied pixel, often fully transparent or opaque like the clock layer's
+inline Argb RandomPremultiplied(uint32_t* seed) {
+    uint32_t kind = NextRandom(seed) % 4;
+    if (kind == 0) {
+        return kArgbTransparent;
+    }
+    uint32_t a = kind == 1 ? 255 : NextRandom(seed) % 256;
+    uint32_t r = NextRandom(seed) % (a + 1);
+    uint32_t g = NextRandom(seed) % (a + 1);
+    uint32_t b = NextRandom(seed) % (a + 1);
+    return a << 24 | r << 16 | g << 8 | b;
+}
+
+// The clock alone on a transparent background, drawn by PixelPainter the way the overlay's
+// paints draw it: face layer, hands, digits
+inline void DrawOverlayLayer(PixelPainter* painter, ClockLayout layout, FrameSize size,
+                             const ClockTime& t, Framebuffer* layer) {
+    ClockGeometry g = ComputeClockGeometry(layout, size.width, size.height);
+    layer->Resize(size.width, size.height);
+    painter->Resize(g);
+    DamageRect all = {0, 0, size.width, size.height};
+    PixelTarget target = MakePixelTarget(ViewOf(layer), all);
+    LocalTime lt;
+    memset(&lt, 0, sizeof(lt));
+    lt.time = t;
+    Argb color = ClockColor(t);
+    if (g.analog.enabled) {
+        NullPaintTracer none;
+        if (!painter->FaceReady(g, color)) {
+            painter->BuildFace(g, color, &none);
+        }
+        painter->CopyFace(target, all);
+        painter->DrawHands(target, g, all, lt, false, color);
+    } else {
+        painter->Fill(target, all);
+    }
+    if (g.hasDigital) {
+        painter->DrawDigits(target, g, lt, color);
+    }
+}
+
+} // namespace p3clock
+
+#endif // P3CLOCK_TOOLS_TEST_PIXELS_H
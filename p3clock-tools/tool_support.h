@@ -0,0 +1,166 @@
+#ifndef P3CLOCK_TOOLS_TOOL_SUPPORT_H
+#define P3CLOCK_TOOLS_TOOL_SUPPORT_H
+
+// What the Linux tools (p3timec-headless, p3timec-check) share around their
+// commands: the "--name value" option loop, JSON results written to a file or
+// stdout, and the parsers and the timer every command uses. Every option
+// takes a value; -h or --help prints the usage and stops with status 0, a
+// missing, bad or unknown option stops with status 2:
+//
+//     p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+//     while (args.Next()) {
+//         const char* value = args.Value();
+//         bool ok = true;
+//         if (args.Is("--frames")) {
+//             frames = atoi(value);
+//             ok = frames > 0;
+//         } else if (args.Is("-o")) {
+//             output = value;
+//         } else {
+//             args.Unknown();
+//         }
+//         args.Check(ok);
+//     }
+//     if (args.Stopped()) {
+//         return args.Status();
+//     }
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include "../p3clock/bench_stats.h"
+#include "../p3clock/clock_geometry.h"
+
+namespace p3clock {
+
+class CommandArgs {
+public:
+    typedef void (*UsageProc)(FILE* out);
+
+    // argv holds the options only, the program and command names already taken off
+    CommandArgs(const char* program, int argc, char** argv, UsageProc usage)
+        : program_(program), argc_(argc), argv_(argv), usage_(usage), next_(0), status_(-1), arg_(""), value_("") {}
+
+    // Moves to the next option and its value. False at the end, and once parsing stopped.
+    bool Next() {
+        if (status_ >= 0 || next_ >= argc_) {
+            return false;
+        }
+        arg_ = argv_[next_];
+        if (strcmp(arg_, "-h") == 0 || strcmp(arg_, "--help") == 0) {
+            usage_(stdout);
+            status_ = 0;
+            return false;
+        }
+        if (next_ + 1 >= argc_) {
+            fprintf(stderr, "%s: %s needs a value\n", program_, arg_);
+            status_ = 2;
+            return false;
+        }
+        value_ = argv_[next_ + 1];
+        next_ += 2;
+        return true;
+    }
+
+    bool Is(const char* name) const { return strcmp(arg_, name) == 0; }
+    const char* Value() const { return value_; }
+
+    // The value did not parse or is out of range
+    void Check(bool ok) {
+        if (!ok && status_ < 0) {
+            fprintf(stderr, "%s: bad value for %s: %s\n", program_, arg_, value_);
+            status_ = 2;
+        }
+    }
+
+    void Unknown() {
+        fprintf(stderr, "%s: unknown option %s\n", program_, arg_);
+        usage_(stderr);
+        status_ = 2;
+    }
+
+    // After the loop: true when the command must return Status() instead of running
+    bool Stopped() const { return status_ >= 0; }
+    int Status() const { return status_; }
+
+private:
+    const char* program_;
+    int argc_;
+    char** argv_;
+    UsageProc usage_;
+    int next_;
+    int status_; // -1 while parsing goes on
+    const char* arg_;
+    const char* value_;
+};
+
+// JSON results in a file, or on stdout for "-"
+class JsonOutput {
+public:
+    explicit JsonOutput(const char* program) : program_(program), out_(NULL), toStdout_(false), json_(stdout) {}
+
+    ~JsonOutput() {
+        if (out_ && !toStdout_) {
+            fclose(out_); // Left open by an early return
+        }
+    }
+
+    bool Open(const char* path) {
+        toStdout_ = strcmp(path, "-") == 0;
+        out_ = toStdout_ ? stdout : fopen(path, "w");
+        if (!out_) {
+            fprintf(stderr, "%s: cannot open %s\n", program_, path);
+            return false;
+        }
+        json_ = JsonWriter(out_);
+        return true;
+    }
+
+    JsonWriter& Json() { return json_; }
+
+    // Ends the document and flushes or closes the file. False, reported, when writing failed.
+    bool Close() {
+        json_.Finish();
+        bool written = toStdout_ ? fflush(out_) == 0 : fclose(out_) == 0;
+        out_ = NULL;
+        if (!written) {
+            fprintf(stderr, "%s: write failed\n", program_);
+        }
+        return written;
+    }
+
+private:
+    const char* program_;
+    FILE* out_;
+    bool toStdout_;
+    JsonWriter json_;
+};
+
+struct FrameSize {
+    int width;
+    int height;
+};
+
+inline bool ParseSize(const char* text, int* width, int* height) {
+    return sscanf(text, "%dx%d", width, height) == 2 && *width > 0 && *height > 0;
+}
+
+inline bool ParseTime(const char* text, ClockTime* t) {
+    return sscanf(text, "%d:%d:%d", &t->hour, &t->minute, &t->second) == 3 &&
+           t->hour >= 0 && t->hour < 24 && t->minute >= 0 && t->minute < 60 && t->second >= 0 && t->second < 60;
+}
+
+inline ClockTime AddSeconds(ClockTime t, int seconds) {
+    int total = ((t.hour * 60 + t.minute) * 60 + t.second + seconds) % 86400;
+    ClockTime r = {total / 3600, total / 60 % 60, total % 60};
+    return r;
+}
+
+inline double MsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace p3clock
+
+#endif // P3CLOCK_TOOLS_TOOL_SUPPORT_H
@@ -0,0 +1,279 @@
+#ifndef P3CLOCK_WIN32_CLOCK_WINDOW_H
+#define P3CLOCK_WIN32_CLOCK_WINDOW_H
+
+// The window of every Win32 program: WinMain's work and the window
+// procedure, which hands each message to ClockCore. A program is one
+// instantiation, e.g. for p3timec-32-moni-1
+//
+//     typedef p3clock::ClockWindow<p3clock::AnalogDigitalLayoutPolicy,
+//                                  p3clock::BufferedPresentation> ClockWindow;
+//     return ClockWindow::Run(hInstance, lpCmdLine, nCmdShow, options);
+//
+// Command line: "/hud" shows the paint HUD from the start; analog layouts
+// also take "/sweep" or "/sweep:HZ" (see ParseSweepOption). "/overlay" or
+// "/overlay:PERCENT" (see ParseOverlayOption) runs the same clock as a
+// borderless, always-on-top translucent overlay: drag it anywhere, Esc fades
+// it out. Keys: H toggles the HUD, T writes the paint trace to
+// p3clock-trace.json.
+//
+// The backend is GdiBackend, or DibBackend when built with
+// /DP3CLOCK_DIB_BACKEND=1; a third template argument picks one for a single
+// program. The overlay always runs on OverlayBackend.
+
+#include "dib_backend.h"
+#include "gdi_backend.h"
+#include "overlay_backend.h"
+
+#ifndef P3CLOCK_DIB_BACKEND
+#define P3CLOCK_DIB_BACKEND 0
+#endif
+
+namespace p3clock {
+
+#if P3CLOCK_DIB_BACKEND
+typedef DibBackend DefaultBackend;
+#else
+typedef GdiBackend DefaultBackend;
+#endif
+
+struct ClockWindowOptions {
+    const TCHAR* title;
+    int width;               // Initial window size
+    int height;
+    bool icons;              // Standard application icon in the title bar and the task bar
+    const TCHAR* errorTitle; // Message boxes of the two start-up failures, in the program's language
+    const TCHAR* registerFailed;
+    const TCHAR* createFailed;
+};
+
+typedef UINT (WINAPI *TimePeriodProc)(UINT);
+
+template <class Layout, class Presentation, class Backend = DefaultBackend>
+class ClockWindow {
+public:
+    typedef ClockCore<Layout, Presentation, Backend> Core;
+
+    static int Run(HINSTANCE hInstance, LPSTR lpCmdLine, int nCmdShow, const ClockWindowOptions& options) {
+        int opacity = Backend::kLayered ? 0 : ParseOverlayOption(lpCmdLine);
+        if (opacity) {
+            return ClockWindow<Layout, Presentation, OverlayBackend>::RunWindow(hInstance, lpCmdLine, nCmdShow,
+                                                                                 options, opacity);
+        }
+        return RunWindow(hInstance, lpCmdLine, nCmdShow, options, 255);
+    }
+
+    static int RunWindow(HINSTANCE hInstance, LPSTR lpCmdLine, int nCmdShow, const ClockWindowOptions& options,
+                         int opacity) {
+        Core core(&backend_, &clock_, ParseSweepOption(lpCmdLine));
+        core_ = &core;
+        backend_.SetOpacity(opacity);
+
+        WNDCLASSEX wc;
+        memset(&wc, 0, sizeof(wc));
+        wc.cbSize = sizeof(WNDCLASSEX);
+        wc.lpfnWndProc = WindowProc;
+        wc.hInstance = hInstance;
+        if (options.icons) {
+            wc.hIcon = LoadIcon(NULL, IDI_APPLICATION);
+            wc.hIconSm = LoadIcon(NULL, IDI_APPLICATION);
+        }
+        wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+        // Only seen with direct presentation, where the window erases with it before every paint
+        wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
+        wc.lpszClassName = _T("P3ClockWindowClass");
+
+        if (!RegisterClassEx(&wc)) {
+            MessageBox(NULL, options.registerFailed, options.errorTitle, MB_ICONERROR | MB_OK);
+            return 0;
+        }
+
+        HWND hwnd;
+        if (Backend::kLayered) {
+            // No frame, so the whole window is the clock; top right of the work area, CW_USEDEFAULT does not place popups
+            RECT work;
+            SystemParametersInfo(SPI_GETWORKAREA, 0, &work, 0);
+            hwnd = CreateWindowEx(WS_EX_LAYERED | WS_EX_TOPMOST | WS_EX_TOOLWINDOW, wc.lpszClassName, options.title,
+                                  WS_POPUP, (int)work.right - options.width - kOverlayMargin,
+                                  (int)work.top + kOverlayMargin, options.width, options.height,
+                                  NULL, NULL, hInstance, NULL);
+        } else {
+            hwnd = CreateWindowEx(0, wc.lpszClassName, options.title, WS_OVERLAPPEDWINDOW,
+                                  CW_USEDEFAULT, CW_USEDEFAULT, options.width, options.height,
+                                  NULL, NULL, hInstance, NULL);
+        }
+        if (!hwnd) {
+            MessageBox(NULL, options.createFailed, options.errorTitle, MB_ICONERROR | MB_OK);
+            return 0;
+        }
+
+        core.ShowHud(ParseHudOption(lpCmdLine));
+        ShowWindow(hwnd, nCmdShow);
+        UpdateWindow(hwnd);
+
+        if (core.SweepHz()) {
+            return RunSweepLoop();
+        }
+        MSG msg;
+        while (GetMessage(&msg, NULL, 0, 0)) {
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+        return (int)msg.wParam;
+    }
+
+private:
+    static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+        switch (uMsg) {
+            case WM_CREATE:
+                backend_.Attach(hwnd);
+                WatchSessionLock(hwnd, TRUE);
+                core_->Create();
+                break;
+
+            case WM_SIZE:
+                core_->Size(LOWORD(lParam), HIWORD(lParam), wParam == SIZE_MINIMIZED);
+                break;
+
+            case WM_ERASEBKGND:
+                if (Core::EraseBackground()) {
+                    return DefWindowProc(hwnd, uMsg, wParam, lParam);
+                }
+                return TRUE; // The back buffer covers every pixel: erasing would only flicker
+
+            case WM_TIMER:
+                if (wParam == kFadeTimerId) {
+                    if (backend_.FadeStep()) {
+                        DestroyWindow(hwnd); // Faded out after WM_CLOSE
+                    }
+                    break;
+                }
+                core_->Timer();
+                break;
+
+            case WM_PAINT:
+            case kOverlayPaintMessage: // OverlayBackend's stand-in for WM_PAINT
+                core_->Paint();
+                break;
+
+            case WM_NCHITTEST:
+                if (Backend::kLayered) {
+                    return HTCAPTION; // The overlay has no title bar: drag it by any pixel
+                }
+                return DefWindowProc(hwnd, uMsg, wParam, lParam);
+
+            case WM_CLOSE:
+                if (backend_.FadeOut()) {
+                    break; // DestroyWindow once the fade is over
+                }
+                return DefWindowProc(hwnd, uMsg, wParam, lParam);
+
+            case WM_KEYDOWN:
+                // H toggles the HUD, T writes the paint trace, Esc closes the overlay
+                if (wParam == 'H') {
+                    core_->ShowHud(!core_->HudShown());
+                } else if (wParam == 'T') {
+                    WritePaintTrace();
+                } else if (wParam == VK_ESCAPE && Backend::kLayered) {
+                    PostMessage(hwnd, WM_CLOSE, 0, 0);
+                }
+                break;
+
+            case WM_TIMECHANGE:
+                core_->TimeChanged();
+                break;
+
+            case WM_WTSSESSION_CHANGE:
+                if (wParam == WTS_SESSION_LOCK || wParam == WTS_SESSION_UNLOCK) {
+                    core_->SessionLocked(wParam == WTS_SESSION_LOCK);
+                }
+                break;
+
+            case WM_DESTROY:
+                KillTimer(hwnd, kTickTimerId);
+                KillTimer(hwnd, kFadeTimerId);
+                WatchSessionLock(hwnd, FALSE);
+                Backend::ReportVisibilityStats(core_->Visibility());
+                backend_.ReportResizeStats(core_->Resizes());
+                Backend::ReportTimeStats(core_->Time());
+                backend_.Release();
+                PostQuitMessage(0);
+                break;
+
+            default:
+                return DefWindowProc(hwnd, uMsg, wParam, lParam);
+        }
+        return 0;
+    }
+
+    // T key: write the phases in the ring as Chrome trace_event JSON (p3clock-trace.json in the working directory)
+    static void WritePaintTrace() {
+        if (!Core::Tracer::kEnabled) {
+            OutputDebugString(_T("P3 Clock trace: built without P3CLOCK_PAINT_TRACE=1\n"));
+            return;
+        }
+        FILE* out = fopen("p3clock-trace.json", "w");
+        bool written = out && core_->Trace().WriteChromeTrace(out);
+        if (out && fclose(out) != 0) {
+            written = false;
+        }
+        OutputDebugString(written ? _T("P3 Clock trace: wrote p3clock-trace.json\n") : _T("P3 Clock trace: cannot write p3clock-trace.json\n"));
+    }
+
+    // Sweep mode message loop: handle all pending messages, paint a frame when the pacer says one
+    // is due, then sleep until the next frame or the next message, whichever comes first.
+    static int RunSweepLoop() {
+        // 1 ms timer resolution, so the waits end close to the frame slots. winmm is loaded at
+        // run time like SetCoalescableTimer, so the tick mode does not need it.
+        HMODULE winmm = LoadLibrary(_T("winmm.dll"));
+        TimePeriodProc pTimeBeginPeriod = winmm ? (TimePeriodProc)GetProcAddress(winmm, "timeBeginPeriod") : NULL;
+        TimePeriodProc pTimeEndPeriod = winmm ? (TimePeriodProc)GetProcAddress(winmm, "timeEndPeriod") : NULL;
+        if (pTimeBeginPeriod) pTimeBeginPeriod(1);
+
+        core_->StartSweep();
+        MSG msg;
+        msg.wParam = 0;
+        for (;;) {
+            bool quit = false;
+            while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+                if (msg.message == WM_QUIT) {
+                    quit = true;
+                    break;
+                }
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+            }
+            if (quit) {
+                break;
+            }
+            double delayMs = core_->SweepStep();
+            if (delayMs < 0.0) {
+                WaitMessage(); // Hidden: no frames until a restore, unlock or paint message arrives
+                continue;
+            }
+            // Round up: waking early would only spin through the pacer until the slot starts
+            MsgWaitForMultipleObjects(0, NULL, FALSE, (DWORD)(delayMs + 0.999), QS_ALLINPUT);
+        }
+
+        Backend::ReportSweepStats(core_->Pacer());
+        if (pTimeEndPeriod) pTimeEndPeriod(1);
+        if (winmm) FreeLibrary(winmm);
+        return (int)msg.wParam;
+    }
+
+    static Win32Clock clock_;
+    static Backend backend_;
+    static Core* core_; // Lives in Run(), as long as the window
+};
+
+template <class Layout, class Presentation, class Backend>
+Win32Clock ClockWindow<Layout, Presentation, Backend>::clock_;
+
+template <class Layout, class Presentation, class Backend>
+Backend ClockWindow<Layout, Presentation, Backend>::backend_;
+
+template <class Layout, class Presentation, class Backend>
+typename ClockWindow<Layout, Presentation, Backend>::Core* ClockWindow<Layout, Presentation, Backend>::core_ = NULL;
+
+} // namespace p3clock
+
+#endif // P3CLOCK_WIN32_CLOCK_WINDOW_H
@@ -0,0 +1,59 @@
+#ifndef P3CLOCK_WIN32_DEBUG_LINE_H
+#define P3CLOCK_WIN32_DEBUG_LINE_H
+
+// One line of OutputDebugString output (DebugView, the debugger's output
+// window), built from printf pieces into a fixed TCHAR buffer.
+//
+// _vsntprintf is _vsnwprintf in UNICODE builds and _vsnprintf in ANSI ones,
+// so the same formats build either way; strings from the portable code are
+// passed with %hs, which means char* in both. A piece that does not fit is
+// cut off: the line stays terminated, keeps its newline and nothing is
+// written past the buffer, where the -1 the CRT returns on truncation would
+// otherwise move the write position backwards.
+
+#include <windows.h>
+#include <tchar.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+namespace p3clock {
+
+class DebugLine {
+public:
+    DebugLine() : used_(0), full_(false) { text_[0] = 0; }
+
+    void Append(const TCHAR* format, ...) {
+        if (full_) {
+            return;
+        }
+        int left = kCapacity - used_;
+        va_list args;
+        va_start(args, format);
+        int written = _vsntprintf(text_ + used_, left, format, args);
+        va_end(args);
+        if (written < 0 || written >= left) {
+            // Truncated: end the line where the buffer ends
+            full_ = true;
+            used_ = kCapacity - 1;
+            text_[kCapacity - 2] = _T('\n');
+            text_[kCapacity - 1] = 0;
+            return;
+        }
+        used_ += written;
+    }
+
+    const TCHAR* Text() const { return text_; }
+
+    void Output() const { OutputDebugString(text_); }
+
+private:
+    static const int kCapacity = 256;
+
+    TCHAR text_[kCapacity];
+    int used_;  // Characters before the terminator
+    bool full_; // A piece was cut off; later pieces are dropped
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_WIN32_DEBUG_LINE_H
@@ -0,0 +1,146 @@
+#ifndef P3CLOCK_WIN32_DIB_BACKEND_H
+#define P3CLOCK_WIN32_DIB_BACKEND_H
+
+// Pixel backend of p3clock::ClockCore (p3clock/clock_core.h), chosen with
+// /DP3CLOCK_DIB_BACKEND=1 (see clock_window.h).
+//
+// The frame is one 32-bit top-down DIB section at the client size, and every
+// paint phase writes its pixels through p3clock::PixelPainter
+// (p3clock/pixel_backend.h): no FillRect, DrawText or BitBlt between
+// BeginPaint and the copy to the window, which is a single BitBlt of the paint
+// rectangle. The face layer and the glyph atlas are plain memory, so the only
+// GDI objects are the frame's bitmap and memory DC. p3timec-check core runs the
+// same PixelPainter on Linux against a Framebuffer.
+//
+// Direct presentation has no back buffer to keep, but pixels need somewhere
+// to go: the frame DIB stands in for the window DC and EndPaint copies the
+// paint rectangle out, after the window has erased it like with GdiBackend.
+
+#include "../p3clock/pixel_backend.h"
+#include "window_backend.h"
+
+namespace p3clock {
+
+class DibBackend : public WindowBackend {
+public:
+    typedef PixelTarget Surface;
+
+    DibBackend() : direct_(NULL) {
+        OffscreenSurface none = {NULL, NULL, NULL, NULL, 0, 0, 0, 0};
+        frame_ = none;
+    }
+
+    // The frame at the client size, whatever the presentation, and the glyph atlas
+    DigitalLayout Resize(const ClockGeometry& g, bool) {
+        HDC hdc = GetDC(hwnd_);
+        ResizeSurface(&frame_, hdc, g.width, g.height, TRUE);
+        ReleaseDC(hwnd_, hdc);
+        return painter_.Resize(g);
+    }
+
+    bool FaceReady(const ClockGeometry& g, Argb color) const { return painter_.FaceReady(g, color); }
+
+    template <class Tracer>
+    void BuildFace(const ClockGeometry& g, Argb color, Tracer* tracer) {
+        painter_.BuildFace(g, color, tracer);
+    }
+
+    void EndPaint(Screen screen) {
+        if (direct_) {
+            Surface target = Target(paint_.rcPaint);
+            Present(screen, target, target.clip);
+            direct_ = NULL;
+        }
+        WindowBackend::EndPaint(screen);
+    }
+
+    Surface ScreenSurface(Screen screen) {
+        direct_ = screen;
+        GdiFlush(); // The previous paint's BitBlt may still be reading the pixels
+        return Target(paint_.rcPaint);
+    }
+
+    // Outside `paint` the frame still holds the previous one, as with GdiBackend's back buffer
+    bool BeginBackBuffer(const ClockGeometry& g, const DamageRect& paint, Surface* target) {
+        if (!frame_.bits || frame_.width != g.width || frame_.height != g.height) {
+            return false;
+        }
+        GdiFlush();
+        *target = MakePixelTarget(FrameView(), paint);
+        return true;
+    }
+
+    void EndBackBuffer(Surface) {}
+
+    // The only GDI drawing call of a paint
+    void Present(Screen screen, Surface, const DamageRect& paint) {
+        if (frame_.hdc) {
+            BitBlt(screen, paint.left, paint.top, paint.right - paint.left, paint.bottom - paint.top,
+                   frame_.hdc, paint.left, paint.top, SRCCOPY);
+        }
+    }
+
+    void Fill(Surface target, const DamageRect& r) { painter_.Fill(target, r); }
+    void CopyFace(Surface target, const DamageRect& r) { painter_.CopyFace(target, r); }
+
+    void DrawHands(Surface target, const ClockGeometry& g, const DamageRect& clip, const LocalTime& t, bool sweep,
+                   Argb color) {
+        painter_.DrawHands(target, g, clip, t, sweep, color);
+    }
+
+    void DrawDigits(Surface target, const ClockGeometry& g, const LocalTime& t, Argb color) {
+        painter_.DrawDigits(target, g, t, color);
+    }
+
+    void DrawHud(Surface target, const DamageRect& r, const char* line) { painter_.DrawHud(target, r, line); }
+
+    // WM_DESTROY: free the frame and the painter's memory
+    void Release() {
+        ReportDibStats();
+        FreeSurface(&frame_);
+        painter_.Release();
+    }
+
+    // Frame allocations and the memory the painter holds, for DebugView or the debugger's output window
+    void ReportDibStats() const {
+        DebugLine line;
+        line.Append(_T("P3 Clock DIB: %lu frame allocations, %lu face builds, %lu atlas builds, %lu KB held, %lu GDI objects\n"),
+                    (unsigned long)frame_.allocations, (unsigned long)painter_.FaceBuilds(),
+                    (unsigned long)painter_.AtlasBuilds(), (unsigned long)(painter_.Bytes() / 1024),
+                    (unsigned long)GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS));
+        line.Output();
+    }
+
+    void ReportResizeStats(const ResizeCoalescer& resize) const {
+        const ResizeStats& stats = resize.Stats();
+        DebugLine line;
+        line.Append(_T("P3 Clock resize: %lu WM_SIZE, %lu rebuilds, %lu coalesced\n"), (unsigned long)stats.events,
+                    (unsigned long)stats.rebuilds, (unsigned long)stats.coalesced);
+        line.Output();
+    }
+
+private:
+    PixelView FrameView() const { return MakePixelView(frame_.bits, frame_.width, frame_.height, frame_.width); }
+
+    // The frame clipped to a paint rectangle; empty while there is no frame
+    Surface Target(const RECT& r) const {
+        DamageRect paint = {(int)r.left, (int)r.top, (int)r.right, (int)r.bottom};
+        if (!frame_.bits) {
+            PixelView none = {NULL, 0, 0, 0};
+            paint.left = paint.top = paint.right = paint.bottom = 0;
+            return MakePixelTarget(none, paint);
+        }
+        return MakePixelTarget(FrameView(), paint);
+    }
+
+    OffscreenSurface frame_; // The window's pixels; a 32 bpp DIB section's rows need no padding
+    PixelPainter painter_;
+    HDC direct_;             // Window DC of a direct-presentation paint, copied to in EndPaint
+
+    DibBackend(const DibBackend&);
+    DibBackend& operator=(const DibBackend&);
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_WIN32_DIB_BACKEND_H
@@ -0,0 +1,381 @@
+#ifndef P3CLOCK_WIN32_GDI_BACKEND_H
+#define P3CLOCK_WIN32_GDI_BACKEND_H
+
+// GDI backend of p3clock::ClockCore (p3clock/clock_core.h), the default of
+// all five Win32 programs. The window half is WindowBackend
+// (window_backend.h); this adds the drawing.
+//
+// Drawing is what the programs did before they shared a core:
+//   - brushes and fonts come from one ResourceCache, so ticks reuse the same
+//     handles and resizing back to a recent size finds its fonts still there;
+//   - the digital font is measured to fit "88:88:88" (font_fit.h) and the
+//     digits are copied from a pre-rendered glyph atlas, with DrawText as the
+//     fallback when GDI runs out of resources;
+//   - the analog face (background, border, Roman numerals) is a cached layer,
+//     and the hands are written anti-aliased into the back buffer's pixels.
+// Surfaces with pixels the program writes itself are 32-bit DIB sections;
+// the digital layouts keep compatible bitmaps, which BitBlt faster on
+// displays that are not 32 bits deep.
+//
+// Everything here needs <windows.h>, which is why it lives next to p3clock
+// and not in it.
+
+#include "../p3clock/resource_cache.h"
+#include "window_backend.h"
+
+namespace p3clock {
+
+// Creates and deletes the GDI objects behind GdiBackend's cache
+struct GdiFactory {
+    HGDIOBJ Create(const ResourceKey& key) {
+        switch (key.type) {
+            case kResourceBrush:
+                return CreateSolidBrush(key.color);
+            case kResourcePen:
+                return CreatePen(PS_SOLID, key.size, key.color);
+            default:
+                // Negative height means character height in pixels
+                return CreateFont(-key.size, 0, 0, 0, key.weight, FALSE, FALSE, FALSE,
+                                  DEFAULT_CHARSET, OUT_TT_PRECIS, CLIP_DEFAULT_PRECIS, PROOF_QUALITY,
+                                  VARIABLE_PITCH | FF_SWISS, _T("Arial"));
+        }
+    }
+
+    void Destroy(HGDIOBJ handle) {
+        DeleteObject(handle);
+    }
+};
+
+typedef ResourceCache<HGDIOBJ, GdiFactory> GdiCache;
+
+// Measures "88:88:88" (kFitText) in the digital font. The fonts come from the cache, so the
+// size that fits is already cached when the paint selects it.
+struct GdiTextMeasurer {
+    HDC hdc;
+    GdiCache* cache;
+
+    TextExtent Measure(int size) {
+        HGDIOBJ hOldFont = SelectObject(hdc, cache->Get(FontKey(size, FW_BOLD)));
+        SIZE extent = {0, 0};
+        GetTextExtentPoint32(hdc, _T("88:88:88"), kFitTextLength, &extent);
+        SelectObject(hdc, hOldFont);
+        TextExtent e = {(int)extent.cx, (int)extent.cy};
+        return e;
+    }
+};
+
+// Glyph source for the atlas: measures and draws single characters with the font selected into hdc
+struct GdiGlyphSource {
+    HDC hdc;
+
+    int Advance(char c) {
+        TCHAR ch = (TCHAR)c;
+        SIZE size;
+        GetTextExtentPoint32(hdc, &ch, 1, &size);
+        return size.cx;
+    }
+
+    int Height() {
+        TEXTMETRIC tm;
+        GetTextMetrics(hdc, &tm);
+        return tm.tmHeight;
+    }
+
+    void Render(char c, int row, int x, int y) {
+        TCHAR ch = (TCHAR)c;
+        SetTextColor(hdc, ToColorRef(row == 1 ? kArgbGreen : kArgbBlue));
+        TextOut(hdc, x, y, &ch, 1);
+    }
+};
+
+// Where a paint draws: the window DC, or the back buffer and its pixels
+struct GdiTarget {
+    HDC hdc;
+    const OffscreenSurface* surface; // NULL for the window DC
+};
+
+class GdiBackend : public WindowBackend {
+public:
+    typedef GdiTarget Surface;
+
+    GdiBackend() : fontSize_(0), faceColor_(0), atlasReady_(FALSE), savedDC_(0) {
+        OffscreenSurface none = {NULL, NULL, NULL, NULL, 0, 0, 0, 0};
+        backBuffer_ = faceLayer_ = glyphAtlas_ = none;
+    }
+
+    // Fit the digital font to its rectangle, resize the back buffer and rebuild the glyph atlas.
+    // Fonts come from the cache, so the previous size's font is kept for a while in case the
+    // window goes back to it, and is deleted when it falls out of the cache.
+    DigitalLayout Resize(const ClockGeometry& g, bool backBuffer) {
+        HDC hdc = GetDC(hwnd_);
+        DigitalLayout digital;
+        digital.enabled = false;
+        if (g.hasDigital) {
+            GdiTextMeasurer measurer = {hdc, &cache_};
+            const DamageRect& r = g.digitalRect;
+            fontSize_ = fontFit_.Get(measurer, r.right - r.left, r.bottom - r.top);
+        }
+        if (backBuffer) {
+            ResizeSurface(&backBuffer_, hdc, g.width, g.height, g.analog.enabled);
+        }
+        if (g.hasDigital) {
+            BuildGlyphAtlas(hdc, g.digitalRect);
+            digital = DigitalLayoutFromText(atlasLayout_, textLayout_);
+        }
+        ReleaseDC(hwnd_, hdc);
+        return digital;
+    }
+
+    bool FaceReady(const ClockGeometry& g, Argb color) const {
+        return faceColor_ == color && faceLayer_.width == g.width && faceLayer_.height == g.height;
+    }
+
+    // Render the static part of the frame for the given size and color into the face layer
+    template <class Tracer>
+    void BuildFace(const ClockGeometry& g, Argb color, Tracer* tracer) {
+        HDC hdcRef = GetDC(hwnd_);
+        BOOL resized = ResizeSurface(&faceLayer_, hdcRef, g.width, g.height, TRUE);
+        ReleaseDC(hwnd_, hdcRef);
+        if (!resized) {
+            faceColor_ = 0;
+            return;
+        }
+        faceColor_ = color;
+        HDC hdcFace = faceLayer_.hdc;
+        RECT clientRect = {0, 0, g.width, g.height};
+        const AnalogLayout& a = g.analog;
+
+        // Fill the entire background with black
+        {
+            ScopedPhase<Tracer> phase(tracer, kPhaseBackground);
+            FillRect(hdcFace, &clientRect, CachedBrush(kArgbBlack));
+        }
+
+        // Anti-aliased border over the black background, written straight into the DIB pixels
+        {
+            ScopedPhase<Tracer> phase(tracer, kPhaseFace);
+            GdiFlush();
+            DamageRect faceClip = {0, 0, g.width, g.height};
+            DrawAARing((uint32_t*)faceLayer_.bits, g.width, faceClip, (float)a.centerX, (float)a.centerY,
+                       (float)a.radius, (float)(a.radius - kFaceBorderWidth), color);
+        }
+
+        // Roman numerals for the hours, inside the face
+        static const TCHAR* const kRomanNumerals[13] = {
+            _T(""), _T("I"), _T("II"), _T("III"), _T("IV"), _T("V"), _T("VI"),
+            _T("VII"), _T("VIII"), _T("IX"), _T("X"), _T("XI"), _T("XII")
+        };
+        ScopedPhase<Tracer> phase(tracer, kPhaseNumerals);
+        int fontSize = g.numeralFontSize;
+        HGDIOBJ hOldFont = SelectObject(hdcFace, CachedFont(fontSize, FW_NORMAL));
+        SetTextColor(hdcFace, ToColorRef(color)); // Numerals color same as clock hands
+        SetBkMode(hdcFace, TRANSPARENT);
+        int numeralRadius = static_cast<int>(a.radius * kNumeralRadius);
+        for (int i = 1; i <= 12; ++i) {
+            // From the 12-entry dial table, clockwise from 12 o'clock
+            Point num = NumeralPoint(i, a.centerX, a.centerY, numeralRadius);
+            RECT numRect = {num.x - fontSize, num.y - fontSize / 2, num.x + fontSize, num.y + fontSize / 2};
+            DrawText(hdcFace, kRomanNumerals[i], -1, &numRect, DT_SINGLELINE | DT_CENTER | DT_VCENTER);
+        }
+        SelectObject(hdcFace, hOldFont); // The numeral font stays in the cache
+    }
+
+    Surface ScreenSurface(Screen screen) {
+        GdiTarget target = {screen, NULL};
+        return target;
+    }
+
+    // Everything outside `paint` still holds the previous (unchanged) frame, so only the
+    // damaged part is redrawn and copied. False while the back buffer does not match the client area.
+    bool BeginBackBuffer(const ClockGeometry& g, const DamageRect& paint, Surface* target) {
+        if (!backBuffer_.hdc || backBuffer_.width != g.width || backBuffer_.height != g.height) {
+            return false;
+        }
+        savedDC_ = SaveDC(backBuffer_.hdc);
+        IntersectClipRect(backBuffer_.hdc, paint.left, paint.top, paint.right, paint.bottom);
+        target->hdc = backBuffer_.hdc;
+        target->surface = &backBuffer_;
+        return true;
+    }
+
+    void EndBackBuffer(Surface target) {
+        RestoreDC(target.hdc, savedDC_); // Drop the clip rectangle
+    }
+
+    // Copy the damaged part of the back buffer to the window DC in one go
+    void Present(Screen screen, Surface target, const DamageRect& paint) {
+        BitBlt(screen, paint.left, paint.top, paint.right - paint.left, paint.bottom - paint.top,
+               target.hdc, paint.left, paint.top, SRCCOPY);
+    }
+
+    void Fill(Surface target, const DamageRect& r) {
+        RECT rect = ToRect(r);
+        FillRect(target.hdc, &rect, CachedBrush(kArgbBlack));
+    }
+
+    // Copy the cached background + face layer instead of redrawing it
+    void CopyFace(Surface target, const DamageRect& r) {
+        BitBlt(target.hdc, r.left, r.top, r.right - r.left, r.bottom - r.top, faceLayer_.hdc, r.left, r.top, SRCCOPY);
+    }
+
+    // Draw the three hands anti-aliased straight into the target's pixels, touching only pixels
+    // inside clip (outside it the previous frame is kept, and blending a hand twice would change its edges).
+    // Hand widths scale with the radius so a 4K clock does not get a 1-pixel second hand.
+    void DrawHands(Surface target, const ClockGeometry& g, const DamageRect& clip, const LocalTime& t, bool sweep,
+                   Argb color) {
+        const OffscreenSurface* surface = target.surface;
+        if (!surface || !surface->bits) {
+            return; // Needs pixels: ClockCore only draws hands into the back buffer
+        }
+        DamageRect bounds = {0, 0, surface->width, surface->height};
+        GdiFlush(); // Let GDI finish drawing into the bitmap before writing its pixels
+        const AnalogLayout& a = g.analog;
+        for (int hand = 0; hand < kHandCount; ++hand) { // Second, minute, hour (hour hand on top)
+            Hand h = static_cast<Hand>(hand);
+            PointF tip;
+            if (sweep) {
+                tip = SweepHandPoint(h, t.time, t.millisecond, a.centerX, a.centerY, a.radius, 1.0);
+            } else {
+                Point p = HandTip(h, t.time, a.centerX, a.centerY, a.radius);
+                tip.x = (float)p.x;
+                tip.y = (float)p.y;
+            }
+            DrawAALine((uint32_t*)surface->bits, surface->width, Intersect(clip, bounds),
+                       a.centerX + 0.5f, a.centerY + 0.5f, tip.x + 0.5f, tip.y + 0.5f,
+                       (float)HandWidth(h, a.radius), color);
+        }
+    }
+
+    void DrawDigits(Surface target, const ClockGeometry& g, const LocalTime& t, Argb color) {
+        if (atlasReady_) {
+            // Eight copies from the pre-rendered atlas; the cells already carry the black background
+            GlyphBlit blits[8];
+            TimeTextBlits(atlasLayout_, textLayout_, t.time, blits);
+            for (int i = 0; i < 8; ++i) {
+                BitBlt(target.hdc, blits[i].dstX, blits[i].dstY, blits[i].width, blits[i].height,
+                       glyphAtlas_.hdc, blits[i].srcX, blits[i].srcY, SRCCOPY);
+            }
+            return;
+        }
+        // No atlas (out of GDI resources): lay out and draw the text. The time source keeps
+        // "HH:MM:SS" up to date field by field; this only widens it to TCHAR.
+        TCHAR text[9];
+        for (int i = 0; i < 8; ++i) {
+            text[i] = (TCHAR)t.text[i];
+        }
+        text[8] = 0;
+        RECT digitalRect = ToRect(g.digitalRect);
+        SetTextColor(target.hdc, ToColorRef(color));
+        SetBkMode(target.hdc, TRANSPARENT);
+        HGDIOBJ hOldFont = SelectObject(target.hdc, DigitalFont());
+        DrawText(target.hdc, text, -1, &digitalRect, DT_SINGLELINE | DT_CENTER | DT_VCENTER);
+        SelectObject(target.hdc, hOldFont);
+    }
+
+    // Last frame time and p99 in the top left corner
+    void DrawHud(Surface target, const DamageRect& r, const char* line) {
+        TCHAR text[64];
+        int length = 0;
+        for (; line[length] && length < 63; ++length) {
+            text[length] = (TCHAR)line[length];
+        }
+        RECT rect = ToRect(r);
+        FillRect(target.hdc, &rect, (HBRUSH)GetStockObject(BLACK_BRUSH));
+        HGDIOBJ hOldFont = SelectObject(target.hdc, GetStockObject(DEFAULT_GUI_FONT));
+        SetTextColor(target.hdc, RGB(160, 160, 160)); // Grey, so it is not mistaken for the clock's blue / green
+        SetBkMode(target.hdc, TRANSPARENT);
+        DrawText(target.hdc, text, length, &rect, DT_SINGLELINE | DT_LEFT | DT_VCENTER);
+        SelectObject(target.hdc, hOldFont);
+    }
+
+    // WM_DESTROY: release the cached brushes and fonts, the back buffer, the face layer and the glyph atlas
+    void Release() {
+        ReportGdiStats();
+        fontSize_ = 0;
+        cache_.Clear();
+        FreeSurface(&backBuffer_);
+        FreeSurface(&faceLayer_);
+        FreeSurface(&glyphAtlas_);
+        atlasReady_ = FALSE;
+        faceColor_ = 0;
+    }
+
+    const FontFitCache& FontFit() const { return fontFit_; }
+
+    // Cache use and the process's GDI object count, for DebugView or the debugger's output window.
+    // Once the window has its size, ticks are all hits and the object count stays flat.
+    void ReportGdiStats() const {
+        const ResourceCacheStats& stats = cache_.Stats();
+        DebugLine line;
+        line.Append(_T("P3 Clock GDI cache: %lu hits, %lu misses, %lu created, %d live, %lu GDI objects\n"),
+                    (unsigned long)stats.hits, (unsigned long)stats.misses, (unsigned long)stats.creates, stats.live,
+                    (unsigned long)GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS));
+        line.Output();
+    }
+
+    // Resize events against actual rebuilds, and how often the font fit had to measure
+    void ReportResizeStats(const ResizeCoalescer& resize) const {
+        const ResizeStats& stats = resize.Stats();
+        const FontFitStats& fit = fontFit_.Stats();
+        DebugLine line;
+        line.Append(_T("P3 Clock resize: %lu WM_SIZE, %lu rebuilds, %lu coalesced; font fit %lu hits, %lu misses, %lu measured\n"),
+                    (unsigned long)stats.events, (unsigned long)stats.rebuilds, (unsigned long)stats.coalesced,
+                    (unsigned long)fit.hits, (unsigned long)fit.misses, (unsigned long)fit.measurements);
+        line.Output();
+    }
+
+private:
+    HBRUSH CachedBrush(Argb color) { return (HBRUSH)cache_.Get(BrushKey(ToColorRef(color))); }
+    HFONT CachedFont(int size, int weight) { return (HFONT)cache_.Get(FontKey(size, weight)); }
+
+    // The fitted digital font, looked up in the cache at every use: sixteen other keys since the
+    // last use may have evicted and deleted it, and the lookup creates it again. The system
+    // default font if there is no fitted size or the font cannot be created.
+    HGDIOBJ DigitalFont() {
+        HFONT hFont = fontSize_ ? CachedFont(fontSize_, FW_BOLD) : NULL;
+        return hFont ? (HGDIOBJ)hFont : GetStockObject(DEFAULT_GUI_FONT);
+    }
+
+    // Render the glyph atlas for the current font and lay out "HH:MM:SS" centered in textRect.
+    // When GDI runs out of resources the atlas stays unavailable and DrawDigits falls back to DrawText.
+    void BuildGlyphAtlas(HDC hdcRef, const DamageRect& textRect) {
+        // Measure on the window DC first: the atlas size depends on the glyph sizes
+        GdiGlyphSource source = {hdcRef};
+        HGDIOBJ hOldFont = SelectObject(hdcRef, DigitalFont());
+        atlasLayout_ = MakeGlyphAtlasLayout(source);
+        SelectObject(hdcRef, hOldFont);
+        textLayout_ = LayoutTimeText(atlasLayout_, textRect.left, textRect.top, textRect.right, textRect.bottom);
+
+        atlasReady_ = ResizeSurface(&glyphAtlas_, hdcRef, atlasLayout_.width, atlasLayout_.height, FALSE);
+        if (!atlasReady_) {
+            return;
+        }
+        RECT atlasRect = {0, 0, atlasLayout_.width, atlasLayout_.height};
+        FillRect(glyphAtlas_.hdc, &atlasRect, CachedBrush(kArgbBlack));
+
+        source.hdc = glyphAtlas_.hdc;
+        hOldFont = SelectObject(glyphAtlas_.hdc, DigitalFont());
+        SetBkMode(glyphAtlas_.hdc, TRANSPARENT);
+        RenderGlyphAtlas(source, atlasLayout_);
+        SelectObject(glyphAtlas_.hdc, hOldFont);
+    }
+
+    GdiCache cache_;   // Brushes and fonts by color / size / weight
+    FontFitCache fontFit_; // Digital font size per window size bucket: a drag only measures sizes it has not seen
+    int fontSize_;     // Digital font size fitted to the window, 0 before the first Resize(); the font is in cache_
+    OffscreenSurface backBuffer_; // Sized to the client area in Resize(), buffered presentation only
+    OffscreenSurface faceLayer_;  // Background, face border and Roman numerals; changes with the size or the color
+    Argb faceColor_;              // 0 = face layer not built
+    OffscreenSurface glyphAtlas_; // Digits and ':' in both colors, rebuilt with the font
+    GlyphAtlasLayout atlasLayout_;
+    TimeTextLayout textLayout_;   // Where each character of "HH:MM:SS" goes
+    BOOL atlasReady_;
+    int savedDC_;
+
+    GdiBackend(const GdiBackend&);
+    GdiBackend& operator=(const GdiBackend&);
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_WIN32_GDI_BACKEND_H
@@ -0,0 +1,240 @@
+#ifndef P3CLOCK_WIN32_OVERLAY_BACKEND_H
+#define P3CLOCK_WIN32_OVERLAY_BACKEND_H
+
+// Overlay backend of p3clock::ClockCore (p3clock/clock_core.h): the clock as
+// a borderless, always-on-top layered window with per-pixel alpha, for "/overlay"
+// (see clock_window.h).
+//
+// PixelPainter draws on a transparent background, so the clock layer is
+// premultiplied ARGB (p3clock/composite.h). A paint draws the damaged part of
+// the layer, then composes it over a translucent backdrop at the window's
+// opacity into a 32-bit DIB section and hands that to UpdateLayeredWindow.
+// The fade in after WM_CREATE and the fade out on WM_CLOSE only compose again
+// at each new opacity; the layer is not redrawn.
+//
+// A layered window updated with UpdateLayeredWindow gets no WM_PAINT, so the
+// update region is kept here: Invalidate posts kOverlayPaintMessage, which
+// the window procedure answers with ClockCore::Paint.
+
+#include "../p3clock/composite.h"
+#include "../p3clock/pixel_backend.h"
+#include "window_backend.h"
+
+namespace p3clock {
+
+const UINT kOverlayPaintMessage = WM_APP + 1;
+const Argb kOverlayBackdrop = 0x66000000u; // Black at 40%, premultiplied: the clock stays readable on any dashboard
+const int kOverlayFadeMs = 250;
+const int kOverlayFadeStepMs = 15;
+const int kOverlayMargin = 16; // Pixels between the overlay and the work area's top right corner
+
+#ifndef WS_EX_LAYERED
+#define WS_EX_LAYERED 0x00080000
+#endif
+#ifndef ULW_ALPHA
+#define ULW_ALPHA 0x00000002
+#endif
+#ifndef AC_SRC_ALPHA
+#define AC_SRC_ALPHA 0x01
+#endif
+
+class OverlayBackend : public WindowBackend {
+public:
+    typedef PixelTarget Surface;
+
+    static const bool kLayered = true;
+
+    OverlayBackend() : painter_(kArgbTransparent), opacity_(255), level_(0), closing_(false), direct_(false) {
+        OffscreenSurface none = {NULL, NULL, NULL, NULL, 0, 0, 0, 0};
+        frame_ = none;
+        invalid_.left = invalid_.top = invalid_.right = invalid_.bottom = 0;
+        painting_ = invalid_;
+        fade_ = MakeFadeRamp(0.0, 0.0, 0, 0);
+    }
+
+    // Opacity of the whole overlay once faded in, 0-255 (ParseOverlayOption)
+    void SetOpacity(int opacity) { opacity_ = opacity; }
+
+    // WM_CREATE: start invisible and fade in
+    void Attach(HWND hwnd) {
+        WindowBackend::Attach(hwnd);
+        StartFade(opacity_);
+    }
+
+    // One posted message per batch of invalidations, like the WM_PAINT it stands in for
+    void Invalidate(const DamageRect& r) {
+        bool idle = IsEmpty(invalid_);
+        invalid_ = Union(invalid_, r);
+        if (idle && !IsEmpty(invalid_)) {
+            PostMessage(hwnd_, kOverlayPaintMessage, 0, 0);
+        }
+    }
+
+    void InvalidateAll() {
+        RECT client;
+        GetClientRect(hwnd_, &client);
+        DamageRect all = {(int)client.left, (int)client.top, (int)client.right, (int)client.bottom};
+        Invalidate(all);
+    }
+
+    void UpdateNow() {
+        if (!IsEmpty(invalid_)) {
+            SendMessage(hwnd_, kOverlayPaintMessage, 0, 0);
+        }
+    }
+
+    // The layer at the client size, the DIB section UpdateLayeredWindow takes, and the glyph atlas
+    DigitalLayout Resize(const ClockGeometry& g, bool) {
+        layer_.Resize(g.width, g.height);
+        Clear(&layer_, kArgbTransparent); // A fade may compose it before the first paint
+        HDC hdc = GetDC(hwnd_);
+        ResizeSurface(&frame_, hdc, g.width, g.height, TRUE);
+        ReleaseDC(hwnd_, hdc);
+        return painter_.Resize(g);
+    }
+
+    bool FaceReady(const ClockGeometry& g, Argb color) const { return painter_.FaceReady(g, color); }
+
+    template <class Tracer>
+    void BuildFace(const ClockGeometry& g, Argb color, Tracer* tracer) {
+        painter_.BuildFace(g, color, tracer);
+    }
+
+    // kOverlayPaintMessage: the kept update region; a stray WM_PAINT is only validated
+    Screen BeginPaint(DamageRect* paint) {
+        ValidateRect(hwnd_, NULL);
+        painting_ = Intersect(invalid_, ClientRect());
+        invalid_.left = invalid_.top = invalid_.right = invalid_.bottom = 0;
+        *paint = painting_;
+        return NULL;
+    }
+
+    void EndPaint(Screen screen) {
+        if (direct_) {
+            Present(screen, Target(painting_), painting_);
+            direct_ = false;
+        }
+    }
+
+    // Direct presentation: the layer keeps every frame anyway, and EndPaint presents it
+    Surface ScreenSurface(Screen) {
+        direct_ = true;
+        return Target(painting_);
+    }
+
+    bool BeginBackBuffer(const ClockGeometry& g, const DamageRect& paint, Surface* target) {
+        if (layer_.width != g.width || layer_.height != g.height) {
+            return false;
+        }
+        *target = Target(paint);
+        return true;
+    }
+
+    void EndBackBuffer(Surface) {}
+
+    void Present(Screen, Surface, const DamageRect& paint) {
+        Compose(paint);
+        UpdateLayer();
+    }
+
+    void Fill(Surface target, const DamageRect& r) { painter_.Fill(target, r); }
+    void CopyFace(Surface target, const DamageRect& r) { painter_.CopyFace(target, r); }
+
+    void DrawHands(Surface target, const ClockGeometry& g, const DamageRect& clip, const LocalTime& t, bool sweep,
+                   Argb color) {
+        painter_.DrawHands(target, g, clip, t, sweep, color);
+    }
+
+    void DrawDigits(Surface target, const ClockGeometry& g, const LocalTime& t, Argb color) {
+        painter_.DrawDigits(target, g, t, color);
+    }
+
+    void DrawHud(Surface target, const DamageRect& r, const char* line) { painter_.DrawHud(target, r, line); }
+
+    // WM_CLOSE: fade out, then FadeStep says when to destroy the window
+    bool FadeOut() {
+        if (!closing_) {
+            closing_ = true;
+            StartFade(0);
+        }
+        return true;
+    }
+
+    // kFadeTimerId: compose the whole overlay at the next opacity of the ramp
+    bool FadeStep() {
+        double nowMs = clock_.NowMs();
+        level_ = fade_.LevelAt(nowMs);
+        Compose(ClientRect());
+        UpdateLayer();
+        if (!fade_.DoneAt(nowMs)) {
+            return false;
+        }
+        ::KillTimer(hwnd_, kFadeTimerId);
+        return closing_;
+    }
+
+    void Release() {
+        FreeSurface(&frame_);
+        layer_ = Framebuffer();
+        painter_.Release();
+    }
+
+    void ReportResizeStats(const ResizeCoalescer& resize) const {
+        const ResizeStats& stats = resize.Stats();
+        DebugLine line;
+        line.Append(_T("P3 Clock resize: %lu WM_SIZE, %lu rebuilds, %lu coalesced\n"), (unsigned long)stats.events,
+                    (unsigned long)stats.rebuilds, (unsigned long)stats.coalesced);
+        line.Output();
+    }
+
+private:
+    void StartFade(int to) {
+        fade_ = MakeFadeRamp(clock_.NowMs(), kOverlayFadeMs, level_, to);
+        SetTimer(hwnd_, kFadeTimerId, kOverlayFadeStepMs, NULL);
+    }
+
+    DamageRect ClientRect() const {
+        DamageRect all = {0, 0, layer_.width, layer_.height};
+        return all;
+    }
+
+    Surface Target(const DamageRect& paint) { return MakePixelTarget(ViewOf(&layer_), paint); }
+
+    // The layer over the backdrop at the current opacity, into the DIB section
+    void Compose(const DamageRect& r) {
+        if (!frame_.bits || frame_.width != layer_.width || frame_.height != layer_.height) {
+            return;
+        }
+        GdiFlush(); // UpdateLayeredWindow may still be reading the pixels
+        PixelView frame = MakePixelView(frame_.bits, frame_.width, frame_.height, frame_.width);
+        ComposeOverlay(frame, ViewOf(layer_), r, kOverlayBackdrop, level_);
+    }
+
+    void UpdateLayer() {
+        if (!frame_.hdc) {
+            return;
+        }
+        POINT source = {0, 0};
+        SIZE size = {frame_.width, frame_.height};
+        BLENDFUNCTION blend = {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA}; // Opacity is already in the pixels
+        UpdateLayeredWindow(hwnd_, NULL, NULL, &size, frame_.hdc, &source, 0, &blend, ULW_ALPHA);
+    }
+
+    PixelPainter painter_;   // On kArgbTransparent: premultiplied output
+    Framebuffer layer_;      // The clock alone, kept between paints like a back buffer
+    OffscreenSurface frame_; // What the window shows: layer_ over the backdrop at level_
+    int opacity_;
+    int level_;              // Current opacity, moving along fade_
+    FadeRamp fade_;
+    bool closing_;
+    bool direct_;
+    DamageRect invalid_;     // The update region's bounding box, as BeginPaint would report it
+    DamageRect painting_;    // What the paint in progress draws
+
+    OverlayBackend(const OverlayBackend&);
+    OverlayBackend& operator=(const OverlayBackend&);
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_WIN32_OVERLAY_BACKEND_H
@@ -0,0 +1,301 @@
+#ifndef P3CLOCK_WIN32_WINDOW_BACKEND_H
+#define P3CLOCK_WIN32_WINDOW_BACKEND_H
+
+// The window half of a ClockCore backend (p3clock/clock_core.h): timers,
+// invalidation, BeginPaint / EndPaint, the clocks and the debug output
+// reports. GdiBackend (gdi_backend.h), DibBackend (dib_backend.h) and
+// OverlayBackend (overlay_backend.h) derive from WindowBackend and differ in
+// how they draw and present.
+
+#include <windows.h>
+#include <tchar.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../p3clock/clock_core.h"
+#include "debug_line.h"
+
+namespace p3clock {
+
+const UINT_PTR kTickTimerId = 1;
+const UINT_PTR kFadeTimerId = 2;
+
+// COLORREF is 0x00BBGGRR, Argb and DIB pixels are 0xAARRGGBB
+inline COLORREF ToColorRef(Argb color) {
+    return RGB(ArgbRed(color), ArgbGreen(color), ArgbBlue(color));
+}
+
+inline RECT ToRect(const DamageRect& r) {
+    RECT rect = {r.left, r.top, r.right, r.bottom};
+    return rect;
+}
+
+#ifndef TIMERV_NO_COALESCING
+#define TIMERV_NO_COALESCING 0xFFFFFFFF
+#endif
+typedef UINT_PTR (WINAPI *SetCoalescableTimerProc)(HWND, UINT_PTR, UINT, TIMERPROC, ULONG);
+
+// Arm the tick timer to fire after delayMs. Windows 8+ has SetCoalescableTimer, which lets us
+// opt out of timer coalescing so the wakeup lands right after the second boundary; XP falls back to SetTimer.
+inline void ArmTickTimer(HWND hwnd, int delayMs) {
+    static SetCoalescableTimerProc pSetCoalescableTimer =
+        (SetCoalescableTimerProc)GetProcAddress(GetModuleHandle(_T("user32.dll")), "SetCoalescableTimer");
+    if (pSetCoalescableTimer) {
+        pSetCoalescableTimer(hwnd, kTickTimerId, delayMs, NULL, TIMERV_NO_COALESCING);
+    } else {
+        SetTimer(hwnd, kTickTimerId, delayMs, NULL);
+    }
+}
+
+#ifndef WM_WTSSESSION_CHANGE
+#define WM_WTSSESSION_CHANGE 0x02B1
+#endif
+#ifndef WTS_SESSION_LOCK
+#define WTS_SESSION_LOCK 0x7
+#define WTS_SESSION_UNLOCK 0x8
+#endif
+#ifndef NOTIFY_FOR_THIS_SESSION
+#define NOTIFY_FOR_THIS_SESSION 0
+#endif
+typedef BOOL (WINAPI *WTSRegisterSessionNotificationProc)(HWND, DWORD);
+typedef BOOL (WINAPI *WTSUnRegisterSessionNotificationProc)(HWND);
+
+// Ask for WM_WTSSESSION_CHANGE so the clock idles while the session is locked. wtsapi32 is loaded
+// at run time like SetCoalescableTimer; without it a lock just goes unnoticed.
+inline void WatchSessionLock(HWND hwnd, BOOL watch) {
+    static HMODULE wtsapi = LoadLibrary(_T("wtsapi32.dll"));
+    if (!wtsapi) {
+        return;
+    }
+    if (watch) {
+        WTSRegisterSessionNotificationProc pRegister =
+            (WTSRegisterSessionNotificationProc)GetProcAddress(wtsapi, "WTSRegisterSessionNotification");
+        if (pRegister) pRegister(hwnd, NOTIFY_FOR_THIS_SESSION);
+    } else {
+        WTSUnRegisterSessionNotificationProc pUnregister =
+            (WTSUnRegisterSessionNotificationProc)GetProcAddress(wtsapi, "WTSUnRegisterSessionNotification");
+        if (pUnregister) pUnregister(hwnd);
+    }
+}
+
+// Milliseconds on the UTC clock (no daylight saving jumps), for the time spent in each visibility state
+inline long long UtcNowMs() {
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    ULARGE_INTEGER ticks;
+    ticks.LowPart = ft.dwLowDateTime;
+    ticks.HighPart = ft.dwHighDateTime;
+    return (long long)(ticks.QuadPart / 10000);
+}
+
+// TRUE when other windows cover the whole client area. Without desktop composition (XP, the classic
+// theme) the window DC's clip region is empty then; with composition it never is, so the clock keeps ticking.
+inline BOOL IsClientAreaCovered(HWND hwnd) {
+    HDC hdc = GetDC(hwnd);
+    RECT clip;
+    int region = GetClipBox(hdc, &clip);
+    ReleaseDC(hwnd, hdc);
+    return region == NULLREGION;
+}
+
+// Clock of TimeSource and of the paint trace: the performance counter is the monotonic counter.
+// The system time is only read by the periodic comparison, and the time zone only when the UTC
+// offset can have changed (a new quarter hour, a time jump, WM_TIMECHANGE).
+struct Win32Clock {
+    LARGE_INTEGER frequency;
+
+    Win32Clock() {
+        QueryPerformanceFrequency(&frequency);
+    }
+
+    long long MonotonicMs() {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        long long ticks = counter.QuadPart, perSecond = frequency.QuadPart;
+        return ticks / perSecond * 1000 + ticks % perSecond * 1000 / perSecond; // Cannot overflow
+    }
+
+    // Milliseconds with their fraction, for the paint trace and the frame pacer
+    double NowMs() {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart * 1000.0 / frequency.QuadPart;
+    }
+
+    long long UtcMs() {
+        return UtcNowMs();
+    }
+
+    int UtcOffsetMinutes() {
+        TIME_ZONE_INFORMATION tz;
+        DWORD zone = GetTimeZoneInformation(&tz);
+        LONG bias = tz.Bias; // UTC = local time + bias, in minutes
+        if (zone == TIME_ZONE_ID_DAYLIGHT) {
+            bias += tz.DaylightBias;
+        } else if (zone == TIME_ZONE_ID_STANDARD) {
+            bias += tz.StandardBias;
+        }
+        return (int)-bias;
+    }
+};
+
+// Off-screen drawing surface (memory DC + bitmap) that lives as long as the window.
+// It is only (re)allocated when the window size changes, never per paint.
+struct OffscreenSurface {
+    HDC hdc;
+    HBITMAP hbm;
+    HBITMAP hbmOld;
+    void* bits; // Pixels of a DIB section (0xAARRGGBB, top-down), writable directly; NULL for a compatible bitmap
+    int width;
+    int height;
+    unsigned int allocations; // Number of bitmaps created for this surface so far
+    unsigned int releases;    // Number of bitmaps freed for this surface so far
+};
+
+inline void FreeSurface(OffscreenSurface* surface) {
+    if (surface->hdc) {
+        SelectObject(surface->hdc, surface->hbmOld); // Select original bitmap back
+        DeleteObject(surface->hbm);
+        DeleteDC(surface->hdc);
+        surface->releases++;
+    }
+    surface->hdc = NULL;
+    surface->hbm = NULL;
+    surface->hbmOld = NULL;
+    surface->bits = NULL;
+    surface->width = 0;
+    surface->height = 0;
+}
+
+// Make sure the surface exists with the given size, as a 32-bit DIB section when `pixels` is set.
+// Returns FALSE if GDI ran out of resources.
+inline BOOL ResizeSurface(OffscreenSurface* surface, HDC hdcRef, int width, int height, BOOL pixels) {
+    if (surface->hdc && surface->width == width && surface->height == height && (surface->bits != NULL) == !!pixels) {
+        return TRUE; // Same size: keep the existing bitmap
+    }
+    FreeSurface(surface);
+    surface->hdc = CreateCompatibleDC(hdcRef);
+    if (!surface->hdc) {
+        return FALSE;
+    }
+    if (pixels) {
+        // 32-bit DIB section: GDI draws into it as usual and the hands are written to its pixels
+        BITMAPINFO bmi;
+        memset(&bmi, 0, sizeof(bmi));
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = width;
+        bmi.bmiHeader.biHeight = -height; // Negative height means top-down rows
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+        surface->hbm = CreateDIBSection(hdcRef, &bmi, DIB_RGB_COLORS, &surface->bits, NULL, 0);
+    } else {
+        surface->hbm = CreateCompatibleBitmap(hdcRef, width, height);
+    }
+    if (!surface->hbm) {
+        surface->bits = NULL;
+        DeleteDC(surface->hdc);
+        surface->hdc = NULL;
+        return FALSE;
+    }
+    surface->hbmOld = (HBITMAP)SelectObject(surface->hdc, surface->hbm);
+    surface->width = width;
+    surface->height = height;
+    surface->allocations++;
+    return TRUE;
+}
+
+// Everything a backend does with the window itself. Derived classes add Resize, the face layer,
+// the back buffer and the drawing calls.
+class WindowBackend {
+public:
+    typedef Win32Clock Clock;
+    typedef HDC Screen;
+
+    // An ordinary window; OverlayBackend hides these with its layered-window versions
+    static const bool kLayered = false;
+    void SetOpacity(int) {}
+    bool FadeOut() { return false; }  // WM_CLOSE: true when the backend destroys the window itself later
+    bool FadeStep() { return false; } // kFadeTimerId: true when the window can be destroyed now
+
+    WindowBackend() : hwnd_(NULL) { paint_.hdc = NULL; }
+
+    // WM_CREATE: the window everything below works on
+    void Attach(HWND hwnd) { hwnd_ = hwnd; }
+
+    void ArmTimer(int delayMs) { ArmTickTimer(hwnd_, delayMs); }
+    void KillTimer() { ::KillTimer(hwnd_, kTickTimerId); }
+
+    void Invalidate(const DamageRect& r) {
+        RECT rect = ToRect(r);
+        InvalidateRect(hwnd_, &rect, TRUE);
+    }
+
+    void InvalidateAll() { InvalidateRect(hwnd_, NULL, TRUE); }
+    void UpdateNow() { UpdateWindow(hwnd_); }
+    bool ClientAreaCovered() { return IsClientAreaCovered(hwnd_) != FALSE; }
+    long long UtcNowMs() { return p3clock::UtcNowMs(); }
+    double CounterMs() { return clock_.NowMs(); }
+
+    void VisibilityChanged(const VisibilityTracker& visibility) { ReportVisibilityStats(visibility); }
+    void SweepStats(const FramePacer& pacer) { ReportSweepStats(pacer); }
+
+    Screen BeginPaint(DamageRect* paint) {
+        HDC hdc = ::BeginPaint(hwnd_, &paint_);
+        const RECT& r = paint_.rcPaint;
+        DamageRect rect = {(int)r.left, (int)r.top, (int)r.right, (int)r.bottom};
+        *paint = rect;
+        return hdc;
+    }
+
+    void EndPaint(Screen) { ::EndPaint(hwnd_, &paint_); }
+
+    // Wakeups per minute in each visibility state
+    static void ReportVisibilityStats(const VisibilityTracker& visibility) {
+        long long nowMs = p3clock::UtcNowMs();
+        DebugLine line;
+        line.Append(_T("P3 Clock idle:"));
+        for (int i = 0; i < kVisibilityStateCount; ++i) {
+            VisibilityState state = static_cast<VisibilityState>(i);
+            line.Append(_T(" %hs %.1f/min (%lu s)"), kVisibilityStateNames[i], visibility.WakeupsPerMinute(state, nowMs),
+                        (unsigned long)(visibility.TimeInStateMs(state, nowMs) / 1000));
+        }
+        line.Append(_T("\n"));
+        line.Output();
+    }
+
+    // Time reads, and how many of them actually read the system time or queried the time zone
+    template <class TimeClock>
+    static void ReportTimeStats(const TimeSource<TimeClock>& time) {
+        const TimeSourceStats& stats = time.Stats();
+        DebugLine line;
+        line.Append(_T("P3 Clock time: %lu reads, %lu clock reads, %lu time zone queries, %lu jumps, %lu offset changes, %lu characters formatted\n"),
+                    (unsigned long)stats.reads, (unsigned long)stats.wallReads, (unsigned long)stats.offsetQueries,
+                    (unsigned long)stats.jumps, (unsigned long)stats.offsetChanges, (unsigned long)stats.charsWritten);
+        line.Output();
+    }
+
+    // Frames shown, dropped and late so far
+    static void ReportSweepStats(const FramePacer& pacer) {
+        const FramePacerStats& stats = pacer.Stats();
+        DebugLine line;
+        line.Append(_T("P3 Clock sweep: %lu frames, %lu dropped, %lu late, %.2f ms/frame, %.1f Hz\n"),
+                    (unsigned long)stats.frames, (unsigned long)stats.dropped, (unsigned long)stats.late,
+                    pacer.AverageWorkMs(), pacer.EffectiveHz());
+        line.Output();
+    }
+
+
+protected:
+    HWND hwnd_;
+    Win32Clock clock_; // Only for CounterMs()
+    PAINTSTRUCT paint_;
+
+private:
+    WindowBackend(const WindowBackend&);
+    WindowBackend& operator=(const WindowBackend&);
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_WIN32_WINDOW_BACKEND_H
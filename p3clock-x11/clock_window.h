@@ -0,0 +1,228 @@
+#ifndef P3CLOCK_X11_CLOCK_WINDOW_H
+#define P3CLOCK_X11_CLOCK_WINDOW_H
+
+// The window of p3timec-x11: what p3clock-win32/clock_window.h does for the
+// Win32 programs, on Xlib. The event loop hands each event to ClockCore:
+//     ConfigureNotify      WM_SIZE (only recorded; the next paint rebuilds for the latest size)
+//     MapNotify/UnmapNotify restore / minimize
+//     Expose               invalidate, like the update region WM_PAINT paints
+//     VisibilityNotify     covered / uncovered
+//     KeyPress             H toggles the HUD, T writes the paint trace, q or Esc quits
+//     WM_DELETE_WINDOW     quit
+// then calls ClockCore::Timer() when the tick is due, paints when anything
+// is invalid, and sleeps in poll() on the connection until the next tick,
+// sweep frame or event.
+
+#include <poll.h>
+#include <signal.h>
+#include <X11/Xatom.h>
+#include <X11/keysym.h>
+
+#include "x11_backend.h"
+
+namespace p3clock {
+
+struct X11WindowOptions {
+    const char* title;
+    int width;  // Initial window size
+    int height;
+    int sweepHz; // 0 for tick mode (ParseSweepOption's range)
+    bool hud;
+    bool shm;    // False for --no-shm: always XPutImage
+    int seconds; // Quit after this long, 0 to run until closed (a run under Xvfb)
+};
+
+static volatile sig_atomic_t g_x11Quit = 0;
+
+inline void OnX11QuitSignal(int) { g_x11Quit = 1; }
+
+// A window of the default screen with a visual PixelPainter can write into, or 0
+inline Window CreateArgbWindow(Display* display, const char* title, int width, int height, XVisualInfo* visual) {
+    int screen = DefaultScreen(display);
+    if (!XMatchVisualInfo(display, screen, 24, TrueColor, visual) || !IsArgbVisual(display, *visual)) {
+        return 0;
+    }
+    XSetWindowAttributes attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.colormap = XCreateColormap(display, RootWindow(display, screen), visual->visual, AllocNone);
+    attributes.background_pixmap = None; // The frame covers every pixel: no erase, no flicker
+    attributes.bit_gravity = NorthWestGravity;
+    attributes.event_mask = StructureNotifyMask | ExposureMask | VisibilityChangeMask | KeyPressMask;
+    Window window = XCreateWindow(display, RootWindow(display, screen), 0, 0, width, height, 0, visual->depth,
+                                  InputOutput, visual->visual,
+                                  CWColormap | CWBackPixmap | CWBitGravity | CWEventMask, &attributes);
+    XStoreName(display, window, title);
+    return window;
+}
+
+template <class Layout, class Presentation>
+class X11ClockWindow {
+public:
+    typedef ClockCore<Layout, Presentation, X11Backend> Core;
+
+    // Returns the exit status: 0, or 1 when there is no display or no usable visual
+    static int Run(const X11WindowOptions& options) {
+        Display* display = XOpenDisplay(NULL);
+        if (!display) {
+            fprintf(stderr, "p3timec-x11: cannot open display %s\n", XDisplayName(NULL));
+            return 1;
+        }
+        XVisualInfo visual;
+        Window window = CreateArgbWindow(display, options.title, options.width, options.height, &visual);
+        if (!window) {
+            fprintf(stderr, "p3timec-x11: no 24-bit TrueColor visual with 32-bit pixels\n");
+            XCloseDisplay(display);
+            return 1;
+        }
+        Atom deleteWindow = XInternAtom(display, "WM_DELETE_WINDOW", False);
+        XSetWMProtocols(display, window, &deleteWindow, 1);
+
+        PosixClock clock;
+        X11Backend backend;
+        Core core(&backend, &clock, options.sweepHz);
+        core_ = &core;
+        backend.Attach(display, window, visual.visual, visual.depth, options.shm);
+        backend.SetPaintProc(PaintNow);
+        core.Create();
+        core.ShowHud(options.hud);
+        XMapWindow(display, window);
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = OnX11QuitSignal;
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+
+        if (core.SweepHz()) {
+            core.StartSweep();
+        }
+        int width = options.width, height = options.height;
+        bool mapped = false;
+        double endMs = options.seconds > 0 ? clock.NowMs() + options.seconds * 1000.0 : 0.0;
+        while (!g_x11Quit) {
+            while (XPending(display) && !g_x11Quit) {
+                XEvent event;
+                XNextEvent(display, &event);
+                if (event.type == backend.CompletionType()) {
+                    backend.Completed(event);
+                    continue;
+                }
+                switch (event.type) {
+                    case ConfigureNotify:
+                        if (event.xconfigure.width != width || event.xconfigure.height != height) {
+                            width = event.xconfigure.width;
+                            height = event.xconfigure.height;
+                            backend.SetClientSize(width, height);
+                            core.Size(width, height, !mapped);
+                        }
+                        break;
+                    case MapNotify:
+                        mapped = true;
+                        backend.SetClientSize(width, height);
+                        core.Size(width, height, false);
+                        break;
+                    case UnmapNotify:
+                        mapped = false; // Iconified, or on another desktop
+                        core.Size(width, height, true);
+                        break;
+                    case Expose: {
+                        const XExposeEvent& e = event.xexpose;
+                        DamageRect r = {e.x, e.y, e.x + e.width, e.y + e.height};
+                        backend.Invalidate(r);
+                        break;
+                    }
+                    case VisibilityNotify:
+                        backend.SetCovered(event.xvisibility.state == VisibilityFullyObscured);
+                        break;
+                    case KeyPress: {
+                        KeySym key = XLookupKeysym(&event.xkey, 0);
+                        if (key == XK_h) {
+                            core.ShowHud(!core.HudShown());
+                        } else if (key == XK_t) {
+                            WritePaintTrace(core);
+                        } else if (key == XK_q || key == XK_Escape) {
+                            g_x11Quit = 1;
+                        }
+                        break;
+                    }
+                    case ClientMessage:
+                        if ((Atom)event.xclient.data.l[0] == deleteWindow) {
+                            g_x11Quit = 1;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+            if (g_x11Quit) {
+                break;
+            }
+
+            int waitMs = -1;
+            if (core.SweepHz()) {
+                double delayMs = core.SweepStep(); // Paints the frame itself, through UpdateNow()
+                // Round up: waking early would only spin through the pacer until the slot starts
+                waitMs = delayMs < 0.0 ? -1 : (int)(delayMs + 0.999); // Hidden: wait for an event
+            } else if (backend.TimerDue()) {
+                core.Timer();
+            }
+            if (backend.HasInvalid()) {
+                core.Paint(); // Exposed areas, ticks, rebuilds
+            }
+            if (!core.SweepHz()) {
+                waitMs = backend.TimerDelayMs();
+            }
+            XFlush(display);
+            if (XPending(display)) {
+                continue; // The paint's requests brought events (a ShmCompletion at least)
+            }
+            if (endMs > 0.0) {
+                double leftMs = endMs - clock.NowMs();
+                if (leftMs <= 0.0) {
+                    break;
+                }
+                waitMs = waitMs < 0 || waitMs > leftMs ? (int)(leftMs + 0.999) : waitMs;
+            }
+            struct pollfd connection = {ConnectionNumber(display), POLLIN, 0};
+            poll(&connection, 1, waitMs);
+        }
+
+        if (core.SweepHz()) {
+            X11Backend::ReportSweepStats(core.Pacer());
+        }
+        X11Backend::ReportResizeStats(core.Resizes());
+        X11Backend::ReportTimeStats(core.Time());
+        backend.Release();
+        XDestroyWindow(display, window);
+        XCloseDisplay(display);
+        return 0;
+    }
+
+private:
+    // UpdateNow(): paint right away, like UpdateWindow sending WM_PAINT
+    static void PaintNow() { core_->Paint(); }
+
+    // T key: write the phases in the ring as Chrome trace_event JSON (p3clock-trace.json in the working directory)
+    static void WritePaintTrace(const Core& core) {
+        if (!Core::Tracer::kEnabled) {
+            fprintf(stderr, "p3timec-x11 trace: built without P3CLOCK_PAINT_TRACE=1\n");
+            return;
+        }
+        FILE* out = fopen("p3clock-trace.json", "w");
+        bool written = out && core.Trace().WriteChromeTrace(out);
+        if (out && fclose(out) != 0) {
+            written = false;
+        }
+        fprintf(stderr, written ? "p3timec-x11 trace: wrote p3clock-trace.json\n"
+                                : "p3timec-x11 trace: cannot write p3clock-trace.json\n");
+    }
+
+    static Core* core_; // Lives in Run(), as long as the window
+};
+
+template <class Layout, class Presentation>
+typename X11ClockWindow<Layout, Presentation>::Core* X11ClockWindow<Layout, Presentation>::core_ = NULL;
+
+} // namespace p3clock
+
+#endif // P3CLOCK_X11_CLOCK_WINDOW_H
@@ -0,0 +1,508 @@
+#ifndef P3CLOCK_X11_X11_BACKEND_H
+#define P3CLOCK_X11_X11_BACKEND_H
+
+// X11 backend of p3clock::ClockCore (p3clock/clock_core.h), for p3timec-x11.
+//
+// DibBackend's design on Xlib: the frame is one 32 bpp XImage at the window
+// size, every paint phase writes its pixels through p3clock::PixelPainter,
+// and a paint ends in one copy of the paint rectangle to the window. With
+// MIT-SHM the XImage lives in a shared memory segment the X server reads
+// directly, so that copy is XShmPutImage and no pixel goes through the
+// socket. Without it (a remote display, a server without the extension, a
+// segment the system will not give) the same image is sent with XPutImage.
+//
+// The server reads a shared image after XShmPutImage returns; the next paint
+// waits for the ShmCompletion event before writing to it again, as
+// DibBackend calls GdiFlush before touching the DIB section.
+//
+// There is no WM_PAINT or WM_TIMER here: the backend keeps the update
+// region's bounding box and the tick's due time, and the event loop
+// (clock_window.h) paints when that region is not empty and calls
+// ClockCore::Timer() when the time is due. UpdateNow() paints through the
+// handler the window sets, as UpdateWindow sends WM_PAINT.
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../p3clock/clock_core.h"
+#include "../p3clock/pixel_backend.h"
+
+namespace p3clock {
+
+// Clock of TimeSource and of the paint trace: CLOCK_MONOTONIC is the counter, CLOCK_REALTIME the
+// wall clock, and the C library's zone rules the UTC offset
+struct PosixClock {
+    long long MonotonicMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+    }
+
+    // Milliseconds with their fraction, for the paint trace and the frame pacer
+    double NowMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+    }
+
+    long long UtcMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+    }
+
+    int UtcOffsetMinutes() {
+        time_t now = time(NULL);
+        struct tm local;
+        localtime_r(&now, &local);
+        return (int)(local.tm_gmtoff / 60);
+    }
+};
+
+// 24-bit TrueColor with 0x00RRGGBB pixels in 32 bits: what every X server of the last decades
+// offers, and the same memory layout as Argb, so the painter writes straight into the image
+inline bool IsArgbVisual(Display* display, const XVisualInfo& info) {
+    int count = 0;
+    XPixmapFormatValues* formats = XListPixmapFormats(display, &count);
+    bool bpp32 = false;
+    for (int i = 0; i < count; ++i) {
+        if (formats[i].depth == info.depth && formats[i].bits_per_pixel == 32) {
+            bpp32 = true;
+        }
+    }
+    if (formats) {
+        XFree(formats);
+    }
+    return bpp32 && info.c_class == TrueColor && info.red_mask == 0xFF0000 && info.green_mask == 0x00FF00 &&
+           info.blue_mask == 0x0000FF;
+}
+
+inline int NativeByteOrder() {
+    const unsigned int one = 1;
+    return *(const unsigned char*)&one ? LSBFirst : MSBFirst;
+}
+
+// Off-screen image that lives as long as the window, in shared memory when the server allows it.
+// It is only (re)allocated when the window size changes, never per paint.
+struct X11Surface {
+    XImage* image;
+    XShmSegmentInfo shm;
+    bool shared;              // image is in shm and presented with XShmPutImage
+    bool busy;                // The server may still be reading a shared image: wait for ShmCompletion
+    Argb* bits;               // The image's pixels, writable directly
+    int width;
+    int height;
+    int stride;               // In pixels
+    unsigned int allocations; // Number of images created for this surface so far
+    unsigned int releases;    // Number of images freed for this surface so far
+};
+
+inline X11Surface NoX11Surface() {
+    X11Surface none;
+    memset(&none, 0, sizeof(none));
+    none.shm.shmid = -1;
+    return none;
+}
+
+static bool g_x11AttachFailed = false;
+
+inline int TrapAttachError(Display*, XErrorEvent*) {
+    g_x11AttachFailed = true; // BadAccess: the server cannot map the segment (another machine, another namespace)
+    return 0;
+}
+
+inline void FreeX11Surface(Display* display, X11Surface* surface) {
+    if (surface->image) {
+        if (surface->shared) {
+            XShmDetach(display, &surface->shm);
+            XSync(display, False); // The server lets go of the segment before it is unmapped here
+            shmdt(surface->shm.shmaddr);
+            surface->image->data = NULL;
+        } else {
+            free(surface->image->data);
+            surface->image->data = NULL;
+        }
+        XDestroyImage(surface->image);
+        surface->releases++;
+    }
+    surface->image = NULL;
+    surface->shm.shmid = -1;
+    surface->shm.shmaddr = NULL;
+    surface->shared = false;
+    surface->busy = false;
+    surface->bits = NULL;
+    surface->width = 0;
+    surface->height = 0;
+    surface->stride = 0;
+}
+
+// A shared image, or false when the segment cannot be had or attached
+inline bool CreateSharedImage(Display* display, Visual* visual, int depth, int width, int height, X11Surface* surface) {
+    if (ImageByteOrder(display) != NativeByteOrder()) {
+        return false; // The server would read the pixels in the other byte order; XPutImage swaps them
+    }
+    XImage* image = XShmCreateImage(display, visual, depth, ZPixmap, NULL, &surface->shm, width, height);
+    if (!image) {
+        return false;
+    }
+    surface->shm.shmid = shmget(IPC_PRIVATE, (size_t)image->bytes_per_line * height, IPC_CREAT | 0600);
+    if (surface->shm.shmid < 0) {
+        XDestroyImage(image);
+        return false;
+    }
+    surface->shm.shmaddr = image->data = (char*)shmat(surface->shm.shmid, NULL, 0);
+    surface->shm.readOnly = True;
+    bool attached = surface->shm.shmaddr != (char*)-1;
+    if (attached) {
+        XErrorHandler previous = XSetErrorHandler(TrapAttachError);
+        g_x11AttachFailed = false;
+        XShmAttach(display, &surface->shm);
+        XSync(display, False);
+        XSetErrorHandler(previous);
+        attached = !g_x11AttachFailed;
+        if (!attached) {
+            shmdt(surface->shm.shmaddr);
+        }
+    }
+    shmctl(surface->shm.shmid, IPC_RMID, NULL); // Freed once both sides detach, even after a crash
+    if (!attached) {
+        image->data = NULL;
+        XDestroyImage(image);
+        return false;
+    }
+    surface->image = image;
+    surface->shared = true;
+    return true;
+}
+
+// Make sure the surface exists with the given size, shared when `shared` is set and the server
+// allows it. Returns false if there is no memory for the image.
+inline bool ResizeX11Surface(Display* display, Visual* visual, int depth, X11Surface* surface, int width, int height,
+                             bool shared) {
+    if (surface->image && surface->width == width && surface->height == height) {
+        return true; // Same size: keep the existing image
+    }
+    FreeX11Surface(display, surface);
+    if (!shared || !CreateSharedImage(display, visual, depth, width, height, surface)) {
+        XImage* image = XCreateImage(display, visual, depth, ZPixmap, 0, NULL, width, height, 32, 0);
+        if (!image) {
+            return false;
+        }
+        image->byte_order = NativeByteOrder(); // Xlib swaps for the server if it has to
+        image->data = (char*)malloc((size_t)image->bytes_per_line * height);
+        if (!image->data) {
+            XDestroyImage(image);
+            return false;
+        }
+        surface->image = image;
+        surface->shared = false;
+    }
+    surface->bits = (Argb*)surface->image->data;
+    surface->width = width;
+    surface->height = height;
+    surface->stride = surface->image->bytes_per_line / 4;
+    surface->allocations++;
+    return true;
+}
+
+// Copy a rectangle of the surface to the window: the server reads shared memory, or the pixels
+// go through the socket
+inline void PutX11Surface(Display* display, Drawable window, GC gc, X11Surface* surface, const DamageRect& r) {
+    unsigned int w = (unsigned int)(r.right - r.left), h = (unsigned int)(r.bottom - r.top);
+    if (!surface->image || IsEmpty(r)) {
+        return;
+    }
+    if (surface->shared) {
+        XShmPutImage(display, window, gc, surface->image, r.left, r.top, r.left, r.top, w, h, True);
+        surface->busy = true;
+    } else {
+        XPutImage(display, window, gc, surface->image, r.left, r.top, r.left, r.top, w, h);
+    }
+}
+
+// A ShmCompletion for this surface's segment; completions for a segment freed since (a resize)
+// say nothing about the current image
+inline bool IsX11SurfaceCompletion(const XEvent& event, int completionType, const X11Surface& surface) {
+    return event.type == completionType && surface.shared &&
+           ((const XShmCompletionEvent&)event).shmseg == surface.shm.shmseg;
+}
+
+struct X11CompletionMatch {
+    int completionType;
+    const X11Surface* surface;
+};
+
+inline Bool IsShmCompletion(Display*, XEvent* event, XPointer match) {
+    const X11CompletionMatch* m = (const X11CompletionMatch*)match;
+    return IsX11SurfaceCompletion(*event, m->completionType, *m->surface);
+}
+
+// Block until the server has read the last shared image put, so its pixels can be written again
+inline void WaitX11Surface(Display* display, int completionType, X11Surface* surface) {
+    if (!surface->busy) {
+        return;
+    }
+    X11CompletionMatch match = {completionType, surface};
+    XEvent event;
+    XIfEvent(display, &event, IsShmCompletion, (XPointer)&match);
+    surface->busy = false;
+}
+
+class X11Backend {
+public:
+    typedef PosixClock Clock;
+    typedef Window Screen;
+    typedef PixelTarget Surface;
+
+    X11Backend()
+        : display_(NULL), window_(0), gc_(0), visual_(NULL), depth_(0), useShm_(false), completionType_(-1),
+          width_(0), height_(0), timerArmed_(false), timerDueMs_(0.0), covered_(false), direct_(false), paint_(NULL) {
+        frame_ = NoX11Surface();
+        invalid_.left = invalid_.top = invalid_.right = invalid_.bottom = 0;
+        painting_ = invalid_;
+        stats_.presents = stats_.sharedPresents = stats_.pixels = 0;
+    }
+
+    // After the window is created: everything below works on it. `shm` is false for --no-shm.
+    void Attach(Display* display, Window window, Visual* visual, int depth, bool shm) {
+        display_ = display;
+        window_ = window;
+        visual_ = visual;
+        depth_ = depth;
+        gc_ = XCreateGC(display, window, 0, NULL);
+        useShm_ = shm && XShmQueryExtension(display);
+        completionType_ = useShm_ ? XShmGetEventBase(display) + ShmCompletion : -1;
+    }
+
+    // ConfigureNotify: the window's size, which InvalidateAll covers
+    void SetClientSize(int width, int height) {
+        width_ = width;
+        height_ = height;
+    }
+
+    bool Shared() const { return frame_.shared; }
+    int CompletionType() const { return completionType_; }
+
+    // ShmCompletion seen by the event loop: the image is free again if the event is for its segment
+    void Completed(const XEvent& event) {
+        if (IsX11SurfaceCompletion(event, completionType_, frame_)) {
+            frame_.busy = false;
+        }
+    }
+
+    void ArmTimer(int delayMs) {
+        timerArmed_ = true;
+        timerDueMs_ = clock_.NowMs() + delayMs;
+    }
+
+    void KillTimer() { timerArmed_ = false; }
+
+    // The event loop's WM_TIMER: true once when the armed time has come
+    bool TimerDue() {
+        if (!timerArmed_ || clock_.NowMs() < timerDueMs_) {
+            return false;
+        }
+        timerArmed_ = false;
+        return true;
+    }
+
+    // Milliseconds until the armed time, -1 when no timer is armed
+    int TimerDelayMs() {
+        if (!timerArmed_) {
+            return -1;
+        }
+        double left = timerDueMs_ - clock_.NowMs();
+        return left <= 0.0 ? 0 : (int)(left + 0.999);
+    }
+
+    void Invalidate(const DamageRect& r) {
+        DamageRect client = {0, 0, width_, height_};
+        invalid_ = Union(invalid_, Intersect(r, client));
+    }
+
+    void InvalidateAll() {
+        DamageRect client = {0, 0, width_, height_};
+        invalid_ = client;
+    }
+
+    bool HasInvalid() const { return !IsEmpty(invalid_); }
+
+    // The window's paint handler, which UpdateNow() calls like UpdateWindow sends WM_PAINT
+    typedef void (*PaintProc)();
+    void SetPaintProc(PaintProc paint) { paint_ = paint; }
+
+    void UpdateNow() {
+        if (paint_ && HasInvalid()) {
+            paint_();
+        }
+    }
+
+    // VisibilityNotify: fully obscured. Compositing managers never send it, so the clock keeps ticking there.
+    void SetCovered(bool covered) { covered_ = covered; }
+    bool ClientAreaCovered() { return covered_; }
+
+    long long UtcNowMs() { return clock_.UtcMs(); }
+    double CounterMs() { return clock_.NowMs(); }
+    void VisibilityChanged(const VisibilityTracker&) {}
+    void SweepStats(const FramePacer&) {}
+
+    // The frame at the client size, whatever the presentation, and the glyph atlas
+    DigitalLayout Resize(const ClockGeometry& g, bool) {
+        ResizeX11Surface(display_, visual_, depth_, &frame_, g.width, g.height, useShm_);
+        return painter_.Resize(g);
+    }
+
+    bool FaceReady(const ClockGeometry& g, Argb color) const { return painter_.FaceReady(g, color); }
+
+    template <class Tracer>
+    void BuildFace(const ClockGeometry& g, Argb color, Tracer* tracer) {
+        painter_.BuildFace(g, color, tracer);
+    }
+
+    Screen BeginPaint(DamageRect* paint) {
+        painting_ = *paint = invalid_;
+        invalid_.left = invalid_.top = invalid_.right = invalid_.bottom = 0;
+        return window_;
+    }
+
+    void EndPaint(Screen screen) {
+        if (direct_) {
+            Present(screen, Target(painting_), painting_);
+            direct_ = false;
+        }
+    }
+
+    // Direct presentation: the image stands in for the window, and EndPaint copies the paint rectangle out
+    Surface ScreenSurface(Screen) {
+        direct_ = true;
+        WaitX11Surface(display_, completionType_, &frame_);
+        return Target(painting_);
+    }
+
+    // Outside `paint` the image still holds the previous frame, like a back buffer
+    bool BeginBackBuffer(const ClockGeometry& g, const DamageRect& paint, Surface* target) {
+        if (!frame_.bits || frame_.width != g.width || frame_.height != g.height) {
+            return false;
+        }
+        WaitX11Surface(display_, completionType_, &frame_);
+        *target = Target(paint);
+        return true;
+    }
+
+    void EndBackBuffer(Surface) {}
+
+    // The only X request of a paint
+    void Present(Screen screen, Surface, const DamageRect& paint) {
+        PutX11Surface(display_, screen, gc_, &frame_, paint);
+        XFlush(display_);
+        stats_.presents++;
+        stats_.sharedPresents += frame_.shared ? 1 : 0;
+        stats_.pixels += (unsigned long long)Area(paint);
+    }
+
+    void Fill(Surface target, const DamageRect& r) { painter_.Fill(target, r); }
+    void CopyFace(Surface target, const DamageRect& r) { painter_.CopyFace(target, r); }
+
+    void DrawHands(Surface target, const ClockGeometry& g, const DamageRect& clip, const LocalTime& t, bool sweep,
+                   Argb color) {
+        painter_.DrawHands(target, g, clip, t, sweep, color);
+    }
+
+    void DrawDigits(Surface target, const ClockGeometry& g, const LocalTime& t, Argb color) {
+        painter_.DrawDigits(target, g, t, color);
+    }
+
+    void DrawHud(Surface target, const DamageRect& r, const char* line) { painter_.DrawHud(target, r, line); }
+
+    // Before XCloseDisplay: free the image and the painter's memory
+    void Release() {
+        ReportPresentStats();
+        WaitX11Surface(display_, completionType_, &frame_);
+        FreeX11Surface(display_, &frame_);
+        painter_.Release();
+        if (gc_) {
+            XFreeGC(display_, gc_);
+            gc_ = 0;
+        }
+    }
+
+    // How the frames went out, and the memory the painter holds
+    void ReportPresentStats() const {
+        fprintf(stderr, "p3timec-x11: %s, %llu presents (%llu shared), %.1f Mpx, %u image allocations, %lu KB held\n",
+                frame_.shared ? "MIT-SHM" : "XPutImage", stats_.presents, stats_.sharedPresents, stats_.pixels / 1e6,
+                frame_.allocations, (unsigned long)(painter_.Bytes() / 1024));
+    }
+
+    static void ReportResizeStats(const ResizeCoalescer& resize) {
+        const ResizeStats& stats = resize.Stats();
+        fprintf(stderr, "p3timec-x11 resize: %lu ConfigureNotify, %lu rebuilds, %lu coalesced\n",
+                (unsigned long)stats.events, (unsigned long)stats.rebuilds, (unsigned long)stats.coalesced);
+    }
+
+    template <class TimeClock>
+    static void ReportTimeStats(const TimeSource<TimeClock>& time) {
+        const TimeSourceStats& stats = time.Stats();
+        fprintf(stderr, "p3timec-x11 time: %lu reads, %lu clock reads, %lu time zone queries, %lu jumps\n",
+                (unsigned long)stats.reads, (unsigned long)stats.wallReads, (unsigned long)stats.offsetQueries,
+                (unsigned long)stats.jumps);
+    }
+
+    static void ReportSweepStats(const FramePacer& pacer) {
+        const FramePacerStats& stats = pacer.Stats();
+        fprintf(stderr, "p3timec-x11 sweep: %lu frames, %lu dropped, %lu late, %.2f ms/frame, %.1f Hz\n",
+                (unsigned long)stats.frames, (unsigned long)stats.dropped, (unsigned long)stats.late,
+                pacer.AverageWorkMs(), pacer.EffectiveHz());
+    }
+
+private:
+    // The image clipped to a paint rectangle; empty while there is no image
+    Surface Target(const DamageRect& r) const {
+        if (!frame_.bits) {
+            PixelView none = {NULL, 0, 0, 0};
+            DamageRect nothing = {0, 0, 0, 0};
+            return MakePixelTarget(none, nothing);
+        }
+        return MakePixelTarget(MakePixelView(frame_.bits, frame_.width, frame_.height, frame_.stride), r);
+    }
+
+    struct PresentStats {
+        unsigned long long presents;
+        unsigned long long sharedPresents;
+        unsigned long long pixels; // Copied to the window in total
+    };
+
+    Display* display_;
+    Window window_;
+    GC gc_;
+    Visual* visual_;
+    int depth_;
+    bool useShm_;        // The server has MIT-SHM and --no-shm was not given
+    int completionType_; // Event type of ShmCompletion
+    int width_;          // Client size from the last ConfigureNotify
+    int height_;
+    bool timerArmed_;
+    double timerDueMs_;  // On clock_.NowMs()
+    bool covered_;
+    bool direct_;
+    PaintProc paint_;
+    X11Surface frame_;   // The window's pixels
+    PixelPainter painter_;
+    PosixClock clock_;   // Only for the timer and CounterMs()
+    DamageRect invalid_; // The update region's bounding box
+    DamageRect painting_;
+    PresentStats stats_;
+
+    X11Backend(const X11Backend&);
+    X11Backend& operator=(const X11Backend&);
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_X11_X11_BACKEND_H
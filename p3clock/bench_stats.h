@@ -0,0 +1,133 @@
+#ifndef P3CLOCK_BENCH_STATS_H
+#define P3CLOCK_BENCH_STATS_H
+
+// Small helpers for the headless benchmarks: frame time statistics and a
+// minimal JSON writer, so results can be diffed and tracked between builds.
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+namespace p3clock {
+
+struct FrameTimeSummary {
+    int frames;
+    double meanMs;
+    double p50Ms;
+    double p99Ms;
+    double maxMs;
+    double fps; // 1000 / mean
+};
+
+// Nearest-rank percentile of already sorted samples, p in [0, 100]
+inline double Percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > sorted.size()) rank = sorted.size();
+    return sorted[rank - 1];
+}
+
+inline FrameTimeSummary SummarizeFrameTimes(std::vector<double> samplesMs) {
+    FrameTimeSummary s;
+    s.frames = (int)samplesMs.size();
+    s.meanMs = s.p50Ms = s.p99Ms = s.maxMs = s.fps = 0.0;
+    if (samplesMs.empty()) {
+        return s;
+    }
+    std::sort(samplesMs.begin(), samplesMs.end());
+    double total = 0.0;
+    for (size_t i = 0; i < samplesMs.size(); ++i) {
+        total += samplesMs[i];
+    }
+    s.meanMs = total / samplesMs.size();
+    s.p50Ms = Percentile(samplesMs, 50.0);
+    s.p99Ms = Percentile(samplesMs, 99.0);
+    s.maxMs = samplesMs.back();
+    s.fps = s.meanMs > 0.0 ? 1000.0 / s.meanMs : 0.0;
+    return s;
+}
+
+// Streaming JSON writer. Objects and arrays nest; commas are inserted automatically.
+class JsonWriter {
+public:
+    explicit JsonWriter(FILE* out) : out_(out), needComma_(false), afterKey_(false), depth_(0) {}
+
+    void BeginObject() { Prefix(); fputc('{', out_); Push(); }
+    void EndObject() { Pop(); fputc('}', out_); needComma_ = true; }
+    void BeginArray() { Prefix(); fputc('[', out_); Push(); }
+    void EndArray() { Pop(); fputc(']', out_); needComma_ = true; }
+
+    // Key of the next value inside an object
+    void Key(const char* key) {
+        Prefix();
+        String(key);
+        fputs(": ", out_);
+        needComma_ = false;
+        afterKey_ = true;
+    }
+
+    void Value(const char* s) { Prefix(); String(s); needComma_ = true; }
+    void Value(double v) { Prefix(); fprintf(out_, "%.6g", v); needComma_ = true; }
+    void Value(long long v) { Prefix(); fprintf(out_, "%lld", v); needComma_ = true; }
+    void Value(int v) { Value((long long)v); }
+    void Value(bool v) { Prefix(); fputs(v ? "true" : "false", out_); needComma_ = true; }
+
+    void Field(const char* key, const char* v) { Key(key); Value(v); }
+    void Field(const char* key, double v) { Key(key); Value(v); }
+    void Field(const char* key, long long v) { Key(key); Value(v); }
+    void Field(const char* key, int v) { Key(key); Value(v); }
+    void Field(const char* key, bool v) { Key(key); Value(v); }
+
+    void Finish() { fputc('\n', out_); }
+
+private:
+    void Prefix() {
+        if (afterKey_) {
+            afterKey_ = false;
+            return;
+        }
+        if (needComma_) {
+            fputc(',', out_);
+        }
+        if (depth_ > 0) {
+            Indent();
+        }
+    }
+
+    void Indent() {
+        fputc('\n', out_);
+        for (int i = 0; i < depth_; ++i) {
+            fputs("  ", out_);
+        }
+    }
+
+    void Push() { ++depth_; needComma_ = false; }
+    void Pop() { --depth_; Indent(); }
+
+    void String(const char* s) {
+        fputc('"', out_);
+        for (; *s; ++s) {
+            if (*s == '"' || *s == '\\') {
+                fputc('\\', out_);
+                fputc(*s, out_);
+            } else if ((unsigned char)*s < 0x20) {
+                fprintf(out_, "\\u%04x", (unsigned char)*s);
+            } else {
+                fputc(*s, out_);
+            }
+        }
+        fputc('"', out_);
+    }
+
+    FILE* out_;
+    bool needComma_;
+    bool afterKey_;
+    int depth_;
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_BENCH_STATS_H
@@ -0,0 +1,494 @@
+#ifndef P3CLOCK_CLOCK_CORE_H
+#define P3CLOCK_CLOCK_CORE_H
+
+// The clock window of every variant: the message handling and the paint
+// sequence that the five Win32 programs used to carry as five copies.
+//
+// What differs between the variants is chosen at compile time:
+//   Layout        DigitalLayoutPolicy        p3timec, p3timec-32-1, p3timec-32-2
+//                 AnalogDigitalLayoutPolicy  p3timec-32-moni-1
+//                 AnalogLayoutPolicy         p3timec-32-moni-only-1
+//   Presentation  DirectPresentation         paint straight into the window (p3timec, p3timec-32-1)
+//                 BufferedPresentation       paint into the back buffer, then copy the damaged part
+// Policies are empty classes whose constants the compiler folds, so each
+// program carries only the paint code of its own layout and presentation.
+//
+// The third parameter is the platform: the window, its timers and its
+// drawing. p3clock-win32/gdi_backend.h implements it with GDI and
+// p3clock-win32/dib_backend.h with PixelPainter (pixel_backend.h) writing the
+// pixels itself; p3timec-check core drives the same core and the same
+// PixelPainter through a simulated window on Linux. A backend provides
+//     typedef ... Clock;    // TimeSource clock (time_source.h) and paint tracer clock
+//     typedef ... Screen;   // What a paint draws to: the window DC between BeginPaint and EndPaint
+//     typedef ... Surface;  // Where the paint phases draw: the window or the back buffer
+//     void ArmTimer(int delayMs);
+//     void KillTimer();
+//     void Invalidate(const DamageRect& r);
+//     void InvalidateAll();
+//     void UpdateNow();                   // Paint the invalid area right away (UpdateWindow)
+//     bool ClientAreaCovered();
+//     long long UtcNowMs();               // Wall clock, for the time spent in each visibility state
+//     double CounterMs();                 // Steady clock of the frame pacer
+//     void VisibilityChanged(const VisibilityTracker& visibility);
+//     void SweepStats(const FramePacer& pacer);
+//     DigitalLayout Resize(const ClockGeometry& g, bool backBuffer); // Fonts, glyph atlas, back buffer
+//     bool FaceReady(const ClockGeometry& g, Argb color);
+//     template <class Tracer> void BuildFace(const ClockGeometry& g, Argb color, Tracer* tracer);
+//     Screen BeginPaint(DamageRect* paint);  // paint receives the bounding box of the invalid area
+//     void EndPaint(Screen screen);
+//     Surface ScreenSurface(Screen screen);
+//     bool BeginBackBuffer(const ClockGeometry& g, const DamageRect& paint, Surface* target);
+//     void EndBackBuffer(Surface target);
+//     void Present(Screen screen, Surface target, const DamageRect& paint);
+//     void Fill(Surface target, const DamageRect& r);      // Background: black, transparent in the overlay
+//     void CopyFace(Surface target, const DamageRect& r);  // From the face layer
+//     void DrawHands(Surface target, const ClockGeometry& g, const DamageRect& clip, const LocalTime& t,
+//                    bool sweep, Argb color);
+//     void DrawDigits(Surface target, const ClockGeometry& g, const LocalTime& t, Argb color);
+//     void DrawHud(Surface target, const DamageRect& rect, const char* text);
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame_pacer.h"
+#include "paint_trace.h"
+#include "resize_coalescer.h"
+#include "soft_clock.h"
+#include "tick_scheduler.h"
+#include "time_source.h"
+#include "visibility.h"
+
+namespace p3clock {
+
+template <ClockLayout L>
+struct LayoutPolicy {
+    static const ClockLayout kLayout = L;
+    static const bool kDigital = L != kLayoutAnalog;
+    static const bool kAnalog = L != kLayoutDigital;
+};
+
+typedef LayoutPolicy<kLayoutDigital> DigitalLayoutPolicy;
+typedef LayoutPolicy<kLayoutAnalogDigital> AnalogDigitalLayoutPolicy;
+typedef LayoutPolicy<kLayoutAnalog> AnalogLayoutPolicy;
+
+// Paint straight into the window. The window erases the damaged area with its class brush before
+// every paint, which is the flicker p3timec-32-1 shows on Vista and 7 without Aero.
+struct DirectPresentation {
+    static const bool kBuffered = false;
+    static const bool kEraseBackground = true;
+
+    template <class Backend>
+    static bool Begin(Backend* backend, typename Backend::Screen screen, const ClockGeometry&, const DamageRect&,
+                      typename Backend::Surface* target) {
+        *target = backend->ScreenSurface(screen);
+        return true;
+    }
+
+    template <class Backend, class Tracer>
+    static void End(Backend*, typename Backend::Screen, typename Backend::Surface, const DamageRect&, Tracer*) {}
+};
+
+// Paint into the persistent back buffer, clipped to the damaged area, and copy that area to the
+// window in one go. Nothing is erased first, so nothing flickers.
+struct BufferedPresentation {
+    static const bool kBuffered = true;
+    static const bool kEraseBackground = false;
+
+    // False while the back buffer is missing or does not match the client area: nothing is drawn
+    template <class Backend>
+    static bool Begin(Backend* backend, typename Backend::Screen, const ClockGeometry& g, const DamageRect& paint,
+                      typename Backend::Surface* target) {
+        return backend->BeginBackBuffer(g, paint, target);
+    }
+
+    template <class Backend, class Tracer>
+    static void End(Backend* backend, typename Backend::Screen screen, typename Backend::Surface target,
+                    const DamageRect& paint, Tracer* tracer) {
+        backend->EndBackBuffer(target);
+        ScopedPhase<Tracer> phase(tracer, kPhasePresent);
+        backend->Present(screen, target, paint);
+    }
+};
+
+const DamageRect kHudRect = {0, 0, 240, 20}; // Top left corner: last frame time and p99
+
+// Finds the option NAME on a command line: a whole token "/NAME", "-NAME" or "--NAME" in any case,
+// alone or as "NAME:VALUE" / "NAME=VALUE". Tokens are separated by blanks outside double quotes, so
+// "/hud" does not match "/hudson" and nothing matches inside a quoted path. *value (when asked for)
+// receives the text after the separator, or NULL without one; it runs to the end of the token.
+// For an option that may be given more than once: finds the next one at or after *cursor and
+// moves *cursor past its token, so the next call finds the one after it.
+inline bool FindNextCommandLineOption(const char** cursor, const char* name, const char** value) {
+    size_t length = strlen(name);
+    const char* p = *cursor;
+    while (p && *p) {
+        while (*p == ' ' || *p == '\t') {
+            ++p;
+        }
+        const char* token = p;
+        bool quoted = false;
+        for (; *p && (quoted || (*p != ' ' && *p != '\t')); ++p) {
+            if (*p == '"') {
+                quoted = !quoted;
+            }
+        }
+        const char* t = token[0] == '"' ? token + 1 : token;
+        if (*t == '/') {
+            ++t;
+        } else if (*t == '-') {
+            t += t[1] == '-' ? 2 : 1;
+        } else {
+            continue;
+        }
+        size_t i = 0;
+        while (i < length && tolower((unsigned char)t[i]) == tolower((unsigned char)name[i])) {
+            ++i;
+        }
+        if (i < length || t + length > p) {
+            continue;
+        }
+        char next = t[length];
+        if (next == ':' || next == '=') {
+            if (value) *value = t + length + 1;
+            *cursor = p;
+            return true;
+        }
+        if (t + length == p || next == '"') {
+            if (value) *value = NULL;
+            *cursor = p;
+            return true;
+        }
+    }
+    *cursor = p;
+    return false;
+}
+
+// The first option NAME on the command line, see FindNextCommandLineOption()
+inline bool FindCommandLineOption(const char* cmdLine, const char* name, const char** value) {
+    const char* cursor = cmdLine;
+    return FindNextCommandLineOption(&cursor, name, value);
+}
+
+// "/sweep" selects the sweep mode at 60 Hz, "/sweep:HZ" at HZ frames per second (60 to 240,
+// e.g. the monitor's refresh rate). Returns 0, tick mode, without the option.
+inline int ParseSweepOption(const char* cmdLine) {
+    const char* value;
+    if (!FindCommandLineOption(cmdLine, "sweep", &value)) {
+        return 0;
+    }
+    int hz = value ? atoi(value) : 60;
+    return hz < 60 ? 60 : hz > 240 ? 240 : hz;
+}
+
+const int kOverlayDefaultPercent = 85;
+
+// "/overlay" shows the clock as a borderless translucent overlay at 85% opacity, "/overlay:PERCENT"
+// at PERCENT (10 to 100). Returns the opacity as 0-255, or 0 without the option.
+inline int ParseOverlayOption(const char* cmdLine) {
+    const char* value;
+    if (!FindCommandLineOption(cmdLine, "overlay", &value)) {
+        return 0;
+    }
+    int percent = value ? atoi(value) : kOverlayDefaultPercent;
+    percent = percent < 10 ? 10 : percent > 100 ? 100 : percent;
+    return (percent * 255 + 50) / 100;
+}
+
+// "/hud" shows the HUD from the start (H toggles it later)
+inline bool ParseHudOption(const char* cmdLine) { return FindCommandLineOption(cmdLine, "hud", NULL); }
+
+template <class Layout, class Presentation, class Backend>
+class ClockCore {
+public:
+    typedef typename Backend::Clock Clock;
+    typedef typename Backend::Screen Screen;
+    typedef typename Backend::Surface Surface;
+    typedef PaintTracer<Clock> Tracer;
+
+    // Hands are written into the pixels of a surface the program owns; a window DC has none
+    typedef char AnalogNeedsBackBuffer[Layout::kAnalog && !Presentation::kBuffered ? -1 : 1];
+
+    // sweepHz is ignored by the digital layout, whose time only changes once a second
+    ClockCore(Backend* backend, Clock* clock, int sweepHz)
+        : backend_(backend), timeSource_(clock), tracer_(clock), sweepHz_(Layout::kAnalog ? sweepHz : 0),
+          showHud_(false), lastReportMs_(0.0), lastCoverCheckMs_(0.0) {
+        geometry_ = ComputeClockGeometry(Layout::kLayout, 0, 0);
+        display_ = timeSource_.Now();
+    }
+
+    // WM_CREATE
+    void Create() {
+        display_ = timeSource_.Now();
+        visibility_.Start(backend_->UtcNowMs());
+        if (!sweepHz_) {
+            // Fire the first tick right after the next wall-clock second boundary
+            backend_->ArmTimer(tickScheduler_.Start(display_.ms));
+        }
+    }
+
+    // WM_SIZE: only record the size; the next Paint() rebuilds for the latest one
+    void Size(int width, int height, bool minimized) {
+        // Minimized: stop ticking until restored (the surfaces are kept for the restore)
+        ApplyVisibility(visibility_.SetMinimized(minimized, backend_->UtcNowMs()));
+        if (width < 1 || height < 1) {
+            return;
+        }
+        resize_.OnSize(width, height);
+        backend_->InvalidateAll();
+    }
+
+    // WM_ERASEBKGND: true when the window should erase before painting
+    static bool EraseBackground() { return Presentation::kEraseBackground; }
+
+    // WM_TIMER: repaint only the digits and hands that changed since the last tick
+    void Timer() {
+        visibility_.CountWakeup();
+        if (!visibility_.Visible()) {
+            backend_->KillTimer(); // A tick that was already queued when the clock was hidden
+            return;
+        }
+        // Covered by other windows: stop until a paint shows part of it again
+        if (backend_->ClientAreaCovered()) {
+            ApplyVisibility(visibility_.SetOccluded(true, backend_->UtcNowMs()));
+            return;
+        }
+
+        LocalTime now = timeSource_.Now();
+        // Re-arm for the next second boundary on every tick, which cancels any drift
+        Tick tick = tickScheduler_.OnTick(now.ms);
+        backend_->ArmTimer(tick.delayMs);
+        if (!tick.present) {
+            return; // Woke up just before the boundary: the second has not changed yet
+        }
+        DamageList damage = damage_.Advance(now.time);
+        display_ = now;
+        Invalidate(damage);
+    }
+
+    // WM_PAINT: draw the display time inside the invalid area
+    void Paint() {
+        ScopedPhase<Tracer> traceFrame(&tracer_, kPhaseFrame);
+        double hudStartMs = showHud_ ? backend_->CounterMs() : 0.0; // The HUD times paints in every build
+        // Part of the window was uncovered: tick again, starting with this paint
+        ApplyVisibility(visibility_.SetOccluded(false, backend_->UtcNowMs()));
+
+        // Sizes from the WM_SIZE burst since the last frame: rebuild for the latest one only
+        int width, height;
+        if (resize_.TakePending(&width, &height)) {
+            ScopedPhase<Tracer> phase(&tracer_, kPhaseResize);
+            Rebuild(width, height);
+        }
+
+        DamageRect paint;
+        Screen screen = backend_->BeginPaint(&paint);
+        Surface target;
+        if (Presentation::Begin(backend_, screen, geometry_, paint, &target)) {
+            Draw(screen, target, paint);
+        }
+        backend_->EndPaint(screen);
+        if (showHud_) {
+            frameTimes_.Record(backend_->CounterMs() - hudStartMs);
+        }
+    }
+
+    // WM_TIMECHANGE: the time or the time zone was changed. Read the system time and the UTC
+    // offset again and show the new time right away.
+    void TimeChanged() {
+        timeSource_.Invalidate();
+        if (visibility_.Visible()) {
+            RestartTicking();
+        }
+    }
+
+    // WM_WTSSESSION_CHANGE: nobody can see the clock while the session is locked
+    void SessionLocked(bool locked) {
+        ApplyVisibility(visibility_.SetLocked(locked, backend_->UtcNowMs()));
+    }
+
+    // H key, "/hud" on the command line
+    void ShowHud(bool show) {
+        showHud_ = show;
+        backend_->Invalidate(kHudRect);
+    }
+
+    bool HudShown() const { return showHud_; }
+
+    // Sweep mode: start the frame grid before the first SweepStep()
+    void StartSweep() {
+        pacer_ = FramePacer(sweepHz_);
+        pacer_.Start(backend_->CounterMs());
+        lastReportMs_ = lastCoverCheckMs_ = backend_->CounterMs();
+    }
+
+    // Sweep mode, after the pending messages: paint a frame when the pacer says one is due.
+    // Returns how long to wait for the next frame, or a negative value while the clock is
+    // hidden (wait for a message instead).
+    double SweepStep() {
+        visibility_.CountWakeup();
+        if (!visibility_.Visible()) {
+            return -1.0; // No frames until a restore, unlock or paint message arrives
+        }
+        FrameSlot slot = pacer_.OnWake(backend_->CounterMs());
+        double delayMs = slot.delayMs;
+        if (slot.render) {
+            SweepFrame();
+            delayMs = pacer_.EndFrame(backend_->CounterMs());
+        }
+        // Once a second, stop when other windows cover the clock
+        if (backend_->CounterMs() - lastCoverCheckMs_ >= 1000.0) {
+            lastCoverCheckMs_ = backend_->CounterMs();
+            if (backend_->ClientAreaCovered()) {
+                ApplyVisibility(visibility_.SetOccluded(true, backend_->UtcNowMs()));
+            }
+        }
+        if (backend_->CounterMs() - lastReportMs_ >= 10000.0) {
+            backend_->SweepStats(pacer_);
+            lastReportMs_ = backend_->CounterMs();
+        }
+        return delayMs;
+    }
+
+    int SweepHz() const { return sweepHz_; }
+    const LocalTime& DisplayTime() const { return display_; }
+    const ClockGeometry& Geometry() const { return geometry_; }
+    const TimeSource<Clock>& Time() const { return timeSource_; }
+    const VisibilityTracker& Visibility() const { return visibility_; }
+    const ResizeCoalescer& Resizes() const { return resize_; }
+    const TickScheduler& Ticks() const { return tickScheduler_; }
+    const FramePacer& Pacer() const { return pacer_; }
+    const Tracer& Trace() const { return tracer_; }
+
+private:
+    // Everything inside `paint`, back to front
+    void Draw(Screen screen, Surface target, const DamageRect& paint) {
+        LocalTime st = display_; // Time chosen by the last tick or rebuild
+        Argb color = ClockColor(st.time);
+        if (Layout::kAnalog) {
+            // The face layer is only rebuilt here when the color flips at midnight / 1 AM
+            if (!backend_->FaceReady(geometry_, color)) {
+                backend_->BuildFace(geometry_, color, &tracer_);
+            }
+            {
+                ScopedPhase<Tracer> phase(&tracer_, kPhaseBackground);
+                if (backend_->FaceReady(geometry_, color)) {
+                    backend_->CopyFace(target, paint);
+                } else {
+                    backend_->Fill(target, paint); // No face layer (out of resources): at least clear the old hands
+                }
+            }
+            ScopedPhase<Tracer> phase(&tracer_, kPhaseHands);
+            backend_->DrawHands(target, geometry_, paint, st, sweepHz_ != 0, color);
+        } else {
+            ScopedPhase<Tracer> phase(&tracer_, kPhaseBackground);
+            backend_->Fill(target, paint);
+        }
+        if (Layout::kDigital) {
+            ScopedPhase<Tracer> phase(&tracer_, kPhaseText);
+            backend_->DrawDigits(target, geometry_, st, color);
+        }
+        char hud[64];
+        if (showHud_ && frameTimes_.FormatHud(hud, sizeof(hud))) {
+            backend_->DrawHud(target, kHudRect, hud);
+        }
+        Presentation::End(backend_, screen, target, paint, &tracer_);
+    }
+
+    // What WM_SIZE used to do for every size: fit the digital font, resize the back buffer and
+    // rebuild the face layer and the glyph atlas
+    void Rebuild(int width, int height) {
+        display_ = timeSource_.Now();
+        geometry_ = ComputeClockGeometry(Layout::kLayout, width, height);
+        DigitalLayout digital = backend_->Resize(geometry_, Presentation::kBuffered);
+        if (!Layout::kDigital) {
+            digital.enabled = false;
+        }
+        if (Layout::kAnalog) {
+            backend_->BuildFace(geometry_, ClockColor(display_.time), &tracer_);
+        }
+        // Tell the damage tracker where the digits and hands are now
+        damage_.SetLayout(digital, geometry_.analog, width, height);
+        ResetDamage(); // The full repaint that follows shows this time
+    }
+
+    void ResetDamage() {
+        if (sweepHz_) {
+            damage_.ResetSweep(display_.time, display_.millisecond);
+        } else {
+            damage_.Reset(display_.time);
+        }
+    }
+
+    // Invalidate only the damaged rectangles (or everything for a full repaint), and the HUD
+    // with every frame while it is shown, so its numbers stay current
+    void Invalidate(const DamageList& damage) {
+        if (damage.full) {
+            backend_->InvalidateAll();
+        } else {
+            for (int i = 0; i < damage.count; ++i) {
+                backend_->Invalidate(damage.rects[i]);
+            }
+        }
+        if (showHud_) {
+            backend_->Invalidate(kHudRect);
+        }
+    }
+
+    // One sweep mode frame: move the hands to the current millisecond and paint the change right away
+    void SweepFrame() {
+        LocalTime now = timeSource_.Now();
+        DamageList damage = damage_.AdvanceSweep(now.time, now.millisecond);
+        display_ = now;
+        Invalidate(damage);
+        backend_->UpdateNow(); // Paint now, inside this frame's slot
+    }
+
+    // Paint a full frame at the current time right away and tick again from the next second boundary
+    void RestartTicking() {
+        display_ = timeSource_.Now();
+        ResetDamage();
+        if (sweepHz_) {
+            pacer_.Start(backend_->CounterMs());
+        } else {
+            backend_->ArmTimer(tickScheduler_.Start(display_.ms));
+        }
+        backend_->InvalidateAll();
+    }
+
+    // Stop ticking when the clock becomes hidden. When it can be seen again, paint one catch-up frame
+    // at the current time right away and tick again from the next second boundary.
+    void ApplyVisibility(VisibilityAction action) {
+        if (action == kVisibilityNoChange) {
+            return;
+        }
+        if (action == kVisibilitySuspend) {
+            backend_->KillTimer();
+        } else {
+            RestartTicking();
+        }
+        backend_->VisibilityChanged(visibility_);
+    }
+
+    Backend* backend_;
+    TimeSource<Clock> timeSource_;
+    Tracer tracer_;
+    FrameTimeWindow frameTimes_; // Paints while the HUD is shown
+    int sweepHz_; // 0 = tick mode
+    bool showHud_;
+    ClockGeometry geometry_;
+    LocalTime display_; // Time on screen: ticks advance it and invalidate what changed, paints draw it
+    DamageTracker damage_;
+    TickScheduler tickScheduler_;
+    VisibilityTracker visibility_; // Minimized, fully covered or locked: no ticks and no paints
+    ResizeCoalescer resize_;
+    FramePacer pacer_;
+    double lastReportMs_;
+    double lastCoverCheckMs_;
+
+    ClockCore(const ClockCore&);
+    ClockCore& operator=(const ClockCore&);
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_CLOCK_CORE_H
@@ -0,0 +1,158 @@
+#ifndef P3CLOCK_CLOCK_GEOMETRY_H
+#define P3CLOCK_CLOCK_GEOMETRY_H
+
+// Platform-independent description of the P3 clock: the time being shown and
+// the geometry the WindowProc paint code uses for the analog face and hands.
+
+#include <math.h>
+
+#include "dial_table.h"
+
+namespace p3clock {
+
+const double kPi = 3.14159265358979323846;
+
+// Broken-down wall-clock time as shown on the clock
+struct ClockTime {
+    int hour;   // 0-23
+    int minute; // 0-59
+    int second; // 0-59
+};
+
+inline bool SameTime(const ClockTime& a, const ClockTime& b) {
+    return a.hour == b.hour && a.minute == b.minute && a.second == b.second;
+}
+
+// Green at midnight (hour 0), blue at every other hour
+inline bool IsGreenHour(const ClockTime& t) {
+    return t.hour == 0;
+}
+
+// Write "HH:MM:SS" (8 characters, no terminator)
+inline void FormatTime(const ClockTime& t, char out[8]) {
+    out[0] = (char)('0' + t.hour / 10);
+    out[1] = (char)('0' + t.hour % 10);
+    out[2] = ':';
+    out[3] = (char)('0' + t.minute / 10);
+    out[4] = (char)('0' + t.minute % 10);
+    out[5] = ':';
+    out[6] = (char)('0' + t.second / 10);
+    out[7] = (char)('0' + t.second % 10);
+}
+
+enum Hand { kSecondHand = 0, kMinuteHand = 1, kHourHand = 2, kHandCount = 3 };
+
+const double kHandLength[kHandCount] = {0.9, 0.7, 0.5}; // Fraction of the face radius
+const int kHandPenWidth[kHandCount] = {1, 3, 5};        // GDI pen width in pixels
+const int kFaceMargin = 20;                             // radius = min(w, h) / 2 - kFaceMargin
+const int kFaceBorderWidth = 2;                         // GDI pen width of the face border
+const double kNumeralRadius = 0.75;                     // Roman numerals sit at 0.75 * radius
+const int kReferenceRadius = 180;                       // Face radius of moni-1 at its default 800x400 size
+
+// Hand angle in degrees, clockwise from 12 o'clock
+inline double HandAngle(Hand hand, const ClockTime& t) {
+    switch (hand) {
+        case kSecondHand: return t.second * 6.0;                        // 6 degrees per second
+        case kMinuteHand: return t.minute * 6.0 + t.second * 0.1;       // + 0.1 degrees per second
+        default:          return (t.hour % 12) * 30.0 + t.minute * 0.5; // + 0.5 degrees per minute
+    }
+}
+
+// Dial resolution of each hand: the number of distinct angles it can show, and the step for a time
+template <Hand H> struct HandDial;
+
+template <> struct HandDial<kSecondHand> {
+    enum { kSteps = 60 }; // 6 degrees
+    static int Step(const ClockTime& t) { return t.second; }
+};
+
+template <> struct HandDial<kMinuteHand> {
+    enum { kSteps = 3600 }; // 0.1 degrees
+    static int Step(const ClockTime& t) { return t.minute * 60 + t.second; }
+};
+
+template <> struct HandDial<kHourHand> {
+    enum { kSteps = 720 }; // 0.5 degrees
+    static int Step(const ClockTime& t) { return (t.hour % 12) * 60 + t.minute; }
+};
+
+template <Hand H>
+inline const UnitVector& HandVectorOf(const ClockTime& t) {
+    return DialVector<HandDial<H>::kSteps>(HandDial<H>::Step(t));
+}
+
+// Direction of the hand at HandAngle(hand, t), from the compile-time tables
+inline const UnitVector& HandVector(Hand hand, const ClockTime& t) {
+    switch (hand) {
+        case kSecondHand: return HandVectorOf<kSecondHand>(t);
+        case kMinuteHand: return HandVectorOf<kMinuteHand>(t);
+        default:          return HandVectorOf<kHourHand>(t);
+    }
+}
+
+struct Point {
+    int x;
+    int y;
+};
+
+// Point at `fraction` of the hand's length, truncated exactly like the GDI paint code
+inline Point HandPoint(Hand hand, const ClockTime& t, int centerX, int centerY, int radius, double fraction) {
+    const UnitVector& v = HandVector(hand, t);
+    double length = radius * kHandLength[hand] * fraction;
+    Point p;
+    p.x = centerX + static_cast<int>(length * v.dx);
+    p.y = centerY + static_cast<int>(length * v.dy);
+    return p;
+}
+
+// Sweep mode: hand angle in degrees including `millisecond` into the current second,
+// so all three hands move continuously instead of once per second
+inline double SweepHandAngle(Hand hand, const ClockTime& t, int millisecond) {
+    double seconds = t.second + millisecond / 1000.0;
+    switch (hand) {
+        case kSecondHand: return seconds * 6.0;
+        case kMinuteHand: return t.minute * 6.0 + seconds * 0.1;
+        default:          return (t.hour % 12) * 30.0 + t.minute * 0.5 + seconds * (0.5 / 60.0);
+    }
+}
+
+struct PointF {
+    float x;
+    float y;
+};
+
+// Sweep angles are continuous, so they take sin / cos instead of the dial tables, and the
+// point is not truncated: the anti-aliased hand moves in sub-pixel steps between frames.
+inline PointF SweepHandPoint(Hand hand, const ClockTime& t, int millisecond,
+                             int centerX, int centerY, int radius, double fraction) {
+    double rad = SweepHandAngle(hand, t, millisecond) * kPi / 180.0;
+    double length = radius * kHandLength[hand] * fraction;
+    PointF p;
+    p.x = (float)(centerX + length * sin(rad));
+    p.y = (float)(centerY - length * cos(rad));
+    return p;
+}
+
+// Anchor of Roman numeral `hour` (1-12) on a circle of numeralRadius pixels
+inline Point NumeralPoint(int hour, int centerX, int centerY, int numeralRadius) {
+    const UnitVector& v = DialVector<12>(hour % 12);
+    Point p;
+    p.x = centerX + static_cast<int>(numeralRadius * v.dx);
+    p.y = centerY + static_cast<int>(numeralRadius * v.dy);
+    return p;
+}
+
+// Hand width in pixels for a face of the given radius. kHandPenWidth is the width at
+// kReferenceRadius; larger faces scale it up so a 4K clock does not get 1-pixel hands.
+inline double HandWidth(Hand hand, int radius) {
+    double scale = (double)radius / kReferenceRadius;
+    return kHandPenWidth[hand] * (scale > 1.0 ? scale : 1.0);
+}
+
+inline Point HandTip(Hand hand, const ClockTime& t, int centerX, int centerY, int radius) {
+    return HandPoint(hand, t, centerX, centerY, radius, 1.0);
+}
+
+} // namespace p3clock
+
+#endif // P3CLOCK_CLOCK_GEOMETRY_H
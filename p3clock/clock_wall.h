@@ -0,0 +1,381 @@
+#ifndef P3CLOCK_CLOCK_WALL_H
+#define P3CLOCK_CLOCK_WALL_H
+
+// A wall of clocks: one window showing the time in N zones on a grid.
+//
+// Every zone gets a cell with a label strip on top and a clock below it, in
+// one of the ClockLayout styles. All cells have the same size, so the cells
+// share one set of cached pixels: a face layer per color and one glyph
+// atlas, built once per cell size instead of once per clock. Each cell keeps
+// its own DamageTracker; Tick() redraws only what changed in each cell, into
+// the one framebuffer for the whole window, and reports the changed
+// rectangles for the caller to present. The damage of a cell shrinks with
+// the cell, so a tick costs about the same pixels for 4 cells as for 256 and
+// the per-cell overhead is a damage comparison.
+//
+// Times are UTC milliseconds; each zone adds a fixed offset (no daylight
+// saving rules).
+
+#include <vector>
+
+#include "clock_core.h" // FindNextCommandLineOption
+#include "clock_geometry.h"
+#include "damage.h"
+#include "framebuffer.h"
+#include "glyph_atlas.h"
+#include "soft_clock.h"
+#include "stroke_font.h"
+
+namespace p3clock {
+
+const int kWallLabelLength = 16;               // Label characters, including the terminator
+const int kMinWallOffsetMinutes = -12 * 60;    // UTC-12:00
+const int kMaxWallOffsetMinutes = 14 * 60;     // UTC+14:00
+
+struct WallZone {
+    int utcOffsetMinutes;
+    char label[kWallLabelLength];
+};
+
+// "UTC+09:00", "UTC-03:30", or "UTC" for offset 0
+inline void FormatUtcOffset(int minutes, char out[kWallLabelLength]) {
+    int n = 0;
+    out[n++] = 'U';
+    out[n++] = 'T';
+    out[n++] = 'C';
+    if (minutes != 0) {
+        int a = minutes < 0 ? -minutes : minutes;
+        out[n++] = minutes < 0 ? '-' : '+';
+        out[n++] = (char)('0' + a / 600);
+        out[n++] = (char)('0' + a / 60 % 10);
+        out[n++] = ':';
+        out[n++] = (char)('0' + a % 60 / 10);
+        out[n++] = (char)('0' + a % 10);
+    }
+    out[n] = '\0';
+}
+
+// Parse "OFFSET[,LABEL]": OFFSET is [+|-]H[:MM] (e.g. +9, -3:30, 0), LABEL up to the
+// next space with '_' for a space, upper-cased for the stroke font and cut to fit.
+// Without a label the offset names the zone. Returns false for anything else.
+inline bool ParseWallZone(const char* spec, WallZone* zone) {
+    const char* p = spec;
+    int sign = 1;
+    if (*p == '+' || *p == '-') {
+        sign = *p == '-' ? -1 : 1;
+        ++p;
+    }
+    if (*p < '0' || *p > '9') {
+        return false;
+    }
+    int hours = 0, minutes = 0;
+    for (int digits = 0; *p >= '0' && *p <= '9'; ++p) {
+        if (++digits > 2) return false;
+        hours = hours * 10 + (*p - '0');
+    }
+    if (*p == ':') {
+        ++p;
+        if (p[0] < '0' || p[0] > '5' || p[1] < '0' || p[1] > '9') {
+            return false;
+        }
+        minutes = (p[0] - '0') * 10 + (p[1] - '0');
+        p += 2;
+    }
+    int offset = sign * (hours * 60 + minutes);
+    if (offset < kMinWallOffsetMinutes || offset > kMaxWallOffsetMinutes) {
+        return false;
+    }
+    zone->utcOffsetMinutes = offset;
+    if (*p == '\0' || *p == ' ') {
+        FormatUtcOffset(offset, zone->label);
+        return true;
+    }
+    if (*p != ',') {
+        return false;
+    }
+    ++p;
+    int n = 0;
+    for (; *p && *p != ' ' && n < kWallLabelLength - 1; ++p) {
+        char c = *p == '_' ? ' ' : *p;
+        zone->label[n++] = c >= 'a' && c <= 'z' ? (char)(c - 'a' + 'A') : c;
+    }
+    zone->label[n] = '\0';
+    return true;
+}
+
+// Zones shown without any "/zone:" option, named by their UTC offsets
+const char* const kDefaultWallZones[] = {"-8", "-5", "0", "+1", "+3", "+5:30", "+8", "+9"};
+
+// The command line of p3timec-wall. "/zone:OFFSET[,LABEL]" adds a clock (repeatable), e.g.
+// /zone:+9,Tokyo /zone:-3:30,Newfoundland /zone:-5,New_York ('_' stands for a space). "/digital"
+// draws digital clocks only and "/analog" analog ones only; the default is analog + digital like
+// p3timec-32-moni-1. Options are whole tokens in any case, so a label such as Digital_Lab is a label.
+inline void ParseWallOptions(const char* cmdLine, ClockLayout* layout, std::vector<WallZone>* zones) {
+    *layout = kLayoutAnalogDigital;
+    if (FindCommandLineOption(cmdLine, "digital", NULL)) {
+        *layout = kLayoutDigital;
+    } else if (FindCommandLineOption(cmdLine, "analog", NULL)) {
+        *layout = kLayoutAnalog;
+    }
+    const char* cursor = cmdLine;
+    const char* value;
+    while (FindNextCommandLineOption(&cursor, "zone", &value)) {
+        WallZone zone;
+        if (value && ParseWallZone(value, &zone)) {
+            zones->push_back(zone);
+        }
+    }
+    if (zones->empty()) {
+        for (size_t i = 0; i < sizeof(kDefaultWallZones) / sizeof(kDefaultWallZones[0]); ++i) {
+            WallZone zone;
+            ParseWallZone(kDefaultWallZones[i], &zone);
+            zones->push_back(zone);
+        }
+    }
+}
+
+// Time of day in a zone `offsetMinutes` from UTC
+inline ClockTime ZoneTime(long long utcMs, int offsetMinutes) {
+    long long seconds = (utcMs >= 0 ? utcMs / 1000 : -((-utcMs + 999) / 1000)) + offsetMinutes * 60LL;
+    int day = (int)(seconds % 86400);
+    if (day < 0) day += 86400;
+    ClockTime t = {day / 3600, day / 60 % 60, day % 60};
+    return t;
+}
+
+// ComputeClockGeometry() for one cell. The fixed 20 px face margin would take most of a
+// small cell, so it shrinks with the cell; cells of 200 px and more keep it.
+inline ClockGeometry ComputeCellGeometry(ClockLayout layout, int width, int height) {
+    ClockGeometry g = ComputeClockGeometry(layout, width, height);
+    if (g.analog.enabled) {
+        int analogWidth = layout == kLayoutAnalogDigital ? width / 2 : width;
+        int side = analogWidth < height ? analogWidth : height;
+        int margin = side / 10 < kFaceMargin ? side / 10 : kFaceMargin;
+        g.analog.radius = side / 2 - margin;
+        if (g.analog.radius < 1) g.analog.radius = 1;
+        g.numeralFontSize = g.analog.radius / 5;
+        if (g.numeralFontSize < 4) g.numeralFontSize = 4;
+    }
+    return g;
+}
+
+const int kMaxWallLabelHeight = 60;
+
+struct WallGrid {
+    int columns;
+    int rows;
+    int cellWidth;
+    int cellHeight;
+    int labelHeight; // Label strip at the top of each cell; 0 when the cells are too small for one
+    int labelFontSize;
+};
+
+inline WallGrid MakeWallGrid(int columns, int rows, int width, int height) {
+    WallGrid grid;
+    grid.columns = columns;
+    grid.rows = rows;
+    grid.cellWidth = columns > 0 ? width / columns : 0;
+    grid.cellHeight = rows > 0 ? height / rows : 0;
+    grid.labelHeight = grid.cellHeight / 6;
+    if (grid.labelHeight > kMaxWallLabelHeight) grid.labelHeight = kMaxWallLabelHeight;
+    grid.labelFontSize = (int)(grid.labelHeight / kStrokeLineHeight);
+    if (grid.labelFontSize < 6) {
+        grid.labelHeight = 0;
+        grid.labelFontSize = 0;
+    }
+    return grid;
+}
+
+// The grid that shows `count` clocks in width x height the largest: the digital font size
+// for layouts with digits, the face radius for the analog one
+inline WallGrid ComputeWallGrid(ClockLayout layout, int count, int width, int height) {
+    WallGrid best = MakeWallGrid(0, 0, width, height);
+    int bestSize = -1;
+    for (int columns = 1; columns <= count; ++columns) {
+        int rows = (count + columns - 1) / columns;
+        WallGrid grid = MakeWallGrid(columns, rows, width, height);
+        ClockGeometry g = ComputeCellGeometry(layout, grid.cellWidth, grid.cellHeight - grid.labelHeight);
+        int size = g.hasDigital ? g.fontSize : g.analog.radius;
+        if (size > bestSize) {
+            best = grid;
+            bestSize = size;
+        }
+    }
+    return best;
+}
+
+class ClockWallRenderer {
+public:
+    explicit ClockWallRenderer(ClockLayout layout) : layout_(layout) {
+        grid_ = MakeWallGrid(0, 0, 0, 0);
+        geometry_ = ComputeCellGeometry(layout, 0, 0);
+        faceBuilt_[0] = faceBuilt_[1] = false;
+    }
+
+    ClockLayout Layout() const { return layout_; }
+    const WallGrid& Grid() const { return grid_; }
+    const ClockGeometry& CellGeometry() const { return geometry_; }
+    const Framebuffer& Frame() const { return frame_; }
+    int CellCount() const { return (int)zones_.size(); }
+
+    // Bytes of the pixels every cell shares: face layers and glyph atlas
+    size_t SharedCacheBytes() const {
+        return (faces_[0].pixels.size() + faces_[1].pixels.size() + atlas_.pixels.size()) * sizeof(Argb);
+    }
+
+    // Replace the zones; the layout is recomputed for the current size
+    void SetZones(const std::vector<WallZone>& zones) {
+        zones_ = zones;
+        Resize(frame_.width, frame_.height);
+    }
+
+    // WM_SIZE: pick the grid, then build the shared glyph atlas for the cell size. The face
+    // layers are built when a cell first needs their color.
+    void Resize(int width, int height) {
+        frame_.Resize(width, height);
+        grid_ = ComputeWallGrid(layout_, CellCount(), width, height);
+        geometry_ = ComputeCellGeometry(layout_, grid_.cellWidth, grid_.cellHeight - grid_.labelHeight);
+        faceBuilt_[0] = faceBuilt_[1] = false;
+
+        DigitalLayout digital;
+        digital.enabled = false;
+        if (geometry_.hasDigital && CellCount() > 0) {
+            atlasLayout_ = BuildTimeGlyphAtlas(&atlas_, geometry_.fontSize);
+            const DamageRect& r = geometry_.digitalRect;
+            textLayout_ = LayoutTimeText(atlasLayout_, r.left, r.top, r.right, r.bottom);
+            digital = DigitalLayoutFromText(atlasLayout_, textLayout_);
+        }
+
+        cells_.resize(zones_.size());
+        for (int i = 0; i < CellCount(); ++i) {
+            Cell& cell = cells_[i];
+            cell.left = i % grid_.columns * grid_.cellWidth;
+            cell.top = i / grid_.columns * grid_.cellHeight;
+            // Shrink the label until it fits the cell
+            cell.labelSize = grid_.labelFontSize;
+            while (cell.labelSize > 4 && StrokeTextWidth(zones_[i].label, cell.labelSize) > grid_.cellWidth) {
+                cell.labelSize--;
+            }
+            cell.damage.SetLayout(digital, geometry_.analog, geometry_.width, geometry_.height);
+        }
+        // Tick() appends at most this many rectangles, so it never allocates
+        damage_.reserve(zones_.size() * kMaxDamageRects);
+    }
+
+    // WM_PAINT after a resize: draw every cell for utcMs
+    void Render(long long utcMs) {
+        Clear(&frame_, kArgbBlack);
+        for (int i = 0; i < CellCount(); ++i) {
+            ClockTime t = ZoneTime(utcMs, zones_[i].utcOffsetMinutes);
+            DrawCell(i, t);
+            cells_[i].damage.Reset(t);
+        }
+    }
+
+    // One tick: redraw what changed in every cell since the last Render() / Tick() and
+    // return the changed rectangles in window coordinates
+    const std::vector<DamageRect>& Tick(long long utcMs) {
+        damage_.clear();
+        for (int i = 0; i < CellCount(); ++i) {
+            Cell& cell = cells_[i];
+            ClockTime t = ZoneTime(utcMs, zones_[i].utcOffsetMinutes);
+            DamageList damage = cell.damage.Advance(t);
+            // Slices of the same hand overlap a lot in small cells. Merging only where that
+            // saves pixels measured best in bench-wall; larger boxes cost more than the calls.
+            MergeDamage(&damage, 0);
+            if (damage.full) {
+                DrawCell(i, t);
+                DamageRect r = {cell.left, cell.top, cell.left + grid_.cellWidth, cell.top + grid_.cellHeight};
+                damage_.push_back(r);
+                continue;
+            }
+            int originY = cell.top + grid_.labelHeight;
+            for (int d = 0; d < damage.count; ++d) {
+                RedrawRect(cell, t, damage.rects[d]);
+                DamageRect r = damage.rects[d];
+                r.left += cell.left;
+                r.right += cell.left;
+                r.top += originY;
+                r.bottom += originY;
+                damage_.push_back(r);
+            }
+        }
+        return damage_;
+    }
+
+private:
+    struct Cell {
+        int left; // Top-left corner of the cell (label strip) in the window
+        int top;
+        int labelSize;
+        DamageTracker damage; // In the coordinates of the cell's clock area
+    };
+
+    // Label strip and clock of cell i
+    void DrawCell(int i, const ClockTime& t) {
+        const Cell& cell = cells_[i];
+        FillRect(&frame_, cell.left, cell.top, cell.left + grid_.cellWidth, cell.top + grid_.labelHeight, kArgbBlack);
+        if (grid_.labelHeight > 0) {
+            DrawStrokeTextCentered(&frame_, zones_[i].label, cell.left, cell.top, cell.left + grid_.cellWidth,
+                                   cell.top + grid_.labelHeight, cell.labelSize, kStrokeNormal, ClockColor(t));
+        }
+        DamageRect all = {0, 0, geometry_.width, geometry_.height};
+        RedrawRect(cell, t, all);
+    }
+
+    // Face, hands and digits of a cell inside `clip`, in the coordinates of its clock area
+    void RedrawRect(const Cell& cell, const ClockTime& t, const DamageRect& clip) {
+        if (IsEmpty(clip)) {
+            return; // Cells too small to hold a clock
+        }
+        Argb color = ClockColor(t);
+        int originX = cell.left, originY = cell.top + grid_.labelHeight;
+        DamageRect target = {originX + clip.left, originY + clip.top, originX + clip.right, originY + clip.bottom};
+        if (geometry_.analog.enabled) {
+            Blit(&frame_, target.left, target.top, Face(color), clip.left, clip.top, clip.right - clip.left, clip.bottom - clip.top);
+            DrawClockHands(&frame_, geometry_.analog, originX, originY, t, 0, false, color, target);
+        } else {
+            FillRect(&frame_, target.left, target.top, target.right, target.bottom, kArgbBlack);
+        }
+        if (geometry_.hasDigital) {
+            // Only the characters that touch the clip; the cells are opaque
+            GlyphBlit blits[8];
+            TimeTextBlits(atlasLayout_, textLayout_, t, blits);
+            for (int i = 0; i < 8; ++i) {
+                DamageRect r = {blits[i].dstX, blits[i].dstY, blits[i].dstX + blits[i].width, blits[i].dstY + blits[i].height};
+                if (!IsEmpty(Intersect(r, clip))) {
+                    Blit(&frame_, originX + blits[i].dstX, originY + blits[i].dstY, atlas_, blits[i].srcX, blits[i].srcY,
+                         blits[i].width, blits[i].height);
+                }
+            }
+        }
+    }
+
+    // Face layer of one cell in `color`, shared by every cell
+    const Framebuffer& Face(Argb color) {
+        int index = color == kArgbGreen ? 1 : 0;
+        if (!faceBuilt_[index]) {
+            faces_[index].Resize(geometry_.width, geometry_.height);
+            DrawClockFace(&faces_[index], geometry_, color);
+            faceBuilt_[index] = true;
+        }
+        return faces_[index];
+    }
+
+    ClockLayout layout_;
+    std::vector<WallZone> zones_;
+    WallGrid grid_;
+    ClockGeometry geometry_; // Clock area of one cell, below its label strip
+    Framebuffer frame_;
+    Framebuffer faces_[2]; // Blue and midnight green face layers
+    bool faceBuilt_[2];
+    Framebuffer atlas_;
+    GlyphAtlasLayout atlasLayout_;
+    TimeTextLayout textLayout_; // In the coordinates of a cell's clock area
+    std::vector<Cell> cells_;
+    std::vector<DamageRect> damage_; // What the last Tick() redrew
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_CLOCK_WALL_H
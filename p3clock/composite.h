@@ -0,0 +1,232 @@
+#ifndef P3CLOCK_COMPOSITE_H
+#define P3CLOCK_COMPOSITE_H
+
+// Premultiplied-alpha compositing for the overlay mode.
+//
+// An overlay pixel is 0xAARRGGBB with the color already multiplied by the
+// alpha (the format UpdateLayeredWindow takes with AC_SRC_ALPHA), so every
+// channel is at most the alpha. The clock draws into such a layer when its
+// background is kArgbTransparent: BlendPixel (simd.h) lerps all four channels
+// towards an opaque color, which on premultiplied pixels is exactly
+// source-over.
+//
+// The kernels work on spans of pixels:
+//   - source-over: dst = src + dst * (255 - src.a) / 255
+//   - global opacity: src is first scaled by opacity / 255, all four channels
+//   - the fade in / out is a ramp of that opacity over time (FadeRamp)
+// Divisions by 255 round to nearest with the exact integer form
+// (x + 128 + ((x + 128) >> 8)) >> 8, so scalar, SSE2 (4 pixels per step) and
+// AVX2 (8 pixels) agree bit for bit. Runs of fully transparent source pixels
+// are skipped and opaque ones copied.
+
+#include <stdint.h>
+
+#include "damage.h"
+#include "framebuffer.h"
+#include "simd.h"
+
+namespace p3clock {
+
+const Argb kArgbTransparent = 0x00000000u;
+
+// x / 255 rounded to nearest, for x in [0, 255 * 255]
+inline uint32_t Div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// All four channels times opacity / 255
+inline Argb ScalePixel(Argb c, int opacity) {
+    uint32_t o = (uint32_t)opacity;
+    return Div255((c >> 24) * o) << 24 | Div255(((c >> 16) & 0xFF) * o) << 16 | Div255(((c >> 8) & 0xFF) * o) << 8 |
+           Div255((c & 0xFF) * o);
+}
+
+// One channel of source-over. Clamped like the SIMD kernels' saturating pack, for the
+// (invalid) premultiplied pixels whose color exceeds their alpha.
+inline uint32_t SourceOverChannel(uint32_t d, uint32_t s, uint32_t inv) {
+    uint32_t v = s + Div255(d * inv);
+    return v > 255 ? 255 : v;
+}
+
+inline Argb SourceOverPixel(Argb dst, Argb src) {
+    uint32_t inv = 255 - (src >> 24);
+    return SourceOverChannel(dst >> 24, src >> 24, inv) << 24 |
+           SourceOverChannel((dst >> 16) & 0xFF, (src >> 16) & 0xFF, inv) << 16 |
+           SourceOverChannel((dst >> 8) & 0xFF, (src >> 8) & 0xFF, inv) << 8 |
+           SourceOverChannel(dst & 0xFF, src & 0xFF, inv);
+}
+
+inline void SourceOverSpanScalar(uint32_t* dst, const uint32_t* src, int count, int opacity) {
+    for (int i = 0; i < count; ++i) {
+        uint32_t s = src[i];
+        if (s == 0) {
+            continue;
+        }
+        if (opacity != 255) {
+            s = ScalePixel(s, opacity);
+        }
+        dst[i] = s >= 0xFF000000u ? s : SourceOverPixel(dst[i], s);
+    }
+}
+
+#if defined(P3CLOCK_X86_SIMD)
+
+// Div255 on eight 16-bit lanes
+P3CLOCK_TARGET("sse2")
+inline __m128i Div255x8(__m128i x) {
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Two pixels widened to 16-bit channels: source-over with global opacity
+P3CLOCK_TARGET("sse2")
+inline __m128i SourceOver2(__m128i d, __m128i s, __m128i opacity, bool scale) {
+    if (scale) {
+        s = Div255x8(_mm_mullo_epi16(s, opacity));
+    }
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i inv = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    return _mm_add_epi16(s, Div255x8(_mm_mullo_epi16(d, inv)));
+}
+
+P3CLOCK_TARGET("sse2")
+inline void SourceOverSpanSse2(uint32_t* dst, const uint32_t* src, int count, int opacity) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000u);
+    const __m128i o = _mm_set1_epi16((short)opacity);
+    bool scale = opacity != 255;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xFFFF) {
+            continue; // Transparent: dst stays
+        }
+        if (!scale && _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), alphaMask)) == 0xFFFF) {
+            _mm_storeu_si128((__m128i*)(dst + i), s); // Opaque: src replaces dst
+            continue;
+        }
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = SourceOver2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero), o, scale);
+        __m128i hi = SourceOver2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero), o, scale);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    SourceOverSpanScalar(dst + i, src + i, count - i, opacity);
+}
+
+P3CLOCK_TARGET("avx2")
+inline __m256i Div255x16(__m256i x) {
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+P3CLOCK_TARGET("avx2")
+inline __m256i SourceOver4(__m256i d, __m256i s, __m256i opacity, bool scale) {
+    if (scale) {
+        s = Div255x16(_mm256_mullo_epi16(s, opacity));
+    }
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m256i inv = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+    return _mm256_add_epi16(s, Div255x16(_mm256_mullo_epi16(d, inv)));
+}
+
+P3CLOCK_TARGET("avx2")
+inline void SourceOverSpanAvx2(uint32_t* dst, const uint32_t* src, int count, int opacity) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000u);
+    const __m256i o = _mm256_set1_epi16((short)opacity);
+    bool scale = opacity != 255;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        if (_mm256_testz_si256(s, s)) {
+            continue;
+        }
+        if (!scale && _mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(s, alphaMask), alphaMask)) == -1) {
+            _mm256_storeu_si256((__m256i*)(dst + i), s);
+            continue;
+        }
+        // Unpacks and the pack work per 128-bit lane, so the pixels come back in order
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i lo = SourceOver4(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(s, zero), o, scale);
+        __m256i hi = SourceOver4(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(s, zero), o, scale);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    SourceOverSpanSse2(dst + i, src + i, count - i, opacity);
+}
+
+#endif // P3CLOCK_X86_SIMD
+
+// src over dst for `count` pixels, src scaled by opacity (0-255) first
+inline void SourceOverSpan(uint32_t* dst, const uint32_t* src, int count, int opacity,
+                           SimdLevel kernel = kSimdAuto) {
+    if (opacity <= 0 || count <= 0) {
+        return;
+    }
+    if (opacity > 255) {
+        opacity = 255;
+    }
+    SimdLevel k = ResolveSimdLevel(kernel);
+#if defined(P3CLOCK_X86_SIMD)
+    if (k == kSimdAvx2) {
+        SourceOverSpanAvx2(dst, src, count, opacity);
+        return;
+    }
+    if (k == kSimdSse2) {
+        SourceOverSpanSse2(dst, src, count, opacity);
+        return;
+    }
+#endif
+    (void)k;
+    SourceOverSpanScalar(dst, src, count, opacity);
+}
+
+// The overlay's pixels inside r: `layer` over a uniform backdrop, the whole at `opacity`
+inline void ComposeOverlay(const PixelView& dst, const PixelView& layer, const DamageRect& r, Argb backdrop,
+                           int opacity, SimdLevel kernel = kSimdAuto) {
+    DamageRect bounds = {0, 0, dst.width < layer.width ? dst.width : layer.width,
+                         dst.height < layer.height ? dst.height : layer.height};
+    DamageRect c = Intersect(r, bounds);
+    if (IsEmpty(c)) {
+        return;
+    }
+    Argb base = ScalePixel(backdrop, opacity < 0 ? 0 : (opacity > 255 ? 255 : opacity));
+    for (int y = c.top; y < c.bottom; ++y) {
+        uint32_t* row = dst.Row(y);
+        for (int x = c.left; x < c.right; ++x) {
+            row[x] = base;
+        }
+        SourceOverSpan(row + c.left, layer.Row(y) + c.left, c.right - c.left, opacity, kernel);
+    }
+}
+
+// Opacity going from `from` to `to` over durationMs, eased at both ends
+struct FadeRamp {
+    double startMs;
+    double durationMs;
+    int from;
+    int to;
+
+    int LevelAt(double nowMs) const {
+        double t = durationMs > 0.0 ? (nowMs - startMs) / durationMs : 1.0;
+        if (t >= 1.0) {
+            return to;
+        }
+        if (t <= 0.0) {
+            return from;
+        }
+        double eased = t * t * (3.0 - 2.0 * t);
+        return from + (int)((to - from) * eased + (to > from ? 0.5 : -0.5));
+    }
+
+    bool DoneAt(double nowMs) const { return nowMs - startMs >= durationMs; }
+};
+
+inline FadeRamp MakeFadeRamp(double startMs, double durationMs, int from, int to) {
+    FadeRamp ramp = {startMs, durationMs, from, to};
+    return ramp;
+}
+
+} // namespace p3clock
+
+#endif // P3CLOCK_COMPOSITE_H
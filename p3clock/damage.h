@@ -0,0 +1,299 @@
+#ifndef P3CLOCK_DAMAGE_H
+#define P3CLOCK_DAMAGE_H
+
+// Damage tracking between two consecutive clock frames.
+//
+// Instead of invalidating the whole client area every second, the tracker
+// compares the time currently on screen with the next one and reports only
+// what changed: the "HH:MM:SS" characters that differ and the area swept by
+// each hand that moved. Everything here is plain C++ so it can be exercised
+// without a window.
+
+#include <math.h>
+
+#include "clock_geometry.h"
+
+namespace p3clock {
+
+struct DamageRect {
+    int left;
+    int top;
+    int right;  // exclusive
+    int bottom; // exclusive
+};
+
+inline bool IsEmpty(const DamageRect& r) {
+    return r.right <= r.left || r.bottom <= r.top;
+}
+
+inline long long Area(const DamageRect& r) {
+    return IsEmpty(r) ? 0 : (long long)(r.right - r.left) * (r.bottom - r.top);
+}
+
+inline DamageRect Union(const DamageRect& a, const DamageRect& b) {
+    if (IsEmpty(a)) return b;
+    if (IsEmpty(b)) return a;
+    DamageRect r;
+    r.left = a.left < b.left ? a.left : b.left;
+    r.top = a.top < b.top ? a.top : b.top;
+    r.right = a.right > b.right ? a.right : b.right;
+    r.bottom = a.bottom > b.bottom ? a.bottom : b.bottom;
+    return r;
+}
+
+inline DamageRect Intersect(const DamageRect& a, const DamageRect& b) {
+    DamageRect r;
+    r.left = a.left > b.left ? a.left : b.left;
+    r.top = a.top > b.top ? a.top : b.top;
+    r.right = a.right < b.right ? a.right : b.right;
+    r.bottom = a.bottom < b.bottom ? a.bottom : b.bottom;
+    if (IsEmpty(r)) {
+        r.left = r.top = r.right = r.bottom = 0;
+    }
+    return r;
+}
+
+// Where the eight characters of "HH:MM:SS" are drawn. Cell i spans
+// [cellLeft[i], cellRight[i]) horizontally and [top, bottom) vertically.
+struct DigitalLayout {
+    bool enabled;
+    int cellLeft[8];
+    int cellRight[8];
+    int top;
+    int bottom;
+};
+
+// Build a DigitalLayout from text metrics: `originX`/`top` is where the string
+// starts, `height` the line height and `extents` the cumulative advance after
+// each character (what GetTextExtentExPoint returns). `margin` pads every cell
+// to cover glyph overhang and anti-aliasing.
+inline DigitalLayout MakeDigitalLayout(int originX, int top, int height, const int extents[8], int margin) {
+    DigitalLayout layout;
+    layout.enabled = true;
+    int x = originX;
+    for (int i = 0; i < 8; ++i) {
+        layout.cellLeft[i] = x - margin;
+        layout.cellRight[i] = originX + extents[i] + margin;
+        x = originX + extents[i];
+    }
+    layout.top = top - margin;
+    layout.bottom = top + height + margin;
+    return layout;
+}
+
+struct AnalogLayout {
+    bool enabled;
+    int centerX;
+    int centerY;
+    int radius;
+};
+
+// Each hand's swept area is covered by this many boxes along its length, which
+// keeps the damage close to the actual wedge instead of one large bounding box.
+const int kHandSlices = 4;
+const int kMaxDamageRects = 1 + kHandCount * kHandSlices;
+
+struct DamageList {
+    bool full;  // Repaint the whole client area (first frame, resize, color change)
+    int count;
+    DamageRect rects[kMaxDamageRects];
+};
+
+inline long long DamageArea(const DamageList& damage, int clientWidth, int clientHeight) {
+    if (damage.full) {
+        return (long long)clientWidth * clientHeight;
+    }
+    long long area = 0;
+    for (int i = 0; i < damage.count; ++i) {
+        area += Area(damage.rects[i]);
+    }
+    return area;
+}
+
+// Merge rectangles while one rectangle around two costs less to redraw than both
+// apart, where a redraw costs `rectCost` (the fixed work of one paint: hands, glyph
+// lookups) plus one per pixel. Small clocks end up with one or two rectangles.
+inline void MergeDamage(DamageList* damage, long long rectCost) {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < damage->count && !merged; ++i) {
+            for (int j = i + 1; j < damage->count; ++j) {
+                DamageRect u = Union(damage->rects[i], damage->rects[j]);
+                if (Area(u) <= Area(damage->rects[i]) + Area(damage->rects[j]) + rectCost) {
+                    damage->rects[i] = u;
+                    damage->rects[j] = damage->rects[--damage->count];
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+class DamageTracker {
+public:
+    DamageTracker() : clientWidth_(0), clientHeight_(0), shownMs_(0), shownSweep_(false), hasShown_(false) {
+        digital_.enabled = false;
+        analog_.enabled = false;
+    }
+
+    // Called when the window is resized. The next Advance() reports full damage.
+    void SetLayout(const DigitalLayout& digital, const AnalogLayout& analog, int clientWidth, int clientHeight) {
+        digital_ = digital;
+        analog_ = analog;
+        clientWidth_ = clientWidth;
+        clientHeight_ = clientHeight;
+        hasShown_ = false;
+    }
+
+    // Record what is on screen after a full repaint, without reporting damage
+    void Reset(const ClockTime& shown) {
+        shown_ = shown;
+        shownMs_ = 0;
+        shownSweep_ = false;
+        hasShown_ = true;
+    }
+
+    // Sweep mode Reset(): the hands were drawn at `millisecond` into the second
+    void ResetSweep(const ClockTime& shown, int millisecond) {
+        shown_ = shown;
+        shownMs_ = millisecond;
+        shownSweep_ = true;
+        hasShown_ = true;
+    }
+
+    // Force the next Advance() to report full damage
+    void Invalidate() {
+        hasShown_ = false;
+    }
+
+    const ClockTime& Shown() const {
+        return shown_;
+    }
+
+    // Compare the frame on screen with `next`, remember `next` as shown and
+    // return the rectangles that must be repainted.
+    DamageList Advance(const ClockTime& next) {
+        return AdvanceTo(next, 0, false);
+    }
+
+    // Sweep mode: like Advance(), with the hands at `millisecond` into the second
+    // (SweepHandPoint) instead of on whole seconds
+    DamageList AdvanceSweep(const ClockTime& next, int millisecond) {
+        return AdvanceTo(next, millisecond, true);
+    }
+
+private:
+    DamageList AdvanceTo(const ClockTime& next, int nextMs, bool sweep) {
+        DamageList damage;
+        damage.full = false;
+        damage.count = 0;
+
+        if (!hasShown_ || sweep != shownSweep_ || IsGreenHour(shown_) != IsGreenHour(next)) {
+            // Nothing trustworthy on screen, or every element changes color
+            damage.full = true;
+        } else {
+            if (digital_.enabled) {
+                AddDigitalDamage(next, &damage);
+            }
+            if (analog_.enabled) {
+                for (int hand = 0; hand < kHandCount; ++hand) {
+                    AddHandDamage(static_cast<Hand>(hand), next, nextMs, sweep, &damage);
+                }
+            }
+        }
+
+        shown_ = next;
+        shownMs_ = nextMs;
+        shownSweep_ = sweep;
+        hasShown_ = true;
+        return damage;
+    }
+
+    void Add(const DamageRect& rect, DamageList* damage) const {
+        DamageRect client = {0, 0, clientWidth_, clientHeight_};
+        DamageRect clipped = Intersect(rect, client);
+        if (IsEmpty(clipped)) {
+            return;
+        }
+        if (damage->count == kMaxDamageRects) {
+            damage->full = true;
+            return;
+        }
+        damage->rects[damage->count++] = clipped;
+    }
+
+    void AddDigitalDamage(const ClockTime& next, DamageList* damage) const {
+        char before[8], after[8];
+        FormatTime(shown_, before);
+        FormatTime(next, after);
+        int first = -1, last = -1;
+        for (int i = 0; i < 8; ++i) {
+            if (before[i] != after[i]) {
+                if (first < 0) first = i;
+                last = i;
+            }
+        }
+        if (first < 0) {
+            return;
+        }
+        DamageRect r = {digital_.cellLeft[first], digital_.top, digital_.cellRight[last], digital_.bottom};
+        Add(r, damage);
+    }
+
+    PointF HandSlicePoint(Hand hand, const ClockTime& t, int millisecond, bool sweep, double fraction) const {
+        if (sweep) {
+            return SweepHandPoint(hand, t, millisecond, analog_.centerX, analog_.centerY, analog_.radius, fraction);
+        }
+        Point p = HandPoint(hand, t, analog_.centerX, analog_.centerY, analog_.radius, fraction);
+        PointF f = {(float)p.x, (float)p.y};
+        return f;
+    }
+
+    void AddHandDamage(Hand hand, const ClockTime& next, int nextMs, bool sweep, DamageList* damage) const {
+        double before = sweep ? SweepHandAngle(hand, shown_, shownMs_) : HandAngle(hand, shown_);
+        double after = sweep ? SweepHandAngle(hand, next, nextMs) : HandAngle(hand, next);
+        if (before == after) {
+            return;
+        }
+        // Half the (scaled) hand width plus slack for rounding and the anti-aliased edge
+        int pad = (int)HandWidth(hand, analog_.radius) / 2 + 2;
+        for (int slice = 0; slice < kHandSlices; ++slice) {
+            double from = (double)slice / kHandSlices;
+            double to = (double)(slice + 1) / kHandSlices;
+            PointF p[4] = {
+                HandSlicePoint(hand, shown_, shownMs_, sweep, from),
+                HandSlicePoint(hand, shown_, shownMs_, sweep, to),
+                HandSlicePoint(hand, next, nextMs, sweep, from),
+                HandSlicePoint(hand, next, nextMs, sweep, to),
+            };
+            float left = p[0].x, top = p[0].y, right = p[0].x, bottom = p[0].y;
+            for (int i = 1; i < 4; ++i) {
+                if (p[i].x < left) left = p[i].x;
+                if (p[i].y < top) top = p[i].y;
+                if (p[i].x > right) right = p[i].x;
+                if (p[i].y > bottom) bottom = p[i].y;
+            }
+            DamageRect r = {(int)floorf(left), (int)floorf(top), (int)ceilf(right), (int)ceilf(bottom)};
+            r.left -= pad;
+            r.top -= pad;
+            r.right += pad + 1;
+            r.bottom += pad + 1;
+            Add(r, damage);
+        }
+    }
+
+    DigitalLayout digital_;
+    AnalogLayout analog_;
+    int clientWidth_;
+    int clientHeight_;
+    ClockTime shown_;
+    int shownMs_;     // Millisecond the hands were drawn at (sweep mode)
+    bool shownSweep_; // The frame on screen was drawn in sweep mode
+    bool hasShown_;
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_DAMAGE_H
@@ -0,0 +1,87 @@
+#ifndef P3CLOCK_DIAL_TABLE_H
+#define P3CLOCK_DIAL_TABLE_H
+
+// Unit vectors for the finite set of angles a clock dial can show.
+//
+// A dial with Steps positions has one direction per step, clockwise from
+// 12 o'clock in screen coordinates (y grows downward). GCC and Clang in
+// C++14 mode generate the tables at compile time. Older compilers (the XP
+// toolchains) and MSVC, whose default /constexpr:steps limit is too small for
+// the 3600-entry minute table, fill the same table once, on first use.
+// Either way the values come from the series below, not the C library's
+// sin and cos.
+
+namespace p3clock {
+
+#if __cplusplus >= 201402L && (defined(__GNUC__) || defined(__clang__))
+#define P3CLOCK_DIAL_CONSTEXPR constexpr
+#define P3CLOCK_DIAL_CONSTEXPR_TABLES 1
+#else
+#define P3CLOCK_DIAL_CONSTEXPR
+#endif
+
+struct UnitVector {
+    double dx; // sin(angle)
+    double dy; // -cos(angle): 12 o'clock points up
+};
+
+// Taylor series of sin and cos for x in [0, pi / 2], accurate to about 1e-16
+inline P3CLOCK_DIAL_CONSTEXPR double SeriesSin(double x) {
+    double term = x, sum = x;
+    for (int n = 1; n < 14; ++n) {
+        term = -term * x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+inline P3CLOCK_DIAL_CONSTEXPR double SeriesCos(double x) {
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 14; ++n) {
+        term = -term * x * x / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+// Direction of step `step` on a dial of `steps` positions. The quadrant is found with
+// integer arithmetic, so the quarter-turn directions are exact.
+inline P3CLOCK_DIAL_CONSTEXPR UnitVector MakeDialVector(int step, int steps) {
+    int quarter = 4 * step / steps;
+    double phi = 1.57079632679489661923 * (4 * step - quarter * steps) / steps;
+    double s = SeriesSin(phi), c = SeriesCos(phi);
+    UnitVector v = {0.0, 0.0};
+    switch (quarter) {
+        case 0:  v.dx = s;  v.dy = -c; break;
+        case 1:  v.dx = c;  v.dy = s;  break;
+        case 2:  v.dx = -s; v.dy = c;  break;
+        default: v.dx = -c; v.dy = -s; break;
+    }
+    return v;
+}
+
+template <int Steps>
+struct DialTable {
+    UnitVector v[Steps];
+
+    P3CLOCK_DIAL_CONSTEXPR DialTable() : v() {
+        for (int i = 0; i < Steps; ++i) {
+            v[i] = MakeDialVector(i, Steps);
+        }
+    }
+};
+
+// Table lookup for step in [0, Steps)
+template <int Steps>
+inline const UnitVector& DialVector(int step) {
+#if defined(P3CLOCK_DIAL_CONSTEXPR_TABLES)
+    static constexpr DialTable<Steps> table{};
+#else
+    static const DialTable<Steps> table;
+#endif
+    return table.v[step];
+}
+
+} // namespace p3clock
+
+#endif // P3CLOCK_DIAL_TABLE_H
@@ -0,0 +1,161 @@
+#ifndef P3CLOCK_FONT_FIT_H
+#define P3CLOCK_FONT_FIT_H
+
+// Digital font size measured to fit "88:88:88" into the digital clock's area.
+//
+// The old size, min(height / 1.5, width / 4.5), guessed the text extent from
+// the box instead of measuring it, so the time was clipped in some window
+// shapes and too small in others. Here the widest time string is measured in
+// the real font: one measurement at a reference size gives a linear estimate,
+// and the estimate is measured again and stepped down until it really fits
+// (hinting does not scale exactly linearly). Measuring is left to a Measurer,
+// any type with
+//     TextExtent Measure(int size); // extent of kFitText at em height `size`
+// so the same fit runs on GDI (a font per size) and on the stroke font.
+//
+// Box sizes are rounded down to kFontFitBucket pixels before fitting, so every
+// box in a bucket gets the same font and it fits all of them. FontFitCache
+// remembers the size per bucket: during a drag-resize only the first visit to
+// a bucket measures anything, and returning to a size costs nothing.
+
+namespace p3clock {
+
+const char kFitText[] = "88:88:88"; // Digits share one advance, so this is as wide as any time
+const int kFitTextLength = 8;
+const int kFitReferenceSize = 100; // Em height of the measurement the estimate scales from
+const int kFontFitBucket = 8;      // Box sizes are fitted in steps of this many pixels
+const int kFontFitFill = 90;       // The text may fill this percentage of the box in each direction
+
+struct TextExtent {
+    int width;
+    int height;
+};
+
+// Space the text may take in a width x height box: the bucket's lower corner, less the margin
+inline TextExtent FontFitBox(int width, int height) {
+    TextExtent box;
+    box.width = (width / kFontFitBucket) * kFontFitBucket * kFontFitFill / 100;
+    box.height = (height / kFontFitBucket) * kFontFitBucket * kFontFitFill / 100;
+    return box;
+}
+
+// Largest font size whose kFitText fits FontFitBox(width, height), at least 1.
+// `reference` is m.Measure(kFitReferenceSize).
+template <class Measurer>
+int FitFontSize(Measurer& m, const TextExtent& reference, int width, int height) {
+    TextExtent box = FontFitBox(width, height);
+    if (reference.width < 1 || reference.height < 1) {
+        return 1;
+    }
+    long long fromWidth = (long long)box.width * kFitReferenceSize / reference.width;
+    long long fromHeight = (long long)box.height * kFitReferenceSize / reference.height;
+    int size = (int)(fromWidth < fromHeight ? fromWidth : fromHeight);
+    for (; size > 1; --size) {
+        TextExtent e = m.Measure(size);
+        if (e.width <= box.width && e.height <= box.height) {
+            break;
+        }
+    }
+    return size < 1 ? 1 : size;
+}
+
+struct FontFitStats {
+    unsigned long long hits;
+    unsigned long long misses;       // Buckets that had to be fitted
+    unsigned long long measurements; // Measure() calls, the reference included
+};
+
+const int kFontFitCacheSize = 1024; // Slots; a full-screen drag visits a few hundred buckets
+
+// Fitted font size per box bucket, for one Measurer (one font face and weight).
+// Open addressing with linear probing; once three quarters of the slots are taken the
+// table starts over, so lookups stay short and a bucket is never fitted twice before that.
+class FontFitCache {
+public:
+    FontFitCache() : used_(0), referenceMeasured_(false) {
+        reference_.width = reference_.height = 0;
+        for (int i = 0; i < kFontFitCacheSize; ++i) {
+            slots_[i].size = 0;
+        }
+        stats_.hits = stats_.misses = stats_.measurements = 0;
+    }
+
+    template <class Measurer>
+    int Get(Measurer& m, int width, int height) {
+        int bucketX = width / kFontFitBucket;
+        int bucketY = height / kFontFitBucket;
+        Slot* slot = Find(bucketX, bucketY);
+        if (slot->size > 0) {
+            stats_.hits++;
+            return slot->size;
+        }
+        stats_.misses++;
+        if (used_ >= kFontFitCacheSize * 3 / 4) {
+            ClearSlots();
+            slot = Find(bucketX, bucketY);
+        }
+        CountingMeasurer<Measurer> counted = {&m, &stats_.measurements};
+        if (!referenceMeasured_) {
+            reference_ = counted.Measure(kFitReferenceSize);
+            referenceMeasured_ = true;
+        }
+        slot->bucketX = bucketX;
+        slot->bucketY = bucketY;
+        slot->size = FitFontSize(counted, reference_, width, height);
+        used_++;
+        return slot->size;
+    }
+
+    // Forget every size, e.g. when the font face or the DPI changes
+    void Clear() {
+        referenceMeasured_ = false;
+        ClearSlots();
+    }
+
+    const FontFitStats& Stats() const { return stats_; }
+
+private:
+    template <class Measurer>
+    struct CountingMeasurer {
+        Measurer* m;
+        unsigned long long* count;
+
+        TextExtent Measure(int size) {
+            (*count)++;
+            return m->Measure(size);
+        }
+    };
+
+    struct Slot {
+        int bucketX;
+        int bucketY;
+        int size; // 0 = empty
+    };
+
+    // The bucket's slot, or the empty slot where it belongs
+    Slot* Find(int bucketX, int bucketY) {
+        unsigned hash = ((unsigned)bucketX << 16 ^ (unsigned)bucketY) * 2654435761u;
+        unsigned i = (hash >> 16) % kFontFitCacheSize;
+        while (slots_[i].size > 0 && (slots_[i].bucketX != bucketX || slots_[i].bucketY != bucketY)) {
+            i = (i + 1) % kFontFitCacheSize;
+        }
+        return &slots_[i];
+    }
+
+    void ClearSlots() {
+        for (int i = 0; i < kFontFitCacheSize; ++i) {
+            slots_[i].size = 0;
+        }
+        used_ = 0;
+    }
+
+    Slot slots_[kFontFitCacheSize];
+    int used_;
+    TextExtent reference_;
+    bool referenceMeasured_;
+    FontFitStats stats_;
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_FONT_FIT_H
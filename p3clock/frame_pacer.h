@@ -0,0 +1,128 @@
+#ifndef P3CLOCK_FRAME_PACER_H
+#define P3CLOCK_FRAME_PACER_H
+
+// Frame pacing for the sweep mode.
+//
+// Frames are due on a fixed grid, one slot every 1000 / hz ms from Start().
+// The caller sleeps for the delay it is given, asks OnWake() whether a frame
+// is due, renders it and reports the end with EndFrame(), which returns the
+// next delay. Like TickScheduler the pacer never reads a clock itself.
+//
+// A frame that starts more than half a frame interval after its slot counts
+// as late; slots that pass without any frame count as dropped. To keep an
+// always-on display cheap, the average render time is held under a budget
+// (a fraction of the frame interval): while it is over budget only every
+// 2nd, 3rd ... slot is rendered, and the divider steps back down once the
+// work fits again.
+
+namespace p3clock {
+
+struct FrameSlot {
+    bool render;     // A frame is due: render it, then call EndFrame()
+    long long slot;  // Grid slot of this wake-up
+    double lateMs;   // How far past the due slot's start this wake-up ran
+    double delayMs;  // Not due: sleep this long before the next OnWake()
+};
+
+struct FramePacerStats {
+    unsigned long long wakeups; // OnWake() calls
+    unsigned long long frames;  // Frames rendered
+    unsigned long long dropped; // Frame intervals that passed without a frame
+    unsigned long long late;    // Frames started more than half an interval late
+    double workMs;              // Total time from OnWake() to EndFrame() of rendered frames
+};
+
+const int kMaxFrameDivider = 8; // 240 Hz can fall back to 30 Hz, 60 Hz to 7.5 Hz
+
+class FramePacer {
+public:
+    // `budget` is the share of each frame interval rendering may use on average
+    explicit FramePacer(double hz = 60.0, double budget = 0.1)
+        : periodMs_(1000.0 / hz), budget_(budget), startMs_(0.0), frameStartMs_(0.0),
+          averageWorkMs_(0.0), lastSlot_(0), divider_(1), started_(false) {
+        stats_.wakeups = stats_.frames = stats_.dropped = stats_.late = 0;
+        stats_.workMs = 0.0;
+    }
+
+    void Start(double nowMs) {
+        startMs_ = nowMs;
+        started_ = true;
+        lastSlot_ = -1;
+    }
+
+    FrameSlot OnWake(double nowMs) {
+        FrameSlot f;
+        stats_.wakeups++;
+        f.slot = SlotOf(nowMs);
+        long long due = lastSlot_ + divider_;
+        if (!started_ || f.slot < due) {
+            f.render = false;
+            f.lateMs = 0.0;
+            f.delayMs = SlotStartMs(due) - nowMs;
+            return f;
+        }
+        // Frame intervals (at the current divider) that went by with no frame
+        long long missed = (f.slot - lastSlot_) / divider_ - 1;
+        if (lastSlot_ >= 0 && missed > 0) {
+            stats_.dropped += (unsigned long long)missed;
+        }
+        due = lastSlot_ < 0 ? f.slot : lastSlot_ + (missed + 1) * divider_;
+        f.lateMs = nowMs - SlotStartMs(due);
+        if (f.lateMs > 0.5 * periodMs_ * divider_) {
+            stats_.late++;
+        }
+        f.render = true;
+        f.delayMs = 0.0;
+        lastSlot_ = due;
+        frameStartMs_ = nowMs;
+        return f;
+    }
+
+    // The frame OnWake() asked for is done. Returns the delay until the next one is due.
+    double EndFrame(double nowMs) {
+        double work = nowMs - frameStartMs_;
+        stats_.frames++;
+        stats_.workMs += work;
+        averageWorkMs_ = stats_.frames == 1 ? work : averageWorkMs_ * 0.9 + work * 0.1;
+
+        // Over budget: render fewer slots. Back down only with some headroom, so the
+        // divider does not flip every frame when the work sits right at the limit.
+        if (averageWorkMs_ > budget_ * periodMs_ * divider_ && divider_ < kMaxFrameDivider) {
+            divider_++;
+        } else if (divider_ > 1 && averageWorkMs_ < 0.8 * budget_ * periodMs_ * (divider_ - 1)) {
+            divider_--;
+        }
+        double delay = SlotStartMs(lastSlot_ + divider_) - nowMs;
+        return delay > 0.0 ? delay : 0.0;
+    }
+
+    double PeriodMs() const { return periodMs_; }
+    int Divider() const { return divider_; }
+    double EffectiveHz() const { return 1000.0 / (periodMs_ * divider_); }
+    double AverageWorkMs() const { return averageWorkMs_; }
+    const FramePacerStats& Stats() const { return stats_; }
+
+private:
+    long long SlotOf(double ms) const {
+        double slot = (ms - startMs_) / periodMs_;
+        return slot >= 0.0 ? (long long)slot : -1;
+    }
+
+    double SlotStartMs(long long slot) const {
+        return startMs_ + slot * periodMs_;
+    }
+
+    double periodMs_;
+    double budget_;
+    double startMs_;
+    double frameStartMs_;
+    double averageWorkMs_;
+    long long lastSlot_; // Slot of the last rendered frame, -1 before the first
+    int divider_;        // Render every divider-th slot
+    bool started_;
+    FramePacerStats stats_;
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_FRAME_PACER_H
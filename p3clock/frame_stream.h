@@ -0,0 +1,175 @@
+#ifndef P3CLOCK_FRAME_STREAM_H
+#define P3CLOCK_FRAME_STREAM_H
+
+// Raw video out of the clock: a fixed pool of frame buffers and a writer
+// thread, for p3timec-headless stream (Y4M or raw RGBA to stdout or a pipe
+// that ffmpeg or OBS reads).
+//
+// The renderer takes a free buffer, fills it and submits it; the writer
+// thread writes submitted buffers in order and gives them back. Every buffer
+// is allocated up front and the queues are fixed rings, so a running stream
+// allocates nothing. When the reader falls behind and no buffer is free, a
+// live stream drops the frame (Acquire(false)) instead of falling behind the
+// clock; an offline one waits for the writer (Acquire(true)).
+//
+// Needs C++11 threads (the headless build), like tile_pool.h.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace p3clock {
+
+struct FrameStreamStats {
+    unsigned long long produced;  // Frames submitted
+    unsigned long long dropped;   // Frames skipped because every buffer was in use
+    unsigned long long written;   // Frames the writer finished
+    unsigned long long bytes;     // Written, frame headers included
+    unsigned long long depthSum;  // Queue depth after each submit, for the mean
+    int maxDepth;                 // Most frames waiting for the writer at once
+    bool failed;                  // A write failed (the reader went away); later frames are dropped
+};
+
+class FrameStream {
+public:
+    // `header` goes before every frame ("FRAME\n" for Y4M, "" for raw)
+    FrameStream(FILE* out, size_t frameBytes, int buffers, const char* header)
+        : out_(out), frameBytes_(frameBytes), header_(header), headerBytes_(strlen(header)),
+          buffers_(buffers < 2 ? 2 : buffers), pool_(frameBytes * buffers_), free_(buffers_), queue_(buffers_),
+          freeCount_(buffers_), queueHead_(0), queueCount_(0), stopping_(false) {
+        for (int i = 0; i < buffers_; ++i) {
+            free_[i] = buffers_ - 1 - i;
+        }
+        stats_.produced = stats_.dropped = stats_.written = stats_.bytes = stats_.depthSum = 0;
+        stats_.maxDepth = 0;
+        stats_.failed = false;
+        writer_ = std::thread(&FrameStream::WriterLoop, this);
+    }
+
+    ~FrameStream() { Finish(); }
+
+    int Buffers() const { return buffers_; }
+    size_t FrameBytes() const { return frameBytes_; }
+
+    // Which pool buffer a frame from Acquire() is, 0 to Buffers() - 1
+    int Index(const unsigned char* frame) const { return (int)((frame - &pool_[0]) / frameBytes_); }
+
+    // A buffer to render the next frame into, or NULL when the frame is dropped. The most
+    // recently freed buffer comes first, which is the most likely to still be in the cache.
+    unsigned char* Acquire(bool wait) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (wait) {
+            freed_.wait(lock, [this] { return freeCount_ > 0 || stats_.failed; });
+        }
+        if (freeCount_ == 0 || stats_.failed) {
+            stats_.dropped++;
+            return NULL;
+        }
+        int index = free_[--freeCount_];
+        return &pool_[(size_t)index * frameBytes_];
+    }
+
+    // Hand a buffer from Acquire() to the writer
+    void Submit(unsigned char* frame) {
+        int index = Index(frame);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_[(queueHead_ + queueCount_) % buffers_] = index;
+            queueCount_++;
+            stats_.produced++;
+            stats_.depthSum += queueCount_;
+            if (queueCount_ > stats_.maxDepth) {
+                stats_.maxDepth = queueCount_;
+            }
+        }
+        submitted_.notify_one();
+    }
+
+    // Frames waiting for the writer right now
+    int QueueDepth() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queueCount_;
+    }
+
+    // Write what is queued, then stop the writer. Returns false if any write failed.
+    bool Finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        submitted_.notify_one();
+        if (writer_.joinable()) {
+            writer_.join();
+        }
+        return !stats_.failed;
+    }
+
+    FrameStreamStats Stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    void WriterLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            submitted_.wait(lock, [this] { return queueCount_ > 0 || stopping_; });
+            if (queueCount_ == 0) {
+                return; // Stopping with nothing left
+            }
+            int index = queue_[queueHead_];
+            bool failed = stats_.failed;
+            lock.unlock();
+            bool ok = failed || Write(&pool_[(size_t)index * frameBytes_]);
+            lock.lock();
+            queueHead_ = (queueHead_ + 1) % buffers_;
+            queueCount_--;
+            free_[freeCount_++] = index;
+            if (!failed) {
+                if (ok) {
+                    stats_.written++;
+                    stats_.bytes += headerBytes_ + frameBytes_;
+                } else {
+                    stats_.failed = true;
+                }
+            }
+            freed_.notify_one();
+        }
+    }
+
+    bool Write(const unsigned char* frame) {
+        if (headerBytes_ && fwrite(header_, 1, headerBytes_, out_) != headerBytes_) {
+            return false;
+        }
+        return fwrite(frame, 1, frameBytes_, out_) == frameBytes_ && fflush(out_) == 0;
+    }
+
+    FILE* out_;
+    size_t frameBytes_;
+    const char* header_;
+    size_t headerBytes_;
+    int buffers_;
+    std::vector<unsigned char> pool_; // buffers_ frames back to back
+    std::vector<int> free_;           // Stack of free buffer indices, freeCount_ deep
+    std::vector<int> queue_;          // Ring of submitted indices in frame order
+    int freeCount_;
+    int queueHead_;
+    int queueCount_;
+    bool stopping_;
+    FrameStreamStats stats_;
+    std::mutex mutex_;
+    std::condition_variable submitted_;
+    std::condition_variable freed_;
+    std::thread writer_;
+
+    FrameStream(const FrameStream&);
+    FrameStream& operator=(const FrameStream&);
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_FRAME_STREAM_H
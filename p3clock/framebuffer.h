@@ -0,0 +1,145 @@
+#ifndef P3CLOCK_FRAMEBUFFER_H
+#define P3CLOCK_FRAMEBUFFER_H
+
+// In-memory 32-bit framebuffer for the software renderer.
+//
+// Pixels are 0xAARRGGBB words, row-major with no padding, which is the same
+// layout as a top-down 32 bpp DIB section on Windows.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace p3clock {
+
+typedef uint32_t Argb;
+
+inline Argb MakeArgb(int r, int g, int b) {
+    return 0xFF000000u | ((Argb)r << 16) | ((Argb)g << 8) | (Argb)b;
+}
+
+inline int ArgbRed(Argb c) { return (int)((c >> 16) & 0xFF); }
+inline int ArgbGreen(Argb c) { return (int)((c >> 8) & 0xFF); }
+inline int ArgbBlue(Argb c) { return (int)(c & 0xFF); }
+
+// Same colors as COLOR_BLUE / COLOR_GREEN / COLOR_BLACK in the Win32 programs
+const Argb kArgbBlue = 0xFF00A2E8u;  // RGB(0, 162, 232)
+const Argb kArgbGreen = 0xFF00C800u; // RGB(0, 200, 0)
+const Argb kArgbBlack = 0xFF000000u;
+
+struct Framebuffer {
+    int width;
+    int height;
+    std::vector<Argb> pixels;
+
+    Framebuffer() : width(0), height(0) {}
+
+    // Contents are undefined after a size change
+    void Resize(int w, int h) {
+        if (w < 0) w = 0;
+        if (h < 0) h = 0;
+        width = w;
+        height = h;
+        pixels.resize((size_t)w * h);
+    }
+
+    Argb* Row(int y) { return &pixels[(size_t)y * width]; }
+    const Argb* Row(int y) const { return &pixels[(size_t)y * width]; }
+
+    Argb At(int x, int y) const { return pixels[(size_t)y * width + x]; }
+};
+
+// Pixels in the same format that something else owns, such as the bits of a DIB
+// section, with rows `stride` pixels apart. The drawing functions below take
+// either; PixelPainter (pixel_backend.h) draws into views only.
+struct PixelView {
+    Argb* pixels;
+    int width;
+    int height;
+    int stride;
+
+    Argb* Row(int y) const { return pixels + (size_t)y * stride; }
+};
+
+inline PixelView MakePixelView(void* pixels, int width, int height, int stride) {
+    PixelView view = {(Argb*)pixels, width, height, stride};
+    return view;
+}
+
+inline PixelView ViewOf(Framebuffer* fb) {
+    return MakePixelView(fb->pixels.empty() ? NULL : &fb->pixels[0], fb->width, fb->height, fb->width);
+}
+
+// Only for reading, e.g. as the source of Blit()
+inline PixelView ViewOf(const Framebuffer& fb) {
+    return ViewOf(const_cast<Framebuffer*>(&fb));
+}
+
+// Fill [left, right) x [top, bottom), clipped to the view
+inline void FillRect(const PixelView& view, int left, int top, int right, int bottom, Argb color) {
+    if (left < 0) left = 0;
+    if (top < 0) top = 0;
+    if (right > view.width) right = view.width;
+    if (bottom > view.height) bottom = view.height;
+    for (int y = top; y < bottom; ++y) {
+        Argb* row = view.Row(y);
+        for (int x = left; x < right; ++x) {
+            row[x] = color;
+        }
+    }
+}
+
+inline void FillRect(Framebuffer* fb, int left, int top, int right, int bottom, Argb color) {
+    FillRect(ViewOf(fb), left, top, right, bottom, color);
+}
+
+inline void Clear(Framebuffer* fb, Argb color) {
+    FillRect(fb, 0, 0, fb->width, fb->height, color);
+}
+
+// Copy a w x h block like BitBlt(SRCCOPY), clipped against both views
+inline void Blit(const PixelView& dst, int dstX, int dstY, const PixelView& src, int srcX, int srcY, int w, int h) {
+    if (srcX < 0) { dstX -= srcX; w += srcX; srcX = 0; }
+    if (srcY < 0) { dstY -= srcY; h += srcY; srcY = 0; }
+    if (dstX < 0) { srcX -= dstX; w += dstX; dstX = 0; }
+    if (dstY < 0) { srcY -= dstY; h += dstY; dstY = 0; }
+    if (srcX + w > src.width) w = src.width - srcX;
+    if (srcY + h > src.height) h = src.height - srcY;
+    if (dstX + w > dst.width) w = dst.width - dstX;
+    if (dstY + h > dst.height) h = dst.height - dstY;
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+    for (int y = 0; y < h; ++y) {
+        memcpy(dst.Row(dstY + y) + dstX, src.Row(srcY + y) + srcX, (size_t)w * sizeof(Argb));
+    }
+}
+
+inline void Blit(Framebuffer* dst, int dstX, int dstY, const Framebuffer& src, int srcX, int srcY, int w, int h) {
+    Blit(ViewOf(dst), dstX, dstY, ViewOf(src), srcX, srcY, w, h);
+}
+
+// Write a binary PPM (P6). Alpha is dropped. Returns false on I/O errors.
+inline bool WritePpm(const Framebuffer& fb, FILE* out) {
+    if (fprintf(out, "P6\n%d %d\n255\n", fb.width, fb.height) < 0) {
+        return false;
+    }
+    std::vector<unsigned char> line((size_t)fb.width * 3);
+    for (int y = 0; y < fb.height; ++y) {
+        const Argb* row = fb.Row(y);
+        for (int x = 0; x < fb.width; ++x) {
+            line[x * 3 + 0] = (unsigned char)ArgbRed(row[x]);
+            line[x * 3 + 1] = (unsigned char)ArgbGreen(row[x]);
+            line[x * 3 + 2] = (unsigned char)ArgbBlue(row[x]);
+        }
+        if (!line.empty() && fwrite(&line[0], 1, line.size(), out) != line.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace p3clock
+
+#endif // P3CLOCK_FRAMEBUFFER_H
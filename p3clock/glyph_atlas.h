@@ -0,0 +1,140 @@
+#ifndef P3CLOCK_GLYPH_ATLAS_H
+#define P3CLOCK_GLYPH_ATLAS_H
+
+// Pre-rasterized glyph atlas for the digital clock.
+//
+// The ten digits and ':' are rendered once per font size, in both clock
+// colors, into an atlas laid out as two rows of cells (row 0 blue, row 1 the
+// midnight green). Digits share one fixed advance so every character of
+// "HH:MM:SS" sits at a position that does not depend on the time, and each
+// frame becomes eight copies from the atlas.
+//
+// The code here only does the layout. Measuring and drawing glyphs is left to
+// a GlyphSource, any type with:
+//     int Advance(char c);                            // advance width in pixels
+//     int Height();                                   // line height in pixels
+//     void Render(char c, int row, int x, int y);     // draw c with its cell's top-left at (x, y)
+// so the same layout runs on GDI and on a software glyph source.
+
+#include "clock_geometry.h"
+#include "damage.h"
+
+namespace p3clock {
+
+const int kAtlasGlyphCount = 11; // "0123456789:"
+const int kAtlasRowCount = 2;    // Row 0 blue, row 1 midnight green
+const char kAtlasGlyphs[kAtlasGlyphCount + 1] = "0123456789:";
+
+inline int AtlasGlyphIndex(char c) {
+    return c == ':' ? 10 : c - '0';
+}
+
+// Atlas row for the color the clock uses at time t
+inline int AtlasRow(const ClockTime& t) {
+    return IsGreenHour(t) ? 1 : 0;
+}
+
+struct GlyphAtlasLayout {
+    int cellHeight;
+    int cellWidth[kAtlasGlyphCount];  // Fixed advance: every digit gets the widest digit's advance
+    int glyphX[kAtlasGlyphCount];     // Offset that centers the glyph inside its cell
+    int cellX[kAtlasGlyphCount];      // Left edge of the cell inside the atlas
+    int width;                        // Atlas size in pixels
+    int height;
+};
+
+template <class GlyphSource>
+GlyphAtlasLayout MakeGlyphAtlasLayout(GlyphSource& source) {
+    GlyphAtlasLayout layout;
+    int advance[kAtlasGlyphCount];
+    int digitAdvance = 0;
+    for (int i = 0; i < kAtlasGlyphCount; ++i) {
+        advance[i] = source.Advance(kAtlasGlyphs[i]);
+        if (i < 10 && advance[i] > digitAdvance) {
+            digitAdvance = advance[i];
+        }
+    }
+    layout.cellHeight = source.Height();
+    layout.width = 0;
+    for (int i = 0; i < kAtlasGlyphCount; ++i) {
+        layout.cellWidth[i] = i < 10 ? digitAdvance : advance[i];
+        layout.glyphX[i] = (layout.cellWidth[i] - advance[i]) / 2;
+        layout.cellX[i] = layout.width;
+        layout.width += layout.cellWidth[i];
+    }
+    layout.height = layout.cellHeight * kAtlasRowCount;
+    return layout;
+}
+
+// Draw every glyph in both rows. The caller has cleared the atlas to the background color
+// and selects the row's color inside source.Render().
+template <class GlyphSource>
+void RenderGlyphAtlas(GlyphSource& source, const GlyphAtlasLayout& layout) {
+    for (int row = 0; row < kAtlasRowCount; ++row) {
+        for (int i = 0; i < kAtlasGlyphCount; ++i) {
+            source.Render(kAtlasGlyphs[i], row, layout.cellX[i] + layout.glyphX[i], row * layout.cellHeight);
+        }
+    }
+}
+
+// Where "HH:MM:SS" goes when centered in a rectangle (like DT_CENTER | DT_VCENTER)
+struct TimeTextLayout {
+    int charX[8];
+    int top;
+    int width;
+};
+
+inline TimeTextLayout LayoutTimeText(const GlyphAtlasLayout& atlas, int left, int top, int right, int bottom) {
+    // Any time string has the same cell widths, so "00:00:00" stands in for all of them
+    const char sample[8] = {'0', '0', ':', '0', '0', ':', '0', '0'};
+    TimeTextLayout text;
+    text.width = 0;
+    for (int i = 0; i < 8; ++i) {
+        text.width += atlas.cellWidth[AtlasGlyphIndex(sample[i])];
+    }
+    int x = left + ((right - left) - text.width) / 2;
+    for (int i = 0; i < 8; ++i) {
+        text.charX[i] = x;
+        x += atlas.cellWidth[AtlasGlyphIndex(sample[i])];
+    }
+    text.top = top + ((bottom - top) - atlas.cellHeight) / 2;
+    return text;
+}
+
+struct GlyphBlit {
+    int dstX;
+    int dstY;
+    int srcX;
+    int srcY;
+    int width;
+    int height;
+};
+
+// The eight atlas copies that draw time t
+inline void TimeTextBlits(const GlyphAtlasLayout& atlas, const TimeTextLayout& text, const ClockTime& t, GlyphBlit out[8]) {
+    char chars[8];
+    FormatTime(t, chars);
+    int row = AtlasRow(t);
+    for (int i = 0; i < 8; ++i) {
+        int glyph = AtlasGlyphIndex(chars[i]);
+        out[i].dstX = text.charX[i];
+        out[i].dstY = text.top;
+        out[i].srcX = atlas.cellX[glyph];
+        out[i].srcY = row * atlas.cellHeight;
+        out[i].width = atlas.cellWidth[glyph];
+        out[i].height = atlas.cellHeight;
+    }
+}
+
+// Character cells for the damage tracker. Glyphs never leave their cell, so no margin is needed.
+inline DigitalLayout DigitalLayoutFromText(const GlyphAtlasLayout& atlas, const TimeTextLayout& text) {
+    int extents[8];
+    for (int i = 0; i < 8; ++i) {
+        extents[i] = text.charX[i] - text.charX[0] + atlas.cellWidth[AtlasGlyphIndex(i == 2 || i == 5 ? ':' : '0')];
+    }
+    return MakeDigitalLayout(text.charX[0], text.top, atlas.cellHeight, extents, 0);
+}
+
+} // namespace p3clock
+
+#endif // P3CLOCK_GLYPH_ATLAS_H
@@ -0,0 +1,127 @@
+#ifndef P3CLOCK_GOLDEN_H
+#define P3CLOCK_GOLDEN_H
+
+// Golden frames: rendered once, looked at, and stored so later builds can be
+// compared against them.
+//
+// Clock frames are long runs of one color (the background, the face, the
+// inside of the digits), so goldens are stored run-length encoded instead of
+// as PPM. The file is a text header "P3RLE\n<width> <height>\n" followed by
+// runs of 4 bytes: length - 1 (runs are 1 to 256 pixels and may cross rows),
+// then red, green and blue. Alpha is not stored; every rendered pixel is
+// opaque. An 800x400 frame takes about 30 KB instead of 960 KB.
+//
+// CompareFrames() allows a small per-channel difference, so a golden survives
+// a compiler or SIMD kernel that rounds an edge pixel the other way, while a
+// hand at the wrong angle or a missing digit still fails.
+
+#include <stdio.h>
+#include <vector>
+
+#include "framebuffer.h"
+
+namespace p3clock {
+
+const int kGoldenMaxRun = 256;
+
+// Write fb as a golden. Returns false on I/O errors.
+inline bool WriteGolden(const Framebuffer& fb, FILE* out) {
+    if (fprintf(out, "P3RLE\n%d %d\n", fb.width, fb.height) < 0) {
+        return false;
+    }
+    std::vector<unsigned char> runs;
+    size_t count = fb.pixels.size();
+    for (size_t i = 0; i < count;) {
+        Argb color = fb.pixels[i] & 0x00FFFFFFu;
+        size_t end = i + 1;
+        while (end < count && end - i < (size_t)kGoldenMaxRun && (fb.pixels[end] & 0x00FFFFFFu) == color) {
+            ++end;
+        }
+        runs.push_back((unsigned char)(end - i - 1));
+        runs.push_back((unsigned char)ArgbRed(color));
+        runs.push_back((unsigned char)ArgbGreen(color));
+        runs.push_back((unsigned char)ArgbBlue(color));
+        i = end;
+    }
+    return runs.empty() || fwrite(&runs[0], 1, runs.size(), out) == runs.size();
+}
+
+// Read a golden written by WriteGolden(). Returns false when the file is not one or is truncated.
+inline bool ReadGolden(FILE* in, Framebuffer* fb) {
+    int width, height;
+    if (fscanf(in, "P3RLE %d %d", &width, &height) != 2 || width < 0 || height < 0 || fgetc(in) != '\n') {
+        return false;
+    }
+    fb->Resize(width, height);
+    size_t count = fb->pixels.size();
+    for (size_t i = 0; i < count;) {
+        unsigned char run[4];
+        if (fread(run, 1, 4, in) != 4) {
+            return false;
+        }
+        size_t length = (size_t)run[0] + 1;
+        if (length > count - i) {
+            return false;
+        }
+        Argb color = MakeArgb(run[1], run[2], run[3]);
+        for (size_t end = i + length; i < end; ++i) {
+            fb->pixels[i] = color;
+        }
+    }
+    return fgetc(in) == EOF;
+}
+
+struct FrameDiff {
+    bool sameSize;
+    long long pixels;    // Pixels compared
+    long long differing; // Pixels with a channel off by more than the tolerance
+    long long inexact;   // Pixels that differ at all, within the tolerance or not
+    int maxChannelDiff;  // Largest difference of one channel
+};
+
+inline int ChannelDiff(int a, int b) {
+    return a > b ? a - b : b - a;
+}
+
+// Compare actual with expected, allowing `tolerance` per channel. When diff is given it receives
+// an image of the differences: the expected frame darkened, pixels within the tolerance yellow
+// and pixels beyond it red.
+inline FrameDiff CompareFrames(const Framebuffer& expected, const Framebuffer& actual, int tolerance,
+                               Framebuffer* diff) {
+    FrameDiff d;
+    d.sameSize = expected.width == actual.width && expected.height == actual.height;
+    d.pixels = (long long)(d.sameSize || expected.pixels.size() > actual.pixels.size() ? expected.pixels.size()
+                                                                                        : actual.pixels.size());
+    d.differing = d.inexact = 0;
+    d.maxChannelDiff = 0;
+    if (!d.sameSize) {
+        d.differing = d.inexact = d.pixels;
+        d.maxChannelDiff = 255;
+        return d;
+    }
+    if (diff) {
+        diff->Resize(expected.width, expected.height);
+    }
+    for (size_t i = 0; i < expected.pixels.size(); ++i) {
+        Argb e = expected.pixels[i];
+        Argb a = actual.pixels[i];
+        int channel = ChannelDiff(ArgbRed(e), ArgbRed(a));
+        int green = ChannelDiff(ArgbGreen(e), ArgbGreen(a));
+        int blue = ChannelDiff(ArgbBlue(e), ArgbBlue(a));
+        if (green > channel) channel = green;
+        if (blue > channel) channel = blue;
+        if (channel > d.maxChannelDiff) d.maxChannelDiff = channel;
+        if (channel > 0) d.inexact++;
+        if (channel > tolerance) d.differing++;
+        if (diff) {
+            diff->pixels[i] = channel > tolerance ? MakeArgb(255, 0, 0)
+                              : channel > 0       ? MakeArgb(255, 255, 0)
+                                                  : MakeArgb(ArgbRed(e) / 4, ArgbGreen(e) / 4, ArgbBlue(e) / 4);
+        }
+    }
+    return d;
+}
+
+} // namespace p3clock
+
+#endif // P3CLOCK_GOLDEN_H
@@ -0,0 +1,287 @@
+#ifndef P3CLOCK_PAINT_TRACE_H
+#define P3CLOCK_PAINT_TRACE_H
+
+// Where the paint time goes: phase timers for WM_PAINT.
+//
+// A ScopedPhase brackets one phase of a paint (the background, the face ring,
+// the numerals, the hands, the text, the final BitBlt); a kPhaseFrame scope
+// brackets the whole paint. Every finished phase becomes one event in a ring
+// holding the last kPaintTraceCapacity events, which WriteChromeTrace() writes
+// as Chrome trace_event JSON (chrome://tracing, Perfetto) whenever asked.
+// The HUD's frame times (the last frame and the p99 of the recent ones) are
+// kept by FrameTimeWindow, which is always compiled in: ClockCore records
+// whole paints into it while the HUD is shown, traced or not.
+//
+// Recording takes no lock. A writer claims a slot with one atomic increment
+// and publishes it with the slot's sequence number (a seqlock), so the tile
+// jobs of a thread pool can record too; a reader copying a slot that is being
+// rewritten sees the sequence change and skips it.
+//
+// Tracing is only compiled in with P3CLOCK_PAINT_TRACE defined to 1. Without
+// it PaintTracer is an empty class whose calls inline to nothing, and the
+// instrumented paint code compiles to the same code as without the scopes.
+//
+// The clock is a template parameter with
+//     double NowMs(); // steady counter in milliseconds, sub-millisecond resolution
+
+#include <stdio.h>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifndef P3CLOCK_PAINT_TRACE
+#define P3CLOCK_PAINT_TRACE 0
+#endif
+
+namespace p3clock {
+
+enum PaintPhase {
+    kPhaseFrame,      // The whole paint
+    kPhaseResize,     // Rebuild for a new window size (fonts, surfaces, atlas)
+    kPhaseBackground, // FillRect, or the copy of the cached face layer
+    kPhaseFace,       // Face ring (Ellipse), when the face is drawn or rebuilt
+    kPhaseNumerals,   // Roman numerals, when the face is drawn or rebuilt
+    kPhaseHands,
+    kPhaseText,       // Digits: glyph atlas copies or DrawText
+    kPhasePresent,    // Copy of the finished frame to the window (BitBlt)
+    kPaintPhaseCount
+};
+
+const char* const kPaintPhaseNames[kPaintPhaseCount] = {
+    "frame", "resize", "background", "face", "numerals", "hands", "text", "present"
+};
+
+const int kPaintTraceCapacity = 4096; // Events kept; a power of two
+const int kPaintTraceFrames = 128;    // Frames in the HUD's p99
+
+struct PhaseEvent {
+    unsigned frame;    // Frames finished before this phase ended
+    int phase;         // PaintPhase
+    int lane;          // Thread that recorded it: 0 = the paint thread, tile workers count up
+    double startMs;    // Clock time
+    double durationMs;
+};
+
+// 32-bit atomics that also build as C++98 (Visual C++ before 2012, old MinGW)
+#if defined(_MSC_VER)
+inline unsigned TraceFetchAdd(volatile unsigned* p, unsigned v) {
+    return (unsigned)_InterlockedExchangeAdd((volatile long*)p, (long)v);
+}
+// x86 and x64 only reorder stores after loads: stopping the compiler is enough for acquire and release
+inline void TraceStoreRelease(volatile unsigned* p, unsigned v) { _ReadWriteBarrier(); *p = v; }
+inline unsigned TraceLoadAcquire(const volatile unsigned* p) { unsigned v = *p; _ReadWriteBarrier(); return v; }
+inline void TraceFenceRelease() { _ReadWriteBarrier(); }
+inline void TraceFenceAcquire() { _ReadWriteBarrier(); }
+#else
+inline unsigned TraceFetchAdd(volatile unsigned* p, unsigned v) { return __atomic_fetch_add(p, v, __ATOMIC_RELAXED); }
+inline void TraceStoreRelease(volatile unsigned* p, unsigned v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+inline unsigned TraceLoadAcquire(const volatile unsigned* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+inline void TraceFenceRelease() { __atomic_thread_fence(__ATOMIC_RELEASE); }
+inline void TraceFenceAcquire() { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+#endif
+
+// Fixed ring of the last kPaintTraceCapacity events, any number of writers and readers
+class PhaseRing {
+public:
+    PhaseRing() : next_(0) {
+        for (int i = 0; i < kPaintTraceCapacity; ++i) {
+            slots_[i].sequence = 0;
+        }
+    }
+
+    void Record(const PhaseEvent& e) {
+        unsigned index = TraceFetchAdd(&next_, 1);
+        Slot& slot = slots_[index & (kPaintTraceCapacity - 1)];
+        // Odd while the event is written, then 2 * (index + 1): readers match it against the index they want
+        TraceStoreRelease(&slot.sequence, index * 2 + 1);
+        TraceFenceRelease();
+        slot.event = e;
+        TraceStoreRelease(&slot.sequence, index * 2 + 2);
+    }
+
+    // Events recorded so far (including those the ring has dropped)
+    unsigned Recorded() const { return TraceLoadAcquire(&next_); }
+
+    // Copy up to max of the newest complete events, oldest first. Returns the count.
+    int Snapshot(PhaseEvent* out, int max) const {
+        unsigned end = TraceLoadAcquire(&next_);
+        unsigned count = end < (unsigned)kPaintTraceCapacity ? end : (unsigned)kPaintTraceCapacity;
+        if (count > (unsigned)max) count = (unsigned)max;
+        int copied = 0;
+        for (unsigned index = end - count; index != end; ++index) {
+            const Slot& slot = slots_[index & (kPaintTraceCapacity - 1)];
+            unsigned before = TraceLoadAcquire(&slot.sequence);
+            if (before != index * 2 + 2) {
+                continue; // Still being written, or already reused for a newer event
+            }
+            PhaseEvent e = slot.event;
+            TraceFenceAcquire();
+            if (TraceLoadAcquire(&slot.sequence) == before) {
+                out[copied++] = e;
+            }
+        }
+        return copied;
+    }
+
+private:
+    struct Slot {
+        volatile unsigned sequence;
+        PhaseEvent event;
+    };
+
+    volatile unsigned next_; // Index of the next event; wraps after 2^32 events, which the mask ignores
+    Slot slots_[kPaintTraceCapacity];
+
+    PhaseRing(const PhaseRing&);
+    PhaseRing& operator=(const PhaseRing&);
+};
+
+// The last kPaintTraceFrames frame times, for the HUD. Frames are painted on one thread: no atomics.
+class FrameTimeWindow {
+public:
+    FrameTimeWindow() : frames_(0) {
+        for (int i = 0; i < kPaintTraceFrames; ++i) {
+            frameMs_[i] = 0.0;
+        }
+    }
+
+    void Record(double ms) {
+        frameMs_[frames_ % kPaintTraceFrames] = ms;
+        frames_++;
+    }
+
+    unsigned Frames() const { return frames_; }
+    double LastFrameMs() const { return frames_ ? frameMs_[(frames_ - 1) % kPaintTraceFrames] : 0.0; }
+
+    // Nearest-rank p99 of the last kPaintTraceFrames frames
+    double P99FrameMs() const {
+        int count = frames_ < (unsigned)kPaintTraceFrames ? (int)frames_ : kPaintTraceFrames;
+        if (count == 0) {
+            return 0.0;
+        }
+        double sorted[kPaintTraceFrames];
+        std::copy(frameMs_, frameMs_ + count, sorted);
+        std::sort(sorted, sorted + count);
+        int rank = (int)(count * 0.99 + 0.999999);
+        return sorted[(rank < 1 ? 1 : rank) - 1];
+    }
+
+    // HUD line "4.21 ms  p99 6.03 ms". False before the first frame.
+    bool FormatHud(char* out, int size) const {
+        if (frames_ == 0) {
+            return false;
+        }
+#if defined(_MSC_VER) && _MSC_VER < 1900
+        int written = _snprintf(out, (size_t)size, "%.2f ms  p99 %.2f ms", LastFrameMs(), P99FrameMs());
+        out[size - 1] = 0; // _snprintf does not terminate a truncated string
+#else
+        int written = snprintf(out, (size_t)size, "%.2f ms  p99 %.2f ms", LastFrameMs(), P99FrameMs());
+#endif
+        return written > 0;
+    }
+
+private:
+    unsigned frames_;
+    double frameMs_[kPaintTraceFrames]; // Frame times by frame number modulo the window
+};
+
+template <class Clock, bool Enabled = (P3CLOCK_PAINT_TRACE != 0)>
+class PaintTracer {
+public:
+    static const bool kEnabled = true;
+
+    explicit PaintTracer(Clock* clock) : clock_(clock) {}
+
+    // Start of a phase
+    double Begin() { return clock_->NowMs(); }
+
+    // End of a phase that began at startMs. Ending kPhaseFrame finishes the frame.
+    void End(PaintPhase phase, double startMs, int lane = 0) {
+        PhaseEvent e;
+        e.frame = frameTimes_.Frames();
+        e.phase = phase;
+        e.lane = lane;
+        e.startMs = startMs;
+        e.durationMs = clock_->NowMs() - startMs;
+        ring_.Record(e);
+        if (phase == kPhaseFrame) {
+            frameTimes_.Record(e.durationMs);
+        }
+    }
+
+    unsigned Frames() const { return frameTimes_.Frames(); }
+    const FrameTimeWindow& FrameTimes() const { return frameTimes_; } // Every traced frame
+
+    const PhaseRing& Ring() const { return ring_; }
+
+    // The events in the ring as Chrome trace_event JSON: one complete ("X") event per phase, on
+    // one row per lane. Returns false on I/O errors.
+    bool WriteChromeTrace(FILE* out) const {
+        PhaseEvent* events = new PhaseEvent[kPaintTraceCapacity];
+        int count = ring_.Snapshot(events, kPaintTraceCapacity);
+        bool ok = fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [", out) >= 0;
+        for (int i = 0; i < count && ok; ++i) {
+            const PhaseEvent& e = events[i];
+            ok = fprintf(out, "%s\n  {\"name\": \"%s\", \"cat\": \"paint\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                              "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"frame\": %u}}",
+                         i ? "," : "", kPaintPhaseNames[e.phase], e.lane, e.startMs * 1000.0, e.durationMs * 1000.0,
+                         e.frame) > 0;
+        }
+        ok = ok && fputs("\n]}\n", out) >= 0;
+        delete[] events;
+        return ok;
+    }
+
+private:
+    Clock* clock_;
+    PhaseRing ring_;
+    FrameTimeWindow frameTimes_;
+
+    PaintTracer(const PaintTracer&);
+    PaintTracer& operator=(const PaintTracer&);
+};
+
+// Tracing compiled out: nothing is stored and every call is empty
+template <class Clock>
+class PaintTracer<Clock, false> {
+public:
+    static const bool kEnabled = false;
+
+    PaintTracer() {}
+    explicit PaintTracer(Clock*) {}
+
+    double Begin() { return 0.0; }
+    void End(PaintPhase, double, int = 0) {}
+    unsigned Frames() const { return 0; }
+    bool WriteChromeTrace(FILE*) const { return false; }
+};
+
+struct NullTraceClock {
+    double NowMs() { return 0.0; }
+};
+
+typedef PaintTracer<NullTraceClock, false> NullPaintTracer;
+
+// Times one phase from construction to the end of the scope
+template <class Tracer>
+class ScopedPhase {
+public:
+    ScopedPhase(Tracer* tracer, PaintPhase phase, int lane = 0)
+        : tracer_(tracer), phase_(phase), lane_(lane), startMs_(tracer->Begin()) {}
+    ~ScopedPhase() { tracer_->End(phase_, startMs_, lane_); }
+
+private:
+    Tracer* tracer_;
+    PaintPhase phase_;
+    int lane_;
+    double startMs_;
+
+    ScopedPhase(const ScopedPhase&);
+    ScopedPhase& operator=(const ScopedPhase&);
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_PAINT_TRACE_H
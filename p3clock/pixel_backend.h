@@ -0,0 +1,161 @@
+#ifndef P3CLOCK_PIXEL_BACKEND_H
+#define P3CLOCK_PIXEL_BACKEND_H
+
+// The drawing half of a ClockCore backend (clock_core.h) in plain pixels: no
+// GDI call between BeginPaint and the final copy to the window.
+//
+// The face layer and the glyph atlas are Framebuffers the program owns, drawn
+// with the software renderer's rasterizers (the stroke font stands in for
+// Arial). A paint draws into a PixelView, which on Windows is the bits of the
+// back buffer's DIB section (p3clock-win32/dib_backend.h) and in p3timec-check
+// is a Framebuffer, so both run this exact code. Every frame comes out pixel
+// for pixel like SoftClockRenderer::Render, which is what its core check checks.
+//
+// A backend keeps its window half (timers, invalidation, BeginPaint) and
+// forwards Resize's fonts and atlas, FaceReady, BuildFace, Fill, CopyFace,
+// DrawHands, DrawDigits and DrawHud to a PixelPainter, with PixelTarget as
+// its Surface.
+//
+// The background is black like the windows', or kArgbTransparent
+// (composite.h) for the overlay: the rasterizers blend every channel, alpha
+// included, so the frame then comes out in premultiplied ARGB.
+
+#include <ctype.h>
+
+#include "paint_trace.h"
+#include "soft_clock.h"
+#include "time_source.h"
+
+namespace p3clock {
+
+// Where a paint draws: the pixels, clipped to the paint rectangle like a DC
+struct PixelTarget {
+    PixelView view;
+    DamageRect clip;
+};
+
+inline PixelTarget MakePixelTarget(const PixelView& view, const DamageRect& paint) {
+    DamageRect bounds = {0, 0, view.width, view.height};
+    PixelTarget target = {view, Intersect(paint, bounds)};
+    return target;
+}
+
+const int kHudFontSize = 12;
+const Argb kArgbHud = 0xFFA0A0A0u; // RGB(160, 160, 160), the GDI HUD's grey
+
+class PixelPainter {
+public:
+    explicit PixelPainter(Argb background = kArgbBlack)
+        : background_(background), faceColor_(0), faceBuilds_(0), atlasBuilds_(0) {}
+
+    Argb Background() const { return background_; }
+
+    // The glyph atlas at the digital font size, and where "HH:MM:SS" goes in g.digitalRect
+    DigitalLayout Resize(const ClockGeometry& g) {
+        DigitalLayout digital;
+        digital.enabled = false;
+        if (g.hasDigital) {
+            atlasLayout_ = BuildTimeGlyphAtlas(&atlas_, g.fontSize, background_);
+            atlasBuilds_++;
+            const DamageRect& r = g.digitalRect;
+            textLayout_ = LayoutTimeText(atlasLayout_, r.left, r.top, r.right, r.bottom);
+            digital = DigitalLayoutFromText(atlasLayout_, textLayout_);
+        }
+        return digital;
+    }
+
+    bool FaceReady(const ClockGeometry& g, Argb color) const {
+        return faceColor_ == color && face_.width == g.width && face_.height == g.height;
+    }
+
+    template <class Tracer>
+    void BuildFace(const ClockGeometry& g, Argb color, Tracer* tracer) {
+        faceBuilds_++;
+        face_.Resize(g.width, g.height);
+        DamageRect all = {0, 0, g.width, g.height};
+        {
+            ScopedPhase<Tracer> phase(tracer, kPhaseFace);
+            DrawClockFaceRing(&face_, g, color, all, background_);
+        }
+        ScopedPhase<Tracer> phase(tracer, kPhaseNumerals);
+        DrawClockNumerals(&face_, g, color);
+        faceColor_ = color;
+    }
+
+    void Fill(const PixelTarget& target, const DamageRect& r) {
+        DamageRect c = Intersect(r, target.clip);
+        FillRect(target.view, c.left, c.top, c.right, c.bottom, background_);
+    }
+
+    void CopyFace(const PixelTarget& target, const DamageRect& r) {
+        DamageRect c = Intersect(r, target.clip);
+        Blit(target.view, c.left, c.top, ViewOf(face_), c.left, c.top, c.right - c.left, c.bottom - c.top);
+    }
+
+    void DrawHands(const PixelTarget& target, const ClockGeometry& g, const DamageRect& clip, const LocalTime& t,
+                   bool sweep, Argb color) {
+        DrawClockHands(target.view, g.analog, 0, 0, t.time, t.millisecond, sweep, color,
+                       Intersect(clip, target.clip));
+    }
+
+    // Eight copies from the atlas; the cells carry the background and both colors
+    void DrawDigits(const PixelTarget& target, const ClockGeometry&, const LocalTime& t, Argb) {
+        GlyphBlit blits[8];
+        TimeTextBlits(atlasLayout_, textLayout_, t.time, blits);
+        PixelView atlas = ViewOf(atlas_);
+        for (int i = 0; i < 8; ++i) {
+            DamageRect dst = {blits[i].dstX, blits[i].dstY, blits[i].dstX + blits[i].width,
+                              blits[i].dstY + blits[i].height};
+            DamageRect r = Intersect(dst, target.clip);
+            if (!IsEmpty(r)) {
+                Blit(target.view, r.left, r.top, atlas, blits[i].srcX + r.left - dst.left,
+                     blits[i].srcY + r.top - dst.top, r.right - r.left, r.bottom - r.top);
+            }
+        }
+    }
+
+    // The line in grey on opaque black, also in the overlay. The stroke font has capitals only, hence "1.25 MS  P99 2.50 MS".
+    void DrawHud(const PixelTarget& target, const DamageRect& rect, const char* text) {
+        hud_.Resize(rect.right - rect.left, rect.bottom - rect.top);
+        Clear(&hud_, kArgbBlack);
+        int x = 2;
+        int y = (hud_.height - StrokeLineHeight(kHudFontSize)) / 2;
+        for (; *text && x < hud_.width; ++text) {
+            char c = (char)toupper((unsigned char)*text);
+            DrawStrokeGlyph(&hud_, c, x, y, kHudFontSize, kStrokeNormal, kArgbHud);
+            x += StrokeAdvance(c, kHudFontSize);
+        }
+        DamageRect c = Intersect(rect, target.clip);
+        Blit(target.view, c.left, c.top, ViewOf(hud_), c.left - rect.left, c.top - rect.top, c.right - c.left,
+             c.bottom - c.top);
+    }
+
+    // WM_DESTROY: give the memory back
+    void Release() {
+        face_ = Framebuffer();
+        atlas_ = Framebuffer();
+        hud_ = Framebuffer();
+        faceColor_ = 0;
+    }
+
+    long long FaceBuilds() const { return faceBuilds_; }
+    long long AtlasBuilds() const { return atlasBuilds_; }
+
+    // Bytes held by the face layer, the atlas and the HUD line
+    size_t Bytes() const { return (face_.pixels.size() + atlas_.pixels.size() + hud_.pixels.size()) * sizeof(Argb); }
+
+private:
+    Argb background_;
+    Framebuffer face_; // Background, face border and Roman numerals; changes with the size or the color
+    Argb faceColor_;   // 0 = face layer not built
+    Framebuffer atlas_; // Digits and ':' in both colors, rebuilt with the font size
+    GlyphAtlasLayout atlasLayout_;
+    TimeTextLayout textLayout_;
+    Framebuffer hud_;
+    long long faceBuilds_;
+    long long atlasBuilds_;
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_PIXEL_BACKEND_H
@@ -0,0 +1,194 @@
+#ifndef P3CLOCK_RASTER_CIRCLE_H
+#define P3CLOCK_RASTER_CIRCLE_H
+
+// Anti-aliased ring and disc rasterizer for the clock face border.
+//
+// Coverage is analytic, with the same 1-pixel ramp as raster_line.h:
+//     cov = clamp(outer + 0.5 - d, 0, 1) - clamp(inner + 0.5 - d, 0, 1)
+// where d is the distance from the pixel center to the circle center. Each
+// row is split into spans: the two edge ramps per circle are evaluated with
+// the scalar / SSE2 / AVX2 kernels, the solid part of the ring is filled with
+// the color and the hole is not touched, so every pixel is written once.
+
+#include <math.h>
+#include <stdint.h>
+
+#include "damage.h"
+#include "simd.h"
+
+namespace p3clock {
+
+// Per-ring constants shared by all kernels
+struct RingSetup {
+    float cx, cy;
+    float outerEdge; // outer + 0.5
+    float innerEdge; // inner + 0.5, or -1 for a disc (no inner term)
+    uint32_t color;
+};
+
+// Coverage of pixel center (px, py) in 1/256 units
+inline uint32_t RingCoverage(const RingSetup& s, float px, float py) {
+    float ex = px - s.cx;
+    float ey = py - s.cy;
+    float d = sqrtf(ex * ex + ey * ey);
+    float outer = s.outerEdge - d;
+    float inner = s.innerEdge - d;
+    outer = outer < 0.0f ? 0.0f : (outer > 1.0f ? 1.0f : outer);
+    inner = inner < 0.0f ? 0.0f : (inner > 1.0f ? 1.0f : inner);
+    return CoverageToAlpha(outer - inner);
+}
+
+inline void RingSpanScalar(uint32_t* row, int from, int to, float py, const RingSetup& s) {
+    for (int x = from; x < to; ++x) {
+        uint32_t a = RingCoverage(s, x + 0.5f, py);
+        if (a) {
+            row[x] = BlendPixel(row[x], s.color, a);
+        }
+    }
+}
+
+#if defined(P3CLOCK_X86_SIMD)
+
+P3CLOCK_TARGET("sse2")
+inline void RingSpanSse2(uint32_t* row, int from, int to, float py, const RingSetup& s) {
+    const __m128 cx = _mm_set1_ps(s.cx);
+    const __m128 outerEdge = _mm_set1_ps(s.outerEdge), innerEdge = _mm_set1_ps(s.innerEdge);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    const float ey = py - s.cy;
+    const __m128 ey2 = _mm_set1_ps(ey * ey);
+    __m128 px = _mm_add_ps(_mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f), _mm_set1_ps((float)from));
+
+    int x = from;
+    for (; x + 4 <= to; x += 4, px = _mm_add_ps(px, _mm_set1_ps(4.0f))) {
+        __m128 ex = _mm_sub_ps(px, cx);
+        __m128 d = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ex, ex), ey2));
+        __m128 outer = _mm_min_ps(_mm_max_ps(_mm_sub_ps(outerEdge, d), zero), one);
+        __m128 inner = _mm_min_ps(_mm_max_ps(_mm_sub_ps(innerEdge, d), zero), one);
+        BlendPixels4(row + x, CoverageToAlpha4(_mm_sub_ps(outer, inner)), s.color);
+    }
+    RingSpanScalar(row, x, to, py, s);
+}
+
+P3CLOCK_TARGET("avx2")
+inline void RingSpanAvx2(uint32_t* row, int from, int to, float py, const RingSetup& s) {
+    const __m256 cx = _mm256_set1_ps(s.cx);
+    const __m256 outerEdge = _mm256_set1_ps(s.outerEdge), innerEdge = _mm256_set1_ps(s.innerEdge);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    const float ey = py - s.cy;
+    const __m256 ey2 = _mm256_set1_ps(ey * ey);
+    __m256 px = _mm256_add_ps(_mm256_set_ps(7.5f, 6.5f, 5.5f, 4.5f, 3.5f, 2.5f, 1.5f, 0.5f), _mm256_set1_ps((float)from));
+
+    int x = from;
+    for (; x + 8 <= to; x += 8, px = _mm256_add_ps(px, _mm256_set1_ps(8.0f))) {
+        // Same arithmetic as the scalar kernel (no FMA) so the kernels agree bit for bit
+        __m256 ex = _mm256_sub_ps(px, cx);
+        __m256 d = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(ex, ex), ey2));
+        __m256 outer = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(outerEdge, d), zero), one);
+        __m256 inner = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(innerEdge, d), zero), one);
+        BlendPixels8(row + x, CoverageToAlpha8(_mm256_sub_ps(outer, inner)), s.color);
+    }
+    RingSpanSse2(row, x, to, py, s);
+}
+
+#endif // P3CLOCK_X86_SIMD
+
+// Pixels [*from, *to) whose centers lie within `radius` of cx on a row ey away from the
+// center. An empty span collapses onto the pixel nearest cx, which lies inside every
+// non-empty span, so the spans of concentric circles stay nested.
+inline void CircleSpan(float cx, float ey, float radius, int* from, int* to) {
+    float h2 = radius * radius - ey * ey;
+    int nearest = (int)floorf(cx);
+    if (radius <= 0.0f || h2 <= 0.0f) {
+        *from = *to = nearest;
+        return;
+    }
+    float h = sqrtf(h2);
+    *from = (int)ceilf(cx - h - 0.5f);
+    *to = (int)floorf(cx + h - 0.5f) + 1;
+    if (*from >= *to) {
+        *from = *to = nearest;
+    }
+}
+
+// Draw an anti-aliased ring between radii `inner` and `outer` around (cx, cy); inner <= 0
+// draws a filled disc. Pixel (x, y) has its center at (x + 0.5, y + 0.5). Only pixels inside
+// `clip` are touched; clip must lie within the buffer. Returns the number of pixels written
+// or evaluated.
+inline long long DrawAARing(uint32_t* pixels, int stride, const DamageRect& clip,
+                            float cx, float cy, float outer, float inner, uint32_t color,
+                            SimdLevel kernel = kSimdAuto) {
+    RingSetup s;
+    s.cx = cx;
+    s.cy = cy;
+    s.outerEdge = outer + 0.5f;
+    s.innerEdge = inner > 0.0f ? inner + 0.5f : -1.0f;
+    s.color = color;
+
+    // Spans use a full pixel of margin around each ramp so float rounding never moves a
+    // pixel with partial coverage into the filled or skipped parts
+    float reach = outer + 1.0f;
+    float solidOuter = outer - 1.0f;
+    float solidInner = inner > 0.0f ? inner + 1.0f : 0.0f;
+    float hole = inner - 1.0f;
+
+    int top = (int)floorf(cy - reach), bottom = (int)ceilf(cy + reach);
+    if (top < clip.top) top = clip.top;
+    if (bottom > clip.bottom) bottom = clip.bottom;
+
+    SimdLevel k = ResolveSimdLevel(kernel);
+    long long touched = 0;
+    for (int y = top; y < bottom; ++y) {
+        float py = y + 0.5f;
+        float ey = py - cy;
+        // Nested spans, left to right: ramp | solid | inner ramp | hole | inner ramp | solid | ramp
+        int x[8];
+        CircleSpan(cx, ey, reach, &x[0], &x[7]);
+        CircleSpan(cx, ey, solidOuter, &x[1], &x[6]);
+        CircleSpan(cx, ey, solidInner, &x[2], &x[5]);
+        CircleSpan(cx, ey, hole, &x[3], &x[4]);
+        if (x[1] > x[2]) {
+            // Ring thinner than the margins: no solid part, evaluate everything outside the hole
+            x[1] = x[2];
+            x[6] = x[5];
+        }
+        for (int i = 0; i < 8; ++i) {
+            x[i] = x[i] < clip.left ? clip.left : (x[i] > clip.right ? clip.right : x[i]);
+        }
+        uint32_t* row = pixels + (long long)y * stride;
+        for (int span = 0; span < 7; ++span) {
+            int from = x[span], to = x[span + 1];
+            if (from >= to || span == 3) {
+                continue; // Empty, or the hole
+            }
+            touched += to - from;
+            if (span == 1 || span == 5) {
+                for (int i = from; i < to; ++i) {
+                    row[i] = color;
+                }
+                continue;
+            }
+#if defined(P3CLOCK_X86_SIMD)
+            if (k == kSimdAvx2) {
+                RingSpanAvx2(row, from, to, py, s);
+                continue;
+            }
+            if (k == kSimdSse2) {
+                RingSpanSse2(row, from, to, py, s);
+                continue;
+            }
+#endif
+            RingSpanScalar(row, from, to, py, s);
+        }
+    }
+    (void)k;
+    return touched;
+}
+
+inline long long FillAADisc(uint32_t* pixels, int stride, const DamageRect& clip,
+                            float cx, float cy, float radius, uint32_t color, SimdLevel kernel = kSimdAuto) {
+    return DrawAARing(pixels, stride, clip, cx, cy, radius, 0.0f, color, kernel);
+}
+
+} // namespace p3clock
+
+#endif // P3CLOCK_RASTER_CIRCLE_H
@@ -0,0 +1,72 @@
+#ifndef P3CLOCK_RESIZE_COALESCER_H
+#define P3CLOCK_RESIZE_COALESCER_H
+
+// Coalesces bursts of WM_SIZE into one rebuild per painted frame.
+//
+// A live drag-resize sends a WM_SIZE for every mouse movement, often several
+// between two frames. Rebuilding fonts, the glyph atlas and the back buffer
+// in each of them only produces sizes nobody sees. Instead WM_SIZE records
+// the new size and invalidates the window; WM_PAINT, which Windows only
+// sends once the message queue is empty, rebuilds for the latest size before
+// drawing. A burst that ends at the size already built (a jitter back and
+// forth) rebuilds nothing.
+
+namespace p3clock {
+
+struct ResizeStats {
+    unsigned long long events;    // OnSize() calls
+    unsigned long long rebuilds;  // Sizes TakePending() handed out
+    unsigned long long coalesced; // Events that never got their own rebuild
+};
+
+class ResizeCoalescer {
+public:
+    ResizeCoalescer() : pending_(false), pendingWidth_(0), pendingHeight_(0), builtWidth_(0), builtHeight_(0) {
+        stats_.events = stats_.rebuilds = stats_.coalesced = 0;
+    }
+
+    // WM_SIZE with the new client size. Nothing is rebuilt here.
+    void OnSize(int width, int height) {
+        stats_.events++;
+        if (pending_) {
+            stats_.coalesced++; // Replaces a size that was never built
+        }
+        pending_ = true;
+        pendingWidth_ = width;
+        pendingHeight_ = height;
+    }
+
+    bool Pending() const { return pending_; }
+
+    // WM_PAINT: true with the size to rebuild for when it differs from the last one built
+    bool TakePending(int* width, int* height) {
+        if (!pending_) {
+            return false;
+        }
+        pending_ = false;
+        if (pendingWidth_ == builtWidth_ && pendingHeight_ == builtHeight_) {
+            stats_.coalesced++;
+            return false;
+        }
+        builtWidth_ = pendingWidth_;
+        builtHeight_ = pendingHeight_;
+        stats_.rebuilds++;
+        *width = builtWidth_;
+        *height = builtHeight_;
+        return true;
+    }
+
+    const ResizeStats& Stats() const { return stats_; }
+
+private:
+    bool pending_;
+    int pendingWidth_;
+    int pendingHeight_;
+    int builtWidth_;
+    int builtHeight_;
+    ResizeStats stats_;
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_RESIZE_COALESCER_H
@@ -0,0 +1,146 @@
+#ifndef P3CLOCK_RESOURCE_CACHE_H
+#define P3CLOCK_RESOURCE_CACHE_H
+
+// Cache of drawing resources (brushes, pens, fonts) keyed by their parameters.
+//
+// Instead of creating a brush or font for every paint or resize and deleting
+// it right after, callers ask the cache for the handle that matches a key.
+// The Capacity most recently used handles are kept; when a new key needs a
+// slot, the least recently used handle is destroyed. A handle therefore stays
+// valid until Capacity other keys have been requested after it, or until
+// Clear(). The cache only stores handles: a Factory creates and destroys
+// them, so the same code runs against GDI and in p3timec-check.
+
+#include <stdint.h>
+
+namespace p3clock {
+
+enum ResourceType { kResourceBrush, kResourcePen, kResourceFont };
+
+struct ResourceKey {
+    ResourceType type;
+    int size;       // Pen width, or font em height (-height in CreateFont); 0 for brushes
+    uint32_t color; // COLORREF of brushes and pens; 0 for fonts
+    int weight;     // Font weight (FW_NORMAL, FW_BOLD); 0 for brushes and pens
+};
+
+inline bool operator==(const ResourceKey& a, const ResourceKey& b) {
+    return a.type == b.type && a.size == b.size && a.color == b.color && a.weight == b.weight;
+}
+
+inline ResourceKey BrushKey(uint32_t color) {
+    ResourceKey key = {kResourceBrush, 0, color, 0};
+    return key;
+}
+
+inline ResourceKey PenKey(int width, uint32_t color) {
+    ResourceKey key = {kResourcePen, width, color, 0};
+    return key;
+}
+
+inline ResourceKey FontKey(int size, int weight) {
+    ResourceKey key = {kResourceFont, size, 0, weight};
+    return key;
+}
+
+struct ResourceCacheStats {
+    unsigned long long hits;
+    unsigned long long misses;   // Lookups that had to call the factory
+    unsigned long long creates;  // Handles the factory created
+    unsigned long long destroys; // Handles destroyed by eviction or Clear()
+    int live;                    // Handles held right now
+};
+
+const int kResourceCacheCapacity = 16; // Enough for a few recent window sizes' fonts
+
+// Factory needs `Handle Create(const ResourceKey&)`, returning a null handle on failure,
+// and `void Destroy(Handle)`.
+template <typename Handle, typename Factory, int Capacity = kResourceCacheCapacity>
+class ResourceCache {
+public:
+    explicit ResourceCache(const Factory& factory = Factory()) : factory_(factory), useCount_(0) {
+        for (int i = 0; i < Capacity; ++i) {
+            entries_[i].used = false;
+        }
+        stats_.hits = stats_.misses = stats_.creates = stats_.destroys = 0;
+        stats_.live = 0;
+    }
+
+    ~ResourceCache() { Clear(); }
+
+    // Handle for key, created on first use. A failed create returns the null handle and
+    // caches nothing, so the next call tries again.
+    Handle Get(const ResourceKey& key) {
+        useCount_++;
+        int victim = 0;
+        for (int i = 0; i < Capacity; ++i) {
+            Entry& e = entries_[i];
+            if (e.used && e.key == key) {
+                e.lastUse = useCount_;
+                stats_.hits++;
+                return e.handle;
+            }
+            // Free slot first, otherwise the least recently used one
+            if (entries_[victim].used && (!e.used || e.lastUse < entries_[victim].lastUse)) {
+                victim = i;
+            }
+        }
+
+        stats_.misses++;
+        Handle handle = factory_.Create(key);
+        if (!handle) {
+            return handle;
+        }
+        stats_.creates++;
+        Entry& e = entries_[victim];
+        if (e.used) {
+            Release(e);
+        }
+        e.key = key;
+        e.handle = handle;
+        e.lastUse = useCount_;
+        e.used = true;
+        stats_.live++;
+        return handle;
+    }
+
+    // Destroy every handle, e.g. in WM_DESTROY. Handles handed out before are invalid afterwards.
+    void Clear() {
+        for (int i = 0; i < Capacity; ++i) {
+            if (entries_[i].used) {
+                Release(entries_[i]);
+            }
+        }
+    }
+
+    const ResourceCacheStats& Stats() const { return stats_; }
+    Factory& GetFactory() { return factory_; }
+
+private:
+    struct Entry {
+        ResourceKey key;
+        Handle handle;
+        unsigned long long lastUse;
+        bool used;
+    };
+
+    void Release(Entry& e) {
+        factory_.Destroy(e.handle);
+        e.used = false;
+        stats_.destroys++;
+        stats_.live--;
+    }
+
+    // Owns its handles: copying would destroy them twice
+    ResourceCache(const ResourceCache&);
+    ResourceCache& operator=(const ResourceCache&);
+
+    Factory factory_;
+    Entry entries_[Capacity];
+    unsigned long long useCount_;
+    ResourceCacheStats stats_;
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_RESOURCE_CACHE_H
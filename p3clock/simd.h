@@ -0,0 +1,147 @@
+#ifndef P3CLOCK_SIMD_H
+#define P3CLOCK_SIMD_H
+
+// Run-time SIMD dispatch and the coverage blend shared by the rasterizers.
+//
+// Kernels are compiled with per-function target attributes (P3CLOCK_TARGET)
+// and picked at run time from CPUID, so the headers also work in the 32-bit
+// XP builds on CPUs without SSE2.
+//
+// Pixels are 32-bit 0xAARRGGBB (the layout of a 32 bpp DIB section). A
+// coverage a in [0, 256] blends an opaque color in premultiplied form:
+//     dst = (dst * (256 - a) + color * a) >> 8
+// computed per 8-bit channel, the same way by every kernel.
+
+#include <stdint.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#define P3CLOCK_X86_SIMD 1
+#include <immintrin.h>
+#if defined(__i386__)
+// 32-bit Windows only guarantees 4-byte stack alignment; realign for __m128 / __m256 spills
+#define P3CLOCK_TARGET(isa) __attribute__((target(isa), force_align_arg_pointer))
+#else
+#define P3CLOCK_TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define P3CLOCK_X86_SIMD 1
+#include <intrin.h>
+#include <immintrin.h>
+#define P3CLOCK_TARGET(isa)
+#endif
+
+namespace p3clock {
+
+enum SimdLevel { kSimdScalar, kSimdSse2, kSimdAvx2, kSimdAuto };
+
+const char* const kSimdLevelNames[3] = {"scalar", "sse2", "avx2"};
+
+// Best level the CPU (and OS, for the AVX state) supports
+inline SimdLevel DetectSimdLevel() {
+#if defined(P3CLOCK_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return kSimdAvx2;
+    if (__builtin_cpu_supports("sse2")) return kSimdSse2;
+#elif defined(P3CLOCK_X86_SIMD)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) return kSimdAvx2;
+    }
+    if (sse2) return kSimdSse2;
+#endif
+    return kSimdScalar;
+}
+
+// kSimdAuto, or a level the CPU lacks, becomes the best supported level
+inline SimdLevel ResolveSimdLevel(SimdLevel level) {
+    static const SimdLevel detected = DetectSimdLevel();
+    if (level == kSimdAuto || level > detected) {
+        return detected;
+    }
+    return level;
+}
+
+inline uint32_t BlendPixel(uint32_t dst, uint32_t color, uint32_t a) {
+    uint32_t inv = 256 - a;
+    uint32_t rb = (((dst & 0x00FF00FFu) * inv + (color & 0x00FF00FFu) * a) >> 8) & 0x00FF00FFu;
+    uint32_t ag = (((dst >> 8) & 0x00FF00FFu) * inv + ((color >> 8) & 0x00FF00FFu) * a) & 0xFF00FF00u;
+    return rb | ag;
+}
+
+// Float coverage in [0, 1] to the 1/256 units of BlendPixel
+inline uint32_t CoverageToAlpha(float cov) {
+    cov = cov < 0.0f ? 0.0f : (cov > 1.0f ? 1.0f : cov);
+    return (uint32_t)(cov * 256.0f + 0.5f);
+}
+
+#if defined(P3CLOCK_X86_SIMD)
+
+P3CLOCK_TARGET("sse2")
+inline __m128i CoverageToAlpha4(__m128 cov) {
+    cov = _mm_min_ps(_mm_max_ps(cov, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(cov, _mm_set1_ps(256.0f)), _mm_set1_ps(0.5f)));
+}
+
+// Blend `color` into the 4 pixels at dst with coverages a (4 x int32 in [0, 256])
+P3CLOCK_TARGET("sse2")
+inline void BlendPixels4(uint32_t* dst, __m128i a, uint32_t color) {
+    const __m128i zero = _mm_setzero_si128();
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, zero)) == 0xFFFF) {
+        return; // Nothing covered
+    }
+    const __m128i c = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+    const __m128i full = _mm_set1_epi16(256);
+    // Spread each pixel's coverage over its four channels
+    __m128i a16 = _mm_packs_epi32(a, a);
+    a16 = _mm_unpacklo_epi16(a16, a16);
+    __m128i aLo = _mm_unpacklo_epi32(a16, a16);
+    __m128i aHi = _mm_unpackhi_epi32(a16, a16);
+
+    __m128i d = _mm_loadu_si128((const __m128i*)dst);
+    __m128i dLo = _mm_unpacklo_epi8(d, zero);
+    __m128i dHi = _mm_unpackhi_epi8(d, zero);
+    dLo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(dLo, _mm_sub_epi16(full, aLo)), _mm_mullo_epi16(c, aLo)), 8);
+    dHi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(dHi, _mm_sub_epi16(full, aHi)), _mm_mullo_epi16(c, aHi)), 8);
+    _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(dLo, dHi));
+}
+
+P3CLOCK_TARGET("avx2")
+inline __m256i CoverageToAlpha8(__m256 cov) {
+    cov = _mm256_min_ps(_mm256_max_ps(cov, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(cov, _mm256_set1_ps(256.0f)), _mm256_set1_ps(0.5f)));
+}
+
+// Blend `color` into the 8 pixels at dst with coverages a (8 x int32 in [0, 256])
+P3CLOCK_TARGET("avx2")
+inline void BlendPixels8(uint32_t* dst, __m256i a, uint32_t color) {
+    if (_mm256_testz_si256(a, a)) {
+        return;
+    }
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i c = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)color), zero);
+    const __m256i full = _mm256_set1_epi16(256);
+    // Unpacks work per 128-bit lane: aLo covers pixels 0,1,4,5 and aHi 2,3,6,7, like dLo / dHi
+    __m256i a16 = _mm256_packs_epi32(a, a);
+    a16 = _mm256_unpacklo_epi16(a16, a16);
+    __m256i aLo = _mm256_unpacklo_epi32(a16, a16);
+    __m256i aHi = _mm256_unpackhi_epi32(a16, a16);
+
+    __m256i d = _mm256_loadu_si256((const __m256i*)dst);
+    __m256i dLo = _mm256_unpacklo_epi8(d, zero);
+    __m256i dHi = _mm256_unpackhi_epi8(d, zero);
+    dLo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(dLo, _mm256_sub_epi16(full, aLo)), _mm256_mullo_epi16(c, aLo)), 8);
+    dHi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(dHi, _mm256_sub_epi16(full, aHi)), _mm256_mullo_epi16(c, aHi)), 8);
+    _mm256_storeu_si256((__m256i*)dst, _mm256_packus_epi16(dLo, dHi));
+}
+
+#endif // P3CLOCK_X86_SIMD
+
+} // namespace p3clock
+
+#endif // P3CLOCK_SIMD_H
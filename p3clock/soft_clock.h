@@ -0,0 +1,382 @@
+#ifndef P3CLOCK_SOFT_CLOCK_H
+#define P3CLOCK_SOFT_CLOCK_H
+
+// Platform-independent renderer of the whole P3 clock window.
+//
+// It reproduces what the Win32 programs draw in WM_PAINT, with the same
+// geometry and color rules, into a Framebuffer instead of a window DC:
+//   kLayoutDigital        p3timec / p3timec-32-1 / p3timec-32-2
+//   kLayoutAnalogDigital  p3timec-32-moni-1 (analog left half, digital right half)
+//   kLayoutAnalog         p3timec-32-moni-only-1
+// Like the Win32 versions, Resize() plays the role of WM_SIZE (fonts, glyph
+// atlas, layout) and Render() the role of WM_PAINT. RenderSweep() is the
+// sweep mode paint: sub-second hands, and only the damaged part redrawn.
+// RenderTiled() is Render() for large frames, split into tiles for a
+// thread pool.
+
+#include <string.h>
+
+#include "clock_geometry.h"
+#include "damage.h"
+#include "font_fit.h"
+#include "framebuffer.h"
+#include "glyph_atlas.h"
+#include "paint_trace.h"
+#include "raster_circle.h"
+#include "raster_line.h"
+#include "soft_raster.h"
+#include "stroke_font.h"
+
+namespace p3clock {
+
+enum ClockLayout { kLayoutDigital, kLayoutAnalogDigital, kLayoutAnalog, kLayoutCount };
+
+const char* const kClockLayoutNames[kLayoutCount] = {"digital", "moni", "moni-only"};
+
+// Parse "digital", "moni" or "moni-only". Returns false for anything else.
+inline bool ParseClockLayout(const char* name, ClockLayout* layout) {
+    for (int i = 0; i < kLayoutCount; ++i) {
+        if (strcmp(name, kClockLayoutNames[i]) == 0) {
+            *layout = static_cast<ClockLayout>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+inline Argb ClockColor(const ClockTime& t) {
+    return IsGreenHour(t) ? kArgbGreen : kArgbBlue;
+}
+
+// Measures kFitText in the stroke font, standing in for GetTextExtentPoint32. The
+// advances do not depend on the weight, so one measurer serves both.
+struct StrokeTextMeasurer {
+    TextExtent Measure(int size) {
+        TextExtent e = {StrokeTextWidth(kFitText, size), StrokeLineHeight(size)};
+        return e;
+    }
+};
+
+// Everything WM_SIZE computes for a client area of width x height
+struct ClockGeometry {
+    int width;
+    int height;
+    bool hasDigital;
+    DamageRect digitalRect; // Rectangle the time string is centered in
+    int fontSize;           // Em height of the digital font (-size in CreateFont)
+    AnalogLayout analog;
+    int numeralFontSize;
+};
+
+inline ClockGeometry ComputeClockGeometry(ClockLayout layout, int width, int height) {
+    ClockGeometry g;
+    g.width = width;
+    g.height = height;
+    g.hasDigital = layout != kLayoutAnalog;
+    g.analog.enabled = layout != kLayoutDigital;
+
+    // Digital: the whole client area, or the right half next to the analog clock
+    int digitalLeft = layout == kLayoutAnalogDigital ? width / 2 : 0;
+    DamageRect digitalRect = {digitalLeft, 0, width, height};
+    g.digitalRect = digitalRect;
+    StrokeTextMeasurer measurer;
+    g.fontSize = FitFontSize(measurer, measurer.Measure(kFitReferenceSize), width - digitalLeft, height);
+
+    // Analog: the left half (moni-1) or the whole client area (moni-only-1)
+    if (layout == kLayoutAnalogDigital) {
+        int analogWidth = width / 2;
+        g.analog.centerX = analogWidth / 2;
+        g.analog.centerY = height / 2;
+        g.analog.radius = (analogWidth < height ? analogWidth : height) / 2 - kFaceMargin;
+    } else {
+        g.analog.centerX = width / 2;
+        g.analog.centerY = height / 2;
+        g.analog.radius = (width < height ? width : height) / 2 - kFaceMargin;
+        if (g.analog.radius < 10) g.analog.radius = 10; // Minimum radius of moni-only-1
+    }
+    g.numeralFontSize = g.analog.radius / 5;
+    if (g.numeralFontSize < 8) g.numeralFontSize = 8;
+    return g;
+}
+
+// Glyph atlas of "0123456789:" in both colors at the digital font size, on `background`
+inline GlyphAtlasLayout BuildTimeGlyphAtlas(Framebuffer* atlas, int fontSize, Argb background = kArgbBlack) {
+    StrokeGlyphSource source = {atlas, fontSize, kStrokeBold};
+    GlyphAtlasLayout layout = MakeGlyphAtlasLayout(source);
+    atlas->Resize(layout.width, layout.height);
+    Clear(atlas, background);
+    RenderGlyphAtlas(source, layout);
+    return layout;
+}
+
+// Background and face border of the face layer inside `clip`
+inline void DrawClockFaceRing(Framebuffer* face, const ClockGeometry& g, Argb color, const DamageRect& clip,
+                              Argb background = kArgbBlack) {
+    FillRect(face, clip.left, clip.top, clip.right, clip.bottom, background);
+    const AnalogLayout& a = g.analog;
+    // Same circle as Ellipse(cx - r, cy - r, cx + r, cy + r), anti-aliased
+    DrawAARing(&face->pixels[0], face->width, clip, (float)a.centerX, (float)a.centerY,
+               (float)a.radius, (float)(a.radius - kFaceBorderWidth), color);
+}
+
+// Roman numerals of the face layer, drawn over the ring
+inline void DrawClockNumerals(Framebuffer* face, const ClockGeometry& g, Argb color) {
+    static const char* const kRomanNumerals[13] = {
+        "", "I", "II", "III", "IV", "V", "VI", "VII", "VIII", "IX", "X", "XI", "XII"
+    };
+    const AnalogLayout& a = g.analog;
+    int fontSize = g.numeralFontSize;
+    int numeralRadius = static_cast<int>(a.radius * kNumeralRadius);
+    for (int i = 1; i <= 12; ++i) {
+        Point num = NumeralPoint(i, a.centerX, a.centerY, numeralRadius);
+        DrawStrokeTextCentered(face, kRomanNumerals[i], num.x - fontSize, num.y - fontSize / 2,
+                               num.x + fontSize, num.y + fontSize / 2, fontSize, kStrokeNormal, color);
+    }
+}
+
+// Background, face border and Roman numerals (the Win32 face layer) into `face`,
+// which has the client area's size
+inline void DrawClockFace(Framebuffer* face, const ClockGeometry& g, Argb color) {
+    DamageRect all = {0, 0, face->width, face->height};
+    DrawClockFaceRing(face, g, color, all);
+    DrawClockNumerals(face, g, color);
+}
+
+// Tiles of RenderTiled(): kTileSize squares, row by row, the last row and column cut short
+const int kTileSize = 256;
+
+inline int TileCount(int width, int height) {
+    return ((width + kTileSize - 1) / kTileSize) * ((height + kTileSize - 1) / kTileSize);
+}
+
+inline DamageRect TileRect(int tile, int width, int height) {
+    int columns = (width + kTileSize - 1) / kTileSize;
+    DamageRect r;
+    r.left = tile % columns * kTileSize;
+    r.top = tile / columns * kTileSize;
+    r.right = r.left + kTileSize < width ? r.left + kTileSize : width;
+    r.bottom = r.top + kTileSize < height ? r.top + kTileSize : height;
+    return r;
+}
+
+// The three hands of the face `a`, whose client area starts at (originX, originY) in `view`.
+// Only pixels inside `clip` (in view coordinates) are touched.
+inline void DrawClockHands(const PixelView& view, const AnalogLayout& a, int originX, int originY, const ClockTime& t,
+                           int millisecond, bool sweep, Argb color, const DamageRect& clip) {
+    // Same integer end points as the GDI code, through pixel centers, with anti-aliased
+    // edges and widths scaled to the face. Sweep mode keeps the fractional end points.
+    for (int hand = 0; hand < kHandCount; ++hand) {
+        Hand h = static_cast<Hand>(hand);
+        PointF tip;
+        if (sweep) {
+            tip = SweepHandPoint(h, t, millisecond, a.centerX, a.centerY, a.radius, 1.0);
+        } else {
+            Point p = HandTip(h, t, a.centerX, a.centerY, a.radius);
+            tip.x = (float)p.x;
+            tip.y = (float)p.y;
+        }
+        DrawAALine(view.pixels, view.stride, clip, originX + a.centerX + 0.5f, originY + a.centerY + 0.5f,
+                   originX + tip.x + 0.5f, originY + tip.y + 0.5f, (float)HandWidth(h, a.radius), color);
+    }
+}
+
+inline void DrawClockHands(Framebuffer* fb, const AnalogLayout& a, int originX, int originY, const ClockTime& t,
+                           int millisecond, bool sweep, Argb color, const DamageRect& clip) {
+    DrawClockHands(ViewOf(fb), a, originX, originY, t, millisecond, sweep, color, clip);
+}
+
+class SoftClockRenderer {
+public:
+    explicit SoftClockRenderer(ClockLayout layout) : layout_(layout), faceColor_(0) {
+        geometry_ = ComputeClockGeometry(layout, 0, 0);
+    }
+
+    ClockLayout Layout() const { return layout_; }
+    const ClockGeometry& Geometry() const { return geometry_; }
+    const Framebuffer& Frame() const { return frame_; }
+    const GlyphAtlasLayout& AtlasLayout() const { return atlasLayout_; }
+    const TimeTextLayout& TextLayout() const { return textLayout_; }
+
+    // WM_SIZE: recompute the layout and rebuild the glyph atlas for the new font size
+    void Resize(int width, int height) {
+        geometry_ = ComputeClockGeometry(layout_, width, height);
+        frame_.Resize(width, height);
+        faceColor_ = 0; // Face layer is rebuilt on the next Render()
+        DigitalLayout digital;
+        digital.enabled = false;
+        if (geometry_.hasDigital) {
+            BuildGlyphAtlas();
+            digital = DigitalLayoutFromText(atlasLayout_, textLayout_);
+        }
+        sweepDamage_.SetLayout(digital, geometry_.analog, width, height);
+    }
+
+    // WM_PAINT: draw the full frame for time t
+    void Render(const ClockTime& t) {
+        NullPaintTracer none;
+        Render(t, &none);
+    }
+
+    // Render() with its phases timed by `tracer` (see paint_trace.h)
+    template <typename Tracer>
+    void Render(const ClockTime& t, Tracer* tracer) {
+        DamageRect all = {0, 0, frame_.width, frame_.height};
+        Argb color = ClockColor(t);
+        if (geometry_.analog.enabled) {
+            if (faceColor_ != color) {
+                face_.Resize(frame_.width, frame_.height);
+                {
+                    ScopedPhase<Tracer> phase(tracer, kPhaseFace);
+                    DrawClockFaceRing(&face_, geometry_, color, all);
+                }
+                {
+                    ScopedPhase<Tracer> phase(tracer, kPhaseNumerals);
+                    DrawClockNumerals(&face_, geometry_, color);
+                }
+                faceColor_ = color;
+            }
+            {
+                ScopedPhase<Tracer> phase(tracer, kPhaseBackground);
+                Blit(&frame_, 0, 0, face_, 0, 0, frame_.width, frame_.height);
+            }
+            ScopedPhase<Tracer> phase(tracer, kPhaseHands);
+            DrawHands(t, 0, false, color, all);
+        } else {
+            ScopedPhase<Tracer> phase(tracer, kPhaseBackground);
+            FillRect(&frame_, 0, 0, frame_.width, frame_.height, kArgbBlack);
+        }
+        if (geometry_.hasDigital) {
+            ScopedPhase<Tracer> phase(tracer, kPhaseText);
+            DrawDigits(t);
+        }
+    }
+
+    // Sweep mode WM_PAINT: draw time t with the hands `millisecond` into the second, redrawing
+    // only what changed since the previous RenderSweep(). Returns that damage.
+    DamageList RenderSweep(const ClockTime& t, int millisecond) {
+        DamageList damage = sweepDamage_.AdvanceSweep(t, millisecond);
+        if (damage.full) {
+            DamageRect all = {0, 0, frame_.width, frame_.height};
+            RenderRect(t, millisecond, true, all);
+        } else {
+            // Each rectangle is restored and redrawn before the next one, so where
+            // rectangles overlap the hands are still blended only once
+            for (int i = 0; i < damage.count; ++i) {
+                RenderRect(t, millisecond, true, damage.rects[i]);
+            }
+        }
+        bool digitsDamaged = damage.full;
+        for (int i = 0; i < damage.count; ++i) {
+            digitsDamaged = digitsDamaged || !IsEmpty(Intersect(damage.rects[i], geometry_.digitalRect));
+        }
+        if (geometry_.hasDigital && digitsDamaged) {
+            DrawDigits(t); // The cells are opaque, so redrawing unchanged digits is harmless
+        }
+        return damage;
+    }
+
+    // Render() split into tiles that `pool` (see tile_pool.h) runs in parallel. The face layer,
+    // when it has to be rebuilt, is drawn in tiles too, before the frame. Every pixel comes out
+    // exactly as Render() draws it, whatever the number of threads.
+    template <typename Pool>
+    void RenderTiled(const ClockTime& t, Pool* pool) {
+        int tiles = TileCount(frame_.width, frame_.height);
+        Argb color = ClockColor(t);
+        if (geometry_.analog.enabled && faceColor_ != color) {
+            face_.Resize(frame_.width, frame_.height);
+            FaceTileJob faceJob = {this, color};
+            pool->Run(tiles, faceJob);
+            DrawClockNumerals(&face_, geometry_, color);
+            faceColor_ = color;
+        }
+        RenderTileJob job = {this, &t};
+        pool->Run(tiles, job);
+    }
+
+private:
+    struct FaceTileJob {
+        SoftClockRenderer* renderer;
+        Argb color;
+        void operator()(int tile) {
+            const Framebuffer& face = renderer->face_;
+            DrawClockFaceRing(&renderer->face_, renderer->geometry_, color, TileRect(tile, face.width, face.height));
+        }
+    };
+
+    // One tile of Render(); the face layer is already built, so tiles only read shared state
+    struct RenderTileJob {
+        SoftClockRenderer* renderer;
+        const ClockTime* t;
+        void operator()(int tile) {
+            DamageRect clip = TileRect(tile, renderer->frame_.width, renderer->frame_.height);
+            renderer->RenderRect(*t, 0, false, clip);
+            if (renderer->geometry_.hasDigital) {
+                renderer->DrawDigits(*t, clip);
+            }
+        }
+    };
+
+    void BuildGlyphAtlas() {
+        atlasLayout_ = BuildTimeGlyphAtlas(&atlas_, geometry_.fontSize);
+        const DamageRect& r = geometry_.digitalRect;
+        textLayout_ = LayoutTimeText(atlasLayout_, r.left, r.top, r.right, r.bottom);
+    }
+
+    // Background, face border and Roman numerals (the Win32 face layer)
+    void BuildFace(Argb color) {
+        face_.Resize(frame_.width, frame_.height);
+        DrawClockFace(&face_, geometry_, color);
+        faceColor_ = color;
+    }
+
+    // Background, face and hands inside `clip`
+    void RenderRect(const ClockTime& t, int millisecond, bool sweep, const DamageRect& clip) {
+        Argb color = ClockColor(t);
+        if (geometry_.analog.enabled) {
+            if (faceColor_ != color) {
+                BuildFace(color);
+            }
+            Blit(&frame_, clip.left, clip.top, face_, clip.left, clip.top, clip.right - clip.left, clip.bottom - clip.top);
+            DrawHands(t, millisecond, sweep, color, clip);
+        } else {
+            FillRect(&frame_, clip.left, clip.top, clip.right, clip.bottom, kArgbBlack);
+        }
+    }
+
+    void DrawDigits(const ClockTime& t) {
+        DamageRect all = {0, 0, frame_.width, frame_.height};
+        DrawDigits(t, all);
+    }
+
+    // The part of the eight characters inside `clip`
+    void DrawDigits(const ClockTime& t, const DamageRect& clip) {
+        GlyphBlit blits[8];
+        TimeTextBlits(atlasLayout_, textLayout_, t, blits);
+        for (int i = 0; i < 8; ++i) {
+            DamageRect dst = {blits[i].dstX, blits[i].dstY, blits[i].dstX + blits[i].width, blits[i].dstY + blits[i].height};
+            DamageRect r = Intersect(dst, clip);
+            if (!IsEmpty(r)) {
+                Blit(&frame_, r.left, r.top, atlas_, blits[i].srcX + r.left - dst.left, blits[i].srcY + r.top - dst.top,
+                     r.right - r.left, r.bottom - r.top);
+            }
+        }
+    }
+
+    void DrawHands(const ClockTime& t, int millisecond, bool sweep, Argb color, const DamageRect& clip) {
+        DrawClockHands(&frame_, geometry_.analog, 0, 0, t, millisecond, sweep, color, clip);
+    }
+
+    ClockLayout layout_;
+    ClockGeometry geometry_;
+    Framebuffer frame_;
+    Framebuffer face_;
+    Argb faceColor_; // 0 = face layer not built for the current size
+    Framebuffer atlas_;
+    GlyphAtlasLayout atlasLayout_;
+    TimeTextLayout textLayout_;
+    DamageTracker sweepDamage_; // What RenderSweep() last drew
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_SOFT_CLOCK_H
@@ -0,0 +1,70 @@
+#ifndef P3CLOCK_SOFT_RASTER_H
+#define P3CLOCK_SOFT_RASTER_H
+
+// Software stand-in for the GDI wide pen (MoveToEx/LineTo with round caps),
+// used by the stroke font. Coverage is binary, like GDI with anti-aliasing
+// off: a pixel is painted when its center lies inside the shape.
+
+#include <math.h>
+
+#include "framebuffer.h"
+
+namespace p3clock {
+
+// Line from (x0, y0) to (x1, y1) drawn with a round pen `width` pixels wide. The
+// coordinates are relative to the pixel (originX, originY), and coverage is decided
+// in those coordinates, so a shape comes out the same wherever its origin is.
+inline void DrawThickLine(Framebuffer* fb, double x0, double y0, double x1, double y1, double width, Argb color,
+                          int originX = 0, int originY = 0) {
+    double hw = width < 1.0 ? 0.5 : width * 0.5;
+    double dx = x1 - x0;
+    double dy = y1 - y0;
+    double len2 = dx * dx + dy * dy;
+
+    double ymin = y0 < y1 ? y0 : y1;
+    double ymax = y0 > y1 ? y0 : y1;
+
+    int top = (int)floor(ymin - hw);
+    int bottom = (int)ceil(ymax + hw);
+    int left = (int)floor((x0 < x1 ? x0 : x1) - hw);
+    int right = (int)ceil((x0 > x1 ? x0 : x1) + hw);
+    if (top < -originY) top = -originY;
+    if (left < -originX) left = -originX;
+    if (bottom > fb->height - 1 - originY) bottom = fb->height - 1 - originY;
+    if (right > fb->width - 1 - originX) right = fb->width - 1 - originX;
+
+    // On each row only a window around the center line can be covered, which keeps
+    // long diagonal hands from scanning their whole bounding box.
+    double slope = fabs(dy) > 1e-9 ? dx / dy : 0.0;
+    double window = fabs(dy) > 1e-9 ? hw * sqrt(len2) / fabs(dy) + hw + 1.0 : 0.0;
+
+    for (int y = top; y <= bottom; ++y) {
+        double py = y + 0.5;
+        int from = left, to = right;
+        if (window > 0.0) {
+            double cy = py < ymin ? ymin : (py > ymax ? ymax : py);
+            double cx = x0 + (cy - y0) * slope;
+            int wl = (int)floor(cx - window);
+            int wr = (int)ceil(cx + window);
+            if (wl > from) from = wl;
+            if (wr < to) to = wr;
+        }
+        Argb* row = fb->Row(y + originY) + originX;
+        for (int x = from; x <= to; ++x) {
+            double px = x + 0.5;
+            // Distance from the pixel center to the segment
+            double t = len2 > 0.0 ? ((px - x0) * dx + (py - y0) * dy) / len2 : 0.0;
+            if (t < 0.0) t = 0.0;
+            if (t > 1.0) t = 1.0;
+            double ex = px - (x0 + t * dx);
+            double ey = py - (y0 + t * dy);
+            if (ex * ex + ey * ey <= hw * hw) {
+                row[x] = color;
+            }
+        }
+    }
+}
+
+} // namespace p3clock
+
+#endif // P3CLOCK_SOFT_RASTER_H
@@ -0,0 +1,178 @@
+#ifndef P3CLOCK_STROKE_FONT_H
+#define P3CLOCK_STROKE_FONT_H
+
+// Minimal stroke font for the software renderer: the digits, ':', the
+// capital letters (I, V and X for the Roman numerals, the rest for clock wall
+// labels) and a little punctuation. Glyphs are polylines in a
+// unit box drawn with round pens, with metrics close to Arial's so the layout
+// matches the GDI programs (size is the em height passed as -size to CreateFont).
+
+#include <string.h>
+
+#include "framebuffer.h"
+#include "soft_raster.h"
+
+namespace p3clock {
+
+struct StrokeSegment {
+    float x0, y0, x1, y1; // Unit box: x and y in [0, 1], y grows downward
+};
+
+struct StrokeGlyph {
+    char ch;
+    float advance; // In em
+    int count;
+    StrokeSegment segments[6];
+};
+
+// Points of a seven-segment style grid: top, middle and bottom rows
+#define P3_TL 0.0f, 0.0f
+#define P3_TR 1.0f, 0.0f
+#define P3_ML 0.0f, 0.5f
+#define P3_MR 1.0f, 0.5f
+#define P3_BL 0.0f, 1.0f
+#define P3_BR 1.0f, 1.0f
+
+const StrokeGlyph kStrokeGlyphs[] = {
+    {'0', 0.556f, 4, {{P3_TL, P3_TR}, {P3_TR, P3_BR}, {P3_BR, P3_BL}, {P3_BL, P3_TL}}},
+    {'1', 0.556f, 2, {{0.6f, 0.0f, 0.6f, 1.0f}, {0.6f, 0.0f, 0.2f, 0.25f}}},
+    {'2', 0.556f, 5, {{P3_TL, P3_TR}, {P3_TR, P3_MR}, {P3_MR, P3_ML}, {P3_ML, P3_BL}, {P3_BL, P3_BR}}},
+    {'3', 0.556f, 4, {{P3_TL, P3_TR}, {P3_TR, P3_BR}, {P3_BR, P3_BL}, {P3_ML, P3_MR}}},
+    {'4', 0.556f, 3, {{P3_TL, P3_ML}, {P3_ML, P3_MR}, {P3_TR, P3_BR}}},
+    {'5', 0.556f, 5, {{P3_TR, P3_TL}, {P3_TL, P3_ML}, {P3_ML, P3_MR}, {P3_MR, P3_BR}, {P3_BR, P3_BL}}},
+    {'6', 0.556f, 5, {{P3_TR, P3_TL}, {P3_TL, P3_BL}, {P3_BL, P3_BR}, {P3_BR, P3_MR}, {P3_MR, P3_ML}}},
+    {'7', 0.556f, 2, {{P3_TL, P3_TR}, {P3_TR, 0.4f, 1.0f}}},
+    {'8', 0.556f, 5, {{P3_TL, P3_TR}, {P3_TR, P3_BR}, {P3_BR, P3_BL}, {P3_BL, P3_TL}, {P3_ML, P3_MR}}},
+    {'9', 0.556f, 5, {{P3_MR, P3_ML}, {P3_ML, P3_TL}, {P3_TL, P3_TR}, {P3_TR, P3_BR}, {P3_BR, P3_BL}}},
+    {':', 0.278f, 2, {{0.5f, 0.3f, 0.5f, 0.3f}, {0.5f, 0.95f, 0.5f, 0.95f}}},
+    {'I', 0.278f, 1, {{0.5f, 0.0f, 0.5f, 1.0f}}},
+    {'V', 0.667f, 2, {{P3_TL, 0.5f, 1.0f}, {0.5f, 1.0f, P3_TR}}},
+    {'X', 0.667f, 2, {{P3_TL, P3_BR}, {P3_TR, P3_BL}}},
+    {'A', 0.667f, 3, {{P3_BL, 0.5f, 0.0f}, {0.5f, 0.0f, P3_BR}, {0.2f, 0.65f, 0.8f, 0.65f}}},
+    {'B', 0.667f, 6, {{P3_TL, P3_BL}, {P3_TL, 0.85f, 0.0f}, {0.85f, 0.0f, 0.85f, 0.5f}, {P3_ML, P3_MR}, {P3_MR, P3_BR}, {P3_BR, P3_BL}}},
+    {'C', 0.722f, 3, {{P3_TR, P3_TL}, {P3_TL, P3_BL}, {P3_BL, P3_BR}}},
+    {'D', 0.722f, 6, {{P3_TL, P3_BL}, {P3_TL, 0.6f, 0.0f}, {0.6f, 0.0f, 1.0f, 0.3f}, {1.0f, 0.3f, 1.0f, 0.7f},
+                      {1.0f, 0.7f, 0.6f, 1.0f}, {0.6f, 1.0f, P3_BL}}},
+    {'E', 0.667f, 4, {{P3_TR, P3_TL}, {P3_TL, P3_BL}, {P3_BL, P3_BR}, {P3_ML, 0.8f, 0.5f}}},
+    {'F', 0.611f, 3, {{P3_TR, P3_TL}, {P3_TL, P3_BL}, {P3_ML, 0.8f, 0.5f}}},
+    {'G', 0.778f, 5, {{P3_TR, P3_TL}, {P3_TL, P3_BL}, {P3_BL, P3_BR}, {P3_BR, 1.0f, 0.55f}, {1.0f, 0.55f, 0.5f, 0.55f}}},
+    {'H', 0.722f, 3, {{P3_TL, P3_BL}, {P3_TR, P3_BR}, {P3_ML, P3_MR}}},
+    {'J', 0.5f, 3, {{P3_TR, P3_BR}, {P3_BR, P3_BL}, {P3_BL, 0.0f, 0.7f}}},
+    {'K', 0.667f, 3, {{P3_TL, P3_BL}, {P3_TR, 0.0f, 0.65f}, {0.35f, 0.4f, P3_BR}}},
+    {'L', 0.556f, 2, {{P3_TL, P3_BL}, {P3_BL, P3_BR}}},
+    {'M', 0.833f, 4, {{P3_BL, P3_TL}, {P3_TL, 0.5f, 0.6f}, {0.5f, 0.6f, P3_TR}, {P3_TR, P3_BR}}},
+    {'N', 0.722f, 3, {{P3_BL, P3_TL}, {P3_TL, P3_BR}, {P3_BR, P3_TR}}},
+    {'O', 0.778f, 4, {{P3_TL, P3_TR}, {P3_TR, P3_BR}, {P3_BR, P3_BL}, {P3_BL, P3_TL}}},
+    {'P', 0.667f, 4, {{P3_BL, P3_TL}, {P3_TL, P3_TR}, {P3_TR, P3_MR}, {P3_MR, P3_ML}}},
+    {'Q', 0.778f, 5, {{P3_TL, P3_TR}, {P3_TR, P3_BR}, {P3_BR, P3_BL}, {P3_BL, P3_TL}, {0.6f, 0.6f, P3_BR}}},
+    {'R', 0.722f, 5, {{P3_BL, P3_TL}, {P3_TL, P3_TR}, {P3_TR, P3_MR}, {P3_MR, P3_ML}, {0.4f, 0.5f, P3_BR}}},
+    {'S', 0.667f, 5, {{P3_TR, P3_TL}, {P3_TL, P3_ML}, {P3_ML, P3_MR}, {P3_MR, P3_BR}, {P3_BR, P3_BL}}},
+    {'T', 0.611f, 2, {{P3_TL, P3_TR}, {0.5f, 0.0f, 0.5f, 1.0f}}},
+    {'U', 0.722f, 3, {{P3_TL, P3_BL}, {P3_BL, P3_BR}, {P3_BR, P3_TR}}},
+    {'W', 0.944f, 4, {{P3_TL, 0.25f, 1.0f}, {0.25f, 1.0f, 0.5f, 0.3f}, {0.5f, 0.3f, 0.75f, 1.0f}, {0.75f, 1.0f, P3_TR}}},
+    {'Y', 0.667f, 3, {{P3_TL, 0.5f, 0.5f}, {P3_TR, 0.5f, 0.5f}, {0.5f, 0.5f, 0.5f, 1.0f}}},
+    {'Z', 0.611f, 3, {{P3_TL, P3_TR}, {P3_TR, P3_BL}, {P3_BL, P3_BR}}},
+    {'+', 0.584f, 2, {{0.5f, 0.2f, 0.5f, 0.8f}, {0.0f, 0.5f, 1.0f, 0.5f}}},
+    {'-', 0.333f, 1, {{0.0f, 0.55f, 1.0f, 0.55f}}},
+    {'.', 0.278f, 1, {{0.5f, 0.95f, 0.5f, 0.95f}}},
+    {'/', 0.278f, 1, {{P3_BL, P3_TR}}},
+    {' ', 0.278f, 0, {{0.0f, 0.0f, 0.0f, 0.0f}}},
+};
+
+#undef P3_TL
+#undef P3_TR
+#undef P3_ML
+#undef P3_MR
+#undef P3_BL
+#undef P3_BR
+
+const float kStrokeLineHeight = 1.15f; // tmHeight / em for Arial
+const float kStrokeAscent = 0.905f;    // Baseline below the top of the line, in em
+const float kStrokeCapHeight = 0.716f; // Glyph box height, in em
+const float kStrokeSideBearing = 0.09f;
+
+enum StrokeWeight { kStrokeNormal, kStrokeBold };
+
+inline const StrokeGlyph* FindStrokeGlyph(char c) {
+    for (size_t i = 0; i < sizeof(kStrokeGlyphs) / sizeof(kStrokeGlyphs[0]); ++i) {
+        if (kStrokeGlyphs[i].ch == c) {
+            return &kStrokeGlyphs[i];
+        }
+    }
+    return 0;
+}
+
+// Advance of one glyph in whole pixels; unknown characters advance like a digit
+inline int StrokeAdvance(char c, int size) {
+    const StrokeGlyph* glyph = FindStrokeGlyph(c);
+    return (int)((glyph ? glyph->advance : 0.556f) * size + 0.5f);
+}
+
+inline int StrokeLineHeight(int size) {
+    return (int)(kStrokeLineHeight * size + 0.5f);
+}
+
+inline int StrokeTextWidth(const char* text, int size) {
+    int width = 0;
+    for (; *text; ++text) {
+        width += StrokeAdvance(*text, size);
+    }
+    return width;
+}
+
+inline double StrokePenWidth(int size, StrokeWeight weight) {
+    double pen = size * (weight == kStrokeBold ? 0.13 : 0.075);
+    return pen < 1.0 ? 1.0 : pen;
+}
+
+// Draw one glyph whose line box starts at (x, y), like TextOut with TA_TOP
+inline void DrawStrokeGlyph(Framebuffer* fb, char c, int x, int y, int size, StrokeWeight weight, Argb color) {
+    const StrokeGlyph* glyph = FindStrokeGlyph(c);
+    if (!glyph) {
+        return;
+    }
+    double pen = StrokePenWidth(size, weight);
+    double advance = StrokeAdvance(c, size);
+    // The glyph box is inset by the side bearing and half the pen so strokes stay in the cell.
+    // It is placed relative to (x, y), so the glyph has the same pixels at any position and a
+    // copy from the glyph atlas matches drawing it in place.
+    double boxLeft = kStrokeSideBearing * size + pen * 0.5;
+    double boxWidth = advance - 2.0 * (kStrokeSideBearing * size + pen * 0.5);
+    if (boxWidth < 0.0) boxWidth = 0.0;
+    double boxTop = (kStrokeAscent - kStrokeCapHeight) * size + pen * 0.5;
+    double boxHeight = kStrokeCapHeight * size - pen;
+    if (boxHeight < 0.0) boxHeight = 0.0;
+    for (int i = 0; i < glyph->count; ++i) {
+        const StrokeSegment& s = glyph->segments[i];
+        DrawThickLine(fb, boxLeft + s.x0 * boxWidth, boxTop + s.y0 * boxHeight,
+                      boxLeft + s.x1 * boxWidth, boxTop + s.y1 * boxHeight, pen, color, x, y);
+    }
+}
+
+// Draw text centered in a rectangle, like DrawText(DT_SINGLELINE | DT_CENTER | DT_VCENTER)
+inline void DrawStrokeTextCentered(Framebuffer* fb, const char* text, int left, int top, int right, int bottom,
+                                   int size, StrokeWeight weight, Argb color) {
+    int x = left + ((right - left) - StrokeTextWidth(text, size)) / 2;
+    int y = top + ((bottom - top) - StrokeLineHeight(size)) / 2;
+    for (; *text; ++text) {
+        DrawStrokeGlyph(fb, *text, x, y, size, weight, color);
+        x += StrokeAdvance(*text, size);
+    }
+}
+
+// GlyphSource for glyph_atlas.h backed by the stroke font
+struct StrokeGlyphSource {
+    Framebuffer* target;
+    int size;
+    StrokeWeight weight;
+
+    int Advance(char c) { return StrokeAdvance(c, size); }
+    int Height() { return StrokeLineHeight(size); }
+    void Render(char c, int row, int x, int y) {
+        DrawStrokeGlyph(target, c, x, y, size, weight, row == 1 ? kArgbGreen : kArgbBlue);
+    }
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_STROKE_FONT_H
@@ -0,0 +1,91 @@
+#ifndef P3CLOCK_TICK_SCHEDULER_H
+#define P3CLOCK_TICK_SCHEDULER_H
+
+// Second-aligned tick scheduling.
+//
+// A fixed 1000 ms timer is not aligned to the wall-clock second and drifts, so
+// the displayed second flips late and now and then skips or repeats a value.
+// The scheduler instead computes, on every tick, the delay to the next second
+// boundary of the time source and the caller re-arms a one-shot timer with it.
+//
+// The scheduler never reads a clock itself: every call takes the current time
+// in milliseconds, so any clock (the real one or a simulated one) can drive it.
+
+namespace p3clock {
+
+struct Tick {
+    bool present;     // A new second started: repaint
+    long long second; // Second number derived from the time source
+    int lateMs;       // How far past the second boundary this tick ran
+    int delayMs;      // Re-arm the timer with this delay
+};
+
+struct TickStats {
+    unsigned long long ticks;     // OnTick() calls
+    unsigned long long presented; // Ticks that showed a new second
+    unsigned long long repeats;   // Ticks that fired before the boundary (same second again)
+    unsigned long long skipped;   // Seconds that were never shown
+};
+
+class TickScheduler {
+public:
+    // `guardMs` is added to every delay so the timer lands just after the
+    // boundary rather than just before it.
+    explicit TickScheduler(int guardMs = 2) : guardMs_(guardMs), lastSecond_(0), started_(false) {
+        stats_.ticks = stats_.presented = stats_.repeats = stats_.skipped = 0;
+    }
+
+    // The caller has just shown the frame for `nowMs`. Returns the first delay.
+    int Start(long long nowMs) {
+        lastSecond_ = SecondOf(nowMs);
+        started_ = true;
+        return DelayToNextSecond(nowMs);
+    }
+
+    Tick OnTick(long long nowMs) {
+        Tick tick;
+        tick.second = SecondOf(nowMs);
+        tick.lateMs = (int)(nowMs - tick.second * 1000);
+        tick.delayMs = DelayToNextSecond(nowMs);
+        stats_.ticks++;
+
+        if (started_ && tick.second == lastSecond_) {
+            // Woke up before the boundary: nothing to show, just wait for it
+            tick.present = false;
+            stats_.repeats++;
+            return tick;
+        }
+        if (started_ && tick.second > lastSecond_ + 1) {
+            stats_.skipped += (unsigned long long)(tick.second - lastSecond_ - 1);
+        }
+        tick.present = true;
+        stats_.presented++;
+        lastSecond_ = tick.second;
+        started_ = true;
+        return tick;
+    }
+
+    int DelayToNextSecond(long long nowMs) const {
+        long long intoSecond = nowMs - SecondOf(nowMs) * 1000;
+        return (int)(1000 - intoSecond) + guardMs_;
+    }
+
+    const TickStats& Stats() const {
+        return stats_;
+    }
+
+private:
+    static long long SecondOf(long long ms) {
+        // Floor division so times before the epoch still round down
+        return ms >= 0 ? ms / 1000 : -((-ms + 999) / 1000);
+    }
+
+    int guardMs_;
+    long long lastSecond_;
+    bool started_;
+    TickStats stats_;
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_TICK_SCHEDULER_H
@@ -0,0 +1,204 @@
+#ifndef P3CLOCK_TILE_POOL_H
+#define P3CLOCK_TILE_POOL_H
+
+// Small thread pool that runs the tiles of one frame, with work stealing.
+//
+// Run() hands out tile indices [0, count): every thread starts with a
+// contiguous block of them in its own queue, takes tiles from the front of
+// that queue, and when it runs dry steals from the back of another thread's
+// queue. A queue only ever shrinks from its two ends, so it is just the
+// range [begin, end) of the block: Run() sets the ranges and allocates
+// nothing, and a frame rendered in tiles allocates no more than one
+// rendered on a single thread. Neighbouring tiles therefore stay on one thread (cache friendly),
+// while a thread whose tiles were cheap (black background) takes over
+// expensive ones (the face, the digits) from the others. The calling thread
+// works too and Run() returns once every tile is done, so the frame is
+// complete when the caller presents it.
+//
+// Which thread renders a tile never changes its pixels: tiles do not overlap
+// and each one is rendered completely by one job, so the output is the same
+// for any thread count. Needs C++11 threads (the Linux tools); the Win32
+// programs do not include it.
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace p3clock {
+
+struct TilePoolStats {
+    unsigned long long runs;   // Run() calls
+    unsigned long long tiles;  // Tiles executed
+    unsigned long long steals; // Tiles taken from another thread's queue
+};
+
+class TilePool {
+public:
+    // `threads` counts the calling thread: 1 runs every tile inline without any worker
+    explicit TilePool(int threads)
+        : threads_(threads < 1 ? 1 : threads), queues_(threads_), fn_(0), ctx_(0), remaining_(0),
+          generation_(0), stopping_(false) {
+        stats_.runs = stats_.tiles = stats_.steals = 0;
+        for (int i = 1; i < threads_; ++i) {
+            workers_.push_back(std::thread(&TilePool::WorkerLoop, this, i));
+        }
+    }
+
+    ~TilePool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            workers_[i].join();
+        }
+    }
+
+    int Threads() const { return threads_; }
+    const TilePoolStats& Stats() const { return stats_; }
+
+    // Call job(tile) for every tile in [0, count) and return when all of them are done
+    template <typename Job>
+    void Run(int count, Job& job) {
+        RunTiles(count, &CallJob<Job>, &job);
+    }
+
+private:
+    typedef void (*TileFn)(void* ctx, int tile);
+
+    template <typename Job>
+    static void CallJob(void* ctx, int tile) {
+        (*static_cast<Job*>(ctx))(tile);
+    }
+
+    // The tiles [begin, end) still waiting in a thread's block
+    struct Queue {
+        Queue() : begin(0), end(0) {}
+
+        std::mutex mutex;
+        int begin;
+        int end;
+    };
+
+    void RunTiles(int count, TileFn fn, void* ctx) {
+        stats_.runs++;
+        stats_.tiles += (unsigned long long)count;
+        if (count <= 0) {
+            return;
+        }
+        if (threads_ == 1) {
+            for (int tile = 0; tile < count; ++tile) {
+                fn(ctx, tile);
+            }
+            return;
+        }
+        // The job is published before any tile is queued: a worker still finishing the
+        // previous Run() may pick up the new tiles right away
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fn_ = fn;
+            ctx_ = ctx;
+            remaining_ = count;
+        }
+        // Contiguous blocks, so each thread starts on one band of the frame
+        for (int i = 0; i < threads_; ++i) {
+            std::lock_guard<std::mutex> lock(queues_[i].mutex);
+            queues_[i].begin = (int)((long long)count * i / threads_);
+            queues_[i].end = (int)((long long)count * (i + 1) / threads_);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            generation_++;
+        }
+        wake_.notify_all();
+
+        Work(0);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (remaining_ > 0) {
+            done_.wait(lock);
+        }
+        fn_ = 0;
+        ctx_ = 0;
+    }
+
+    void WorkerLoop(int index) {
+        unsigned long long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (!stopping_ && generation_ == seen) {
+                    wake_.wait(lock);
+                }
+                if (stopping_) {
+                    return;
+                }
+                seen = generation_;
+            }
+            Work(index);
+        }
+    }
+
+    // Run tiles until no queue has any left
+    void Work(int index) {
+        int finished = 0;
+        unsigned long long stolen = 0;
+        int tile;
+        while (TakeOwn(index, &tile) || Steal(index, &tile, &stolen)) {
+            fn_(ctx_, tile);
+            finished++;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.steals += stolen;
+        remaining_ -= finished;
+        if (remaining_ == 0) {
+            done_.notify_all();
+        }
+    }
+
+    bool TakeOwn(int index, int* tile) {
+        Queue& q = queues_[index];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.begin == q.end) {
+            return false;
+        }
+        *tile = q.begin++;
+        return true;
+    }
+
+    // Take the last tile of the next thread that still has some, farthest from where it works
+    bool Steal(int index, int* tile, unsigned long long* stolen) {
+        for (int i = 1; i < threads_; ++i) {
+            Queue& q = queues_[(index + i) % threads_];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.begin != q.end) {
+                *tile = --q.end;
+                (*stolen)++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Owns threads: not copyable
+    TilePool(const TilePool&);
+    TilePool& operator=(const TilePool&);
+
+    int threads_;
+    std::vector<Queue> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_; // Guards everything below
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    TileFn fn_;
+    void* ctx_;
+    int remaining_;
+    unsigned long long generation_;
+    bool stopping_;
+    TilePoolStats stats_;
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_TILE_POOL_H
@@ -0,0 +1,298 @@
+#ifndef P3CLOCK_TIME_SOURCE_H
+#define P3CLOCK_TIME_SOURCE_H
+
+// Local time from a cheap monotonic counter plus a cached UTC offset.
+//
+// GetLocalTime converts the system time through the time-zone rules on every
+// call, and the clock then formatted all of "HH:MM:SS" again. Here the wall
+// clock is read once and tied to a monotonic counter; after that the local
+// time is counter + base + offset. The slow calls only happen when something
+// can have changed:
+//   - the UTC offset is queried again when the time enters a new quarter hour
+//     of UTC. Offsets are whole quarter hours and zones switch at a whole
+//     local hour, so every DST transition falls on such a boundary;
+//   - the wall clock is compared with the counter every wallCheckMs. A
+//     difference over kJumpToleranceMs (an NTP step, the user setting the
+//     time) is a jump: the base and the offset are taken again;
+//   - Invalidate() forces both, for WM_TIMECHANGE (time or time zone changed).
+// Between two checks the counter's drift against the wall clock stays far
+// below a millisecond per second, and every check re-bases on the wall clock.
+//
+// "HH:MM:SS" is kept with the time and advanced field by field: one second on
+// rewrites only the characters that changed. Any other step (a jump, DST, the
+// first read) formats the whole string.
+//
+// The clock is a template parameter with
+//     long long MonotonicMs(); // steady counter, never goes back
+//     long long UtcMs();       // wall clock, ms since any fixed UTC epoch at midnight
+//     int UtcOffsetMinutes();  // local - UTC right now
+// so the same code runs on Windows and on FakeClock, which drives hours of
+// simulated time (DST transitions and jumps included) in p3timec-check.
+
+#include "clock_geometry.h"
+
+namespace p3clock {
+
+const long long kOffsetPeriodMs = 15 * 60 * 1000; // The UTC offset can only change on these boundaries
+const int kWallCheckMs = 10000;                   // Default period of the wall-clock comparison
+const int kJumpToleranceMs = 250;                 // Counter vs wall clock differences above this are jumps
+
+struct LocalTime {
+    long long ms;    // Local milliseconds since the epoch (continuous across midnight, steps at DST)
+    ClockTime time;  // Broken down
+    int millisecond; // 0-999 into time.second
+    char text[8];    // "HH:MM:SS", no terminator
+    int changed;     // Bit i set when text[i] differs from the previous Now(); all 8 on a full format
+};
+
+struct TimeSourceStats {
+    unsigned long long reads;         // Now() calls
+    unsigned long long wallReads;     // UtcMs() calls
+    unsigned long long offsetQueries; // UtcOffsetMinutes() calls
+    unsigned long long jumps;         // Wall-clock jumps detected by the periodic comparison
+    unsigned long long offsetChanges; // Queries that returned a new offset (DST, time zone)
+    unsigned long long fullFormats;   // Whole "HH:MM:SS" formatted
+    unsigned long long charsWritten;  // Characters of "HH:MM:SS" written in total
+};
+
+inline long long FloorDiv(long long a, long long b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+template <class Clock>
+class TimeSource {
+public:
+    explicit TimeSource(Clock* clock, int wallCheckMs = kWallCheckMs)
+        : clock_(clock), wallCheckMs_(wallCheckMs), synced_(false), baseMs_(0), nextWallCheckMs_(0),
+          offsetFromMs_(0), offsetUntilMs_(0), offsetMinutes_(0), second_(0), formatted_(false) {
+        stats_.reads = stats_.wallReads = stats_.offsetQueries = stats_.jumps = 0;
+        stats_.offsetChanges = stats_.fullFormats = stats_.charsWritten = 0;
+        last_.ms = 0;
+        last_.time.hour = last_.time.minute = last_.time.second = 0;
+        last_.millisecond = 0;
+        FormatTime(last_.time, last_.text);
+        last_.changed = 0;
+    }
+
+    LocalTime Now() {
+        stats_.reads++;
+        long long monoMs = clock_->MonotonicMs();
+        bool synced = false;
+        if (!synced_ || monoMs >= nextWallCheckMs_) {
+            Sync(monoMs);
+            synced = true;
+        }
+        long long utcMs = monoMs + baseMs_;
+        if (utcMs < offsetFromMs_ || utcMs >= offsetUntilMs_) {
+            // Take the offset at the wall clock's own time, so a query right at a
+            // boundary sees the rules on the same side of it as Windows does
+            if (!synced) {
+                Sync(monoMs);
+                utcMs = monoMs + baseMs_;
+            }
+            RefreshOffset(utcMs);
+        }
+        Advance(utcMs + offsetMinutes_ * 60000LL);
+        return last_;
+    }
+
+    // The time or the time zone was changed (WM_TIMECHANGE): read both again on the next Now()
+    void Invalidate() {
+        synced_ = false;
+        offsetFromMs_ = offsetUntilMs_ = 0;
+    }
+
+    int OffsetMinutes() const { return offsetMinutes_; }
+    const TimeSourceStats& Stats() const { return stats_; }
+
+private:
+    void Sync(long long monoMs) {
+        long long utcMs = clock_->UtcMs();
+        stats_.wallReads++;
+        if (synced_) {
+            long long drift = utcMs - (monoMs + baseMs_);
+            if (drift > kJumpToleranceMs || drift < -kJumpToleranceMs) {
+                stats_.jumps++;
+                offsetFromMs_ = offsetUntilMs_ = 0; // A jump can cross a DST transition
+            }
+        } else {
+            offsetFromMs_ = offsetUntilMs_ = 0;
+        }
+        baseMs_ = utcMs - monoMs;
+        nextWallCheckMs_ = monoMs + wallCheckMs_;
+        synced_ = true;
+    }
+
+    void RefreshOffset(long long utcMs) {
+        int minutes = clock_->UtcOffsetMinutes();
+        stats_.offsetQueries++;
+        if (minutes != offsetMinutes_ && stats_.offsetQueries > 1) {
+            stats_.offsetChanges++;
+        }
+        offsetMinutes_ = minutes;
+        offsetFromMs_ = FloorDiv(utcMs, kOffsetPeriodMs) * kOffsetPeriodMs;
+        offsetUntilMs_ = offsetFromMs_ + kOffsetPeriodMs;
+    }
+
+    void Advance(long long localMs) {
+        long long second = FloorDiv(localMs, 1000);
+        last_.ms = localMs;
+        last_.millisecond = (int)(localMs - second * 1000);
+        last_.changed = 0;
+        if (formatted_ && second == second_) {
+            return;
+        }
+        ClockTime& t = last_.time;
+        char* text = last_.text;
+        if (formatted_ && second == second_ + 1) {
+            // Carry from the seconds up, touching only the characters that change
+            int changed = 1 << 7;
+            if (++t.second == 60) {
+                t.second = 0;
+                changed |= 1 << 6;
+                if (++t.minute == 60) {
+                    t.minute = 0;
+                    changed |= 1 << 4 | 1 << 3;
+                    if (++t.hour == 24) {
+                        t.hour = 0;
+                    }
+                    changed |= 1 << 1;
+                    if (t.hour % 10 == 0) changed |= 1 << 0;
+                } else {
+                    changed |= 1 << 4;
+                    if (t.minute % 10 == 0) changed |= 1 << 3;
+                }
+            } else if (t.second % 10 == 0) {
+                changed |= 1 << 6;
+            }
+            for (int i = 0; i < 8; ++i) {
+                if (changed & (1 << i)) {
+                    text[i] = DigitOf(t, i);
+                    stats_.charsWritten++;
+                }
+            }
+            last_.changed = changed;
+        } else {
+            int ofDay = (int)(second - FloorDiv(second, 86400) * 86400);
+            t.hour = ofDay / 3600;
+            t.minute = ofDay / 60 % 60;
+            t.second = ofDay % 60;
+            FormatTime(t, text);
+            last_.changed = 0xff;
+            stats_.fullFormats++;
+            stats_.charsWritten += 8;
+        }
+        second_ = second;
+        formatted_ = true;
+    }
+
+    static char DigitOf(const ClockTime& t, int index) {
+        switch (index) {
+            case 0: return (char)('0' + t.hour / 10);
+            case 1: return (char)('0' + t.hour % 10);
+            case 3: return (char)('0' + t.minute / 10);
+            case 4: return (char)('0' + t.minute % 10);
+            case 6: return (char)('0' + t.second / 10);
+            case 7: return (char)('0' + t.second % 10);
+            default: return ':';
+        }
+    }
+
+    Clock* clock_;
+    int wallCheckMs_;
+    bool synced_;
+    long long baseMs_;          // UTC - counter at the last wall-clock read
+    long long nextWallCheckMs_; // Counter time of the next comparison
+    long long offsetFromMs_;    // UTC quarter hour the cached offset was taken in
+    long long offsetUntilMs_;
+    int offsetMinutes_;
+    long long second_; // Local second last_ shows
+    bool formatted_;
+    LocalTime last_;
+    TimeSourceStats stats_;
+};
+
+const int kFakeClockMaxRules = 16;
+
+// Simulated clock for p3timec-check. Time only moves when the caller
+// advances it; the wall clock can jump on its own, and the local offset
+// follows a list of DST periods. Every read is counted.
+class FakeClock {
+public:
+    FakeClock(long long utcMs, int standardMinutes)
+        : monoMs_(0), utcMs_(utcMs), standardMinutes_(standardMinutes), ruleCount_(0), monoReads_(0), wallReads_(0),
+          offsetReads_(0) {}
+
+    // Between startUtcMs (inclusive) and endUtcMs the offset is standard + dstMinutes
+    bool AddDst(long long startUtcMs, long long endUtcMs, int dstMinutes) {
+        if (ruleCount_ == kFakeClockMaxRules) {
+            return false;
+        }
+        Rule r = {startUtcMs, endUtcMs, dstMinutes};
+        rules_[ruleCount_++] = r;
+        return true;
+    }
+
+    // Time passes: the counter and the wall clock move together
+    void Advance(long long ms) {
+        monoMs_ += ms;
+        utcMs_ += ms;
+    }
+
+    // The wall clock alone is set (NTP step, the user); the counter keeps going
+    void JumpWall(long long ms) { utcMs_ += ms; }
+
+    // A new time zone, as after changing it in the control panel
+    void SetStandardMinutes(int minutes) { standardMinutes_ = minutes; }
+
+    long long MonotonicMs() {
+        monoReads_++;
+        return monoMs_;
+    }
+
+    long long UtcMs() {
+        wallReads_++;
+        return utcMs_;
+    }
+
+    int UtcOffsetMinutes() {
+        offsetReads_++;
+        return OffsetAt(utcMs_);
+    }
+
+    // The slow path as GetLocalTime takes it: offset rules applied to the wall clock. Not counted.
+    int OffsetAt(long long utcMs) const {
+        for (int i = 0; i < ruleCount_; ++i) {
+            if (utcMs >= rules_[i].startUtcMs && utcMs < rules_[i].endUtcMs) {
+                return standardMinutes_ + rules_[i].dstMinutes;
+            }
+        }
+        return standardMinutes_;
+    }
+
+    long long LocalMs() const { return utcMs_ + OffsetAt(utcMs_) * 60000LL; }
+    long long Utc() const { return utcMs_; }
+    unsigned long long MonotonicReads() const { return monoReads_; }
+    unsigned long long WallReads() const { return wallReads_; }
+    unsigned long long OffsetReads() const { return offsetReads_; }
+
+private:
+    struct Rule {
+        long long startUtcMs;
+        long long endUtcMs;
+        int dstMinutes;
+    };
+
+    long long monoMs_;
+    long long utcMs_;
+    int standardMinutes_;
+    Rule rules_[kFakeClockMaxRules];
+    int ruleCount_;
+    unsigned long long monoReads_;
+    unsigned long long wallReads_;
+    unsigned long long offsetReads_;
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_TIME_SOURCE_H
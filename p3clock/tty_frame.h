@@ -0,0 +1,214 @@
+#ifndef P3CLOCK_TTY_FRAME_H
+#define P3CLOCK_TTY_FRAME_H
+
+// Frames of the software renderer as truecolor ANSI text, for the terminal
+// frontend (p3timec-tty), its check (p3timec-check tty) and its benchmark
+// (p3timec-headless bench-tty).
+//
+// One character cell shows two pixels: U+2580 (upper half block) in the
+// upper pixel's color as foreground over the lower pixel's color as
+// background, so a terminal of C x R cells shows a C x 2R frame. Cells whose
+// two pixels match are a space on the background color.
+//
+// TtyScreen remembers the cells the terminal shows and Encode() emits only
+// the ones that changed: a cursor move (CUP, or CUF over a short gap) to the
+// start of each run of changed cells, then the cells, with SGR color changes
+// only where the pen changes. A gap of unchanged cells inside a row is
+// rewritten instead of skipped when that is shorter. The bytes go into a
+// caller-owned buffer, which stops growing once it has held a full frame.
+
+#include <string>
+#include <vector>
+
+#include "framebuffer.h"
+
+namespace p3clock {
+
+struct TtyCell {
+    Argb top;
+    Argb bottom;
+};
+
+inline bool operator==(const TtyCell& a, const TtyCell& b) { return a.top == b.top && a.bottom == b.bottom; }
+inline bool operator!=(const TtyCell& a, const TtyCell& b) { return !(a == b); }
+
+struct TtyEncodeStats {
+    long long cells; // Cells written, rewritten gap cells included
+    long long runs;  // Cursor moves
+    long long bytes;
+};
+
+const char kUpperHalfBlock[] = "\xE2\x96\x80"; // U+2580 in UTF-8
+
+// The cell at (col, row) of a frame twice as tall as the cell grid
+inline TtyCell CellOf(const Framebuffer& frame, int col, int row) {
+    TtyCell cell = {frame.At(col, row * 2), frame.At(col, row * 2 + 1)};
+    return cell;
+}
+
+class TtyScreen {
+public:
+    TtyScreen() : cols_(0), rows_(0), valid_(false), fgValid_(false), bgValid_(false), fg_(0), bg_(0) {}
+
+    int Cols() const { return cols_; }
+    int Rows() const { return rows_; }
+
+    // The terminal size changed: the next Encode() clears and draws everything
+    void Resize(int cols, int rows) {
+        cols_ = cols < 0 ? 0 : cols;
+        rows_ = rows < 0 ? 0 : rows;
+        shown_.resize((size_t)cols_ * rows_);
+        valid_ = false;
+    }
+
+    // Someone else wrote to the terminal: same as a resize to the same size
+    void Invalidate() { valid_ = false; }
+
+    // Append to `out` what turns the terminal into `frame` (Cols() x 2 Rows() pixels)
+    TtyEncodeStats Encode(const Framebuffer& frame, std::string* out) {
+        TtyEncodeStats stats = {0, 0, 0};
+        size_t start = out->size();
+        bool full = !valid_;
+        if (full) {
+            out->append("\x1b[0m\x1b[2J"); // Default colors, then forget whatever was on the screen
+            fgValid_ = bgValid_ = false;
+        }
+        cursorRow_ = -1;
+        cursorCol_ = -1;
+        for (int row = 0; row < rows_; ++row) {
+            TtyCell* shown = &shown_[(size_t)row * cols_];
+            for (int col = 0; col < cols_; ++col) {
+                TtyCell cell = CellOf(frame, col, row);
+                if (!full && cell == shown[col]) {
+                    continue;
+                }
+                MoveTo(row, col, frame, out, &stats);
+                AppendCell(cell, out);
+                stats.cells++;
+                shown[col] = cell;
+                cursorCol_ = col + 1;
+            }
+        }
+        valid_ = true;
+        stats.bytes = (long long)(out->size() - start);
+        return stats;
+    }
+
+private:
+    // Put the cursor on (row, col): nothing if it is there; across a short gap in the row by
+    // rewriting the unchanged cells or CUF, whichever is shorter; anywhere else by CUP
+    void MoveTo(int row, int col, const Framebuffer& frame, std::string* out, TtyEncodeStats* stats) {
+        if (row == cursorRow_ && col == cursorCol_) {
+            return;
+        }
+        char move[32];
+        if (row == cursorRow_ && col > cursorCol_ && col - cursorCol_ <= kMaxRewrite) {
+            size_t moveBytes = FormatCsi(move, col - cursorCol_, -1, 'C');
+            size_t before = out->size();
+            bool fgValid = fgValid_, bgValid = bgValid_;
+            Argb fg = fg_, bg = bg_;
+            for (int c = cursorCol_; c < col; ++c) {
+                AppendCell(CellOf(frame, c, row), out);
+            }
+            if (out->size() - before <= moveBytes) {
+                stats->cells += col - cursorCol_;
+                return;
+            }
+            out->resize(before); // Within capacity: no allocation
+            fgValid_ = fgValid;
+            bgValid_ = bgValid;
+            fg_ = fg;
+            bg_ = bg;
+            out->append(move, moveBytes);
+        } else {
+            out->append(move, FormatCsi(move, row + 1, col + 1, 'H'));
+            cursorRow_ = row;
+        }
+        stats->runs++;
+    }
+
+    // One cell, after the SGR its colors need. A space needs only the background.
+    void AppendCell(const TtyCell& cell, std::string* out) {
+        bool solid = cell.top == cell.bottom;
+        bool setFg = !solid && !(fgValid_ && fg_ == cell.top);
+        bool setBg = !(bgValid_ && bg_ == cell.bottom);
+        if (setFg || setBg) {
+            out->append("\x1b[");
+            if (setFg) {
+                AppendRgb("38;2;", cell.top, out);
+                fg_ = cell.top;
+                fgValid_ = true;
+            }
+            if (setBg) {
+                if (setFg) {
+                    out->push_back(';');
+                }
+                AppendRgb("48;2;", cell.bottom, out);
+                bg_ = cell.bottom;
+                bgValid_ = true;
+            }
+            out->push_back('m');
+        }
+        if (solid) {
+            out->push_back(' ');
+        } else {
+            out->append(kUpperHalfBlock, 3);
+        }
+    }
+
+    static void AppendRgb(const char* prefix, Argb c, std::string* out) {
+        char digits[12];
+        out->append(prefix);
+        out->append(digits, FormatNumber(ArgbRed(c), digits));
+        out->push_back(';');
+        out->append(digits, FormatNumber(ArgbGreen(c), digits));
+        out->push_back(';');
+        out->append(digits, FormatNumber(ArgbBlue(c), digits));
+    }
+
+    static size_t FormatNumber(int n, char* buffer) {
+        char reversed[12];
+        size_t count = 0;
+        do {
+            reversed[count++] = (char)('0' + n % 10);
+            n /= 10;
+        } while (n > 0);
+        for (size_t i = 0; i < count; ++i) {
+            buffer[i] = reversed[count - 1 - i];
+        }
+        return count;
+    }
+
+    // "ESC [ a ; b final", or "ESC [ a final" when b < 0, where a count of 1 can be left out
+    static size_t FormatCsi(char* buffer, int a, int b, char final) {
+        size_t n = 0;
+        buffer[n++] = '\x1b';
+        buffer[n++] = '[';
+        if (b >= 0 || a != 1) {
+            n += FormatNumber(a, buffer + n);
+        }
+        if (b >= 0) {
+            buffer[n++] = ';';
+            n += FormatNumber(b, buffer + n);
+        }
+        buffer[n++] = final;
+        return n;
+    }
+
+    static const int kMaxRewrite = 8; // Longest gap worth trying to rewrite instead of skipping
+
+    int cols_;
+    int rows_;
+    std::vector<TtyCell> shown_; // What the terminal shows, row by row
+    bool valid_;                 // shown_ matches the terminal
+    bool fgValid_;               // fg_ is the terminal's current foreground
+    bool bgValid_;               // bg_ is the terminal's current background
+    Argb fg_;
+    Argb bg_;
+    int cursorRow_;              // Where the last Encode() left the cursor, -1 when unknown
+    int cursorCol_;
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_TTY_FRAME_H
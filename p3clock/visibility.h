@@ -0,0 +1,108 @@
+#ifndef P3CLOCK_VISIBILITY_H
+#define P3CLOCK_VISIBILITY_H
+
+// Visibility of the clock window, so it stops ticking while nobody can see it.
+//
+// The window is hidden while it is minimized, fully covered by other windows
+// or the session is locked. The three conditions are kept apart because they
+// end apart: unlocking a session whose clock is minimized does not make the
+// clock visible. Every Set*() call returns what the window has to do about it:
+// stop its timer when it becomes hidden, or paint one catch-up frame at the
+// current time and re-arm the timer when it becomes visible again.
+//
+// Wakeups (timer ticks, sweep frames) are counted per state, which shows what
+// the idle mode saves. Like TickScheduler the tracker never reads a clock: the
+// calls that need one take the current time in milliseconds.
+
+namespace p3clock {
+
+enum VisibilityState { kStateVisible, kStateMinimized, kStateOccluded, kStateLocked, kVisibilityStateCount };
+
+const char* const kVisibilityStateNames[kVisibilityStateCount] = {"visible", "minimized", "occluded", "locked"};
+
+enum VisibilityAction {
+    kVisibilityNoChange,
+    kVisibilitySuspend, // Became hidden: stop the timer, paint nothing
+    kVisibilityResume   // Visible again: paint the current time now and start ticking again
+};
+
+class VisibilityTracker {
+public:
+    VisibilityTracker() : minimized_(false), occluded_(false), locked_(false), state_(kStateVisible), sinceMs_(0) {
+        for (int i = 0; i < kVisibilityStateCount; ++i) {
+            wakeups_[i] = 0;
+            timeMs_[i] = 0;
+        }
+    }
+
+    // The window was created (visible) at nowMs
+    void Start(long long nowMs) {
+        sinceMs_ = nowMs;
+    }
+
+    VisibilityAction SetMinimized(bool minimized, long long nowMs) {
+        minimized_ = minimized;
+        return Update(nowMs);
+    }
+
+    VisibilityAction SetOccluded(bool occluded, long long nowMs) {
+        occluded_ = occluded;
+        return Update(nowMs);
+    }
+
+    VisibilityAction SetLocked(bool locked, long long nowMs) {
+        locked_ = locked;
+        return Update(nowMs);
+    }
+
+    VisibilityState State() const { return state_; }
+    bool Visible() const { return state_ == kStateVisible; }
+
+    // The window woke up (a timer tick, a sweep frame) in the current state
+    void CountWakeup() {
+        wakeups_[state_]++;
+    }
+
+    unsigned long long Wakeups(VisibilityState state) const {
+        return wakeups_[state];
+    }
+
+    // Time spent in `state` so far, including the current stretch
+    long long TimeInStateMs(VisibilityState state, long long nowMs) const {
+        return timeMs_[state] + (state == state_ ? nowMs - sinceMs_ : 0);
+    }
+
+    double WakeupsPerMinute(VisibilityState state, long long nowMs) const {
+        long long ms = TimeInStateMs(state, nowMs);
+        return ms > 0 ? wakeups_[state] * 60000.0 / ms : 0.0;
+    }
+
+private:
+    VisibilityAction Update(long long nowMs) {
+        // A locked session hides everything; a minimized window cannot also be seen as covered
+        VisibilityState next = locked_ ? kStateLocked : minimized_ ? kStateMinimized : occluded_ ? kStateOccluded : kStateVisible;
+        if (next == state_) {
+            return kVisibilityNoChange;
+        }
+        bool wasVisible = state_ == kStateVisible;
+        timeMs_[state_] += nowMs - sinceMs_;
+        sinceMs_ = nowMs;
+        state_ = next;
+        if (wasVisible) {
+            return kVisibilitySuspend;
+        }
+        return state_ == kStateVisible ? kVisibilityResume : kVisibilityNoChange;
+    }
+
+    bool minimized_;
+    bool occluded_;
+    bool locked_;
+    VisibilityState state_;
+    long long sinceMs_; // When the current state began
+    unsigned long long wakeups_[kVisibilityStateCount];
+    long long timeMs_[kVisibilityStateCount]; // Finished stretches only
+};
+
+} // namespace p3clock
+
+#endif // P3CLOCK_VISIBILITY_H
@@ -0,0 +1,231 @@
+#ifndef P3CLOCK_YUV_H
+#define P3CLOCK_YUV_H
+
+// 0xAARRGGBB frames to planar YUV 4:2:0 (I420) or to RGBA bytes, for the raw
+// video stream of p3timec-headless stream.
+//
+// BT.601 in limited range, the usual integer form:
+//     Y = ((66 R + 129 G + 25 B + 128) >> 8) + 16
+//     U = ((-38 R - 74 G + 112 B + 128) >> 8) + 128
+//     V = ((112 R - 94 G - 18 B + 128) >> 8) + 128
+// U and V take the rounded mean of each 2x2 block (centered chroma, Y4M's
+// C420jpeg). Every intermediate fits an unsigned 16-bit lane once the
+// chroma is biased by 128 << 8, so scalar, SSE2 (8 pixels per step) and AVX2
+// (16) give the same bytes. Alpha is ignored; widths and heights are even.
+
+#include <stdint.h>
+#include <string.h>
+
+#include "framebuffer.h"
+#include "simd.h"
+
+namespace p3clock {
+
+// The Y, U and V planes of one frame, rows `stride` bytes apart (half the width for U and V)
+struct YuvPlanes {
+    uint8_t* y;
+    uint8_t* u;
+    uint8_t* v;
+    int yStride;
+    int uvStride;
+};
+
+inline uint8_t LumaOf(uint32_t r, uint32_t g, uint32_t b) {
+    return (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+// Chroma of the block means; (x + (128 << 8)) >> 8 is (x >> 8) + 128 without a negative shift
+inline uint8_t ChromaUOf(uint32_t r, uint32_t g, uint32_t b) {
+    return (uint8_t)((112 * b - 38 * r - 74 * g + 128 + (128 << 8)) >> 8);
+}
+
+inline uint8_t ChromaVOf(uint32_t r, uint32_t g, uint32_t b) {
+    return (uint8_t)((112 * r - 94 * g - 18 * b + 128 + (128 << 8)) >> 8);
+}
+
+// Columns [x, width) of one row pair
+inline void ArgbToI420RowsScalar(const uint32_t* row0, const uint32_t* row1, int x, int width, uint8_t* y0,
+                                 uint8_t* y1, uint8_t* u, uint8_t* v) {
+    for (; x < width; x += 2) {
+        uint32_t p[4] = {row0[x], row0[x + 1], row1[x], row1[x + 1]};
+        uint32_t r = 2, g = 2, b = 2; // Rounding of the mean
+        for (int i = 0; i < 4; ++i) {
+            uint32_t pr = (p[i] >> 16) & 0xFF, pg = (p[i] >> 8) & 0xFF, pb = p[i] & 0xFF;
+            (i < 2 ? y0 : y1)[x + (i & 1)] = LumaOf(pr, pg, pb);
+            r += pr;
+            g += pg;
+            b += pb;
+        }
+        r >>= 2;
+        g >>= 2;
+        b >>= 2;
+        u[x / 2] = ChromaUOf(r, g, b);
+        v[x / 2] = ChromaVOf(r, g, b);
+    }
+}
+
+#if defined(P3CLOCK_X86_SIMD)
+
+// Eight pixels to their R, G and B in 16-bit lanes
+P3CLOCK_TARGET("sse2")
+inline void SplitRgb8(const uint32_t* p, __m128i* r, __m128i* g, __m128i* b) {
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    __m128i lo = _mm_loadu_si128((const __m128i*)p);
+    __m128i hi = _mm_loadu_si128((const __m128i*)(p + 4));
+    *b = _mm_packs_epi32(_mm_and_si128(lo, mask), _mm_and_si128(hi, mask));
+    *g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 8), mask), _mm_and_si128(_mm_srli_epi32(hi, 8), mask));
+    *r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 16), mask), _mm_and_si128(_mm_srli_epi32(hi, 16), mask));
+}
+
+P3CLOCK_TARGET("sse2")
+inline __m128i Luma8(__m128i r, __m128i g, __m128i b) {
+    __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)), _mm_mullo_epi16(g, _mm_set1_epi16(129))),
+                                _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)), _mm_set1_epi16(128)));
+    return _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+}
+
+// Both rows' channel, summed over horizontal pairs, rounded mean in lanes 0-3
+P3CLOCK_TARGET("sse2")
+inline __m128i BlockMean4(__m128i row0, __m128i row1) {
+    __m128i s = _mm_add_epi16(row0, row1);
+    __m128i pairs = _mm_add_epi32(_mm_and_si128(s, _mm_set1_epi32(0xFFFF)), _mm_srli_epi32(s, 16));
+    __m128i mean = _mm_srli_epi32(_mm_add_epi32(pairs, _mm_set1_epi32(2)), 2);
+    return _mm_packs_epi32(mean, mean);
+}
+
+// c0 * r + c1 * g + c2 * b + bias, wrapping in 16 bits, >> 8; the true value is in [0, 65535]
+P3CLOCK_TARGET("sse2")
+inline __m128i Chroma8(__m128i r, __m128i g, __m128i b, short cr, short cg, short cb) {
+    __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(cr)), _mm_mullo_epi16(g, _mm_set1_epi16(cg))),
+                                _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(cb)), _mm_set1_epi16((short)(128 + (128 << 8)))));
+    return _mm_srli_epi16(sum, 8);
+}
+
+P3CLOCK_TARGET("sse2")
+inline void ArgbToI420RowsSse2(const uint32_t* row0, const uint32_t* row1, int width, uint8_t* y0, uint8_t* y1,
+                               uint8_t* u, uint8_t* v) {
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i r0, g0, b0, r1, g1, b1;
+        SplitRgb8(row0 + x, &r0, &g0, &b0);
+        SplitRgb8(row1 + x, &r1, &g1, &b1);
+        __m128i luma = _mm_packus_epi16(Luma8(r0, g0, b0), Luma8(r1, g1, b1));
+        _mm_storel_epi64((__m128i*)(y0 + x), luma);
+        _mm_storel_epi64((__m128i*)(y1 + x), _mm_srli_si128(luma, 8));
+        __m128i r = BlockMean4(r0, r1), g = BlockMean4(g0, g1), b = BlockMean4(b0, b1);
+        __m128i chroma = _mm_packus_epi16(Chroma8(r, g, b, -38, -74, 112), Chroma8(r, g, b, 112, -94, -18));
+        int u4 = _mm_cvtsi128_si32(chroma); // Four bytes of each
+        int v4 = _mm_cvtsi128_si32(_mm_srli_si128(chroma, 8));
+        memcpy(u + x / 2, &u4, 4);
+        memcpy(v + x / 2, &v4, 4);
+    }
+    ArgbToI420RowsScalar(row0, row1, x, width, y0, y1, u, v);
+}
+
+// 16 pixels to R, G and B in 16-bit lanes, in pixel order (packs works per 128-bit lane)
+P3CLOCK_TARGET("avx2")
+inline void SplitRgb16(const uint32_t* p, __m256i* r, __m256i* g, __m256i* b) {
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    __m256i lo = _mm256_loadu_si256((const __m256i*)p);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(p + 8));
+    *b = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_and_si256(lo, mask), _mm256_and_si256(hi, mask)),
+                                  _MM_SHUFFLE(3, 1, 2, 0));
+    *g = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(lo, 8), mask),
+                                                     _mm256_and_si256(_mm256_srli_epi32(hi, 8), mask)),
+                                  _MM_SHUFFLE(3, 1, 2, 0));
+    *r = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(lo, 16), mask),
+                                                     _mm256_and_si256(_mm256_srli_epi32(hi, 16), mask)),
+                                  _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+P3CLOCK_TARGET("avx2")
+inline __m256i Luma16(__m256i r, __m256i g, __m256i b) {
+    __m256i sum = _mm256_add_epi16(
+        _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(66)), _mm256_mullo_epi16(g, _mm256_set1_epi16(129))),
+        _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(25)), _mm256_set1_epi16(128)));
+    return _mm256_add_epi16(_mm256_srli_epi16(sum, 8), _mm256_set1_epi16(16));
+}
+
+// Rounded block means in lanes 0-7, in order
+P3CLOCK_TARGET("avx2")
+inline __m256i BlockMean8(__m256i row0, __m256i row1) {
+    __m256i s = _mm256_add_epi16(row0, row1);
+    __m256i pairs = _mm256_add_epi32(_mm256_and_si256(s, _mm256_set1_epi32(0xFFFF)), _mm256_srli_epi32(s, 16));
+    __m256i mean = _mm256_srli_epi32(_mm256_add_epi32(pairs, _mm256_set1_epi32(2)), 2);
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(mean, mean), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+P3CLOCK_TARGET("avx2")
+inline __m256i Chroma16(__m256i r, __m256i g, __m256i b, short cr, short cg, short cb) {
+    __m256i sum = _mm256_add_epi16(
+        _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(cr)), _mm256_mullo_epi16(g, _mm256_set1_epi16(cg))),
+        _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(cb)), _mm256_set1_epi16((short)(128 + (128 << 8)))));
+    return _mm256_srli_epi16(sum, 8);
+}
+
+P3CLOCK_TARGET("avx2")
+inline void ArgbToI420RowsAvx2(const uint32_t* row0, const uint32_t* row1, int width, uint8_t* y0, uint8_t* y1,
+                               uint8_t* u, uint8_t* v) {
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i r0, g0, b0, r1, g1, b1;
+        SplitRgb16(row0 + x, &r0, &g0, &b0);
+        SplitRgb16(row1 + x, &r1, &g1, &b1);
+        // [row 0 0-7, row 1 0-7 | row 0 8-15, row 1 8-15] back to one row per half
+        __m256i luma = _mm256_permute4x64_epi64(_mm256_packus_epi16(Luma16(r0, g0, b0), Luma16(r1, g1, b1)),
+                                                _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i*)(y0 + x), _mm256_castsi256_si128(luma));
+        _mm_storeu_si128((__m128i*)(y1 + x), _mm256_extracti128_si256(luma, 1));
+        __m256i r = BlockMean8(r0, r1), g = BlockMean8(g0, g1), b = BlockMean8(b0, b1);
+        __m256i chroma = _mm256_packus_epi16(Chroma16(r, g, b, -38, -74, 112), Chroma16(r, g, b, 112, -94, -18));
+        __m128i uv = _mm256_castsi256_si128(chroma); // U 0-7, V 0-7
+        _mm_storel_epi64((__m128i*)(u + x / 2), uv);
+        _mm_storel_epi64((__m128i*)(v + x / 2), _mm_srli_si128(uv, 8));
+    }
+    ArgbToI420RowsSse2(row0 + x, row1 + x, width - x, y0 + x, y1 + x, u + x / 2, v + x / 2);
+}
+
+#endif // P3CLOCK_X86_SIMD
+
+// The whole view into `planes`; view.width and view.height are even
+inline void ArgbToI420(const PixelView& view, const YuvPlanes& planes, SimdLevel kernel = kSimdAuto) {
+    SimdLevel k = ResolveSimdLevel(kernel);
+    for (int y = 0; y + 1 < view.height; y += 2) {
+        const uint32_t* row0 = view.Row(y);
+        const uint32_t* row1 = view.Row(y + 1);
+        uint8_t* y0 = planes.y + (size_t)y * planes.yStride;
+        uint8_t* y1 = y0 + planes.yStride;
+        uint8_t* u = planes.u + (size_t)(y / 2) * planes.uvStride;
+        uint8_t* v = planes.v + (size_t)(y / 2) * planes.uvStride;
+#if defined(P3CLOCK_X86_SIMD)
+        if (k == kSimdAvx2) {
+            ArgbToI420RowsAvx2(row0, row1, view.width, y0, y1, u, v);
+            continue;
+        }
+        if (k == kSimdSse2) {
+            ArgbToI420RowsSse2(row0, row1, view.width, y0, y1, u, v);
+            continue;
+        }
+#endif
+        (void)k;
+        ArgbToI420RowsScalar(row0, row1, 0, view.width, y0, y1, u, v);
+    }
+}
+
+// The whole view as R, G, B, A bytes (ffmpeg's rgba), rows back to back
+inline void ArgbToRgba(const PixelView& view, uint8_t* out) {
+    for (int y = 0; y < view.height; ++y) {
+        const uint32_t* row = view.Row(y);
+        for (int x = 0; x < view.width; ++x, out += 4) {
+            uint32_t c = row[x];
+            out[0] = (uint8_t)(c >> 16);
+            out[1] = (uint8_t)(c >> 8);
+            out[2] = (uint8_t)c;
+            out[3] = (uint8_t)(c >> 24);
+        }
+    }
+}
+
+} // namespace p3clock
+
+#endif // P3CLOCK_YUV_H
@@ -10,23 +10,36 @@ if sys.platform == "win32":
     except (AttributeError, ImportError):
         pass
 
+shown_time = None
+shown_color = None
+
 def update_time():
-    current_time = time.localtime()
+    global shown_time, shown_color
+
+    # 只讀一次時間：時、分、秒都取自同一個 localtime，不再另外呼叫 strftime
+    now = time.time()
+    current_time = time.localtime(now)
     hour = current_time.tm_hour
     minute = current_time.tm_min
     second = current_time.tm_sec
 
-    time_string = time.strftime("%H:%M:%S")
-    clock_label.config(text=time_string)
+    # 只有文字或顏色變了才更新標籤
+    time_string = "%02d:%02d:%02d" % (hour, minute, second)
+    if time_string != shown_time:
+        clock_label.config(text=time_string)
+        shown_time = time_string
 
     if hour == 0:
-        clock_label.config(fg="#086d28")
-    elif hour == 1 and minute == 0 and second == 0:
-        clock_label.config(fg="#249aff")
+        color = "#086d28"
     else:
-        clock_label.config(fg="#249aff")
-
-    window.after(1000, update_time)
+        color = "#249aff"
+    if color != shown_color:
+        clock_label.config(fg=color)
+        shown_color = color
+
+    # 在下一個整秒之後觸發，而不是固定的 1000 毫秒 (不會漂移或跳過一秒)
+    delay = 1000 - int(now * 1000) % 1000 + 2
+    window.after(delay, update_time)
 
 current_display_font = None
 
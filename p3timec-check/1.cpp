@@ -0,0 +1,304 @@
+// P3 clock checks: the portable code of the Win32 programs run against
+// references on Linux (exact math, frames rendered from scratch, goldens
+// stored in the repo, model terminals and windows). Each check exits with 1
+// when what it compares differs; with no check named, all of them run with
+// their defaults. Builds anywhere with a C++ compiler, e.g.
+//     g++ -O2 -pthread -o p3timec-check p3timec-check/1.cpp
+// and is run from the repository root, where the goldens are found.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../p3clock-tools/heap_counter.h"
+#include "../p3clock-tools/tool_support.h"
+#include "alloc_check.h"
+#include "atlas_check.h"
+#include "cache_check.h"
+#include "check_output.h"
+#include "circle_check.h"
+#include "composite_check.h"
+#include "core_check.h"
+#include "damage_check.h"
+#include "dial_check.h"
+#include "golden_check.h"
+#include "idle_check.h"
+#include "options_check.h"
+#include "paint_check.h"
+#include "resize_check.h"
+#include "ticks_check.h"
+#include "tiles_check.h"
+#include "time_check.h"
+#include "trace_check.h"
+#include "tty_check.h"
+
+static void PrintUsage(FILE* out) {
+    fprintf(out,
+        "usage: p3timec-check [-o PATH]\n"
+        "       p3timec-check CHECK [options] [-o PATH]\n"
+        "\n"
+        "Without CHECK every check runs with its defaults. -o PATH writes the JSON\n"
+        "results there, '-' for stdout. Default: -\n"
+        "\n"
+        "dial: compare the hand and numeral positions from the dial tables with\n"
+        "sin / cos for every angle and every radius up to 8K. Fails when a position\n"
+        "is off by half a pixel or more\n"
+        "  --max-radius N  largest face radius checked. Default: 4320\n"
+        "\n"
+        "circle: the anti-aliased ring kernel against an 8x8 supersampled reference,\n"
+        "and every SIMD kernel the CPU supports against the scalar one. Fails when\n"
+        "the coverage error exceeds the tolerance or a kernel differs\n"
+        "\n"
+        "atlas: draw \"HH:MM:SS\" as the eight glyph atlas copies of the digital\n"
+        "layout and directly with the stroke font, at every font size in the range\n"
+        "(every rounding of the advances), in both colors, centered in rectangles\n"
+        "wider than, as wide as and narrower than the text. Fails on any pixel that\n"
+        "differs\n"
+        "  --min-size N    smallest font size. Default: 6\n"
+        "  --max-size N    largest font size. Default: 200\n"
+        "\n"
+        "cache: replay the brush and font requests of the analog Win32 programs (a\n"
+        "resize drag, maximize / restore, a day of ticks, WM_DESTROY) against the\n"
+        "GDI resource cache with a counting handle factory. Fails when ticks or a\n"
+        "repeated resize create handles, the live handle count grows past the cache\n"
+        "capacity, or handles are left after WM_DESTROY\n"
+        "  --ticks N       ticks to replay. Default: 86400 (a day, across midnight)\n"
+        "\n"
+        "time: run the cached local-time source on a simulated clock through DST\n"
+        "transitions (spring forward, fall back, a half-hour shift) and wall clock\n"
+        "jumps, comparing every read with the time zone rules applied to the wall\n"
+        "clock. Fails when a read is wrong other than right after an unannounced\n"
+        "jump, before the wall clock check, a transition or a jump goes unnoticed,\n"
+        "or \"HH:MM:SS\" does not match the time\n"
+        "  --hours N       simulated hours per scenario. Default: 48\n"
+        "  --max-step N    largest gap between two reads in ms. Default: 1100\n"
+        "  --wall-check N  ms between wall clock checks. Default: 10000\n"
+        "\n"
+        "ticks: drive the second-aligned tick scheduler for hours with simulated\n"
+        "timers that fire late (jitter), run fast or slow against the wall clock\n"
+        "(drift), or stall for 400 ms every 617 s, and report the flip latency from\n"
+        "the second boundary to the tick that shows it (p50 / p99 / max). Fails when\n"
+        "a second is skipped or repeated, a timer fires before the boundary, or the\n"
+        "p99 latency exceeds the bound\n"
+        "  --hours N       simulated hours per timer. Default: 24\n"
+        "  --jitter MS     timer messages arrive 0 to MS - 1 ms late. Default: 16\n"
+        "  --drift PPM     timer clock against the wall clock. Default: 500\n"
+        "  --max-p99 MS    bound on the p99 flip latency. Default: 20\n"
+        "\n"
+        "idle: run the Win32 tick loop with its visibility handling on a simulated\n"
+        "clock through a script of minimize / restore, cover / uncover and lock /\n"
+        "unlock events, and report wakeups per minute in each state. Fails when the\n"
+        "clock wakes up while hidden, ticks at the wrong rate while visible, or\n"
+        "shows a stale time after becoming visible again\n"
+        "  --script LIST   comma-separated EVENT@SECONDS, EVENT one of minimize,\n"
+        "                  restore, cover, uncover, lock, unlock. Default: an hour\n"
+        "                  with every event, including a restore while locked\n"
+        "  --seconds N     simulated time. Default: 3600\n"
+        "\n"
+        "damage: the rectangles the damage tracker invalidates for a second tick,\n"
+        "a minute rollover, an hour rollover and the color change at 01:00:00, for\n"
+        "every layout, against the pixels that change between the two frames. Fails\n"
+        "when a changed pixel is not covered, the damage is full other than for the\n"
+        "color change, or it covers more of the client area than the case allows\n"
+        "(8%%, 25%% and 45%%)\n"
+        "  --layout NAME   digital, moni or moni-only (repeatable). Default: all three\n"
+        "  --size WxH      client area (repeatable). Default: 160x90, 800x400, 480x640\n"
+        "\n"
+        "tiles: every layout rendered in tiles on the thread pool against the same\n"
+        "frame rendered on one thread, at sizes with whole and partial tiles, second\n"
+        "by second across 01:00:00 where the face is rebuilt. Fails on a difference\n"
+        "  --threads N     pool threads. Default: 4\n"
+        "  --seconds N     frames per size and layout. Default: 6\n"
+        "\n"
+        "resize: replay a drag-resize WM_SIZE by WM_SIZE with one rebuild per frame\n"
+        "and the fitted font. Fails when the fitted time is clipped, a frame\n"
+        "rebuilds twice, a size fitted before is measured again, or toggling\n"
+        "maximize / restore creates fonts\n"
+        "  --trace PATH    WM_SIZE log, one \"MS WIDTH HEIGHT\" per line. Default: a\n"
+        "                  recorded drag at 125 Hz mouse input\n"
+        "  --events N      length of the recorded drag. Default: 1000\n"
+        "  --hz N          paints per second. Default: 60\n"
+        "\n"
+        "golden: render every layout at fixed times (midnight green, 00:59:59,\n"
+        "01:00:00, 10:08:30, 12:59:59, 23:59:59) and sizes and compare the frames\n"
+        "with the goldens. Fails when a frame is missing or off. With --timings the\n"
+        "renders are timed too, and the check also fails when the median frame time\n"
+        "(of the fastest of 5 rounds) regressed past the threshold. The baseline is\n"
+        "taken on the machine that compares, with --update timings after building\n"
+        "with -O2, and stays out of the repo\n"
+        "  --golden DIR    goldens. Default: p3timec-check/golden\n"
+        "  --layout NAME   digital, moni or moni-only (repeatable). Default: all three\n"
+        "  --size WxH      frame size (repeatable). Default: 160x90, 800x400, 480x640\n"
+        "  --time HH:MM:SS time to draw (repeatable). Default: the six above\n"
+        "  --tolerance N   allowed difference per channel. Default: 8\n"
+        "  --max-differing N\n"
+        "                  pixels allowed beyond the tolerance. Default: 0\n"
+        "  --timings PATH  time the renders against the baseline in PATH\n"
+        "  --frames N      timed frames per time and round. Default: 50\n"
+        "  --max-regression PCT\n"
+        "                  allowed slowdown of the median against the baseline,\n"
+        "                  0 to skip. Default: 50\n"
+        "  --min-slowdown MS\n"
+        "                  slowdowns below this always pass (timer noise on small\n"
+        "                  frames). Default: 0.05\n"
+        "  --max-frame-ms MS\n"
+        "                  absolute limit on the median, 0 for none; times the\n"
+        "                  renders without --timings too. Default: 0\n"
+        "  --update WHAT   frames, timings or all: rewrite them from this build\n"
+        "                  (timings into the --timings file)\n"
+        "  --diff-dir DIR  write actual, golden and diff PPMs of failed frames here\n"
+        "\n"
+        "paint: time the analog paint against the paint it replaced, which drew\n"
+        "the background, face, border and numerals with every WM_PAINT instead of\n"
+        "copying the face layer built in WM_SIZE; the median of the fastest of 5\n"
+        "rounds counts. Fails when the frames differ; the speedup is printed, and\n"
+        "only fails the run below --min-speedup, as a ratio of two timings it\n"
+        "moves with the load on the machine. Both paints write every pixel, so the\n"
+        "gain narrows as the frame grows (about 2x at 800x400, 1.1x at 3840x2160)\n"
+        "  --layout NAME   moni or moni-only (repeatable). Default: both\n"
+        "  --size WxH      frame size (repeatable). Default: 800x400, 1920x1080,\n"
+        "                  3840x2160\n"
+        "  --frames N      timed frames per paint and round. Default: 20\n"
+        "  --min-speedup X required before / after ratio. Default: not checked\n"
+        "\n"
+        "trace: hammer the paint tracer's ring with concurrent writers while a\n"
+        "reader copies it. Fails when the reader sees a torn or reordered event or\n"
+        "events go missing\n"
+        "  --writers N     threads writing the ring. Default: 4\n"
+        "  --ring-events N events per writer. Default: 200000\n"
+        "\n"
+        "core: drive the window core the Win32 programs are built from\n"
+        "(p3clock/clock_core.h) through a simulated window: every layout and\n"
+        "presentation a program uses, hours of ticks across midnight and DST, drags,\n"
+        "minimize / cover / lock, clock and time zone changes, and the sweep mode.\n"
+        "After every paint the window must equal a frame rendered from scratch.\n"
+        "Fails on a wrong pixel, a stale second, a wakeup while hidden, more than one\n"
+        "rebuild per drag, or erasing under double buffering\n"
+        "  --seconds N     simulated time in tick mode. Default: 3600\n"
+        "  --sweep-seconds S\n"
+        "                  simulated time in sweep mode, 0 to skip. Default: 5\n"
+        "  --hz N          sweep frames per second (60 to 240). Default: 60\n"
+        "  --size WxH      initial client area. Default: 800x400\n"
+        "\n"
+        "alloc: run the window core of every Win32 program through the simulated\n"
+        "window for steady ticks from 10:55:00 (minute and hour rollovers, no\n"
+        "color change) after the first paint and two ticks. Fails when a tick\n"
+        "allocates on the heap, allocates a back buffer surface (the GDI bitmap of\n"
+        "ResizeSurface), or rebuilds the face layer or the glyph atlas. The GDI\n"
+        "brushes and fonts of the ticks are checked by cache\n"
+        "  --size WxH      client area (repeatable). Default: 800x400, 3840x2160\n"
+        "  --seconds N     simulated time. Default: 600\n"
+        "\n"
+        "composite: check the overlay's premultiplied-alpha kernels\n"
+        "(p3clock/composite.h): division by 255 and source-over against floating\n"
+        "point, every SIMD level against scalar on random spans, offsets and tails,\n"
+        "the fade ramps, and every layout drawn on transparent and composed over\n"
+        "black against the window's frame. Fails on any difference\n"
+        "  --spans N       random spans per kernel. Default: 20000\n"
+        "\n"
+        "tty: replay what p3timec-tty writes per tick on a model terminal, which\n"
+        "must show the rendered frame. Fails on a mismatched cell or output the\n"
+        "model does not understand\n"
+        "  --size CxR      terminal columns x rows (repeatable). Default: 80x24,\n"
+        "                  120x40 and 200x60\n"
+        "  --layout NAME   digital, moni or moni-only (repeatable). Default: digital\n"
+        "                  and moni\n"
+        "  --time HH:MM:SS first time shown. Default: 23:59:00 (the color changes\n"
+        "                  at midnight)\n"
+        "  --ticks N       seconds after the first frame. Default: 120\n"
+        "\n"
+        "options: parse p3timec-wall command lines with ParseWallOptions. Fails\n"
+        "when /digital, /analog or /zone: matches anything but a whole option in\n"
+        "any case, e.g. a zone label such as Digital_Lab switches the layout\n");
+}
+
+typedef int (*CheckProc)(p3clock::CommandArgs& args, CheckOutput& output);
+
+struct Check {
+    const char* name;
+    CheckProc run;
+};
+
+// In the order they run: the math first, then the pieces, then whole windows
+static const Check kChecks[] = {
+    {"dial", RunDialCheck},
+    {"circle", RunCircleCheck},
+    {"atlas", RunAtlasCheck},
+    {"cache", RunCacheCheck},
+    {"time", RunTimeCheck},
+    {"ticks", RunTicksCheck},
+    {"idle", RunIdleCheck},
+    {"damage", RunDamageCheck},
+    {"tiles", RunTilesCheck},
+    {"resize", RunResizeCheck},
+    {"golden", RunGoldenCheck},
+    {"paint", RunPaintCheck},
+    {"trace", RunTraceCheck},
+    {"core", RunCoreCheck},
+    {"alloc", RunAllocCheck},
+    {"composite", RunCompositeCheck},
+    {"tty", RunTtyCheck},
+    {"options", RunOptionsCheck},
+};
+static const int kCheckCount = sizeof(kChecks) / sizeof(kChecks[0]);
+
+// Every check with its defaults, the results in one document
+static int RunAllChecks(const char* path) {
+    p3clock::JsonOutput out("p3timec-check");
+    if (!out.Open(path)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Key("checks");
+    json.BeginArray();
+    int failed = 0;
+    for (int i = 0; i < kCheckCount; ++i) {
+        fprintf(stderr, "[%s]\n", kChecks[i].name);
+        p3clock::CommandArgs args("p3timec-check", 0, NULL, PrintUsage);
+        CheckOutput output(&json);
+        if (kChecks[i].run(args, output) != 0) {
+            fprintf(stderr, "[%s] FAILED\n", kChecks[i].name);
+            failed++;
+        }
+    }
+    json.EndArray();
+    json.Field("passed", failed == 0);
+    json.EndObject();
+    fprintf(stderr, "%d of %d checks passed\n", kCheckCount - failed, kCheckCount);
+    if (!out.Close()) {
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    // -o PATH belongs to the program, whichever check runs; the rest go to the check
+    const char* path = "-";
+    std::vector<char*> rest;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else {
+            rest.push_back(argv[i]);
+        }
+    }
+    if (rest.empty()) {
+        return RunAllChecks(path);
+    }
+    for (int i = 0; i < kCheckCount; ++i) {
+        if (strcmp(rest[0], kChecks[i].name) == 0) {
+            p3clock::CommandArgs args("p3timec-check", (int)rest.size() - 1, &rest[0] + 1, PrintUsage);
+            CheckOutput output(path);
+            return kChecks[i].run(args, output);
+        }
+    }
+    if (strcmp(rest[0], "-h") == 0 || strcmp(rest[0], "--help") == 0) {
+        PrintUsage(stdout);
+        return 0;
+    }
+    fprintf(stderr, "p3timec-check: unknown check %s\n", rest[0]);
+    PrintUsage(stderr);
+    return 2;
+}
@@ -0,0 +1,160 @@
+#ifndef P3TIMEC_CHECK_ALLOC_CHECK_H
+#define P3TIMEC_CHECK_ALLOC_CHECK_H
+
+// alloc: what steady-state ticks of the window core allocate, on the heap and
+// as GDI surfaces, through the simulated window (p3clock-tools/sim_window.h).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../p3clock/clock_core.h"
+#include "../p3clock-tools/heap_counter.h"
+#include "../p3clock-tools/sim_window.h"
+#include "../p3clock-tools/tool_support.h"
+#include "check_output.h"
+
+const int kAllocWarmupTicks = 2;
+
+struct AllocRunResult {
+    const char* name;
+    const char* programs;
+    p3clock::FrameSize size;
+    long long ticks;  // Timer messages counted
+    long long paints; // WM_PAINTs among them
+    unsigned long long heapAllocations;
+    unsigned long long heapBytes;
+    long long surfaceAllocations; // Back buffer bitmaps (ResizeSurface)
+    long long faceBuilds;
+    long long atlasBuilds;
+    bool passed;
+};
+
+// WM_CREATE, WM_SIZE and the first WM_PAINT, then kAllocWarmupTicks ticks, then `seconds` of
+// ticks from 10:55:00 (minute rollovers and the hour rollover, no color change) during which
+// nothing may be allocated
+template <class Layout, class Presentation>
+static AllocRunResult RunAllocCore(const char* name, const char* programs, p3clock::FrameSize size, int seconds) {
+    typedef p3clock::ClockCore<Layout, Presentation, p3clock::SimBackend> Core;
+    AllocRunResult r;
+    r.name = name;
+    r.programs = programs;
+    r.size = size;
+    p3clock::CoreSimClock clock(1780272000000LL + 10LL * 3600000 + 55LL * 60000, 0);
+    p3clock::SimBackend backend(&clock, Core::EraseBackground());
+    Core core(&backend, &clock, 0);
+    core.Create();
+    backend.SetClientSize(size.width, size.height);
+    core.Size(size.width, size.height, false);
+    core.Paint();
+
+    unsigned long long heapBefore = 0, bytesBefore = 0;
+    long long paintsBefore = 0, surfacesBefore = 0, facesBefore = 0, atlasesBefore = 0;
+    r.ticks = 0;
+    for (int i = 0; clock.elapsedMs < seconds * 1000LL || i <= kAllocWarmupTicks; ++i) {
+        if (i == kAllocWarmupTicks) {
+            heapBefore = p3clock::HeapAllocations();
+            bytesBefore = p3clock::HeapBytesAllocated();
+            paintsBefore = backend.paints;
+            surfacesBefore = backend.backBufferAllocations;
+            facesBefore = backend.painter.FaceBuilds();
+            atlasesBefore = backend.painter.AtlasBuilds();
+        }
+        clock.Step(backend.timerDueMs > clock.elapsedMs ? backend.timerDueMs - clock.elapsedMs : 1000);
+        backend.timerArmed = false;
+        core.Timer();
+        if (backend.HasInvalid()) {
+            core.Paint();
+        }
+        r.ticks += i >= kAllocWarmupTicks ? 1 : 0;
+    }
+    r.heapAllocations = p3clock::HeapAllocations() - heapBefore;
+    r.heapBytes = p3clock::HeapBytesAllocated() - bytesBefore;
+    r.paints = backend.paints - paintsBefore;
+    r.surfaceAllocations = backend.backBufferAllocations - surfacesBefore;
+    r.faceBuilds = backend.painter.FaceBuilds() - facesBefore;
+    r.atlasBuilds = backend.painter.AtlasBuilds() - atlasesBefore;
+    r.passed = r.paints > 0 && r.heapAllocations == 0 && r.surfaceAllocations == 0 && r.faceBuilds == 0 &&
+               r.atlasBuilds == 0;
+    return r;
+}
+
+static int RunAllocCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    std::vector<p3clock::FrameSize> sizes;
+    int seconds = 600;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--size")) {
+            p3clock::FrameSize size;
+            ok = p3clock::ParseSize(value, &size.width, &size.height);
+            if (ok) sizes.push_back(size);
+        } else if (args.Is("--seconds")) {
+            seconds = atoi(value);
+            ok = seconds > 0;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (sizes.empty()) {
+        p3clock::FrameSize defaults[] = {{800, 400}, {3840, 2160}};
+        sizes.assign(defaults, defaults + 2);
+    }
+
+    using namespace p3clock;
+    std::vector<AllocRunResult> results;
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        results.push_back(RunAllocCore<DigitalLayoutPolicy, DirectPresentation>(
+            "digital-direct", "p3timec, p3timec-32-1", sizes[s], seconds));
+        results.push_back(RunAllocCore<DigitalLayoutPolicy, BufferedPresentation>(
+            "digital-buffered", "p3timec-32-2", sizes[s], seconds));
+        results.push_back(RunAllocCore<AnalogDigitalLayoutPolicy, BufferedPresentation>(
+            "moni-buffered", "p3timec-32-moni-1", sizes[s], seconds));
+        results.push_back(RunAllocCore<AnalogLayoutPolicy, BufferedPresentation>(
+            "moni-only-buffered", "p3timec-32-moni-only-1", sizes[s], seconds));
+    }
+
+    bool passed = true;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const AllocRunResult& r = results[i];
+        passed = passed && r.passed;
+        fprintf(stderr, "%s %-18s %4dx%-4d %5lld ticks %5lld paints  %llu heap allocations (%llu bytes)  "
+                        "%lld surfaces  %lld face builds  %lld atlas builds\n",
+                r.passed ? "ok  " : "FAIL", r.name, r.size.width, r.size.height, r.ticks, r.paints,
+                r.heapAllocations, r.heapBytes, r.surfaceAllocations, r.faceBuilds, r.atlasBuilds);
+    }
+
+    if (!output.Begin("alloc")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("seconds", seconds);
+    json.Field("passed", passed);
+    json.Key("runs");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const AllocRunResult& r = results[i];
+        json.BeginObject();
+        json.Field("core", r.name);
+        json.Field("programs", r.programs);
+        json.Field("width", r.size.width);
+        json.Field("height", r.size.height);
+        json.Field("passed", r.passed);
+        json.Field("ticks", r.ticks);
+        json.Field("paints", r.paints);
+        json.Field("heap_allocations", (long long)r.heapAllocations);
+        json.Field("heap_bytes", (long long)r.heapBytes);
+        json.Field("surface_allocations", r.surfaceAllocations);
+        json.Field("face_builds", r.faceBuilds);
+        json.Field("atlas_builds", r.atlasBuilds);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_ALLOC_CHECK_H
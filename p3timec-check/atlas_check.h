@@ -0,0 +1,158 @@
+#ifndef P3TIMEC_CHECK_ATLAS_CHECK_H
+#define P3TIMEC_CHECK_ATLAS_CHECK_H
+
+// atlas: the eight glyph atlas copies that draw the time against the same
+// text drawn directly with the stroke font.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../p3clock/glyph_atlas.h"
+#include "../p3clock/soft_clock.h"
+#include "../p3clock/stroke_font.h"
+#include "check_output.h"
+
+// Every digit in both atlas rows
+static const p3clock::ClockTime kAtlasTimes[] = {
+    {0, 12, 34},  // Green
+    {16, 57, 8},  // Blue
+    {23, 49, 59},
+};
+static const int kAtlasTimeCount = sizeof(kAtlasTimes) / sizeof(kAtlasTimes[0]);
+
+// Width of the rectangle the text is centered in, from the text width and the digit advance
+enum AtlasRectWidth { kAtlasRectWide, kAtlasRectExact, kAtlasRectNarrow, kAtlasRectHalf, kAtlasRectWidthCount };
+
+static const char* const kAtlasRectWidthNames[kAtlasRectWidthCount] = {"wide", "exact", "narrow", "half"};
+
+static int AtlasRectWidthFor(AtlasRectWidth kind, int textWidth, int digitAdvance) {
+    switch (kind) {
+        case kAtlasRectWide:   return textWidth + 41;                    // Odd space left over
+        case kAtlasRectExact:  return textWidth;
+        case kAtlasRectNarrow: return textWidth - 2 * digitAdvance - 1; // Text wider than the rectangle
+        default:               return textWidth / 2;
+    }
+}
+
+struct AtlasCaseResult {
+    AtlasRectWidth rect;
+    int frames;
+    int differing;         // Frames where the copies and the direct text disagree
+    long long maxPixelsOff; // In the worst of them
+    int firstSize;         // Font size of the first differing frame, 0 for none
+};
+
+// The frame extends 3 pixels past the rectangle on the sides and 2 above, so text wider than the
+// rectangle is drawn past it and clipped at the frame edge, the way DrawText does in a window
+static long long CompareAtlasText(int size, AtlasRectWidth kind, const p3clock::ClockTime& t,
+                                  p3clock::Framebuffer* atlas, p3clock::Framebuffer* copied, p3clock::Framebuffer* direct) {
+    char text[9];
+    p3clock::FormatTime(t, text);
+    text[8] = 0;
+    int width = AtlasRectWidthFor(kind, p3clock::StrokeTextWidth(text, size), p3clock::StrokeAdvance('0', size));
+    if (width < 1) width = 1;
+    int height = p3clock::StrokeLineHeight(size) + 3;
+    p3clock::DamageRect r = {3, 2, 3 + width, 2 + height};
+
+    p3clock::GlyphAtlasLayout layout = p3clock::BuildTimeGlyphAtlas(atlas, size);
+    p3clock::TimeTextLayout textLayout = p3clock::LayoutTimeText(layout, r.left, r.top, r.right, r.bottom);
+    p3clock::GlyphBlit blits[8];
+    p3clock::TimeTextBlits(layout, textLayout, t, blits);
+    copied->Resize(r.right + 3, r.bottom);
+    p3clock::Clear(copied, p3clock::kArgbBlack);
+    for (int i = 0; i < 8; ++i) {
+        p3clock::Blit(copied, blits[i].dstX, blits[i].dstY, *atlas, blits[i].srcX, blits[i].srcY, blits[i].width,
+                      blits[i].height);
+    }
+
+    direct->Resize(r.right + 3, r.bottom);
+    p3clock::Clear(direct, p3clock::kArgbBlack);
+    p3clock::DrawStrokeTextCentered(direct, text, r.left, r.top, r.right, r.bottom, size, p3clock::kStrokeBold,
+                                    p3clock::ClockColor(t));
+
+    long long off = 0;
+    for (size_t i = 0; i < direct->pixels.size(); ++i) {
+        off += copied->pixels[i] != direct->pixels[i] ? 1 : 0;
+    }
+    return off;
+}
+
+static int RunAtlasCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    int minSize = 6;
+    int maxSize = 200;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--min-size")) {
+            minSize = atoi(value);
+            ok = minSize > 0 && minSize <= 1000;
+        } else if (args.Is("--max-size")) {
+            maxSize = atoi(value);
+            ok = maxSize > 0 && maxSize <= 1000;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (maxSize < minSize) {
+        fprintf(stderr, "p3timec-check: --max-size is below --min-size\n");
+        return 2;
+    }
+
+    // Every size in the range, so every way the advances round (0.556 and 0.278 em) comes up
+    bool passed = true;
+    std::vector<AtlasCaseResult> results;
+    p3clock::Framebuffer atlas, copied, direct;
+    for (int k = 0; k < kAtlasRectWidthCount; ++k) {
+        AtlasCaseResult r = {static_cast<AtlasRectWidth>(k), 0, 0, 0, 0};
+        for (int size = minSize; size <= maxSize; ++size) {
+            for (int t = 0; t < kAtlasTimeCount; ++t) {
+                long long off = CompareAtlasText(size, r.rect, kAtlasTimes[t], &atlas, &copied, &direct);
+                r.frames++;
+                if (off > 0) {
+                    if (r.differing == 0) r.firstSize = size;
+                    r.differing++;
+                    if (off > r.maxPixelsOff) r.maxPixelsOff = off;
+                }
+            }
+        }
+        bool ok = r.differing == 0;
+        fprintf(stderr, "%-6s sizes %d-%d %s  %5d frames  %d differ", kAtlasRectWidthNames[k], minSize, maxSize,
+                ok ? "ok  " : "FAIL", r.frames, r.differing);
+        if (!ok) {
+            fprintf(stderr, " (first at size %d, up to %lld px)", r.firstSize, r.maxPixelsOff);
+        }
+        fprintf(stderr, "\n");
+        passed = passed && ok;
+        results.push_back(r);
+    }
+
+    if (!output.Begin("atlas")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("min_size", minSize);
+    json.Field("max_size", maxSize);
+    json.Field("passed", passed);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const AtlasCaseResult& r = results[i];
+        json.BeginObject();
+        json.Field("rect", kAtlasRectWidthNames[r.rect]);
+        json.Field("passed", r.differing == 0);
+        json.Field("frames", r.frames);
+        json.Field("differing", r.differing);
+        json.Field("max_pixels_off", r.maxPixelsOff);
+        json.Field("first_size", r.firstSize);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_ATLAS_CHECK_H
@@ -0,0 +1,195 @@
+#ifndef P3TIMEC_CHECK_CACHE_CHECK_H
+#define P3TIMEC_CHECK_CACHE_CHECK_H
+
+// cache: the brush and font requests of the analog Win32 programs replayed
+// against the GDI resource cache, on counted handles (p3clock-tools/gdi_counting.h).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../p3clock/font_fit.h"
+#include "../p3clock/resource_cache.h"
+#include "../p3clock/soft_clock.h"
+#include "../p3clock-tools/gdi_counting.h"
+#include "check_output.h"
+
+// The requests RebuildForSize makes in p3timec-32-moni-1 / moni-only-1: the fonts the digital
+// font fit measures and the digital font (moni-1 only), the glyph atlas background (moni-1
+// only) and BuildFaceLayer's background brush and numeral font
+static void ReplaySize(p3clock::CountingCache* cache, p3clock::FontFitCache* fit, p3clock::ClockLayout layout, int width, int height) {
+    p3clock::ClockGeometry g = p3clock::ComputeClockGeometry(layout, width, height);
+    if (g.hasDigital) {
+        p3clock::CachedFontMeasurer measurer = {cache};
+        cache->Get(p3clock::FontKey(fit->Get(measurer, g.digitalRect.right - g.digitalRect.left, height), p3clock::kFwBold));
+        cache->Get(p3clock::BrushKey(p3clock::kColorRefBlack));
+    }
+    cache->Get(p3clock::BrushKey(p3clock::kColorRefBlack));
+    cache->Get(p3clock::FontKey(g.numeralFontSize, p3clock::kFwNormal));
+}
+
+struct CachePhaseResult {
+    const char* name;
+    long long requests;
+    long long creates; // Factory calls during the phase
+    int liveBefore;
+    int liveAfter;
+    int liveMax;
+};
+
+static CachePhaseResult BeginCachePhase(const char* name, p3clock::CountingCache* cache) {
+    const p3clock::ResourceCacheStats& stats = cache->Stats();
+    CachePhaseResult r = {name, -(long long)(stats.hits + stats.misses), -cache->GetFactory().creates,
+                          cache->GetFactory().live, 0, cache->GetFactory().live};
+    return r;
+}
+
+static void EndCachePhase(CachePhaseResult* r, p3clock::CountingCache* cache) {
+    const p3clock::ResourceCacheStats& stats = cache->Stats();
+    r->requests += (long long)(stats.hits + stats.misses);
+    r->creates += cache->GetFactory().creates;
+    r->liveAfter = cache->GetFactory().live;
+}
+
+struct CacheCheckResult {
+    const char* variant;
+    CachePhaseResult phases[4]; // drag, toggle, ticks, destroy
+    p3clock::ResourceCacheStats stats;
+    long long badDestroys;
+    bool passed;
+};
+
+static CacheCheckResult CheckCache(const char* variant, p3clock::ClockLayout layout, int ticks) {
+    CacheCheckResult r;
+    r.variant = variant;
+    p3clock::CountingCache cache;
+    p3clock::FontFitCache fit;
+
+    // Window created at 800x400 and dragged out to 1920x1080 and back, 8 pixels per WM_SIZE
+    CachePhaseResult& drag = r.phases[0];
+    drag = BeginCachePhase("drag", &cache);
+    for (int step = 0; step <= 280; ++step) {
+        int grow = step <= 140 ? step : 280 - step;
+        ReplaySize(&cache, &fit, layout, 800 + grow * 8, 400 + grow * 5);
+        if (cache.GetFactory().live > drag.liveMax) drag.liveMax = cache.GetFactory().live;
+    }
+    EndCachePhase(&drag, &cache);
+
+    // Maximize / restore: both sizes' fonts stay cached
+    CachePhaseResult& toggle = r.phases[1];
+    ReplaySize(&cache, &fit, layout, 3840, 2160);
+    ReplaySize(&cache, &fit, layout, 800, 400);
+    toggle = BeginCachePhase("toggle", &cache);
+    for (int i = 0; i < 100; ++i) {
+        ReplaySize(&cache, &fit, layout, i % 2 ? 800 : 3840, i % 2 ? 400 : 2160);
+        if (cache.GetFactory().live > toggle.liveMax) toggle.liveMax = cache.GetFactory().live;
+    }
+    EndCachePhase(&toggle, &cache);
+
+    // Ticks from 23:00, across the color flips at midnight and 1 AM. WM_PAINT only asks for
+    // the face's brush and font when the color change rebuilds the face layer.
+    CachePhaseResult& tick = r.phases[2];
+    tick = BeginCachePhase("ticks", &cache);
+    p3clock::ClockTime t = {23, 0, 0};
+    p3clock::ClockGeometry g = p3clock::ComputeClockGeometry(layout, 800, 400);
+    p3clock::Argb faceColor = p3clock::ClockColor(t);
+    for (int i = 0; i < ticks; ++i) {
+        t = p3clock::AddSeconds(t, 1);
+        if (p3clock::ClockColor(t) != faceColor) {
+            faceColor = p3clock::ClockColor(t);
+            cache.Get(p3clock::BrushKey(p3clock::kColorRefBlack));
+            cache.Get(p3clock::FontKey(g.numeralFontSize, p3clock::kFwNormal));
+        }
+        if (cache.GetFactory().live > tick.liveMax) tick.liveMax = cache.GetFactory().live;
+    }
+    EndCachePhase(&tick, &cache);
+
+    // WM_DESTROY
+    CachePhaseResult& destroy = r.phases[3];
+    destroy = BeginCachePhase("destroy", &cache);
+    cache.Clear();
+    EndCachePhase(&destroy, &cache);
+
+    r.stats = cache.Stats();
+    r.badDestroys = cache.GetFactory().badDestroys;
+    r.passed = drag.liveMax <= p3clock::kResourceCacheCapacity &&
+               toggle.creates == 0 && toggle.liveAfter == toggle.liveBefore &&
+               tick.creates == 0 && tick.liveMax == tick.liveBefore &&
+               destroy.liveAfter == 0 && r.stats.live == 0 &&
+               r.stats.destroys == r.stats.creates && r.badDestroys == 0;
+    return r;
+}
+
+static int RunCacheCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    int ticks = 86400;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--ticks")) {
+            ticks = atoi(value);
+            ok = ticks > 0;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    CacheCheckResult results[2] = {
+        CheckCache("p3timec-32-moni-1", p3clock::kLayoutAnalogDigital, ticks),
+        CheckCache("p3timec-32-moni-only-1", p3clock::kLayoutAnalog, ticks),
+    };
+    bool passed = true;
+    for (int i = 0; i < 2; ++i) {
+        const CacheCheckResult& r = results[i];
+        passed = passed && r.passed;
+        fprintf(stderr, "%-24s %s  %llu hits  %llu misses  ", r.variant, r.passed ? "ok  " : "FAIL",
+                r.stats.hits, r.stats.misses);
+        for (int p = 0; p < 4; ++p) {
+            fprintf(stderr, "%s: %lld created, live %d -> %d%s", r.phases[p].name, r.phases[p].creates,
+                    r.phases[p].liveBefore, r.phases[p].liveAfter, p < 3 ? "  " : "\n");
+        }
+    }
+
+    if (!output.Begin("cache")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("capacity", p3clock::kResourceCacheCapacity);
+    json.Field("ticks", ticks);
+    json.Field("passed", passed);
+    json.Key("results");
+    json.BeginArray();
+    for (int i = 0; i < 2; ++i) {
+        const CacheCheckResult& r = results[i];
+        json.BeginObject();
+        json.Field("variant", r.variant);
+        json.Field("passed", r.passed);
+        json.Field("hits", (long long)r.stats.hits);
+        json.Field("misses", (long long)r.stats.misses);
+        json.Field("creates", (long long)r.stats.creates);
+        json.Field("destroys", (long long)r.stats.destroys);
+        json.Field("bad_destroys", r.badDestroys);
+        json.Key("phases");
+        json.BeginArray();
+        for (int p = 0; p < 4; ++p) {
+            const CachePhaseResult& phase = r.phases[p];
+            json.BeginObject();
+            json.Field("name", phase.name);
+            json.Field("requests", phase.requests);
+            json.Field("creates", phase.creates);
+            json.Field("live_before", phase.liveBefore);
+            json.Field("live_after", phase.liveAfter);
+            json.Field("live_max", phase.liveMax);
+            json.EndObject();
+        }
+        json.EndArray();
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_CACHE_CHECK_H
@@ -0,0 +1,57 @@
+#ifndef P3TIMEC_CHECK_CHECK_OUTPUT_H
+#define P3TIMEC_CHECK_CHECK_OUTPUT_H
+
+// Where a check writes its JSON result. Run alone ("p3timec-check dial -o
+// dial.json") a check gets a document of its own; run with the others, each
+// result is one object of the "checks" array in the shared document. A check
+// writes through Begin() / Json() / End():
+//
+//     if (!output.Begin("dial")) {
+//         return 1;
+//     }
+//     p3clock::JsonWriter& json = output.Json();
+//     json.Field("passed", passed);
+//     return output.End(passed);
+
+#include "../p3clock-tools/tool_support.h"
+
+class CheckOutput {
+public:
+    // A document of its own at path ("-" for stdout)
+    explicit CheckOutput(const char* path) : path_(path), own_("p3timec-check"), json_(NULL) {}
+
+    // One object of an array another CheckOutput user has open
+    explicit CheckOutput(p3clock::JsonWriter* shared) : path_(NULL), own_("p3timec-check"), json_(shared) {}
+
+    // Opens the document if the check has one of its own and starts the result object;
+    // false, reported, when the file cannot be opened
+    bool Begin(const char* check) {
+        if (path_) {
+            if (!own_.Open(path_)) {
+                return false;
+            }
+            json_ = &own_.Json();
+        }
+        json_->BeginObject();
+        json_->Field("check", check);
+        return true;
+    }
+
+    p3clock::JsonWriter& Json() { return *json_; }
+
+    // Ends the result object: the check's exit status, 1 when it failed or its file did not write
+    int End(bool passed) {
+        json_->EndObject();
+        if (path_ && !own_.Close()) {
+            return 1;
+        }
+        return passed ? 0 : 1;
+    }
+
+private:
+    const char* path_; // NULL when writing into a shared document
+    p3clock::JsonOutput own_;
+    p3clock::JsonWriter* json_;
+};
+
+#endif // P3TIMEC_CHECK_CHECK_OUTPUT_H
@@ -0,0 +1,181 @@
+#ifndef P3TIMEC_CHECK_CIRCLE_CHECK_H
+#define P3TIMEC_CHECK_CIRCLE_CHECK_H
+
+// circle: the anti-aliased ring kernels (p3clock/raster_circle.h), the scalar
+// one against an 8x8 supersampled reference, every SIMD level against scalar.
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include "../p3clock/raster_circle.h"
+#include "../p3clock/simd.h"
+#include "../p3clock/soft_clock.h"
+#include "check_output.h"
+
+struct CircleAccuracy {
+    float radius;
+    float width;      // Ring width, 0 for a disc
+    double maxError;  // Largest coverage error, in 1/255
+    double meanError; // Mean coverage error over the pixels either side covers, in 1/255
+};
+
+// Fraction of 8x8 samples of pixel (x, y) that lie in the ring
+static double SupersampledRingCoverage(int x, int y, double cx, double cy, double outer, double inner) {
+    int inside = 0;
+    for (int sy = 0; sy < 8; ++sy) {
+        for (int sx = 0; sx < 8; ++sx) {
+            double ex = x + (sx + 0.5) / 8.0 - cx;
+            double ey = y + (sy + 0.5) / 8.0 - cy;
+            double d2 = ex * ex + ey * ey;
+            if (d2 <= outer * outer && (inner <= 0.0 || d2 >= inner * inner)) {
+                inside++;
+            }
+        }
+    }
+    return inside / 64.0;
+}
+
+// Draw a white ring on black with the scalar kernel and compare each pixel to the reference
+static CircleAccuracy MeasureCircleAccuracy(float radius, float width) {
+    CircleAccuracy r = {radius, width, 0.0, 0.0};
+    int size = (int)(radius * 2.0f) + 8;
+    float cx = size * 0.5f + 0.3f, cy = size * 0.5f + 0.7f; // Off the pixel grid
+    float inner = width > 0.0f ? radius - width : 0.0f;
+    p3clock::Framebuffer fb;
+    fb.Resize(size, size);
+    p3clock::Clear(&fb, p3clock::kArgbBlack);
+    p3clock::DamageRect clip = {0, 0, size, size};
+    p3clock::DrawAARing(&fb.pixels[0], fb.width, clip, cx, cy, radius, inner, 0xFFFFFFFFu, p3clock::kSimdScalar);
+    double total = 0.0;
+    long long counted = 0;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            double expected = 255.0 * SupersampledRingCoverage(x, y, cx, cy, radius, inner);
+            double actual = (double)(fb.At(x, y) & 0xFF);
+            if (expected == 0.0 && actual == 0.0) continue;
+            double error = fabs(actual - expected);
+            if (error > r.maxError) r.maxError = error;
+            total += error;
+            counted++;
+        }
+    }
+    r.meanError = counted ? total / counted : 0.0;
+    return r;
+}
+
+struct CircleAgreement {
+    p3clock::SimdLevel kernel;
+    float radius;
+    float width;          // Ring width, 0 for a disc
+    long long pixels;     // Pixels compared
+    long long mismatches; // Pixels that differ from the scalar kernel's output
+};
+
+// The same rings drawn with `kernel` and with the scalar kernel at a few sub-pixel centers,
+// each in a buffer just large enough for it
+static CircleAgreement CompareCircleKernel(p3clock::SimdLevel kernel, float radius, float width) {
+    CircleAgreement r = {kernel, radius, width, 0, 0};
+    int size = (int)(radius * 2.0f) + 8;
+    float inner = width > 0.0f ? radius - width : 0.0f;
+    p3clock::Framebuffer reference, fb;
+    reference.Resize(size, size);
+    fb.Resize(size, size);
+    p3clock::DamageRect clip = {0, 0, size, size};
+    for (int i = 0; i < 8; ++i) {
+        float cx = size * 0.5f + (i % 7) * 0.13f;
+        float cy = size * 0.5f + (i % 5) * 0.19f;
+        p3clock::Clear(&reference, 0xFF102030u);
+        p3clock::Clear(&fb, 0xFF102030u);
+        p3clock::Argb color = i & 1 ? p3clock::kArgbBlue : p3clock::kArgbGreen;
+        p3clock::DrawAARing(&reference.pixels[0], size, clip, cx, cy, radius, inner, color, p3clock::kSimdScalar);
+        p3clock::DrawAARing(&fb.pixels[0], size, clip, cx, cy, radius, inner, color, kernel);
+        for (size_t k = 0; k < fb.pixels.size(); ++k) {
+            if (fb.pixels[k] != reference.pixels[k]) r.mismatches++;
+        }
+        r.pixels += (long long)fb.pixels.size();
+    }
+    return r;
+}
+
+static int RunCircleCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    while (args.Next()) {
+        args.Unknown();
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    // A 1-pixel linear ramp is within about 1/8 of the exact area coverage
+    static const double kMaxErrorTolerance = 32.0;
+    static const float kAccuracyRadii[] = {3.3f, 10.0f, 32.5f, 180.0f};
+    static const float kAccuracyWidths[] = {1.0f, 2.0f, 6.5f, 0.0f};
+    // Numeral-sized to the face radius of the moni layout at 1080p and 4K
+    static const float kAgreementRadii[] = {3.3f, 10.0f, 32.5f, 180.0f, 520.0f, 1060.0f};
+    static const float kAgreementWidths[] = {2.0f, 0.0f};
+
+    bool passed = true;
+    std::vector<CircleAccuracy> accuracy;
+    for (size_t r = 0; r < sizeof(kAccuracyRadii) / sizeof(kAccuracyRadii[0]); ++r) {
+        for (size_t w = 0; w < sizeof(kAccuracyWidths) / sizeof(kAccuracyWidths[0]); ++w) {
+            if (kAccuracyWidths[w] >= kAccuracyRadii[r]) continue;
+            CircleAccuracy a = MeasureCircleAccuracy(kAccuracyRadii[r], kAccuracyWidths[w]);
+            fprintf(stderr, "radius %7.1f width %4.1f  max error %5.1f/255  mean %5.2f/255\n",
+                    a.radius, a.width, a.maxError, a.meanError);
+            passed = passed && a.maxError <= kMaxErrorTolerance;
+            accuracy.push_back(a);
+        }
+    }
+
+    p3clock::SimdLevel best = p3clock::ResolveSimdLevel(p3clock::kSimdAuto);
+    std::vector<CircleAgreement> agreement;
+    for (int k = p3clock::kSimdScalar + 1; k <= best; ++k) {
+        for (size_t r = 0; r < sizeof(kAgreementRadii) / sizeof(kAgreementRadii[0]); ++r) {
+            for (size_t w = 0; w < sizeof(kAgreementWidths) / sizeof(kAgreementWidths[0]); ++w) {
+                CircleAgreement a = CompareCircleKernel(static_cast<p3clock::SimdLevel>(k), kAgreementRadii[r],
+                                                        kAgreementWidths[w]);
+                fprintf(stderr, "%-6s radius %7.1f %-5s  %lld of %lld pixels differ from scalar\n",
+                        p3clock::kSimdLevelNames[k], a.radius, a.width > 0.0f ? "ring" : "disc", a.mismatches,
+                        a.pixels);
+                passed = passed && a.mismatches == 0;
+                agreement.push_back(a);
+            }
+        }
+    }
+
+    if (!output.Begin("circle")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("best_kernel", p3clock::kSimdLevelNames[best]);
+    json.Field("max_error_tolerance", kMaxErrorTolerance);
+    json.Field("passed", passed);
+    json.Key("accuracy");
+    json.BeginArray();
+    for (size_t i = 0; i < accuracy.size(); ++i) {
+        const CircleAccuracy& a = accuracy[i];
+        json.BeginObject();
+        json.Field("radius", (double)a.radius);
+        json.Field("width", (double)a.width);
+        json.Field("max_error", a.maxError);
+        json.Field("mean_error", a.meanError);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.Key("kernels");
+    json.BeginArray();
+    for (size_t i = 0; i < agreement.size(); ++i) {
+        const CircleAgreement& a = agreement[i];
+        json.BeginObject();
+        json.Field("kernel", p3clock::kSimdLevelNames[a.kernel]);
+        json.Field("radius", (double)a.radius);
+        json.Field("width", (double)a.width);
+        json.Field("pixels", a.pixels);
+        json.Field("mismatches", a.mismatches);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_CIRCLE_CHECK_H
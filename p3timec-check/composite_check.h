@@ -0,0 +1,244 @@
+#ifndef P3TIMEC_CHECK_COMPOSITE_CHECK_H
+#define P3TIMEC_CHECK_COMPOSITE_CHECK_H
+
+// composite: the overlay's premultiplied-alpha kernels (p3clock/composite.h)
+// against floating point, every SIMD level against scalar, and every layout
+// composed over black against the window's frame.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../p3clock/composite.h"
+#include "../p3clock/pixel_backend.h"
+#include "../p3clock-tools/test_pixels.h"
+#include "check_output.h"
+#include "golden_check.h"
+
+static uint32_t ReferenceDiv255(double x) {
+    return (uint32_t)floor(x / 255.0 + 0.5);
+}
+
+// Source-over with opacity in two rounded steps, the way composite.h documents it
+static p3clock::Argb ReferenceSourceOver(p3clock::Argb dst, p3clock::Argb src, int opacity) {
+    uint32_t s[4], out = 0;
+    for (int c = 0; c < 4; ++c) {
+        s[c] = ReferenceDiv255(((src >> (c * 8)) & 0xFF) * (double)opacity);
+    }
+    for (int c = 0; c < 4; ++c) {
+        uint32_t v = s[c] + ReferenceDiv255(((dst >> (c * 8)) & 0xFF) * (double)(255 - s[3]));
+        out |= (v > 255 ? 255 : v) << (c * 8);
+    }
+    return out;
+}
+
+static bool IsPremultiplied(p3clock::Argb c) {
+    int a = (int)(c >> 24);
+    return p3clock::ArgbRed(c) <= a && p3clock::ArgbGreen(c) <= a && p3clock::ArgbBlue(c) <= a;
+}
+
+struct CompositeCheck {
+    const char* name;
+    long long cases;
+    long long failures;
+};
+
+static void ReportCompositeCheck(const CompositeCheck& c) {
+    fprintf(stderr, "%s %-28s %10lld cases %6lld failures\n", c.failures ? "FAIL" : "ok  ", c.name, c.cases,
+            c.failures);
+}
+
+static int RunCompositeCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    int spans = 20000;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--spans")) {
+            spans = atoi(value);
+            ok = spans > 0;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    using namespace p3clock;
+    SimdLevel best = ResolveSimdLevel(kSimdAuto);
+    std::vector<CompositeCheck> checks;
+
+    // Div255 and ScalePixel against floating point, every input
+    CompositeCheck div = {"div255", 0, 0};
+    for (uint32_t x = 0; x <= 255 * 255; ++x, ++div.cases) {
+        if (Div255(x) != ReferenceDiv255(x)) div.failures++;
+    }
+    checks.push_back(div);
+
+    // One channel of source-over for every premultiplied source and every destination:
+    // the reference, and never above the alpha when the destination was premultiplied too
+    CompositeCheck channel = {"source-over channel", 0, 0};
+    for (uint32_t sa = 0; sa <= 255; ++sa) {
+        for (uint32_t sc = 0; sc <= sa; ++sc) {
+            for (uint32_t d = 0; d <= 255; ++d, ++channel.cases) {
+                uint32_t inv = 255 - sa;
+                uint32_t v = SourceOverChannel(d, sc, inv);
+                uint32_t alpha = SourceOverChannel(255, sa, inv); // Largest alpha any destination gives
+                if (v != sc + ReferenceDiv255(d * (double)inv) || v > alpha) channel.failures++;
+            }
+        }
+    }
+    checks.push_back(channel);
+
+    // Whole spans: scalar against the reference, each SIMD level against scalar, at random
+    // offsets and lengths so every tail and misalignment comes up
+    static const int kOpacities[] = {0, 1, 64, 128, 217, 254, 255};
+    const int kOpacityCount = (int)(sizeof(kOpacities) / sizeof(kOpacities[0]));
+    const int kMaxSpan = 67;
+    uint32_t seed = 2026;
+    std::vector<Argb> src(kMaxSpan + 8), dst(kMaxSpan + 8), expected(kMaxSpan + 8), actual(kMaxSpan + 8);
+    CompositeCheck reference = {"scalar = reference", 0, 0};
+    CompositeCheck premultiplied = {"premultiplied out", 0, 0};
+    CompositeCheck levels[3] = {{"scalar", 0, 0}, {"sse2 = scalar", 0, 0}, {"avx2 = scalar", 0, 0}};
+    for (int n = 0; n < spans; ++n) {
+        int offset = (int)(p3clock::NextRandom(&seed) % 8);
+        int count = (int)(p3clock::NextRandom(&seed) % (kMaxSpan + 1));
+        int opacity = n < kOpacityCount * 16 ? kOpacities[n % kOpacityCount] : (int)(p3clock::NextRandom(&seed) % 256);
+        for (size_t i = 0; i < src.size(); ++i) {
+            src[i] = p3clock::RandomPremultiplied(&seed);
+            dst[i] = p3clock::RandomPremultiplied(&seed);
+        }
+        if (n % 5 == 0) {
+            std::fill(src.begin(), src.end(), kArgbTransparent); // Whole vectors of the skip path
+        } else if (n % 5 == 1) {
+            for (size_t i = 0; i < src.size(); ++i) src[i] |= 0xFF000000u; // And of the copy path
+        }
+        expected = dst;
+        SourceOverSpan(&expected[offset], &src[offset], count, opacity, kSimdScalar);
+        for (size_t i = 0; i < dst.size(); ++i, ++reference.cases, ++premultiplied.cases) {
+            bool inside = (int)i >= offset && (int)i < offset + count;
+            Argb want = inside && opacity > 0 ? ReferenceSourceOver(dst[i], src[i], opacity) : dst[i];
+            if (expected[i] != want) reference.failures++;
+            if (!IsPremultiplied(expected[i])) premultiplied.failures++;
+        }
+        for (int k = kSimdSse2; k <= best; ++k) {
+            actual = dst;
+            SourceOverSpan(&actual[offset], &src[offset], count, opacity, static_cast<SimdLevel>(k));
+            levels[k].cases++;
+            if (actual != expected) levels[k].failures++;
+        }
+    }
+    checks.push_back(reference);
+    checks.push_back(premultiplied);
+    for (int k = kSimdSse2; k <= best; ++k) {
+        checks.push_back(levels[k]);
+    }
+
+    // Identities at every level: a transparent source leaves the destination, an opaque one at
+    // full opacity replaces it
+    CompositeCheck identities = {"identities", 0, 0};
+    for (int k = kSimdScalar; k <= best; ++k) {
+        for (int n = 0; n < 64; ++n, ++identities.cases) {
+            for (size_t i = 0; i < src.size(); ++i) {
+                dst[i] = p3clock::RandomPremultiplied(&seed);
+                src[i] = kArgbTransparent;
+            }
+            actual = dst;
+            SourceOverSpan(&actual[0], &src[0], (int)src.size(), (int)(p3clock::NextRandom(&seed) % 256), static_cast<SimdLevel>(k));
+            if (actual != dst) identities.failures++;
+            for (size_t i = 0; i < src.size(); ++i) src[i] = p3clock::RandomPremultiplied(&seed) | 0xFF000000u;
+            SourceOverSpan(&actual[0], &src[0], (int)src.size(), 255, static_cast<SimdLevel>(k));
+            if (actual != src) identities.failures++;
+        }
+    }
+    checks.push_back(identities);
+
+    // Fade ramps: the endpoints, never outside them, never backwards
+    CompositeCheck fades = {"fade ramp", 0, 0};
+    static const int kRamps[][2] = {{0, 217}, {217, 0}, {0, 255}, {255, 26}, {128, 128}};
+    for (size_t r = 0; r < sizeof(kRamps) / sizeof(kRamps[0]); ++r) {
+        FadeRamp ramp = MakeFadeRamp(1000.0, 250.0, kRamps[r][0], kRamps[r][1]);
+        int lo = kRamps[r][0] < kRamps[r][1] ? kRamps[r][0] : kRamps[r][1];
+        int hi = kRamps[r][0] < kRamps[r][1] ? kRamps[r][1] : kRamps[r][0];
+        int previous = ramp.LevelAt(900.0);
+        if (previous != ramp.from || ramp.LevelAt(1000.0) != ramp.from || ramp.LevelAt(1250.0) != ramp.to ||
+            ramp.DoneAt(1249.0) || !ramp.DoneAt(1250.0)) {
+            fades.failures++;
+        }
+        for (double t = 1000.0; t <= 1300.0; t += 0.5, ++fades.cases) {
+            int level = ramp.LevelAt(t);
+            bool backwards = ramp.to > ramp.from ? level < previous : level > previous;
+            if (level < lo || level > hi || backwards) fades.failures++;
+            previous = level;
+        }
+    }
+    FadeRamp instant = MakeFadeRamp(0.0, 0.0, 0, 217);
+    if (instant.LevelAt(0.0) != 217 || !instant.DoneAt(0.0)) fades.failures++;
+    checks.push_back(fades);
+
+    // The overlay's own frames: every layout at the golden sizes and times, drawn on
+    // transparent, must be premultiplied and, over opaque black at full opacity, exactly the
+    // window's frame
+    CompositeCheck frames = {"overlay = window frame", 0, 0};
+    CompositeCheck layerPixels = {"overlay layer premultiplied", 0, 0};
+    for (int l = 0; l < kLayoutCount; ++l) {
+        ClockLayout layout = static_cast<ClockLayout>(l);
+        PixelPainter painter(kArgbTransparent);
+        SoftClockRenderer renderer(layout);
+        Framebuffer layer, composed;
+        for (int s = 0; s < kGoldenSizeCount; ++s) {
+            p3clock::FrameSize size = kGoldenSizes[s];
+            renderer.Resize(size.width, size.height);
+            composed.Resize(size.width, size.height);
+            for (int t = 0; t < kGoldenTimeCount; ++t) {
+                renderer.Render(kGoldenTimes[t]);
+                p3clock::DrawOverlayLayer(&painter, layout, size, kGoldenTimes[t], &layer);
+                for (size_t i = 0; i < layer.pixels.size(); ++i, ++layerPixels.cases) {
+                    if (!IsPremultiplied(layer.pixels[i])) layerPixels.failures++;
+                }
+                DamageRect all = {0, 0, size.width, size.height};
+                for (int k = kSimdScalar; k <= best; ++k, ++frames.cases) {
+                    ComposeOverlay(ViewOf(&composed), ViewOf(layer), all, kArgbBlack, 255, static_cast<SimdLevel>(k));
+                    if (composed.pixels != renderer.Frame().pixels) {
+                        frames.failures++;
+                        fprintf(stderr, "p3timec-check: %s %dx%d %02d:%02d:%02d (%s) differs from the window frame\n",
+                                kClockLayoutNames[l], size.width, size.height, kGoldenTimes[t].hour,
+                                kGoldenTimes[t].minute, kGoldenTimes[t].second, kSimdLevelNames[k]);
+                    }
+                }
+            }
+        }
+    }
+    checks.push_back(layerPixels);
+    checks.push_back(frames);
+
+    bool passed = true;
+    for (size_t i = 0; i < checks.size(); ++i) {
+        ReportCompositeCheck(checks[i]);
+        passed = passed && checks[i].failures == 0;
+    }
+
+    if (!output.Begin("composite")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("best_kernel", kSimdLevelNames[best]);
+    json.Field("spans", spans);
+    json.Field("passed", passed);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < checks.size(); ++i) {
+        json.BeginObject();
+        json.Field("name", checks[i].name);
+        json.Field("cases", checks[i].cases);
+        json.Field("failures", checks[i].failures);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_COMPOSITE_CHECK_H
@@ -0,0 +1,465 @@
+#ifndef P3TIMEC_CHECK_CORE_CHECK_H
+#define P3TIMEC_CHECK_CORE_CHECK_H
+
+// core: ClockCore, the shared window code of the Win32 programs, driven through
+// the simulated window of p3clock-tools/sim_window.h, with every paint compared
+// against a full SoftClockRenderer frame.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../p3clock/clock_core.h"
+#include "../p3clock/pixel_backend.h"
+#include "../p3clock/time_source.h"
+#include "../p3clock-tools/sim_window.h"
+#include "check_output.h"
+
+enum CoreEventType {
+    kCoreResize,   // A drag: kCoreDragSteps WM_SIZE towards width x height with no paint in between
+    kCoreMinimize,
+    kCoreRestore,
+    kCoreCover,    // Noticed by the next tick
+    kCoreUncover,  // The system invalidates the window and paints it
+    kCoreLock,
+    kCoreUnlock,
+    kCoreSilentJump, // The wall clock is stepped without WM_TIMECHANGE (NTP): found by the periodic check
+    kCoreSetClock,   // The user sets the clock: WM_TIMECHANGE
+    kCoreSetZone,    // The user picks another time zone: WM_TIMECHANGE
+};
+
+const int kCoreDragSteps = 24;
+
+struct CoreEvent {
+    long long atMs; // From the start of the run
+    CoreEventType type;
+    int a; // Width, jump in ms, or the zone's standard offset in minutes
+    int b; // Height
+};
+
+struct CoreScenario {
+    long long startUtcMs;
+    int standardMinutes;
+    long long dstStartMs; // DST (+60 minutes) from this point of the run on; 0 for none
+    std::vector<CoreEvent> events;
+};
+
+struct CoreCheckResult {
+    const char* name;
+    const char* programs;
+    bool sweep;
+    long long paints;
+    long long mismatchedPaints; // Screen differing from the full reference frame after a paint
+    long long firstMismatchMs;
+    long long maxDifferingPixels;
+    long long staleMaxSeconds;  // Shown second behind the local time while visible (silent jumps excepted)
+    long long hiddenWakeups;
+    long long resizeEvents;
+    long long rebuilds;
+    long long expectedRebuilds; // One per burst of WM_SIZE
+    long long erasedPixels;
+    double paintedFraction;     // Mean part of the client area a paint covers
+    long long faceBuilds;
+    bool passed;
+};
+
+template <class Layout, class Presentation>
+class CoreSimulation {
+public:
+    typedef p3clock::ClockCore<Layout, Presentation, p3clock::SimBackend> Core;
+
+    CoreSimulation(const CoreScenario& scenario, int sweepHz, int width, int height)
+        : scenario_(scenario), clock_(scenario.startUtcMs, scenario.standardMinutes),
+          backend_(&clock_, Core::EraseBackground()), core_(&backend_, &clock_, sweepHz), reference_(Layout::kLayout),
+          width_(width), height_(height), builtWidth_(0), builtHeight_(0), minimized_(false), silentJumpMs_(-1) {
+        if (scenario.dstStartMs) {
+            clock_.AddDst(scenario.startUtcMs + scenario.dstStartMs, scenario.startUtcMs + 1000LL * 24 * 3600, 60);
+        }
+        memset(&r_, 0, sizeof(r_));
+        r_.firstMismatchMs = -1;
+    }
+
+    CoreCheckResult Run(long long durationMs) {
+        core_.Create(); // WM_CREATE, then the WM_SIZE of CreateWindowEx and the first WM_PAINT
+        Size(width_, height_, false);
+        ExpectRebuild();
+        PaintIfNeeded();
+        if (core_.SweepHz()) {
+            RunSweep(durationMs);
+        } else {
+            RunTicks(durationMs);
+        }
+        const p3clock::VisibilityTracker& visibility = core_.Visibility();
+        for (int i = 0; i < p3clock::kVisibilityStateCount; ++i) {
+            if (i != p3clock::kStateVisible) {
+                r_.hiddenWakeups += visibility.Wakeups(static_cast<p3clock::VisibilityState>(i));
+            }
+        }
+        const p3clock::ResizeStats& resize = core_.Resizes().Stats();
+        r_.sweep = core_.SweepHz() != 0;
+        r_.resizeEvents = (long long)resize.events;
+        r_.rebuilds = (long long)resize.rebuilds;
+        r_.paints = backend_.paints;
+        r_.erasedPixels = backend_.erasedPixels;
+        r_.faceBuilds = backend_.painter.FaceBuilds();
+        r_.paintedFraction = backend_.paints ? backend_.paintedFraction / backend_.paints : 0.0;
+        // Ticks never fire while hidden. The sweep loop wakes once for each message that arrives
+        // then, and for nothing else.
+        long long allowedHiddenWakeups = core_.SweepHz() ? (long long)scenario_.events.size() : 0;
+        // Direct presentation flickers by design (p3timec, p3timec-32-1); double buffering must not
+        r_.passed = r_.mismatchedPaints == 0 && r_.staleMaxSeconds <= 1 && r_.hiddenWakeups <= allowedHiddenWakeups &&
+                    r_.rebuilds == r_.expectedRebuilds && r_.rebuilds == backend_.resizes &&
+                    (Core::EraseBackground() || r_.erasedPixels == 0);
+        return r_;
+    }
+
+private:
+    void RunTicks(long long durationMs) {
+        size_t next = 0;
+        const std::vector<CoreEvent>& events = scenario_.events;
+        for (;;) {
+            long long eventMs = next < events.size() ? events[next].atMs : durationMs;
+            bool timer = backend_.timerArmed && backend_.timerDueMs < eventMs;
+            long long stepMs = timer ? backend_.timerDueMs : eventMs;
+            if (stepMs >= durationMs) {
+                break;
+            }
+            clock_.Step(stepMs - clock_.elapsedMs);
+            if (timer) {
+                backend_.timerArmed = false; // SetTimer is re-armed by every tick that keeps ticking
+                core_.Timer();
+            } else {
+                Apply(events[next++]);
+            }
+            PaintIfNeeded();
+        }
+    }
+
+    void RunSweep(long long durationMs) {
+        core_.StartSweep();
+        size_t next = 0;
+        const std::vector<CoreEvent>& events = scenario_.events;
+        while (clock_.elapsedMs < durationMs) {
+            while (next < events.size() && events[next].atMs <= clock_.elapsedMs) {
+                Apply(events[next++]);
+                PaintIfNeeded();
+            }
+            double delayMs = core_.SweepStep();
+            if (backend_.updateRequested) {
+                backend_.updateRequested = false;
+                PaintIfNeeded();
+            }
+            long long stepMs;
+            if (delayMs < 0.0) {
+                stepMs = (next < events.size() ? events[next].atMs : durationMs) - clock_.elapsedMs; // WaitMessage
+            } else {
+                stepMs = (long long)(delayMs + 0.999);
+            }
+            clock_.Step(stepMs > 0 ? stepMs : 1);
+        }
+    }
+
+    void Size(int width, int height, bool minimized) {
+        if (!minimized) {
+            backend_.SetClientSize(width, height);
+        }
+        core_.Size(minimized ? 0 : width, minimized ? 0 : height, minimized);
+    }
+
+    void Apply(const CoreEvent& e) {
+        switch (e.type) {
+            case kCoreResize:
+                for (int i = 1; i <= kCoreDragSteps; ++i) {
+                    // Linear drag from the current size, ending on the target
+                    Size(width_ + (e.a - width_) * i / kCoreDragSteps, height_ + (e.b - height_) * i / kCoreDragSteps, false);
+                }
+                width_ = e.a;
+                height_ = e.b;
+                ExpectRebuild();
+                break;
+            case kCoreMinimize:
+                minimized_ = true;
+                Size(0, 0, true);
+                break;
+            case kCoreRestore:
+                minimized_ = false;
+                Size(width_, height_, false);
+                ExpectRebuild();
+                break;
+            case kCoreCover:
+                backend_.covered = true;
+                break;
+            case kCoreUncover:
+                backend_.covered = false;
+                backend_.InvalidateAll();
+                break;
+            case kCoreLock:
+                core_.SessionLocked(true);
+                break;
+            case kCoreUnlock:
+                core_.SessionLocked(false);
+                break;
+            case kCoreSilentJump:
+                clock_.JumpWall(e.a);
+                silentJumpMs_ = clock_.elapsedMs;
+                break;
+            case kCoreSetClock:
+                clock_.JumpWall(e.a);
+                core_.TimeChanged();
+                break;
+            default:
+                clock_.SetStandardMinutes(e.a);
+                core_.TimeChanged();
+                break;
+        }
+    }
+
+    // A burst of WM_SIZE ends: one rebuild, unless it ends on the size already built
+    void ExpectRebuild() {
+        if (width_ != builtWidth_ || height_ != builtHeight_) {
+            r_.expectedRebuilds++;
+            builtWidth_ = width_;
+            builtHeight_ = height_;
+        }
+    }
+
+    // The window gets WM_PAINT when part of it is invalid and it can be seen
+    void PaintIfNeeded() {
+        if (minimized_ || backend_.covered || !backend_.HasInvalid()) {
+            return;
+        }
+        core_.Paint();
+        Verify();
+    }
+
+    // The whole screen against a frame rendered from scratch for the time the core shows
+    void Verify() {
+        const p3clock::LocalTime& shown = core_.DisplayTime();
+        const p3clock::Framebuffer* expected;
+        p3clock::SoftClockRenderer sweepReference(Layout::kLayout);
+        if (core_.SweepHz()) {
+            sweepReference.Resize(width_, height_); // A fresh tracker: the first sweep frame is drawn in full
+            sweepReference.RenderSweep(shown.time, shown.millisecond);
+            expected = &sweepReference.Frame();
+        } else {
+            if (reference_.Geometry().width != width_ || reference_.Geometry().height != height_) {
+                reference_.Resize(width_, height_);
+            }
+            reference_.Render(shown.time);
+            expected = &reference_.Frame();
+        }
+        p3clock::FrameDiff d = p3clock::CompareFrames(*expected, backend_.screen, 0, NULL);
+        if (d.differing) {
+            r_.mismatchedPaints++;
+            if (r_.firstMismatchMs < 0) r_.firstMismatchMs = clock_.elapsedMs;
+            if (d.differing > r_.maxDifferingPixels) r_.maxDifferingPixels = d.differing;
+        }
+        // A silent jump only shows after the time source's next wall-clock check
+        if (silentJumpMs_ < 0 || clock_.elapsedMs - silentJumpMs_ > p3clock::kWallCheckMs) {
+            long long stale = p3clock::FloorDiv(clock_.LocalMs(), 1000) - p3clock::FloorDiv(shown.ms, 1000);
+            if (stale < 0) stale = -stale;
+            if (stale > r_.staleMaxSeconds) r_.staleMaxSeconds = stale;
+        }
+    }
+
+    const CoreScenario& scenario_;
+    p3clock::CoreSimClock clock_;
+    p3clock::SimBackend backend_;
+    Core core_;
+    p3clock::SoftClockRenderer reference_;
+    int width_;
+    int height_;
+    int builtWidth_;
+    int builtHeight_;
+    bool minimized_;
+    long long silentJumpMs_;
+    CoreCheckResult r_;
+};
+
+// 2026-06-01 23:40:00 at UTC+1: midnight (green) after 20 minutes, DST at 00:50 takes the clock
+// straight to 01:50 (blue), then every other event a window sees
+static CoreScenario TickScenario() {
+    CoreScenario s;
+    s.startUtcMs = 1780272000000LL + 22LL * 3600000 + 40 * 60000;
+    s.standardMinutes = 60;
+    s.dstStartMs = 70 * 60000LL;
+    const CoreEvent events[] = {
+        {5000, kCoreResize, 1000, 520},
+        {5100, kCoreResize, 1000, 520}, // Maximize again to the same size: one rebuild, nothing changes
+        {60400, kCoreMinimize, 0, 0},
+        {120700, kCoreRestore, 0, 0},
+        {180200, kCoreCover, 0, 0},
+        {260900, kCoreUncover, 0, 0},
+        {320500, kCoreLock, 0, 0},
+        {400300, kCoreUnlock, 0, 0},
+        {600000, kCoreSilentJump, 4000, 0},
+        {900500, kCoreSetClock, -65000, 0},
+        {1199950, kCoreResize, 480, 640}, // Right before midnight: the drag and the color flip together
+        {2100000, kCoreLock, 0, 0},
+        {2160000, kCoreMinimize, 0, 0},
+        {2220000, kCoreUnlock, 0, 0},   // Unlocked while minimized: still hidden
+        {2280000, kCoreRestore, 0, 0},
+        {3300000, kCoreSetZone, -300, 0},
+        {3400000, kCoreResize, 160, 90},
+    };
+    s.events.assign(events, events + sizeof(events) / sizeof(events[0]));
+    return s;
+}
+
+// 23:59:58: sub-second hands across midnight, a drag and a minimize in between
+static CoreScenario SweepScenario() {
+    CoreScenario s;
+    s.startUtcMs = 1780272000000LL + 22LL * 3600000 + 59 * 60000 + 58000;
+    s.standardMinutes = 60;
+    s.dstStartMs = 0;
+    const CoreEvent events[] = {
+        {1000, kCoreResize, 640, 480},
+        {2500, kCoreMinimize, 0, 0},
+        {3000, kCoreRestore, 0, 0},
+        {3200, kCoreSetClock, 1500, 0},
+    };
+    s.events.assign(events, events + sizeof(events) / sizeof(events[0]));
+    return s;
+}
+
+template <class Layout, class Presentation>
+static CoreCheckResult CheckCore(const char* name, const char* programs, const CoreScenario& scenario, int sweepHz,
+                                 long long durationMs, int width, int height) {
+    CoreSimulation<Layout, Presentation> simulation(scenario, sweepHz, width, height);
+    CoreCheckResult r = simulation.Run(durationMs);
+    r.name = name;
+    r.programs = programs;
+    return r;
+}
+
+// "/hud" in whatever build the core was compiled in: every paint after the first has a frame
+// time to show and draws it (the first one has nothing timed yet)
+static bool CheckHud(long long* paints, long long* hudDraws) {
+    typedef p3clock::ClockCore<p3clock::DigitalLayoutPolicy, p3clock::BufferedPresentation, p3clock::SimBackend> Core;
+    p3clock::CoreSimClock clock(1780272000000LL + 10LL * 3600000, 0);
+    p3clock::SimBackend backend(&clock, Core::EraseBackground());
+    Core core(&backend, &clock, 0);
+    core.Create();
+    core.ShowHud(true);
+    backend.SetClientSize(800, 400);
+    core.Size(800, 400, false);
+    core.Paint();
+    for (int i = 0; i < 10; ++i) {
+        clock.Step(backend.timerDueMs > clock.elapsedMs ? backend.timerDueMs - clock.elapsedMs : 1000);
+        backend.timerArmed = false;
+        core.Timer();
+        if (backend.HasInvalid()) {
+            core.Paint();
+        }
+    }
+    *paints = backend.paints;
+    *hudDraws = backend.hudDraws;
+    return backend.paints > 1 && backend.hudDraws == backend.paints - 1;
+}
+
+static int RunCoreCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    int seconds = 3600;
+    double sweepSeconds = 5.0;
+    int hz = 60;
+    int width = 800, height = 400;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--seconds")) {
+            seconds = atoi(value);
+            ok = seconds > 0;
+        } else if (args.Is("--sweep-seconds")) {
+            sweepSeconds = atof(value);
+            ok = sweepSeconds >= 0.0;
+        } else if (args.Is("--hz")) {
+            hz = atoi(value);
+            ok = hz >= 60 && hz <= 240;
+        } else if (args.Is("--size")) {
+            ok = p3clock::ParseSize(value, &width, &height);
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    using namespace p3clock;
+    CoreScenario ticks = TickScenario();
+    CoreScenario sweep = SweepScenario();
+    long long tickMs = seconds * 1000LL;
+    long long sweepMs = (long long)(sweepSeconds * 1000.0);
+    std::vector<CoreCheckResult> results;
+    results.push_back(CheckCore<DigitalLayoutPolicy, DirectPresentation>(
+        "digital-direct", "p3timec, p3timec-32-1", ticks, 0, tickMs, width, height));
+    results.push_back(CheckCore<DigitalLayoutPolicy, BufferedPresentation>(
+        "digital-buffered", "p3timec-32-2", ticks, 0, tickMs, width, height));
+    results.push_back(CheckCore<AnalogDigitalLayoutPolicy, BufferedPresentation>(
+        "moni-buffered", "p3timec-32-moni-1", ticks, 0, tickMs, width, height));
+    results.push_back(CheckCore<AnalogLayoutPolicy, BufferedPresentation>(
+        "moni-only-buffered", "p3timec-32-moni-only-1", ticks, 0, tickMs, width, height));
+    if (sweepMs > 0) {
+        results.push_back(CheckCore<AnalogDigitalLayoutPolicy, BufferedPresentation>(
+            "moni-buffered", "p3timec-32-moni-1 /sweep", sweep, hz, sweepMs, width, height));
+        results.push_back(CheckCore<AnalogLayoutPolicy, BufferedPresentation>(
+            "moni-only-buffered", "p3timec-32-moni-only-1 /sweep", sweep, hz, sweepMs, width, height));
+    }
+
+    bool passed = true;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const CoreCheckResult& r = results[i];
+        passed = passed && r.passed;
+        fprintf(stderr, "%s %-18s %-6s %6lld paints (%5.1f%% of the window each), %lld off, stale %lld s, "
+                        "%lld hidden wakeups, %lld/%lld rebuilds for %lld WM_SIZE, %lld pixels erased\n",
+                r.passed ? "ok  " : "FAIL", r.name, r.sweep ? "sweep" : "ticks", r.paints, r.paintedFraction * 100.0,
+                r.mismatchedPaints, r.staleMaxSeconds, r.hiddenWakeups, r.rebuilds, r.expectedRebuilds,
+                r.resizeEvents, r.erasedPixels);
+        if (r.mismatchedPaints) {
+            fprintf(stderr, "     first mismatch %.3f s into the run, up to %lld pixels off\n",
+                    r.firstMismatchMs / 1000.0, r.maxDifferingPixels);
+        }
+    }
+    long long hudPaints, hudDraws;
+    bool hudPassed = CheckHud(&hudPaints, &hudDraws);
+    passed = passed && hudPassed;
+    fprintf(stderr, "%s hud                       %6lld paints, HUD drawn in %lld\n", hudPassed ? "ok  " : "FAIL",
+            hudPaints, hudDraws);
+
+    if (!output.Begin("core")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("seconds", seconds);
+    json.Field("sweep_seconds", sweepSeconds);
+    json.Field("hz", hz);
+    json.Field("passed", passed);
+    json.Field("hud_paints", hudPaints);
+    json.Field("hud_draws", hudDraws);
+    json.Key("runs");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const CoreCheckResult& r = results[i];
+        json.BeginObject();
+        json.Field("core", r.name);
+        json.Field("programs", r.programs);
+        json.Field("mode", r.sweep ? "sweep" : "ticks");
+        json.Field("passed", r.passed);
+        json.Field("paints", r.paints);
+        json.Field("painted_fraction", r.paintedFraction);
+        json.Field("mismatched_paints", r.mismatchedPaints);
+        json.Field("max_differing_pixels", r.maxDifferingPixels);
+        json.Field("stale_max_seconds", r.staleMaxSeconds);
+        json.Field("hidden_wakeups", r.hiddenWakeups);
+        json.Field("resize_events", r.resizeEvents);
+        json.Field("rebuilds", r.rebuilds);
+        json.Field("expected_rebuilds", r.expectedRebuilds);
+        json.Field("face_builds", r.faceBuilds);
+        json.Field("erased_pixels", r.erasedPixels);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_CORE_CHECK_H
@@ -0,0 +1,196 @@
+#ifndef P3TIMEC_CHECK_DAMAGE_CHECK_H
+#define P3TIMEC_CHECK_DAMAGE_CHECK_H
+
+// damage: the rectangles the damage tracker invalidates for a tick against the
+// pixels that actually change between the two frames.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../p3clock/damage.h"
+#include "../p3clock/soft_clock.h"
+#include "../p3clock-tools/tool_support.h"
+#include "check_output.h"
+
+struct DamageCase {
+    const char* name;
+    p3clock::ClockTime before;
+    p3clock::ClockTime after;
+    double maxAreaPct; // Of the client area; a color change repaints it all instead
+};
+
+static const DamageCase kDamageCases[] = {
+    {"second", {10, 8, 30}, {10, 8, 31}, 8.0},  // One digit, the second hand
+    {"minute", {10, 8, 59}, {10, 9, 0}, 25.0},  // Three digits, second and minute hands
+    {"hour", {10, 59, 59}, {11, 0, 0}, 45.0},   // Six digits and every hand
+    {"color", {0, 59, 59}, {1, 0, 0}, 100.0},   // Green to blue: full damage
+};
+static const int kDamageCaseCount = sizeof(kDamageCases) / sizeof(kDamageCases[0]);
+
+static const p3clock::FrameSize kDamageSizes[] = {
+    {160, 90},
+    {800, 400},
+    {480, 640},
+};
+static const int kDamageSizeCount = sizeof(kDamageSizes) / sizeof(kDamageSizes[0]);
+
+struct DamageCaseResult {
+    p3clock::ClockLayout layout;
+    p3clock::FrameSize size;
+    const DamageCase* test;
+    bool full;
+    int rects;
+    p3clock::DamageRect bounds; // Union of the rectangles
+    long long area;             // Sum of their areas (the client area when full)
+    double areaPct;
+    long long changed;   // Pixels that differ between the frames
+    long long uncovered; // Of those, pixels no rectangle covers
+    bool passed;
+};
+
+static bool InDamage(const p3clock::DamageList& damage, int x, int y) {
+    if (damage.full) {
+        return true;
+    }
+    for (int i = 0; i < damage.count; ++i) {
+        const p3clock::DamageRect& r = damage.rects[i];
+        if (x >= r.left && x < r.right && y >= r.top && y < r.bottom) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The tracker set up the way SoftClockRenderer::Resize() sets up its own, shown `before`,
+// advanced to `after`, against both frames rendered from scratch
+static DamageCaseResult CheckDamageCase(p3clock::ClockLayout layout, p3clock::FrameSize size, const DamageCase& test) {
+    DamageCaseResult r;
+    r.layout = layout;
+    r.size = size;
+    r.test = &test;
+    p3clock::SoftClockRenderer renderer(layout);
+    renderer.Resize(size.width, size.height);
+    p3clock::DigitalLayout digital;
+    digital.enabled = false;
+    if (renderer.Geometry().hasDigital) {
+        digital = p3clock::DigitalLayoutFromText(renderer.AtlasLayout(), renderer.TextLayout());
+    }
+    p3clock::DamageTracker tracker;
+    tracker.SetLayout(digital, renderer.Geometry().analog, size.width, size.height);
+    tracker.Reset(test.before);
+    p3clock::DamageList damage = tracker.Advance(test.after);
+
+    renderer.Render(test.before);
+    p3clock::Framebuffer before = renderer.Frame();
+    renderer.Render(test.after);
+    const p3clock::Framebuffer& after = renderer.Frame();
+    r.changed = r.uncovered = 0;
+    for (int y = 0; y < size.height; ++y) {
+        for (int x = 0; x < size.width; ++x) {
+            if (before.At(x, y) != after.At(x, y)) {
+                r.changed++;
+                r.uncovered += InDamage(damage, x, y) ? 0 : 1;
+            }
+        }
+    }
+
+    r.full = damage.full;
+    r.rects = damage.full ? 1 : damage.count;
+    p3clock::DamageRect all = {0, 0, size.width, size.height};
+    p3clock::DamageRect none = {0, 0, 0, 0};
+    r.bounds = damage.full ? all : none;
+    for (int i = 0; i < damage.count && !damage.full; ++i) {
+        r.bounds = p3clock::Union(r.bounds, damage.rects[i]);
+    }
+    r.area = p3clock::DamageArea(damage, size.width, size.height);
+    r.areaPct = 100.0 * r.area / ((double)size.width * size.height);
+    // Every changed pixel repainted, and only a color change repaints the whole client area
+    bool expectFull = p3clock::IsGreenHour(test.before) != p3clock::IsGreenHour(test.after);
+    r.passed = r.uncovered == 0 && r.full == expectFull && r.areaPct <= test.maxAreaPct;
+    return r;
+}
+
+static int RunDamageCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    std::vector<p3clock::ClockLayout> layouts;
+    std::vector<p3clock::FrameSize> sizes;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--layout")) {
+            p3clock::ClockLayout layout;
+            ok = p3clock::ParseClockLayout(value, &layout);
+            if (ok) layouts.push_back(layout);
+        } else if (args.Is("--size")) {
+            p3clock::FrameSize size;
+            ok = p3clock::ParseSize(value, &size.width, &size.height);
+            if (ok) sizes.push_back(size);
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (layouts.empty()) {
+        for (int l = 0; l < p3clock::kLayoutCount; ++l) {
+            layouts.push_back((p3clock::ClockLayout)l);
+        }
+    }
+    if (sizes.empty()) {
+        sizes.assign(kDamageSizes, kDamageSizes + kDamageSizeCount);
+    }
+
+    bool passed = true;
+    std::vector<DamageCaseResult> results;
+    for (size_t l = 0; l < layouts.size(); ++l) {
+        for (size_t s = 0; s < sizes.size(); ++s) {
+            for (int c = 0; c < kDamageCaseCount; ++c) {
+                DamageCaseResult r = CheckDamageCase(layouts[l], sizes[s], kDamageCases[c]);
+                fprintf(stderr, "%-9s %4dx%-4d %-6s %s  %d rects  union %d,%d-%d,%d  %5.1f%% of the client  %lld px changed  %lld uncovered\n",
+                        p3clock::kClockLayoutNames[r.layout], r.size.width, r.size.height, r.test->name,
+                        r.passed ? "ok  " : "FAIL", r.rects, r.bounds.left, r.bounds.top, r.bounds.right,
+                        r.bounds.bottom, r.areaPct, r.changed, r.uncovered);
+                passed = passed && r.passed;
+                results.push_back(r);
+            }
+        }
+    }
+
+    if (!output.Begin("damage")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("passed", passed);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const DamageCaseResult& r = results[i];
+        json.BeginObject();
+        json.Field("layout", p3clock::kClockLayoutNames[r.layout]);
+        json.Field("width", r.size.width);
+        json.Field("height", r.size.height);
+        json.Field("case", r.test->name);
+        json.Field("passed", r.passed);
+        json.Field("full", r.full);
+        json.Field("rects", r.rects);
+        json.Key("union");
+        json.BeginArray();
+        json.Value(r.bounds.left);
+        json.Value(r.bounds.top);
+        json.Value(r.bounds.right);
+        json.Value(r.bounds.bottom);
+        json.EndArray();
+        json.Field("area", r.area);
+        json.Field("area_pct", r.areaPct);
+        json.Field("max_area_pct", r.test->maxAreaPct);
+        json.Field("changed", r.changed);
+        json.Field("uncovered", r.uncovered);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_DAMAGE_CHECK_H
@@ -0,0 +1,100 @@
+#ifndef P3TIMEC_CHECK_DIAL_CHECK_H
+#define P3TIMEC_CHECK_DIAL_CHECK_H
+
+// dial: the hand and numeral positions of the dial tables against sin / cos,
+// every angle at every radius up to an 8K face.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../p3clock/dial_table.h"
+#include "../p3clock/soft_clock.h"
+#include "check_output.h"
+
+struct DialCheckResult {
+    const char* name;
+    int steps;
+    double maxError;          // Largest distance between the table and sin / cos positions, in pixels
+    long long points;         // Positions compared
+    long long pixelMismatches; // Truncated positions that land on a different pixel
+};
+
+// Compare length * DialVector<Steps> with length * (sin, -cos) of the same angle for every
+// step and every radius, where length = radius * fraction
+template <int Steps>
+static DialCheckResult CheckDial(const char* name, double fraction, int maxRadius) {
+    DialCheckResult r = {name, Steps, 0.0, 0, 0};
+    for (int step = 0; step < Steps; ++step) {
+        const p3clock::UnitVector& v = p3clock::DialVector<Steps>(step);
+        double rad = step * 360.0 / Steps * p3clock::kPi / 180.0;
+        double dx = sin(rad), dy = -cos(rad);
+        for (int radius = 1; radius <= maxRadius; ++radius) {
+            double length = radius * fraction;
+            double ex = length * v.dx - length * dx;
+            double ey = length * v.dy - length * dy;
+            double error = sqrt(ex * ex + ey * ey);
+            if (error > r.maxError) r.maxError = error;
+            if ((int)(length * v.dx) != (int)(length * dx) || (int)(length * v.dy) != (int)(length * dy)) {
+                r.pixelMismatches++;
+            }
+            r.points++;
+        }
+    }
+    return r;
+}
+
+static int RunDialCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    int maxRadius = 4320; // Half the height of an 8K screen
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--max-radius")) {
+            maxRadius = atoi(value);
+            ok = maxRadius > 0;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    DialCheckResult results[4] = {
+        CheckDial<p3clock::HandDial<p3clock::kSecondHand>::kSteps>("second", p3clock::kHandLength[p3clock::kSecondHand], maxRadius),
+        CheckDial<p3clock::HandDial<p3clock::kMinuteHand>::kSteps>("minute", p3clock::kHandLength[p3clock::kMinuteHand], maxRadius),
+        CheckDial<p3clock::HandDial<p3clock::kHourHand>::kSteps>("hour", p3clock::kHandLength[p3clock::kHourHand], maxRadius),
+        CheckDial<12>("numeral", p3clock::kNumeralRadius, maxRadius),
+    };
+    bool passed = true;
+    for (int i = 0; i < 4; ++i) {
+        const DialCheckResult& r = results[i];
+        passed = passed && r.maxError < 0.5;
+        fprintf(stderr, "%-8s %5d steps  max error %.3g px  %lld of %lld truncated positions on another pixel\n",
+                r.name, r.steps, r.maxError, r.pixelMismatches, r.points);
+    }
+
+    if (!output.Begin("dial")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("max_radius", maxRadius);
+    json.Field("passed", passed);
+    json.Key("dials");
+    json.BeginArray();
+    for (int i = 0; i < 4; ++i) {
+        const DialCheckResult& r = results[i];
+        json.BeginObject();
+        json.Field("name", r.name);
+        json.Field("steps", r.steps);
+        json.Field("max_error_px", r.maxError);
+        json.Field("points", r.points);
+        json.Field("pixel_mismatches", r.pixelMismatches);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_DIAL_CHECK_H
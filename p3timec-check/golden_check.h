@@ -0,0 +1,394 @@
+#ifndef P3TIMEC_CHECK_GOLDEN_CHECK_H
+#define P3TIMEC_CHECK_GOLDEN_CHECK_H
+
+// golden: every layout at fixed sizes and times against the frames stored in
+// p3timec-check/golden. Render times are only measured on request and compared
+// with a baseline the same machine wrote; none is kept in the repo.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "../p3clock/bench_stats.h"
+#include "../p3clock/golden.h"
+#include "../p3clock/soft_clock.h"
+#include "check_output.h"
+
+// Every layout at every size and time, against frames stored in the repo
+static const p3clock::ClockTime kGoldenTimes[] = {
+    {0, 0, 0},    // Midnight: the green hour starts
+    {0, 59, 59},  // Its last second
+    {1, 0, 0},    // Blue again
+    {10, 8, 30},  // Hands apart, no numeral covered
+    {12, 59, 59}, // Every digit but the first changes on the next tick
+    {23, 59, 59}, // The day wraps on the next tick
+};
+static const int kGoldenTimeCount = sizeof(kGoldenTimes) / sizeof(kGoldenTimes[0]);
+
+static const p3clock::FrameSize kGoldenSizes[] = {
+    {160, 90},  // Smallest fonts and pens
+    {800, 400}, // The CreateWindowEx size
+    {480, 640}, // Portrait: the layout limited by the width
+};
+static const int kGoldenSizeCount = sizeof(kGoldenSizes) / sizeof(kGoldenSizes[0]);
+
+const int kGoldenTimingRounds = 5;
+
+enum GoldenUpdate { kUpdateNone, kUpdateFrames, kUpdateTimings, kUpdateAll };
+
+struct GoldenFrameResult {
+    p3clock::ClockLayout layout;
+    p3clock::FrameSize size;
+    p3clock::ClockTime time;
+    bool found; // The golden exists and could be read
+    p3clock::FrameDiff diff;
+    bool passed;
+};
+
+struct GoldenTimingResult {
+    p3clock::ClockLayout layout;
+    p3clock::FrameSize size;
+    p3clock::FrameTimeSummary frames;
+    double baselineMs; // Stored median, 0 when there is none
+    double limitMs;    // Median above this fails, 0 when unchecked
+    bool passed;
+};
+
+static std::string GoldenPath(const char* dir, p3clock::ClockLayout layout, p3clock::FrameSize size, p3clock::ClockTime t) {
+    char name[128];
+    snprintf(name, sizeof(name), "/%s-%dx%d-%02d%02d%02d.rle", p3clock::kClockLayoutNames[layout], size.width,
+             size.height, t.hour, t.minute, t.second);
+    return std::string(dir) + name;
+}
+
+static bool WritePpmFile(const std::string& path, const p3clock::Framebuffer& fb) {
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) {
+        return false;
+    }
+    bool written = p3clock::WritePpm(fb, out);
+    return fclose(out) == 0 && written;
+}
+
+// --timings file: "LAYOUT WxH MEDIAN_MS" per line, '#' starts a comment
+static bool ReadGoldenTimings(const std::string& path, std::vector<GoldenTimingResult>* timings) {
+    FILE* in = fopen(path.c_str(), "r");
+    if (!in) {
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), in)) {
+        char name[64];
+        GoldenTimingResult t;
+        if (line[0] == '#' || sscanf(line, "%63s %dx%d %lf", name, &t.size.width, &t.size.height, &t.baselineMs) != 4 ||
+            !p3clock::ParseClockLayout(name, &t.layout)) {
+            continue;
+        }
+        timings->push_back(t);
+    }
+    fclose(in);
+    return true;
+}
+
+static bool WriteGoldenTimings(const std::string& path, const std::vector<GoldenTimingResult>& timings, int frames) {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) {
+        return false;
+    }
+    fprintf(out, "# Median ms per frame, written by p3timec-check golden --update timings (built\n"
+                 "# with -O2, %d frames per time and round). Only comparable on the machine that wrote them.\n",
+            frames);
+    for (size_t i = 0; i < timings.size(); ++i) {
+        const GoldenTimingResult& t = timings[i];
+        fprintf(out, "%s %dx%d %.4f\n", p3clock::kClockLayoutNames[t.layout], t.size.width, t.size.height,
+                t.baselineMs);
+    }
+    return fclose(out) == 0;
+}
+
+static const GoldenTimingResult* FindTiming(const std::vector<GoldenTimingResult>& timings, p3clock::ClockLayout layout,
+                                            p3clock::FrameSize size) {
+    for (size_t i = 0; i < timings.size(); ++i) {
+        if (timings[i].layout == layout && timings[i].size.width == size.width && timings[i].size.height == size.height) {
+            return &timings[i];
+        }
+    }
+    return NULL;
+}
+
+static int RunGoldenCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    const char* dir = "p3timec-check/golden";
+    std::vector<p3clock::ClockLayout> layouts;
+    std::vector<p3clock::FrameSize> sizes;
+    std::vector<p3clock::ClockTime> times;
+    int tolerance = 8;
+    long long maxDiffering = 0;
+    int frames = 50;
+    double maxRegression = 50.0;
+    double minSlowdownMs = 0.05;
+    double maxFrameMs = 0.0;
+    GoldenUpdate update = kUpdateNone;
+    const char* diffDir = NULL;
+    const char* timingsPath = NULL;
+
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--golden")) {
+            dir = value;
+        } else if (args.Is("--layout")) {
+            p3clock::ClockLayout layout;
+            ok = p3clock::ParseClockLayout(value, &layout);
+            if (ok) layouts.push_back(layout);
+        } else if (args.Is("--size")) {
+            p3clock::FrameSize size;
+            ok = p3clock::ParseSize(value, &size.width, &size.height);
+            if (ok) sizes.push_back(size);
+        } else if (args.Is("--time")) {
+            p3clock::ClockTime t;
+            ok = p3clock::ParseTime(value, &t);
+            if (ok) times.push_back(t);
+        } else if (args.Is("--tolerance")) {
+            tolerance = atoi(value);
+            ok = tolerance >= 0 && tolerance <= 255;
+        } else if (args.Is("--max-differing")) {
+            maxDiffering = atoll(value);
+            ok = maxDiffering >= 0;
+        } else if (args.Is("--frames")) {
+            frames = atoi(value);
+            ok = frames > 0;
+        } else if (args.Is("--max-regression")) {
+            maxRegression = atof(value);
+            ok = maxRegression >= 0.0;
+        } else if (args.Is("--min-slowdown")) {
+            minSlowdownMs = atof(value);
+            ok = minSlowdownMs >= 0.0;
+        } else if (args.Is("--max-frame-ms")) {
+            maxFrameMs = atof(value);
+            ok = maxFrameMs >= 0.0;
+        } else if (args.Is("--update")) {
+            if (strcmp(value, "frames") == 0) {
+                update = kUpdateFrames;
+            } else if (strcmp(value, "timings") == 0) {
+                update = kUpdateTimings;
+            } else if (strcmp(value, "all") == 0) {
+                update = kUpdateAll;
+            } else {
+                ok = false;
+            }
+        } else if (args.Is("--diff-dir")) {
+            diffDir = value;
+        } else if (args.Is("--timings")) {
+            timingsPath = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    bool updateFrames = update == kUpdateFrames || update == kUpdateAll;
+    bool updateTimings = update == kUpdateTimings || update == kUpdateAll;
+    if (updateTimings && !timingsPath) {
+        fprintf(stderr, "p3timec-check: --update timings needs --timings PATH\n");
+        return 2;
+    }
+    if (layouts.empty()) {
+        for (int l = 0; l < p3clock::kLayoutCount; ++l) {
+            layouts.push_back((p3clock::ClockLayout)l);
+        }
+    }
+    if (sizes.empty()) {
+        sizes.assign(kGoldenSizes, kGoldenSizes + kGoldenSizeCount);
+    }
+    if (times.empty()) {
+        times.assign(kGoldenTimes, kGoldenTimes + kGoldenTimeCount);
+    }
+    // The frames are the check; render times depend on the machine, so they are only
+    // taken when asked for, and a regression is only judged against a baseline the same
+    // build wrote on the same machine
+    bool timed = timingsPath || maxFrameMs > 0.0;
+    bool checkTimings = timingsPath && !updateTimings && maxRegression > 0.0;
+    std::vector<GoldenTimingResult> baseline;
+    if (checkTimings && !ReadGoldenTimings(timingsPath, &baseline)) {
+        fprintf(stderr, "p3timec-check: cannot read %s, take a baseline with --update timings\n", timingsPath);
+        return 2;
+    }
+
+    bool passed = true;
+    std::vector<GoldenFrameResult> frameResults;
+    std::vector<GoldenTimingResult> timingResults;
+    p3clock::Framebuffer golden;
+    p3clock::Framebuffer diff;
+    for (size_t l = 0; l < layouts.size(); ++l) {
+        for (size_t s = 0; s < sizes.size(); ++s) {
+            p3clock::SoftClockRenderer renderer(layouts[l]);
+            renderer.Resize(sizes[s].width, sizes[s].height);
+            for (size_t t = 0; t < times.size(); ++t) {
+                GoldenFrameResult r;
+                r.layout = layouts[l];
+                r.size = sizes[s];
+                r.time = times[t];
+                renderer.Render(r.time);
+                std::string path = GoldenPath(dir, r.layout, r.size, r.time);
+                if (updateFrames) {
+                    FILE* out = fopen(path.c_str(), "wb");
+                    bool written = out && p3clock::WriteGolden(renderer.Frame(), out);
+                    if (!out || fclose(out) != 0 || !written) {
+                        fprintf(stderr, "p3timec-check: cannot write %s\n", path.c_str());
+                        return 1;
+                    }
+                }
+                FILE* in = fopen(path.c_str(), "rb");
+                r.found = in && p3clock::ReadGolden(in, &golden);
+                if (in) fclose(in);
+                r.diff = p3clock::CompareFrames(r.found ? golden : p3clock::Framebuffer(), renderer.Frame(),
+                                                tolerance, diffDir ? &diff : NULL);
+                r.passed = r.found && r.diff.sameSize && r.diff.differing <= maxDiffering;
+                fprintf(stderr, "%-9s %4dx%-4d %02d:%02d:%02d %s  %lld px off  %lld inexact  max %d%s\n",
+                        p3clock::kClockLayoutNames[r.layout], r.size.width, r.size.height, r.time.hour,
+                        r.time.minute, r.time.second, r.passed ? "ok  " : "FAIL", r.diff.differing, r.diff.inexact,
+                        r.diff.maxChannelDiff, r.found ? "" : "  (no golden, run with --update frames)");
+                if (!r.passed && diffDir) {
+                    // golden / actual / diff side by side for a look in an image viewer
+                    std::string base = GoldenPath(diffDir, r.layout, r.size, r.time);
+                    base.resize(base.size() - 4);
+                    bool written = WritePpmFile(base + "-actual.ppm", renderer.Frame());
+                    if (r.found) {
+                        written = WritePpmFile(base + "-golden.ppm", golden) && written;
+                    }
+                    if (r.found && r.diff.sameSize) {
+                        written = WritePpmFile(base + "-diff.ppm", diff) && written;
+                    }
+                    if (!written) {
+                        fprintf(stderr, "p3timec-check: cannot write %s-*.ppm\n", base.c_str());
+                    }
+                }
+                passed = passed && r.passed;
+                frameResults.push_back(r);
+            }
+            if (!timed) {
+                continue;
+            }
+
+            // Frames of a running clock: the face layer is built by the first Render() at each
+            // time. The fastest of kGoldenTimingRounds rounds counts, so a burst of load from
+            // elsewhere on the machine does not look like a regression.
+            GoldenTimingResult tr;
+            tr.layout = layouts[l];
+            tr.size = sizes[s];
+            for (int round = 0; round < kGoldenTimingRounds; ++round) {
+                std::vector<double> samples;
+                samples.reserve((size_t)frames * times.size());
+                for (size_t t = 0; t < times.size(); ++t) {
+                    renderer.Render(times[t]);
+                    for (int f = 0; f < frames; ++f) {
+                        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                        renderer.Render(times[t]);
+                        samples.push_back(p3clock::MsSince(start));
+                    }
+                }
+                p3clock::FrameTimeSummary summary = p3clock::SummarizeFrameTimes(samples);
+                if (round == 0 || summary.p50Ms < tr.frames.p50Ms) {
+                    tr.frames = summary;
+                }
+            }
+            const GoldenTimingResult* stored = FindTiming(baseline, tr.layout, tr.size);
+            tr.baselineMs = stored ? stored->baselineMs : 0.0;
+            tr.limitMs = 0.0;
+            if (checkTimings && tr.baselineMs > 0.0) {
+                tr.limitMs = tr.baselineMs * (1.0 + maxRegression / 100.0);
+                if (tr.limitMs < tr.baselineMs + minSlowdownMs) tr.limitMs = tr.baselineMs + minSlowdownMs;
+            }
+            if (maxFrameMs > 0.0 && (tr.limitMs == 0.0 || maxFrameMs < tr.limitMs)) {
+                tr.limitMs = maxFrameMs;
+            }
+            tr.passed = tr.limitMs == 0.0 || tr.frames.p50Ms <= tr.limitMs;
+            if (tr.baselineMs > 0.0) {
+                fprintf(stderr, "%-9s %4dx%-4d timing   %s  %8.3f ms/frame  baseline %8.3f  %+6.1f%%\n",
+                        p3clock::kClockLayoutNames[tr.layout], tr.size.width, tr.size.height,
+                        tr.passed ? "ok  " : "FAIL", tr.frames.p50Ms, tr.baselineMs,
+                        (tr.frames.p50Ms / tr.baselineMs - 1.0) * 100.0);
+            } else {
+                fprintf(stderr, "%-9s %4dx%-4d timing   %s  %8.3f ms/frame\n",
+                        p3clock::kClockLayoutNames[tr.layout], tr.size.width, tr.size.height,
+                        tr.passed ? "ok  " : "FAIL", tr.frames.p50Ms);
+            }
+            passed = passed && tr.passed;
+            timingResults.push_back(tr);
+        }
+    }
+    if (updateTimings) {
+        // Cases that were not run keep their stored timings
+        std::vector<GoldenTimingResult> merged;
+        ReadGoldenTimings(timingsPath, &merged);
+        for (size_t i = 0; i < timingResults.size(); ++i) {
+            GoldenTimingResult fresh = timingResults[i];
+            fresh.baselineMs = fresh.frames.p50Ms;
+            const GoldenTimingResult* stored = FindTiming(merged, fresh.layout, fresh.size);
+            if (stored) {
+                merged[stored - &merged[0]] = fresh;
+            } else {
+                merged.push_back(fresh);
+            }
+        }
+        if (!WriteGoldenTimings(timingsPath, merged, frames)) {
+            fprintf(stderr, "p3timec-check: cannot write %s\n", timingsPath);
+            return 1;
+        }
+    }
+
+    if (!output.Begin("golden")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("golden", dir);
+    json.Field("tolerance", tolerance);
+    json.Field("max_differing", maxDiffering);
+    json.Field("frames", frames);
+    json.Field("timings_baseline", timingsPath ? timingsPath : "");
+    json.Field("max_regression_pct", checkTimings ? maxRegression : 0.0);
+    json.Field("max_frame_ms", maxFrameMs);
+    json.Field("passed", passed);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < frameResults.size(); ++i) {
+        const GoldenFrameResult& r = frameResults[i];
+        char time[16];
+        snprintf(time, sizeof(time), "%02d:%02d:%02d", r.time.hour, r.time.minute, r.time.second);
+        json.BeginObject();
+        json.Field("layout", p3clock::kClockLayoutNames[r.layout]);
+        json.Field("width", r.size.width);
+        json.Field("height", r.size.height);
+        json.Field("time", time);
+        json.Field("passed", r.passed);
+        json.Field("found", r.found);
+        json.Field("same_size", r.diff.sameSize);
+        json.Field("differing", r.diff.differing);
+        json.Field("inexact", r.diff.inexact);
+        json.Field("max_channel_diff", r.diff.maxChannelDiff);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.Key("timings");
+    json.BeginArray();
+    for (size_t i = 0; i < timingResults.size(); ++i) {
+        const GoldenTimingResult& r = timingResults[i];
+        json.BeginObject();
+        json.Field("layout", p3clock::kClockLayoutNames[r.layout]);
+        json.Field("width", r.size.width);
+        json.Field("height", r.size.height);
+        json.Field("passed", r.passed);
+        json.Field("frame_p50_ms", r.frames.p50Ms);
+        json.Field("frame_p99_ms", r.frames.p99Ms);
+        json.Field("baseline_ms", r.baselineMs);
+        json.Field("limit_ms", r.limitMs);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_GOLDEN_CHECK_H
@@ -0,0 +1,244 @@
+#ifndef P3TIMEC_CHECK_IDLE_CHECK_H
+#define P3TIMEC_CHECK_IDLE_CHECK_H
+
+// idle: the Win32 tick loop with its visibility handling on a simulated clock,
+// through minimize / restore, cover / uncover and lock / unlock.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../p3clock/tick_scheduler.h"
+#include "../p3clock/time_source.h"
+#include "../p3clock/visibility.h"
+#include "check_output.h"
+
+enum IdleEventType { kIdleMinimize, kIdleRestore, kIdleCover, kIdleUncover, kIdleLock, kIdleUnlock, kIdleEventCount };
+
+static const char* const kIdleEventNames[kIdleEventCount] = {"minimize", "restore", "cover", "uncover", "lock", "unlock"};
+
+struct IdleEvent {
+    IdleEventType type;
+    long long atMs; // From the start of the simulation
+};
+
+static const char* const kDefaultIdleScript =
+    "minimize@600.4,restore@1200.7,cover@1500.2,uncover@1800.9,"
+    "lock@2100.5,minimize@2200.1,unlock@2700.3,restore@2800.6";
+
+// "minimize@600.4,restore@1200.7" -> events in time order. Returns false on a bad entry.
+static bool ParseIdleScript(const char* text, std::vector<IdleEvent>* events) {
+    events->clear();
+    const char* p = text;
+    while (*p) {
+        const char* at = strchr(p, '@');
+        if (!at) {
+            return false;
+        }
+        int type = 0;
+        while (type < kIdleEventCount && (strlen(kIdleEventNames[type]) != (size_t)(at - p) ||
+                                          strncmp(p, kIdleEventNames[type], at - p) != 0)) {
+            ++type;
+        }
+        char* end = NULL;
+        double seconds = strtod(at + 1, &end);
+        if (type == kIdleEventCount || end == at + 1 || seconds < 0.0 || (*end && *end != ',')) {
+            return false;
+        }
+        IdleEvent e = {static_cast<IdleEventType>(type), (long long)(seconds * 1000.0)};
+        if (!events->empty() && e.atMs < events->back().atMs) {
+            return false;
+        }
+        events->push_back(e);
+        p = *end ? end + 1 : end;
+    }
+    return true;
+}
+
+struct IdleSimResult {
+    p3clock::VisibilityTracker visibility;
+    long long durationMs;
+    long long frames;        // Timer ticks that showed a new second
+    long long catchUpFrames; // Frames painted right when the clock became visible again
+    long long resumes;
+    long long staleMaxSeconds; // Largest gap between the shown and the current second while visible
+    long long wakeupsWithoutIdle; // Ticks the timer would have fired had it never stopped
+};
+
+// The WM_TIMER / WM_SIZE / WM_PAINT / WM_WTSSESSION_CHANGE handling of the Win32 programs on a
+// simulated clock. Timer messages arrive 0-15 ms after they are due, like the system timer.
+class IdleSimulation {
+public:
+    explicit IdleSimulation(long long startMs)
+        : nowMs_(startMs), shownSecond_(startMs / 1000), timerArmed_(false), timerDueMs_(0), covered_(false), jitter_(1) {
+        r_.durationMs = 0;
+        r_.frames = r_.catchUpFrames = r_.resumes = r_.staleMaxSeconds = r_.wakeupsWithoutIdle = 0;
+    }
+
+    IdleSimResult Run(const std::vector<IdleEvent>& events, long long durationMs) {
+        long long startMs = nowMs_;
+        long long endMs = startMs + durationMs;
+        r_.visibility.Start(nowMs_);
+        Arm(scheduler_.Start(nowMs_)); // WM_CREATE
+        size_t next = 0;
+        for (;;) {
+            long long eventMs = next < events.size() ? startMs + events[next].atMs : endMs;
+            long long stepMs = timerArmed_ && timerDueMs_ < eventMs ? timerDueMs_ : eventMs;
+            if (stepMs > endMs) stepMs = endMs;
+            // The shown second only changes at steps, so its lag is largest right before one
+            if (r_.visibility.Visible() && stepMs > nowMs_) {
+                long long stale = (stepMs - 1) / 1000 - shownSecond_;
+                if (stale > r_.staleMaxSeconds) r_.staleMaxSeconds = stale;
+            }
+            nowMs_ = stepMs;
+            if (nowMs_ >= endMs) {
+                break;
+            }
+            if (timerArmed_ && timerDueMs_ == nowMs_ && nowMs_ < eventMs) {
+                OnTimer();
+            } else {
+                OnEvent(events[next++].type);
+            }
+        }
+        r_.durationMs = durationMs;
+        r_.wakeupsWithoutIdle = durationMs / 1000;
+        return r_;
+    }
+
+private:
+    void Arm(int delayMs) {
+        jitter_ = jitter_ * 1103515245u + 12345u;
+        timerArmed_ = true;
+        timerDueMs_ = nowMs_ + delayMs + (jitter_ >> 16) % 16;
+    }
+
+    // WM_TIMER
+    void OnTimer() {
+        timerArmed_ = false;
+        r_.visibility.CountWakeup();
+        if (!r_.visibility.Visible()) {
+            return; // KillTimer
+        }
+        if (covered_) {
+            Apply(r_.visibility.SetOccluded(true, nowMs_));
+            return;
+        }
+        p3clock::Tick tick = scheduler_.OnTick(nowMs_);
+        Arm(tick.delayMs);
+        if (tick.present) {
+            shownSecond_ = nowMs_ / 1000;
+            r_.frames++;
+        }
+    }
+
+    void OnEvent(IdleEventType type) {
+        switch (type) {
+            case kIdleMinimize: Apply(r_.visibility.SetMinimized(true, nowMs_)); break;
+            case kIdleRestore:  Apply(r_.visibility.SetMinimized(false, nowMs_)); break;
+            case kIdleCover:    covered_ = true; break; // Noticed by the next tick
+            case kIdleUncover:  covered_ = false; Apply(r_.visibility.SetOccluded(false, nowMs_)); break; // WM_PAINT
+            case kIdleLock:     Apply(r_.visibility.SetLocked(true, nowMs_)); break;
+            default:            Apply(r_.visibility.SetLocked(false, nowMs_)); break;
+        }
+    }
+
+    // ApplyVisibility
+    void Apply(p3clock::VisibilityAction action) {
+        if (action == p3clock::kVisibilitySuspend) {
+            timerArmed_ = false;
+        } else if (action == p3clock::kVisibilityResume) {
+            shownSecond_ = nowMs_ / 1000;
+            r_.catchUpFrames++;
+            r_.resumes++;
+            Arm(scheduler_.Start(nowMs_));
+        }
+    }
+
+    long long nowMs_;
+    long long shownSecond_;
+    bool timerArmed_;
+    long long timerDueMs_;
+    bool covered_;
+    unsigned int jitter_;
+    p3clock::TickScheduler scheduler_;
+    IdleSimResult r_;
+};
+
+static int RunIdleCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    const char* script = kDefaultIdleScript;
+    int seconds = 3600;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--script")) {
+            script = value;
+        } else if (args.Is("--seconds")) {
+            seconds = atoi(value);
+            ok = seconds > 0;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    std::vector<IdleEvent> events;
+    if (!ParseIdleScript(script, &events)) {
+        fprintf(stderr, "p3timec-check: bad value for --script: %s\n", script);
+        return 2;
+    }
+
+    // Start a quarter second into 12:00:00 so no event lands on a second boundary
+    IdleSimulation simulation(12LL * 3600 * 1000 + 250);
+    IdleSimResult r = simulation.Run(events, seconds * 1000LL);
+    long long endMs = 12LL * 3600 * 1000 + 250 + r.durationMs;
+
+    // Hidden states must not wake up at all; visible time must tick once a second
+    bool passed = r.staleMaxSeconds <= 1;
+    unsigned long long wakeups = 0;
+    for (int i = 0; i < p3clock::kVisibilityStateCount; ++i) {
+        p3clock::VisibilityState state = static_cast<p3clock::VisibilityState>(i);
+        wakeups += r.visibility.Wakeups(state);
+        double perMinute = r.visibility.WakeupsPerMinute(state, endMs);
+        if (state == p3clock::kStateVisible) {
+            passed = passed && perMinute >= 58.0 && perMinute <= 61.0;
+        } else {
+            passed = passed && r.visibility.Wakeups(state) == 0;
+        }
+        fprintf(stderr, "%-9s %6lld s  %6llu wakeups  %5.1f per minute\n", p3clock::kVisibilityStateNames[i],
+                r.visibility.TimeInStateMs(state, endMs) / 1000, r.visibility.Wakeups(state), perMinute);
+    }
+    fprintf(stderr, "%llu wakeups (%lld without the idle mode), %lld resumes, largest stale time while visible %lld s: %s\n",
+            wakeups, r.wakeupsWithoutIdle, r.resumes, r.staleMaxSeconds, passed ? "ok" : "FAIL");
+
+    if (!output.Begin("idle")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("script", script);
+    json.Field("seconds", seconds);
+    json.Field("passed", passed);
+    json.Field("wakeups", (long long)wakeups);
+    json.Field("wakeups_without_idle", r.wakeupsWithoutIdle);
+    json.Field("frames", r.frames);
+    json.Field("catch_up_frames", r.catchUpFrames);
+    json.Field("resumes", r.resumes);
+    json.Field("stale_max_seconds", r.staleMaxSeconds);
+    json.Key("states");
+    json.BeginArray();
+    for (int i = 0; i < p3clock::kVisibilityStateCount; ++i) {
+        p3clock::VisibilityState state = static_cast<p3clock::VisibilityState>(i);
+        json.BeginObject();
+        json.Field("state", p3clock::kVisibilityStateNames[i]);
+        json.Field("seconds", r.visibility.TimeInStateMs(state, endMs) / 1000.0);
+        json.Field("wakeups", (long long)r.visibility.Wakeups(state));
+        json.Field("wakeups_per_minute", r.visibility.WakeupsPerMinute(state, endMs));
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_IDLE_CHECK_H
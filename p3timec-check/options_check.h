@@ -0,0 +1,87 @@
+#ifndef P3TIMEC_CHECK_OPTIONS_CHECK_H
+#define P3TIMEC_CHECK_OPTIONS_CHECK_H
+
+// options: command lines of p3timec-wall through ParseWallOptions, which
+// must match /digital, /analog and every /zone: as whole tokens in any case.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../p3clock/clock_wall.h"
+#include "check_output.h"
+
+struct WallOptionsCase {
+    const char* cmdLine;
+    p3clock::ClockLayout layout;
+    int zones;
+    const char* firstLabel;
+};
+
+static const WallOptionsCase kWallOptionsCases[] = {
+    {"", p3clock::kLayoutAnalogDigital, 8, "UTC-08:00"}, // The default zones
+    {"/digital", p3clock::kLayoutDigital, 8, "UTC-08:00"},
+    {"/ANALOG /zone:+9,Tokyo", p3clock::kLayoutAnalog, 1, "TOKYO"},
+    {"-Digital --zone=+5:30,Pune", p3clock::kLayoutDigital, 1, "PUNE"},
+    {"/zone:+1,Digital_Lab", p3clock::kLayoutAnalogDigital, 1, "DIGITAL LAB"}, // A label, not /digital
+    {"/zone:-3,Analog_Hub /zone:+9,Tokyo", p3clock::kLayoutAnalogDigital, 2, "ANALOG HUB"},
+    {"/Zone:-3:30,Newfoundland /ZONE:+14 /zone:+15", p3clock::kLayoutAnalogDigital, 2, "NEWFOUNDLAND"},
+    {"/digitalis /analogue", p3clock::kLayoutAnalogDigital, 8, "UTC-08:00"},
+    {"/log:zone:+5,Trap \"C:\\zone:+6\\wall.exe\"", p3clock::kLayoutAnalogDigital, 8, "UTC-08:00"}, // Inside values
+};
+static const int kWallOptionsCaseCount = sizeof(kWallOptionsCases) / sizeof(kWallOptionsCases[0]);
+
+struct WallOptionsResult {
+    const WallOptionsCase* test;
+    p3clock::ClockLayout layout;
+    std::vector<p3clock::WallZone> zones;
+    bool passed;
+};
+
+static int RunOptionsCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    while (args.Next()) {
+        args.Unknown();
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    bool passed = true;
+    std::vector<WallOptionsResult> results;
+    for (int c = 0; c < kWallOptionsCaseCount; ++c) {
+        WallOptionsResult r;
+        r.test = &kWallOptionsCases[c];
+        p3clock::ParseWallOptions(r.test->cmdLine, &r.layout, &r.zones);
+        r.passed = r.layout == r.test->layout && (int)r.zones.size() == r.test->zones &&
+                   strcmp(r.zones[0].label, r.test->firstLabel) == 0;
+        fprintf(stderr, "%s %-9s %d zones, first %-13s p3timec-wall %s\n", r.passed ? "ok  " : "FAIL",
+                p3clock::kClockLayoutNames[r.layout], (int)r.zones.size(), r.zones[0].label, r.test->cmdLine);
+        passed = passed && r.passed;
+        results.push_back(r);
+    }
+
+    if (!output.Begin("options")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("passed", passed);
+    json.Key("wall");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const WallOptionsResult& r = results[i];
+        json.BeginObject();
+        json.Field("command_line", r.test->cmdLine);
+        json.Field("passed", r.passed);
+        json.Field("layout", p3clock::kClockLayoutNames[r.layout]);
+        json.Field("expected_layout", p3clock::kClockLayoutNames[r.test->layout]);
+        json.Field("zones", (int)r.zones.size());
+        json.Field("expected_zones", r.test->zones);
+        json.Field("first_label", r.zones[0].label);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_OPTIONS_CHECK_H
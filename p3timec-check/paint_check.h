@@ -0,0 +1,196 @@
+#ifndef P3TIMEC_CHECK_PAINT_CHECK_H
+#define P3TIMEC_CHECK_PAINT_CHECK_H
+
+// paint: the analog paint with the cached face layer against the paint that
+// redrew the face every time, in time and pixels.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../p3clock/bench_stats.h"
+#include "../p3clock/glyph_atlas.h"
+#include "../p3clock/soft_clock.h"
+#include "../p3clock-tools/tool_support.h"
+#include "check_output.h"
+
+static const p3clock::FrameSize kPaintSizes[] = {
+    {800, 400},   // CreateWindowEx default
+    {1920, 1080},
+    {3840, 2160}, // The wall displays
+};
+static const int kPaintSizeCount = sizeof(kPaintSizes) / sizeof(kPaintSizes[0]);
+
+const int kPaintRounds = 5;
+
+// WM_PAINT of the moni programs before the face layer: background, face, border and the twelve
+// numerals drawn into the back buffer with every paint, then the hands and the digits
+class UncachedFacePaint {
+public:
+    UncachedFacePaint(p3clock::ClockLayout layout, int width, int height) {
+        geometry_ = p3clock::ComputeClockGeometry(layout, width, height);
+        frame_.Resize(width, height);
+        if (geometry_.hasDigital) {
+            atlasLayout_ = p3clock::BuildTimeGlyphAtlas(&atlas_, geometry_.fontSize);
+            const p3clock::DamageRect& r = geometry_.digitalRect;
+            textLayout_ = p3clock::LayoutTimeText(atlasLayout_, r.left, r.top, r.right, r.bottom);
+        }
+    }
+
+    void Render(const p3clock::ClockTime& t) {
+        p3clock::Argb color = p3clock::ClockColor(t);
+        p3clock::DamageRect all = {0, 0, frame_.width, frame_.height};
+        p3clock::DrawClockFace(&frame_, geometry_, color);
+        p3clock::DrawClockHands(&frame_, geometry_.analog, 0, 0, t, 0, false, color, all);
+        if (geometry_.hasDigital) {
+            p3clock::GlyphBlit blits[8];
+            p3clock::TimeTextBlits(atlasLayout_, textLayout_, t, blits);
+            for (int i = 0; i < 8; ++i) {
+                p3clock::Blit(&frame_, blits[i].dstX, blits[i].dstY, atlas_, blits[i].srcX, blits[i].srcY,
+                              blits[i].width, blits[i].height);
+            }
+        }
+    }
+
+    const p3clock::Framebuffer& Frame() const { return frame_; }
+
+private:
+    p3clock::ClockGeometry geometry_;
+    p3clock::Framebuffer frame_;
+    p3clock::Framebuffer atlas_;
+    p3clock::GlyphAtlasLayout atlasLayout_;
+    p3clock::TimeTextLayout textLayout_;
+};
+
+struct PaintCaseResult {
+    p3clock::ClockLayout layout;
+    p3clock::FrameSize size;
+    p3clock::FrameTimeSummary before; // Face redrawn every paint
+    p3clock::FrameTimeSummary after;  // Face layer copied
+    double speedup;                   // Median before / median after
+    bool sameFrames;
+    bool passed;
+};
+
+// Steady ticks from 10:08:00 (no color change), timed in kPaintRounds rounds that alternate
+// between the two paints; the fastest round of each counts, so load from elsewhere on the
+// machine slows both rather than one
+static PaintCaseResult RunPaintCase(p3clock::ClockLayout layout, p3clock::FrameSize size, int frames) {
+    PaintCaseResult r;
+    r.layout = layout;
+    r.size = size;
+    UncachedFacePaint before(layout, size.width, size.height);
+    p3clock::SoftClockRenderer after(layout);
+    after.Resize(size.width, size.height);
+    p3clock::ClockTime start = {10, 8, 0};
+    after.Render(start); // Builds the face layer, like the first WM_PAINT after WM_SIZE
+    before.Render(start);
+    r.sameFrames = before.Frame().pixels == after.Frame().pixels;
+
+    for (int round = 0; round < kPaintRounds; ++round) {
+        std::vector<double> beforeMs, afterMs;
+        beforeMs.reserve(frames);
+        afterMs.reserve(frames);
+        for (int i = 0; i < frames; ++i) {
+            p3clock::ClockTime t = p3clock::AddSeconds(start, i + 1);
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            before.Render(t);
+            beforeMs.push_back(p3clock::MsSince(begin));
+            begin = std::chrono::steady_clock::now();
+            after.Render(t);
+            afterMs.push_back(p3clock::MsSince(begin));
+            r.sameFrames = r.sameFrames && before.Frame().pixels == after.Frame().pixels;
+        }
+        p3clock::FrameTimeSummary b = p3clock::SummarizeFrameTimes(beforeMs);
+        p3clock::FrameTimeSummary a = p3clock::SummarizeFrameTimes(afterMs);
+        if (round == 0 || b.p50Ms < r.before.p50Ms) r.before = b;
+        if (round == 0 || a.p50Ms < r.after.p50Ms) r.after = a;
+    }
+    r.speedup = r.after.p50Ms > 0.0 ? r.before.p50Ms / r.after.p50Ms : 0.0;
+    r.passed = false;
+    return r;
+}
+
+static int RunPaintCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    std::vector<p3clock::ClockLayout> layouts;
+    std::vector<p3clock::FrameSize> sizes;
+    int frames = 20;
+    double minSpeedup = 0.0; // Off: the ratio is reported, the frames decide
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--layout")) {
+            p3clock::ClockLayout layout;
+            ok = p3clock::ParseClockLayout(value, &layout) && layout != p3clock::kLayoutDigital;
+            if (ok) layouts.push_back(layout);
+        } else if (args.Is("--size")) {
+            p3clock::FrameSize size;
+            ok = p3clock::ParseSize(value, &size.width, &size.height);
+            if (ok) sizes.push_back(size);
+        } else if (args.Is("--frames")) {
+            frames = atoi(value);
+            ok = frames > 0;
+        } else if (args.Is("--min-speedup")) {
+            minSpeedup = atof(value);
+            ok = minSpeedup > 0.0;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (layouts.empty()) {
+        layouts.push_back(p3clock::kLayoutAnalogDigital);
+        layouts.push_back(p3clock::kLayoutAnalog);
+    }
+    if (sizes.empty()) {
+        sizes.assign(kPaintSizes, kPaintSizes + kPaintSizeCount);
+    }
+
+    bool passed = true;
+    std::vector<PaintCaseResult> results;
+    for (size_t l = 0; l < layouts.size(); ++l) {
+        for (size_t s = 0; s < sizes.size(); ++s) {
+            PaintCaseResult r = RunPaintCase(layouts[l], sizes[s], frames);
+            // A ratio of two wall-clock timings only fails the run when asked for: on a loaded machine
+            // the margin at 4K (about 1.1x) is within the noise
+            r.passed = r.sameFrames && (minSpeedup <= 0.0 || r.speedup >= minSpeedup);
+            fprintf(stderr, "%-9s %4dx%-4d %s  before %8.3f ms  after %8.3f ms  %5.1fx%s\n",
+                    p3clock::kClockLayoutNames[r.layout], r.size.width, r.size.height, r.passed ? "ok  " : "FAIL",
+                    r.before.p50Ms, r.after.p50Ms, r.speedup, r.sameFrames ? "" : "  frames differ");
+            passed = passed && r.passed;
+            results.push_back(r);
+        }
+    }
+
+    if (!output.Begin("paint")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("frames", frames);
+    json.Field("min_speedup", minSpeedup); // 0: not checked
+    json.Field("passed", passed);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const PaintCaseResult& r = results[i];
+        json.BeginObject();
+        json.Field("layout", p3clock::kClockLayoutNames[r.layout]);
+        json.Field("width", r.size.width);
+        json.Field("height", r.size.height);
+        json.Field("passed", r.passed);
+        json.Field("same_frames", r.sameFrames);
+        json.Field("before_p50_ms", r.before.p50Ms);
+        json.Field("before_p99_ms", r.before.p99Ms);
+        json.Field("after_p50_ms", r.after.p50Ms);
+        json.Field("after_p99_ms", r.after.p99Ms);
+        json.Field("speedup", r.speedup);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_PAINT_CHECK_H
@@ -0,0 +1,91 @@
+#ifndef P3TIMEC_CHECK_RESIZE_CHECK_H
+#define P3TIMEC_CHECK_RESIZE_CHECK_H
+
+// resize: a drag-resize replayed WM_SIZE by WM_SIZE (p3clock-tools/resize_replay.h):
+// the fitted font fits, frames rebuild once, and sizes seen before cost nothing.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../p3clock/soft_clock.h"
+#include "../p3clock-tools/resize_replay.h"
+#include "check_output.h"
+
+static int RunResizeCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    const char* tracePath = NULL;
+    int events = 1000;
+    double hz = 60.0;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--trace")) {
+            tracePath = value;
+        } else if (args.Is("--events")) {
+            events = atoi(value);
+            ok = events > 0;
+        } else if (args.Is("--hz")) {
+            hz = atof(value);
+            ok = hz > 0.0 && hz <= 1000.0;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    std::vector<p3clock::ResizeEvent> trace;
+    if (tracePath) {
+        if (!p3clock::ReadResizeTrace(tracePath, &trace)) {
+            fprintf(stderr, "p3timec-check: cannot read resize trace %s\n", tracePath);
+            return 2;
+        }
+    } else {
+        trace = p3clock::RecordedDrag(events);
+    }
+
+    // The fitted text fits, a frame rebuilds once at most, and sizes fitted before are neither
+    // measured again nor given new fonts
+    bool passed = true;
+    std::vector<p3clock::ResizeCaseResult> results;
+    for (int l = 0; l < p3clock::kLayoutCount; ++l) {
+        p3clock::ResizeCaseResult r = p3clock::RunResizeCase(static_cast<p3clock::ClockLayout>(l), trace, hz);
+        bool ok = r.fill.clippedFitted == 0 && r.after.rebuilds <= r.after.frames && r.replay.measurements == 0 &&
+                  r.toggle.fontCreates == 0 && r.toggle.measurements == 0;
+        fprintf(stderr, "%s %-9s %lld rebuilds in %lld frames  %d of %d sizes clipped  %lld measured on replay  "
+                "%lld fonts, %lld measured on maximize / restore\n", ok ? "ok  " : "FAIL",
+                p3clock::kClockLayoutNames[l], r.after.rebuilds, r.after.frames, r.fill.clippedFitted, r.fill.sizes,
+                r.replay.measurements, r.toggle.fontCreates, r.toggle.measurements);
+        passed = passed && ok;
+        results.push_back(r);
+    }
+
+    if (!output.Begin("resize")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("trace", tracePath ? tracePath : "recorded");
+    json.Field("events", (int)trace.size());
+    json.Field("hz", hz);
+    json.Field("passed", passed);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const p3clock::ResizeCaseResult& r = results[i];
+        json.BeginObject();
+        json.Field("layout", p3clock::kClockLayoutNames[r.layout]);
+        json.Field("frames", r.after.frames);
+        json.Field("rebuilds", r.after.rebuilds);
+        json.Field("sizes", r.fill.sizes);
+        json.Field("clipped", r.fill.clippedFitted);
+        json.Field("replay_measurements", r.replay.measurements);
+        json.Field("toggle_font_creates", r.toggle.fontCreates);
+        json.Field("toggle_measurements", r.toggle.measurements);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_RESIZE_CHECK_H
@@ -0,0 +1,164 @@
+#ifndef P3TIMEC_CHECK_TICKS_CHECK_H
+#define P3TIMEC_CHECK_TICKS_CHECK_H
+
+// ticks: the second-aligned tick scheduler driven for hours by simulated
+// timers that fire late, drift against the wall clock or stall.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../p3clock/bench_stats.h"
+#include "../p3clock/tick_scheduler.h"
+#include "check_output.h"
+
+// How the one-shot timer behaves against the wall clock
+struct TickTimerModel {
+    const char* name;
+    int driftSign; // -1: the timer clock runs fast (fires early), +1: slow, 0: exact
+    bool stalls;   // Now and then a timer message waits behind a busy message loop
+};
+
+static const TickTimerModel kTickTimerModels[] = {
+    {"steady", 0, false},
+    {"fast", -1, false},
+    {"slow", 1, false},
+    {"stalls", 0, true},
+};
+static const int kTickTimerModelCount = sizeof(kTickTimerModels) / sizeof(kTickTimerModels[0]);
+
+const int kTickStallEverySeconds = 617; // Not a multiple of anything the scheduler does
+const int kTickStallMs = 400;
+
+struct TickRunResult {
+    const TickTimerModel* model;
+    long long flips;    // Ticks that showed a new second
+    long long skipped;  // Seconds never shown
+    long long repeated; // A second shown again
+    long long early;    // Timer messages that arrived before the boundary
+    p3clock::FrameTimeSummary latency; // Boundary to the tick that shows it, ms
+    bool passed;
+};
+
+// WM_CREATE and WM_TIMER of the Win32 programs on a simulated wall clock in ms. Each delay the
+// scheduler asks for is stretched by the drift, then the message arrives 0 to jitterMs - 1 ms
+// late, like the system timer, plus kTickStallMs when a stall is due.
+static TickRunResult RunTickModel(const TickTimerModel& model, int hours, int jitterMs, double driftPpm) {
+    TickRunResult r;
+    r.model = &model;
+    r.flips = r.skipped = r.repeated = 0;
+    double stretch = 1.0 + model.driftSign * driftPpm / 1e6;
+    // Off any boundary, and off whole milliseconds like a real clock
+    double startMs = 1700000000000.0 + 437.25;
+    double endMs = startMs + hours * 3600000.0;
+    double nextStallMs = startMs + kTickStallEverySeconds * 1000.0;
+    unsigned int jitter = 1;
+
+    p3clock::TickScheduler scheduler;
+    double nowMs = startMs;
+    long long shown = (long long)nowMs / 1000;
+    int delayMs = scheduler.Start((long long)nowMs);
+    std::vector<double> latencies;
+    latencies.reserve((size_t)hours * 3600);
+    for (;;) {
+        jitter = jitter * 1103515245u + 12345u;
+        nowMs += delayMs * stretch + (jitterMs > 0 ? (jitter >> 16) % jitterMs : 0);
+        if (model.stalls && nowMs >= nextStallMs) {
+            nowMs += kTickStallMs;
+            nextStallMs += kTickStallEverySeconds * 1000.0;
+        }
+        if (nowMs >= endMs) {
+            break;
+        }
+        p3clock::Tick tick = scheduler.OnTick((long long)nowMs);
+        delayMs = tick.delayMs;
+        if (!tick.present) {
+            continue;
+        }
+        // Judged on what the window shows, not on the scheduler's own counters
+        if (tick.second == shown) {
+            r.repeated++;
+        } else if (tick.second > shown + 1) {
+            r.skipped += tick.second - shown - 1;
+        }
+        shown = tick.second;
+        r.flips++;
+        latencies.push_back(nowMs - tick.second * 1000.0);
+    }
+    r.early = (long long)scheduler.Stats().repeats;
+    r.latency = p3clock::SummarizeFrameTimes(latencies);
+    r.passed = false;
+    return r;
+}
+
+static int RunTicksCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    int hours = 24;
+    int jitterMs = 16;
+    double driftPpm = 500.0;
+    double maxP99Ms = 20.0;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--hours")) {
+            hours = atoi(value);
+            ok = hours > 0;
+        } else if (args.Is("--jitter")) {
+            jitterMs = atoi(value);
+            ok = jitterMs >= 0 && jitterMs < 500;
+        } else if (args.Is("--drift")) {
+            driftPpm = atof(value);
+            ok = driftPpm >= 0.0 && driftPpm < 100000.0;
+        } else if (args.Is("--max-p99")) {
+            maxP99Ms = atof(value);
+            ok = maxP99Ms > 0.0;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    bool passed = true;
+    std::vector<TickRunResult> results;
+    for (int m = 0; m < kTickTimerModelCount; ++m) {
+        TickRunResult r = RunTickModel(kTickTimerModels[m], hours, jitterMs, driftPpm);
+        r.passed = r.skipped == 0 && r.repeated == 0 && r.early == 0 && r.latency.p99Ms <= maxP99Ms;
+        fprintf(stderr, "%-6s %s  %7lld flips  latency p50 %5.1f  p99 %5.1f  max %6.1f ms  %lld skipped  %lld repeated  %lld early\n",
+                r.model->name, r.passed ? "ok  " : "FAIL", r.flips, r.latency.p50Ms, r.latency.p99Ms, r.latency.maxMs,
+                r.skipped, r.repeated, r.early);
+        passed = passed && r.passed;
+        results.push_back(r);
+    }
+
+    if (!output.Begin("ticks")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("hours", hours);
+    json.Field("jitter_ms", jitterMs);
+    json.Field("drift_ppm", driftPpm);
+    json.Field("max_p99_ms", maxP99Ms);
+    json.Field("passed", passed);
+    json.Key("timers");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const TickRunResult& r = results[i];
+        json.BeginObject();
+        json.Field("timer", r.model->name);
+        json.Field("passed", r.passed);
+        json.Field("flips", r.flips);
+        json.Field("skipped", r.skipped);
+        json.Field("repeated", r.repeated);
+        json.Field("early", r.early);
+        json.Field("latency_p50_ms", r.latency.p50Ms);
+        json.Field("latency_p99_ms", r.latency.p99Ms);
+        json.Field("latency_max_ms", r.latency.maxMs);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_TICKS_CHECK_H
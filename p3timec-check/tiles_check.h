@@ -0,0 +1,102 @@
+#ifndef P3TIMEC_CHECK_TILES_CHECK_H
+#define P3TIMEC_CHECK_TILES_CHECK_H
+
+// tiles: frames rendered in tiles on the thread pool (RenderTiled) against the
+// same frames rendered on one thread.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../p3clock/soft_clock.h"
+#include "../p3clock/tile_pool.h"
+#include "../p3clock-tools/tool_support.h"
+#include "check_output.h"
+
+struct TileCheckResult {
+    p3clock::ClockLayout layout;
+    p3clock::FrameSize size;
+    int frames;
+    int differing; // Frames where RenderTiled() and Render() disagree
+};
+
+// RenderTiled() on `threads` threads against Render() on one, second by second across
+// 01:00:00, where the face layer is rebuilt (green to blue)
+static TileCheckResult CompareTiledFrames(p3clock::ClockLayout layout, p3clock::FrameSize size, int threads, int seconds) {
+    TileCheckResult r = {layout, size, 0, 0};
+    p3clock::TilePool pool(threads);
+    p3clock::SoftClockRenderer tiled(layout), reference(layout);
+    tiled.Resize(size.width, size.height);
+    reference.Resize(size.width, size.height);
+    p3clock::ClockTime rebuild = {1, 0, 0};
+    for (int i = 0; i < seconds; ++i) {
+        p3clock::ClockTime t = p3clock::AddSeconds(rebuild, i - seconds / 2);
+        tiled.RenderTiled(t, &pool);
+        reference.Render(t);
+        r.differing += tiled.Frame().pixels == reference.Frame().pixels ? 0 : 1;
+        r.frames++;
+    }
+    return r;
+}
+
+static int RunTilesCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    int threads = 4;
+    int seconds = 6;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--threads")) {
+            threads = atoi(value);
+            ok = threads > 0 && threads <= 256;
+        } else if (args.Is("--seconds")) {
+            seconds = atoi(value);
+            ok = seconds > 0 && seconds <= 120;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    // Whole tiles, a last row and column cut short, and frames narrower than one tile
+    static const p3clock::FrameSize kSizes[] = {{1024, 512}, {1921, 1081}, {300, 700}, {160, 90}};
+    bool passed = true;
+    std::vector<TileCheckResult> results;
+    for (int l = 0; l < p3clock::kLayoutCount; ++l) {
+        for (size_t s = 0; s < sizeof(kSizes) / sizeof(kSizes[0]); ++s) {
+            TileCheckResult r = CompareTiledFrames(static_cast<p3clock::ClockLayout>(l), kSizes[s], threads, seconds);
+            fprintf(stderr, "%s %-9s %5dx%-5d %3d tiles  %d of %d frames differ\n", r.differing ? "FAIL" : "ok  ",
+                    p3clock::kClockLayoutNames[l], r.size.width, r.size.height,
+                    p3clock::TileCount(r.size.width, r.size.height), r.differing, r.frames);
+            passed = passed && r.differing == 0;
+            results.push_back(r);
+        }
+    }
+
+    if (!output.Begin("tiles")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("threads", threads);
+    json.Field("tile_size", p3clock::kTileSize);
+    json.Field("passed", passed);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const TileCheckResult& r = results[i];
+        json.BeginObject();
+        json.Field("layout", p3clock::kClockLayoutNames[r.layout]);
+        json.Field("width", r.size.width);
+        json.Field("height", r.size.height);
+        json.Field("tiles", p3clock::TileCount(r.size.width, r.size.height));
+        json.Field("frames", r.frames);
+        json.Field("differing", r.differing);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_TILES_CHECK_H
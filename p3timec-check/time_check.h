@@ -0,0 +1,235 @@
+#ifndef P3TIMEC_CHECK_TIME_CHECK_H
+#define P3TIMEC_CHECK_TIME_CHECK_H
+
+// time: the cached local-time source on a simulated clock through DST
+// transitions, zone changes and wall clock jumps.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../p3clock/time_source.h"
+#include "check_output.h"
+
+// A stretch of simulated time for the time check: one zone, at most one DST period, and events
+enum TimeEventType {
+    kTimeSilentJump, // The wall clock steps without notice (NTP): found by the periodic comparison
+    kTimeSetClock,   // The user sets the clock: WM_TIMECHANGE, so Invalidate()
+    kTimeSetZone,    // The user picks another time zone: WM_TIMECHANGE as well
+    kTimeEventCount
+};
+
+static const char* const kTimeEventNames[kTimeEventCount] = {"silent-jump", "set-clock", "set-zone"};
+
+struct TimeEvent {
+    long long atMs; // From the start of the scenario
+    TimeEventType type;
+    long long value; // Jump in ms, or the new standard offset in minutes
+};
+
+const int kMaxTimeEvents = 8;
+
+struct TimeScenario {
+    const char* name;
+    long long startUtcMs; // ms since 1970-01-01 00:00 UTC
+    int standardMinutes;
+    long long dstStartUtcMs;
+    long long dstEndUtcMs;
+    int dstMinutes; // 0 = no DST period
+    int eventCount;
+    TimeEvent events[kMaxTimeEvents];
+};
+
+const long long kNoTransition = 1LL << 60;
+
+static const TimeScenario kTimeScenarios[] = {
+    // Berlin, 2026-03-29 02:00 CET -> 03:00 CEST
+    {"spring-forward", 1774656000000LL, 60, 1774746000000LL, kNoTransition, 60, 0, {}},
+    // New York, 2026-11-01 02:00 EDT -> 01:00 EST: the hour from 01:00 is shown twice
+    {"fall-back", 1793404800000LL, -300, -kNoTransition, 1793512800000LL, 60, 0, {}},
+    // Lord Howe Island, 2026-04-05 02:00 +11:00 -> 01:30 +10:30: half an hour of DST
+    {"half-hour", 1775260800000LL, 630, -kNoTransition, 1775314800000LL, 30, 0, {}},
+    // Tokyo, no DST, with the wall clock set in every way the system can set it
+    {"jumps", 1780272000000LL, 540, 0, 0, 0, 5,
+     {{6 * 3600000LL, kTimeSilentJump, 5 * 60000},
+      {12 * 3600000LL, kTimeSilentJump, -3000},
+      {18 * 3600000LL, kTimeSetClock, -3600000},
+      {24 * 3600000LL, kTimeSetZone, 480},
+      {30 * 3600000LL, kTimeSilentJump, 200}}},
+};
+
+const int kTimeScenarioCount = (int)(sizeof(kTimeScenarios) / sizeof(kTimeScenarios[0]));
+
+struct TimeCheckResult {
+    const char* name;
+    long long reads;
+    long long mismatches;     // Reads whose local time differed from the slow path
+    long long textErrors;     // "HH:MM:SS" not matching the broken-down time, or changed bits missing
+    long long staleMs;        // Longest stretch of mismatches after a silent jump
+    long long lateMismatches; // Mismatches not explained by a silent jump still waiting for its check
+    long long offsetChanges;
+    p3clock::TimeSourceStats stats;
+    unsigned long long wallReads;   // UtcMs() calls the clock saw
+    unsigned long long offsetReads; // UtcOffsetMinutes() calls the clock saw
+    bool passed;
+};
+
+static TimeCheckResult CheckTimeScenario(const TimeScenario& scenario, int hours, int maxStepMs, int wallCheckMs) {
+    TimeCheckResult r;
+    memset(&r, 0, sizeof(r));
+    r.name = scenario.name;
+    p3clock::FakeClock clock(scenario.startUtcMs, scenario.standardMinutes);
+    if (scenario.dstMinutes) {
+        clock.AddDst(scenario.dstStartUtcMs, scenario.dstEndUtcMs, scenario.dstMinutes);
+    }
+    p3clock::TimeSource<p3clock::FakeClock> source(&clock, wallCheckMs);
+
+    long long endMs = hours * 3600000LL;
+    long long elapsedMs = 0;
+    long long silentSinceMs = -1; // Last silent jump the source may not have seen yet
+    long long mismatchFromMs = -1;
+    int nextEvent = 0;
+    unsigned int random = 12345;
+    char previous[8];
+    bool havePrevious = false;
+    while (elapsedMs < endMs) {
+        // Ticks and sweep frames come at any spacing: from 1 ms to a bit over a second
+        random = random * 1103515245u + 12345u;
+        long long stepMs = 1 + (random >> 8) % (unsigned)maxStepMs;
+        clock.Advance(stepMs);
+        elapsedMs += stepMs;
+        while (nextEvent < scenario.eventCount && scenario.events[nextEvent].atMs <= elapsedMs) {
+            const TimeEvent& e = scenario.events[nextEvent++];
+            if (e.type == kTimeSetZone) {
+                clock.SetStandardMinutes((int)e.value);
+            } else {
+                clock.JumpWall(e.value);
+            }
+            if (e.type == kTimeSilentJump) {
+                silentSinceMs = elapsedMs;
+            } else {
+                source.Invalidate();
+            }
+        }
+
+        p3clock::LocalTime now = source.Now();
+        r.reads++;
+        long long expectedMs = clock.LocalMs();
+        if (now.ms != expectedMs) {
+            r.mismatches++;
+            if (mismatchFromMs < 0) mismatchFromMs = elapsedMs;
+            if (silentSinceMs >= 0 && elapsedMs - silentSinceMs <= wallCheckMs) {
+                if (elapsedMs - silentSinceMs > r.staleMs) r.staleMs = elapsedMs - silentSinceMs;
+            } else {
+                r.lateMismatches++;
+            }
+        } else {
+            mismatchFromMs = -1;
+        }
+
+        // The incremental text has to match a full format of the same time
+        long long second = p3clock::FloorDiv(now.ms, 1000);
+        int ofDay = (int)(second - p3clock::FloorDiv(second, 86400) * 86400);
+        p3clock::ClockTime t = {ofDay / 3600, ofDay / 60 % 60, ofDay % 60};
+        char text[8];
+        p3clock::FormatTime(t, text);
+        bool textOk = memcmp(text, now.text, 8) == 0 && p3clock::SameTime(t, now.time) &&
+                      now.millisecond == (int)(now.ms - second * 1000);
+        for (int i = 0; havePrevious && i < 8; ++i) {
+            if (previous[i] != now.text[i] && !(now.changed & (1 << i))) textOk = false;
+        }
+        r.textErrors += textOk ? 0 : 1;
+        memcpy(previous, now.text, 8);
+        havePrevious = true;
+    }
+    r.stats = source.Stats();
+    r.offsetChanges = (long long)r.stats.offsetChanges;
+    r.wallReads = clock.WallReads();
+    r.offsetReads = clock.OffsetReads();
+    // Every DST transition and zone change in the simulated stretch shows up as one new offset,
+    // every step past the tolerance as a jump
+    long long transitionUtcMs = scenario.dstStartUtcMs != -kNoTransition ? scenario.dstStartUtcMs : scenario.dstEndUtcMs;
+    long long expectedChanges = scenario.dstMinutes && transitionUtcMs - scenario.startUtcMs <= endMs ? 1 : 0;
+    unsigned long long expectedJumps = 0;
+    for (int i = 0; i < nextEvent; ++i) {
+        const TimeEvent& e = scenario.events[i];
+        expectedChanges += e.type == kTimeSetZone ? 1 : 0;
+        expectedJumps += e.type == kTimeSilentJump && (e.value > p3clock::kJumpToleranceMs || e.value < -p3clock::kJumpToleranceMs);
+    }
+    r.passed = r.textErrors == 0 && r.lateMismatches == 0 && r.offsetChanges == expectedChanges &&
+               r.stats.jumps == expectedJumps;
+    return r;
+}
+
+// Local time on the host, for timing the fast path against localtime_r + strftime
+static int RunTimeCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    int hours = 48;
+    int maxStepMs = 1100;
+    int wallCheckMs = p3clock::kWallCheckMs;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--hours")) {
+            hours = atoi(value);
+            ok = hours > 0 && hours <= 24 * 366;
+        } else if (args.Is("--max-step")) {
+            maxStepMs = atoi(value);
+            ok = maxStepMs > 0;
+        } else if (args.Is("--wall-check")) {
+            wallCheckMs = atoi(value);
+            ok = wallCheckMs > 0;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    bool passed = true;
+    std::vector<TimeCheckResult> results;
+    for (int s = 0; s < kTimeScenarioCount; ++s) {
+        TimeCheckResult r = CheckTimeScenario(kTimeScenarios[s], hours, maxStepMs, wallCheckMs);
+        fprintf(stderr, "%-14s %s  %lld reads  %llu clock reads  %llu zone queries  %llu jumps found  "
+                "%lld offset changes  %.2f chars/read  %lld off (stale %lld ms)\n",
+                r.name, r.passed ? "ok  " : "FAIL", r.reads, r.wallReads, r.offsetReads, r.stats.jumps,
+                r.offsetChanges, (double)r.stats.charsWritten / r.reads, r.mismatches, r.staleMs);
+        passed = passed && r.passed;
+        results.push_back(r);
+    }
+
+    if (!output.Begin("time")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("hours", hours);
+    json.Field("max_step_ms", maxStepMs);
+    json.Field("wall_check_ms", wallCheckMs);
+    json.Field("passed", passed);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const TimeCheckResult& r = results[i];
+        json.BeginObject();
+        json.Field("scenario", r.name);
+        json.Field("passed", r.passed);
+        json.Field("reads", r.reads);
+        json.Field("clock_reads", (long long)r.wallReads);
+        json.Field("zone_queries", (long long)r.offsetReads);
+        json.Field("jumps_found", (long long)r.stats.jumps);
+        json.Field("offset_changes", r.offsetChanges);
+        json.Field("full_formats", (long long)r.stats.fullFormats);
+        json.Field("chars_written", (long long)r.stats.charsWritten);
+        json.Field("mismatches", r.mismatches);
+        json.Field("late_mismatches", r.lateMismatches);
+        json.Field("stale_ms", r.staleMs);
+        json.Field("text_errors", r.textErrors);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_TIME_CHECK_H
@@ -0,0 +1,131 @@
+#ifndef P3TIMEC_CHECK_TRACE_CHECK_H
+#define P3TIMEC_CHECK_TRACE_CHECK_H
+
+// trace: the paint tracer's ring (p3clock/paint_trace.h) under concurrent
+// writers while a reader copies it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "../p3clock/paint_trace.h"
+#include "check_output.h"
+
+struct RingCheckResult {
+    int writers;
+    int eventsPerWriter;
+    long long snapshots;     // Snapshots the reader took while the writers ran
+    long long eventsChecked; // Events in those snapshots
+    long long torn;          // Events whose fields do not belong together
+    long long outOfOrder;    // Events of one writer not in the order it recorded them
+    int finalCount;          // Events in the ring after the writers finished
+    bool passed;
+};
+
+// Writer w records its i-th event with fields derived from (w, i), so a half-written or mixed up
+// event is recognized. The reader snapshots the ring all the while.
+static RingCheckResult CheckPhaseRing(int writers, int eventsPerWriter) {
+    RingCheckResult result;
+    result.writers = writers;
+    result.eventsPerWriter = eventsPerWriter;
+    result.snapshots = result.eventsChecked = result.torn = result.outOfOrder = 0;
+
+    p3clock::PhaseRing* ring = new p3clock::PhaseRing;
+    std::vector<p3clock::PhaseEvent> events(p3clock::kPaintTraceCapacity);
+    std::vector<double> lastSeen(writers);
+    volatile bool done = false;
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w) {
+        threads.push_back(std::thread([ring, w, eventsPerWriter]() {
+            for (int i = 0; i < eventsPerWriter; ++i) {
+                p3clock::PhaseEvent e;
+                e.frame = (unsigned)i;
+                e.phase = (w + i) % p3clock::kPaintPhaseCount;
+                e.lane = w;
+                e.startMs = (double)i;
+                e.durationMs = i * 3.0 + w;
+                ring->Record(e);
+            }
+        }));
+    }
+    std::thread reader([&]() {
+        while (!done) {
+            int count = ring->Snapshot(&events[0], p3clock::kPaintTraceCapacity);
+            result.snapshots++;
+            std::fill(lastSeen.begin(), lastSeen.end(), -1.0);
+            for (int k = 0; k < count; ++k) {
+                const p3clock::PhaseEvent& e = events[k];
+                result.eventsChecked++;
+                bool valid = e.lane >= 0 && e.lane < writers && e.phase == (int)((e.lane + e.frame) % p3clock::kPaintPhaseCount) &&
+                             e.startMs == (double)e.frame && e.durationMs == e.frame * 3.0 + e.lane;
+                if (!valid) {
+                    result.torn++;
+                    continue;
+                }
+                // Each writer's events land in the ring in the order it recorded them
+                if (e.startMs <= lastSeen[e.lane]) {
+                    result.outOfOrder++;
+                }
+                lastSeen[e.lane] = e.startMs;
+            }
+        }
+    });
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    done = true;
+    reader.join();
+
+    result.finalCount = ring->Snapshot(&events[0], p3clock::kPaintTraceCapacity);
+    long long total = (long long)writers * eventsPerWriter;
+    int expected = total < p3clock::kPaintTraceCapacity ? (int)total : p3clock::kPaintTraceCapacity;
+    result.passed = result.torn == 0 && result.outOfOrder == 0 && result.finalCount == expected &&
+                    ring->Recorded() == (unsigned)total;
+    delete ring;
+    return result;
+}
+static int RunTraceCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    int writers = 4;
+    int ringEvents = 200000;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--writers")) {
+            writers = atoi(value);
+            ok = writers > 0 && writers <= 64;
+        } else if (args.Is("--ring-events")) {
+            ringEvents = atoi(value);
+            ok = ringEvents > 0;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    RingCheckResult ring = CheckPhaseRing(writers, ringEvents);
+    fprintf(stderr, "ring %s  %d writers x %d events  %lld snapshots  %lld events read  %lld torn  %lld out of order\n",
+            ring.passed ? "ok  " : "FAIL", ring.writers, ring.eventsPerWriter, ring.snapshots, ring.eventsChecked,
+            ring.torn, ring.outOfOrder);
+
+    if (!output.Begin("trace")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("capacity", p3clock::kPaintTraceCapacity);
+    json.Field("writers", ring.writers);
+    json.Field("events_per_writer", ring.eventsPerWriter);
+    json.Field("snapshots", ring.snapshots);
+    json.Field("events_read", ring.eventsChecked);
+    json.Field("torn", ring.torn);
+    json.Field("out_of_order", ring.outOfOrder);
+    json.Field("final_count", ring.finalCount);
+    json.Field("passed", ring.passed);
+    return output.End(ring.passed);
+}
+
+#endif // P3TIMEC_CHECK_TRACE_CHECK_H
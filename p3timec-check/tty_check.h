@@ -0,0 +1,243 @@
+#ifndef P3TIMEC_CHECK_TTY_CHECK_H
+#define P3TIMEC_CHECK_TTY_CHECK_H
+
+// tty: what p3timec-tty writes per tick, replayed on a model terminal that must
+// show the rendered frame.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../p3clock/soft_clock.h"
+#include "../p3clock/tty_frame.h"
+#include "../p3clock-tools/tool_support.h"
+#include "check_output.h"
+
+// The terminal as far as TtyScreen drives it: CUP, CUF, SGR 0 / 38;2 / 48;2, ED 2, and cells
+// that are a space or U+2580. Anything else, or a cell written past the right margin, is an error.
+class VirtualTerminal {
+public:
+    VirtualTerminal() : cols_(0), rows_(0), row_(0), col_(0), fg_(0), bg_(0), errors_(0) {}
+
+    void Resize(int cols, int rows) {
+        cols_ = cols;
+        rows_ = rows;
+        p3clock::TtyCell blank = {0, 0};
+        cells_.assign((size_t)cols * rows, blank);
+        row_ = col_ = 0;
+    }
+
+    long long Errors() const { return errors_; }
+
+    void Feed(const std::string& text) {
+        size_t i = 0;
+        while (i < text.size()) {
+            if (text[i] == '\x1b') {
+                i = Escape(text, i);
+            } else if (text[i] == ' ') {
+                Put(bg_, bg_);
+                i++;
+            } else if (text.compare(i, 3, p3clock::kUpperHalfBlock) == 0) {
+                Put(fg_, bg_);
+                i += 3;
+            } else {
+                errors_++;
+                i++;
+            }
+        }
+    }
+
+    // Cells that differ from what `frame` should look like
+    long long Mismatches(const p3clock::Framebuffer& frame) const {
+        long long count = 0;
+        for (int row = 0; row < rows_; ++row) {
+            for (int col = 0; col < cols_; ++col) {
+                if (cells_[(size_t)row * cols_ + col] != p3clock::CellOf(frame, col, row)) count++;
+            }
+        }
+        return count;
+    }
+
+private:
+    size_t Escape(const std::string& text, size_t i) {
+        if (i + 1 >= text.size() || text[i + 1] != '[') {
+            errors_++;
+            return i + 1;
+        }
+        std::vector<int> args;
+        int value = -1;
+        size_t j = i + 2;
+        for (; j < text.size(); ++j) {
+            char c = text[j];
+            if (c >= '0' && c <= '9') {
+                value = (value < 0 ? 0 : value * 10) + (c - '0');
+            } else if (c == ';') {
+                args.push_back(value);
+                value = -1;
+            } else {
+                break;
+            }
+        }
+        if (j >= text.size()) {
+            errors_++;
+            return j;
+        }
+        args.push_back(value);
+        char final = text[j];
+        int first = args[0] < 0 ? 1 : args[0];
+        if (final == 'H') {
+            int second = args.size() > 1 && args[1] >= 0 ? args[1] : 1;
+            row_ = first - 1;
+            col_ = second - 1;
+        } else if (final == 'C') {
+            col_ += first;
+        } else if (final == 'J' && args[0] == 2) {
+            p3clock::TtyCell blank = {bg_, bg_};
+            std::fill(cells_.begin(), cells_.end(), blank);
+        } else if (final == 'm') {
+            Sgr(args);
+        } else {
+            errors_++;
+        }
+        return j + 1;
+    }
+
+    void Sgr(const std::vector<int>& args) {
+        for (size_t k = 0; k < args.size(); ++k) {
+            if (args[k] <= 0) {
+                fg_ = bg_ = 0; // Default colors: taken as black here, which no clock frame relies on
+            } else if ((args[k] == 38 || args[k] == 48) && k + 4 < args.size() && args[k + 1] == 2) {
+                p3clock::Argb c = p3clock::MakeArgb(args[k + 2], args[k + 3], args[k + 4]);
+                (args[k] == 38 ? fg_ : bg_) = c;
+                k += 4;
+            } else {
+                errors_++;
+            }
+        }
+    }
+
+    void Put(p3clock::Argb top, p3clock::Argb bottom) {
+        if (row_ < 0 || row_ >= rows_ || col_ < 0 || col_ >= cols_) {
+            errors_++;
+            return;
+        }
+        p3clock::TtyCell cell = {top, bottom};
+        cells_[(size_t)row_ * cols_ + col_] = cell;
+        col_++;
+    }
+
+    int cols_;
+    int rows_;
+    std::vector<p3clock::TtyCell> cells_;
+    int row_;
+    int col_;
+    p3clock::Argb fg_;
+    p3clock::Argb bg_;
+    long long errors_; // Sequences this model does not know, and cells off the screen
+};
+struct TtyReplayResult {
+    p3clock::ClockLayout layout;
+    int cols;
+    int rows;
+    long long mismatches; // Cells where the replayed output differs from the frame, summed over the frames
+    long long errors;     // Output the replay did not understand
+};
+
+// The first frame and `ticks` seconds after it, encoded the way p3timec-tty writes them and
+// fed to the model terminal, which must show each rendered frame
+static TtyReplayResult ReplayTty(p3clock::ClockLayout layout, int cols, int rows, p3clock::ClockTime start, int ticks) {
+    TtyReplayResult r = {layout, cols, rows, 0, 0};
+    p3clock::SoftClockRenderer renderer(layout);
+    renderer.Resize(cols, rows * 2);
+    p3clock::TtyScreen screen;
+    screen.Resize(cols, rows);
+    VirtualTerminal terminal;
+    terminal.Resize(cols, rows);
+    std::string out;
+    for (int i = 0; i <= ticks; ++i) {
+        renderer.Render(p3clock::AddSeconds(start, i));
+        out.clear();
+        screen.Encode(renderer.Frame(), &out);
+        terminal.Feed(out);
+        r.mismatches += terminal.Mismatches(renderer.Frame());
+    }
+    r.errors = terminal.Errors();
+    return r;
+}
+
+static int RunTtyCheck(p3clock::CommandArgs& args, CheckOutput& output) {
+    std::vector<p3clock::FrameSize> sizes;
+    std::vector<p3clock::ClockLayout> layouts;
+    p3clock::ClockTime start = {23, 59, 0};
+    int ticks = 120;
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--size")) {
+            p3clock::FrameSize size;
+            ok = p3clock::ParseSize(value, &size.width, &size.height);
+            if (ok) sizes.push_back(size);
+        } else if (args.Is("--layout")) {
+            p3clock::ClockLayout layout;
+            ok = p3clock::ParseClockLayout(value, &layout);
+            if (ok) layouts.push_back(layout);
+        } else if (args.Is("--time")) {
+            ok = p3clock::ParseTime(value, &start);
+        } else if (args.Is("--ticks")) {
+            ticks = atoi(value);
+            ok = ticks > 0;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (sizes.empty()) {
+        p3clock::FrameSize defaults[] = {{80, 24}, {120, 40}, {200, 60}};
+        sizes.assign(defaults, defaults + 3);
+    }
+    if (layouts.empty()) {
+        layouts.push_back(p3clock::kLayoutDigital);
+        layouts.push_back(p3clock::kLayoutAnalogDigital);
+    }
+
+    bool passed = true;
+    std::vector<TtyReplayResult> results;
+    for (size_t l = 0; l < layouts.size(); ++l) {
+        for (size_t s = 0; s < sizes.size(); ++s) {
+            TtyReplayResult r = ReplayTty(layouts[l], sizes[s].width, sizes[s].height, start, ticks);
+            bool ok = r.mismatches == 0 && r.errors == 0;
+            fprintf(stderr, "%s %-9s %3dx%-3d %lld mismatched cells  %lld errors\n", ok ? "ok  " : "FAIL",
+                    p3clock::kClockLayoutNames[r.layout], r.cols, r.rows, r.mismatches, r.errors);
+            passed = passed && ok;
+            results.push_back(r);
+        }
+    }
+
+    if (!output.Begin("tty")) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = output.Json();
+    json.Field("ticks", ticks);
+    json.Field("passed", passed);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const TtyReplayResult& r = results[i];
+        json.BeginObject();
+        json.Field("layout", p3clock::kClockLayoutNames[r.layout]);
+        json.Field("cols", r.cols);
+        json.Field("rows", r.rows);
+        json.Field("mismatches", r.mismatches);
+        json.Field("errors", r.errors);
+        json.EndObject();
+    }
+    json.EndArray();
+    return output.End(passed);
+}
+
+#endif // P3TIMEC_CHECK_TTY_CHECK_H
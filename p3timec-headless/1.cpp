@@ -0,0 +1,2540 @@
+// Headless P3 clock: renders the clock layouts of the Win32 programs with the
+// software renderer in p3clock and writes the frames as PPM images, streams
+// them as video, and times the paint paths (the bench-* commands). What must
+// hold regardless of speed is checked by p3timec-check.
+// Builds anywhere with a C++ compiler, e.g.
+//     g++ -O2 -pthread -o p3timec-headless p3timec-headless/1.cpp
+
+#include <math.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "../p3clock/bench_stats.h"
+#include "../p3clock/clock_core.h"
+#include "../p3clock/clock_wall.h"
+#include "../p3clock/composite.h"
+#include "../p3clock/frame_pacer.h"
+#include "../p3clock/frame_stream.h"
+#include "../p3clock/paint_trace.h"
+#include "../p3clock/pixel_backend.h"
+#include "../p3clock/raster_circle.h"
+#include "../p3clock/raster_line.h"
+#include "../p3clock/resize_coalescer.h"
+#include "../p3clock/soft_clock.h"
+#include "../p3clock/tile_pool.h"
+#include "../p3clock/time_source.h"
+#include "../p3clock/tty_frame.h"
+#include "../p3clock/yuv.h"
+#include "../p3clock-tools/heap_counter.h"
+#include "../p3clock-tools/resize_replay.h"
+#include "../p3clock-tools/sim_window.h"
+#include "../p3clock-tools/test_pixels.h"
+#include "../p3clock-tools/tool_support.h"
+
+static void PrintUsage(FILE* out) {
+    fprintf(out,
+        "usage: p3timec-headless [render] [options]\n"
+        "       p3timec-headless bench [options]\n"
+        "       p3timec-headless bench-sweep [options]\n"
+        "       p3timec-headless bench-line [options]\n"
+        "       p3timec-headless bench-circle [options]\n"
+        "       p3timec-headless bench-time [options]\n"
+        "       p3timec-headless render-wall [options]\n"
+        "       p3timec-headless bench-wall [options]\n"
+        "       p3timec-headless bench-tiles [options]\n"
+        "       p3timec-headless bench-resize [options]\n"
+        "       p3timec-headless bench-trace [options]\n"
+        "       p3timec-headless bench-pixels [options]\n"
+        "       p3timec-headless bench-composite [options]\n"
+        "       p3timec-headless stream [options]\n"
+        "       p3timec-headless bench-yuv [options]\n"
+        "       p3timec-headless bench-tty [options]\n"
+        "\n"
+        "render: draw frames and write them as PPM\n"
+        "  --layout NAME   digital (p3timec), moni (p3timec-32-moni-1) or moni-only\n"
+        "                  (p3timec-32-moni-only-1). Default: moni\n"
+        "  --size WxH      client area size. Default: 800x400 (the CreateWindowEx size)\n"
+        "  --time HH:MM:SS time to draw. Default: the current local time\n"
+        "  --count N       render N consecutive seconds starting at --time. Default: 1\n"
+        "  --threads N     render in tiles on N threads (same pixels). Default: 1\n"
+        "  -o PATH         output file, '-' for stdout. With --count > 1 PATH is a\n"
+        "                  printf pattern taking the frame index, e.g. frame%%03d.ppm\n"
+        "\n"
+        "bench: time the paint path of every variant and write JSON results\n"
+        "  --variant NAME  only this program (repeatable). Default: all five\n"
+        "  --size WxH      only this size (repeatable). Default: 800x400, 1920x1080,\n"
+        "                  3840x2160 and 7680x4320\n"
+        "  --frames N      measured frames per case. Default: 120\n"
+        "  --warmup N      unmeasured frames per case. Default: 5\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n"
+        "\n"
+        "bench-sweep: run the sweep mode (sub-second hands) in real time under the\n"
+        "frame pacer and report sustained fps, dropped and late frames and CPU time\n"
+        "  --variant NAME  p3timec-32-moni-1 or p3timec-32-moni-only-1 (repeatable).\n"
+        "                  Default: both\n"
+        "  --size WxH      client area size (repeatable). Default: 1920x1080 and 3840x2160\n"
+        "  --hz N          target refresh rate (repeatable). Default: 60, 120 and 240\n"
+        "  --seconds N     wall time per case. Default: 3\n"
+        "  --budget F      share of each frame interval rendering may use before the\n"
+        "                  pacer skips frames. Default: 0.1\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n"
+        "\n"
+        "bench-line: pixels per second of each anti-aliased line kernel the CPU\n"
+        "supports, and how far each one is from the scalar kernel\n"
+        "  --lines N       lines per kernel and width. Default: 2000\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n"
+        "\n"
+        "bench-circle: pixels per second of each anti-aliased ring kernel at face\n"
+        "radii up to 8K, and how far each one is from the scalar kernel\n"
+        "  --rings N       rings per kernel and radius. Default: 20\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n"
+        "\n"
+        "bench-time: the cost of reading the local time as text on the host clock,\n"
+        "localtime_r + strftime against the cached time source\n"
+        "  --reads N       reads per way. Default: 1000000\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n"
+        "\n"
+        "render-wall: draw a clock wall (p3timec-wall), one cell per zone, as PPM\n"
+        "  --layout NAME   digital, moni or moni-only. Default: moni\n"
+        "  --size WxH      client area size. Default: 1600x900\n"
+        "  --time HH:MM:SS UTC time to draw. Default: 10:08:30\n"
+        "  --zones LIST    ';'-separated OFFSET[,LABEL], e.g. \"+9,Tokyo;-5,New_York\"\n"
+        "  --cells N       fill up to N cells with generated zones. Default: 8\n"
+        "                  without --zones\n"
+        "  -o PATH         output file, '-' for stdout. Default: -\n"
+        "\n"
+        "bench-wall: time the ticks of a clock wall against one full repaint per\n"
+        "zone (a window per zone) at the same cell size, for growing cell counts\n"
+        "  --layout NAME   digital, moni or moni-only. Default: moni\n"
+        "  --size WxH      wall size. Default: 1920x1080\n"
+        "  --cells N       cell count (repeatable). Default: 1, 4, 16, 64 and 256\n"
+        "  --ticks N       seconds per case. Default: 600\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n"
+        "\n"
+        "bench-tiles: time full frames rendered in tiles on a work-stealing thread\n"
+        "pool for growing thread counts\n"
+        "  --layout NAME   digital, moni or moni-only. Default: moni\n"
+        "  --size WxH      frame size (repeatable). Default: 3840x2160 and 7680x4320\n"
+        "  --threads N     thread count (repeatable). Default: 1, 2, 4 ... up to the\n"
+        "                  number of cores\n"
+        "  --frames N      measured frames per case. Default: 30\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n"
+        "\n"
+        "bench-resize: replay a drag-resize WM_SIZE by WM_SIZE, rebuilding on every\n"
+        "one with the old font size against one rebuild per frame with the fitted\n"
+        "font, and report rebuild time and font creations\n"
+        "  --layout NAME   digital, moni or moni-only (repeatable). Default: all three\n"
+        "  --trace PATH    WM_SIZE log, one \"MS WIDTH HEIGHT\" per line. Default: a\n"
+        "                  recorded drag at 125 Hz mouse input\n"
+        "  --events N      length of the recorded drag. Default: 1000\n"
+        "  --hz N          paints per second. Default: 60\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n"
+        "\n"
+        "bench-trace: render frames with every paint phase traced and report where\n"
+        "the frame time goes and what tracing costs per phase\n"
+        "  --layout NAME   digital, moni or moni-only. Default: moni\n"
+        "  --size WxH      frame size. Default: 1920x1080\n"
+        "  --frames N      traced frames, from 00:59:50 on. Default: 300\n"
+        "  --trace PATH    write the traced frames as Chrome trace_event JSON\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n"
+        "\n"
+        "bench-pixels: time the paints of the pixel backend (p3clock/pixel_backend.h,\n"
+        "the /DP3CLOCK_DIB_BACKEND=1 Win32 build) through the window core: tick\n"
+        "paints of the damaged area and full repaints, each copied to the screen\n"
+        "  --size WxH      client area (repeatable). Default: 800x400, 1920x1080 and\n"
+        "                  3840x2160\n"
+        "  --ticks N       simulated seconds of tick paints per case. Default: 600\n"
+        "  --frames N      full repaints per case. Default: 30\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n"
+        "\n"
+        "bench-composite: time composing a whole overlay frame (a fade step) with\n"
+        "each kernel, on the rendered clock and on random pixels, fully opaque and\n"
+        "at the default /overlay opacity\n"
+        "  --size WxH      frame size. Default: 1920x1080\n"
+        "  --passes N      frames composed per case. Default: 50\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n"
+        "\n"
+        "stream: write the clock as raw video for ffmpeg or OBS, e.g.\n"
+        "  p3timec-headless stream | ffmpeg -i - out.mp4\n"
+        "Frames go through a fixed pool of buffers to a writer thread. Live, frames\n"
+        "are paced at --fps and dropped while the reader is behind; with --time the\n"
+        "stream waits for the reader instead. Stops after --frames or on Ctrl+C, then\n"
+        "prints frames produced, dropped and written and the queue depth\n"
+        "  --layout NAME   digital, moni or moni-only. Default: moni\n"
+        "  --size WxH      frame size, even. Default: 1280x720\n"
+        "  --fps N         frames per second (1 to 240). Default: 30\n"
+        "  --format NAME   y4m (I420, BT.601 limited range) or rgba (raw bytes).\n"
+        "                  Default: y4m\n"
+        "  --frames N      frames to write, 0 for no end. Default: 0\n"
+        "  --time HH:MM:SS render from this time on, 1/fps apart, as fast as the\n"
+        "                  reader takes them. Default: the local time, live\n"
+        "  --hands MODE    sweep (move every frame) or tick. Default: sweep\n"
+        "  --buffers N     frame buffers in the pool (2 to 64). Default: 4\n"
+        "  --kernel NAME   RGB to YUV kernel: scalar, sse2, avx2 or auto. Default: auto\n"
+        "  --stats PATH    also write the stats as JSON\n"
+        "  -o PATH         stream output: a file, a named pipe or '-' for stdout.\n"
+        "                  Default: -\n"
+        "\n"
+        "bench-yuv: time the stream's RGB to I420 conversion with each kernel, on a\n"
+        "rendered frame and on noise, and count bytes that differ from scalar\n"
+        "  --size WxH      frame size, even (repeatable). Default: 1280x720,\n"
+        "                  1920x1080 and 3840x2160\n"
+        "  --passes N      conversions per case. Default: 50\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n"
+        "\n"
+        "bench-tty: what p3timec-tty writes per tick (bytes, cells, cursor moves,\n"
+        "write calls) against a full redraw\n"
+        "  --size CxR      terminal columns x rows (repeatable). Default: 80x24,\n"
+        "                  120x40 and 200x60\n"
+        "  --layout NAME   digital, moni or moni-only (repeatable). Default: digital\n"
+        "                  and moni\n"
+        "  --time HH:MM:SS first time shown. Default: 23:59:00 (the color changes\n"
+        "                  at midnight)\n"
+        "  --ticks N       seconds after the first frame. Default: 120\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n");
+}
+
+static p3clock::ClockTime CurrentLocalTime() {
+    time_t now = time(NULL);
+    struct tm* local = localtime(&now);
+    p3clock::ClockTime t = {local->tm_hour, local->tm_min, local->tm_sec};
+    return t;
+}
+
+static int RunRender(int argc, char** argv) {
+    p3clock::ClockLayout layout = p3clock::kLayoutAnalogDigital;
+    int width = 800, height = 400;
+    p3clock::ClockTime start = CurrentLocalTime();
+    int count = 1;
+    int threads = 1;
+    const char* output = "-";
+
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--layout")) {
+            ok = p3clock::ParseClockLayout(value, &layout);
+        } else if (args.Is("--size")) {
+            ok = p3clock::ParseSize(value, &width, &height);
+        } else if (args.Is("--time")) {
+            ok = p3clock::ParseTime(value, &start);
+        } else if (args.Is("--count")) {
+            count = atoi(value);
+            ok = count > 0;
+        } else if (args.Is("--threads")) {
+            threads = atoi(value);
+            ok = threads > 0 && threads <= 256;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    p3clock::SoftClockRenderer renderer(layout);
+    renderer.Resize(width, height);
+    p3clock::TilePool pool(threads);
+
+    for (int frame = 0; frame < count; ++frame) {
+        if (threads > 1) {
+            renderer.RenderTiled(p3clock::AddSeconds(start, frame), &pool);
+        } else {
+            renderer.Render(p3clock::AddSeconds(start, frame));
+        }
+
+        bool toStdout = strcmp(output, "-") == 0;
+        char path[1024];
+        if (!toStdout) {
+            if (count > 1) {
+                snprintf(path, sizeof(path), output, frame);
+            } else {
+                snprintf(path, sizeof(path), "%s", output);
+            }
+        }
+        FILE* out = toStdout ? stdout : fopen(path, "wb");
+        if (!out) {
+            fprintf(stderr, "p3timec-headless: cannot open %s\n", path);
+            return 1;
+        }
+        bool written = p3clock::WritePpm(renderer.Frame(), out);
+        if (toStdout) {
+            written = fflush(out) == 0 && written;
+        } else {
+            written = fclose(out) == 0 && written;
+        }
+        if (!written) {
+            fprintf(stderr, "p3timec-headless: write failed\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// The five Win32 programs and how their WM_PAINT maps onto the software renderer
+struct BenchVariant {
+    const char* name;
+    p3clock::ClockLayout layout;
+    bool backBuffer; // Paint into a back buffer, then copy it to the window
+};
+
+static const BenchVariant kBenchVariants[] = {
+    {"p3timec", p3clock::kLayoutDigital, false},
+    {"p3timec-32-1", p3clock::kLayoutDigital, false},
+    {"p3timec-32-2", p3clock::kLayoutDigital, true},
+    {"p3timec-32-moni-1", p3clock::kLayoutAnalogDigital, true},
+    {"p3timec-32-moni-only-1", p3clock::kLayoutAnalog, true},
+};
+static const int kBenchVariantCount = sizeof(kBenchVariants) / sizeof(kBenchVariants[0]);
+
+static const p3clock::FrameSize kFrameSizes[] = {
+    {800, 400},   // CreateWindowEx default
+    {1920, 1080},
+    {3840, 2160},
+    {7680, 4320},
+};
+
+struct BenchResult {
+    const BenchVariant* variant;
+    p3clock::FrameSize size;
+    double resizeMs; // WM_SIZE: layout, fonts, glyph atlas
+    p3clock::FrameTimeSummary frames;
+    double allocationsPerFrame;
+    double bytesPerFrame;
+    size_t peakHeapBytes; // Peak live heap over the case, above what was live before it
+};
+
+static BenchResult RunBenchCase(const BenchVariant& variant, p3clock::FrameSize size, int frames, int warmup) {
+    BenchResult result;
+    result.variant = &variant;
+    result.size = size;
+    size_t liveBefore = p3clock::HeapLiveBytes();
+    p3clock::ResetHeapPeak();
+
+    {
+        p3clock::SoftClockRenderer renderer(variant.layout);
+        p3clock::Framebuffer window;
+        window.Resize(size.width, size.height);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        renderer.Resize(size.width, size.height);
+        result.resizeMs = p3clock::MsSince(start);
+
+        // 10:08:00 onward: every digit, hand and numeral color stays steady (no midnight rebuild)
+        p3clock::ClockTime t = {10, 8, 0};
+        std::vector<double> samples;
+        samples.reserve(frames);
+        unsigned long long allocationsBefore = 0, bytesBefore = 0;
+        for (int i = 0; i < warmup + frames; ++i) {
+            if (i == warmup) {
+                allocationsBefore = p3clock::HeapAllocations();
+                bytesBefore = p3clock::HeapBytesAllocated();
+            }
+            start = std::chrono::steady_clock::now();
+            renderer.Render(t);
+            if (variant.backBuffer) {
+                p3clock::Blit(&window, 0, 0, renderer.Frame(), 0, 0, size.width, size.height);
+            }
+            double ms = p3clock::MsSince(start);
+            if (i >= warmup) {
+                samples.push_back(ms);
+            }
+            t = p3clock::AddSeconds(t, 1);
+        }
+        result.allocationsPerFrame = (double)(p3clock::HeapAllocations() - allocationsBefore) / frames;
+        result.bytesPerFrame = (double)(p3clock::HeapBytesAllocated() - bytesBefore) / frames;
+        result.frames = p3clock::SummarizeFrameTimes(samples);
+    }
+    result.peakHeapBytes = p3clock::HeapPeakBytes() - liveBefore;
+    return result;
+}
+
+static long long PeakRssKb() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(__APPLE__)
+        return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return -1;
+}
+
+static int RunBench(int argc, char** argv) {
+    std::vector<const BenchVariant*> variants;
+    std::vector<p3clock::FrameSize> sizes;
+    int frames = 120, warmup = 5;
+    const char* output = "-";
+
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--variant")) {
+            ok = false;
+            for (int v = 0; v < kBenchVariantCount; ++v) {
+                if (strcmp(value, kBenchVariants[v].name) == 0) {
+                    variants.push_back(&kBenchVariants[v]);
+                    ok = true;
+                }
+            }
+        } else if (args.Is("--size")) {
+            p3clock::FrameSize size;
+            ok = p3clock::ParseSize(value, &size.width, &size.height);
+            if (ok) sizes.push_back(size);
+        } else if (args.Is("--frames")) {
+            frames = atoi(value);
+            ok = frames > 0;
+        } else if (args.Is("--warmup")) {
+            warmup = atoi(value);
+            ok = warmup >= 0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (variants.empty()) {
+        for (int v = 0; v < kBenchVariantCount; ++v) variants.push_back(&kBenchVariants[v]);
+    }
+    if (sizes.empty()) {
+        sizes.assign(kFrameSizes, kFrameSizes + sizeof(kFrameSizes) / sizeof(kFrameSizes[0]));
+    }
+
+    std::vector<BenchResult> results;
+    for (size_t v = 0; v < variants.size(); ++v) {
+        for (size_t s = 0; s < sizes.size(); ++s) {
+            BenchResult r = RunBenchCase(*variants[v], sizes[s], frames, warmup);
+            fprintf(stderr, "%-24s %5dx%-5d mean %8.3f ms  p99 %8.3f ms  %8.1f fps  %.1f allocs/frame\n",
+                    r.variant->name, r.size.width, r.size.height, r.frames.meanMs, r.frames.p99Ms, r.frames.fps,
+                    r.allocationsPerFrame);
+            results.push_back(r);
+        }
+    }
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "paint");
+    json.Field("frames", frames);
+    json.Field("warmup", warmup);
+    json.Field("peak_rss_kb", PeakRssKb());
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        json.BeginObject();
+        json.Field("variant", r.variant->name);
+        json.Field("layout", p3clock::kClockLayoutNames[r.variant->layout]);
+        json.Field("width", r.size.width);
+        json.Field("height", r.size.height);
+        json.Field("resize_ms", r.resizeMs);
+        json.Field("mean_ms", r.frames.meanMs);
+        json.Field("p50_ms", r.frames.p50Ms);
+        json.Field("p99_ms", r.frames.p99Ms);
+        json.Field("max_ms", r.frames.maxMs);
+        json.Field("fps", r.frames.fps);
+        json.Field("allocs_per_frame", r.allocationsPerFrame);
+        json.Field("bytes_per_frame", r.bytesPerFrame);
+        json.Field("peak_heap_bytes", (long long)r.peakHeapBytes);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+struct SweepBenchResult {
+    const BenchVariant* variant;
+    p3clock::FrameSize size;
+    double targetHz;
+    double wallMs;
+    double cpuMs;
+    p3clock::FramePacerStats pacer;
+    int finalDivider;
+    p3clock::FrameTimeSummary frames; // Render + present time of each frame
+    double damagePixelsPerFrame;
+};
+
+// Sweep mode in real time: sleep until the pacer's next slot, render the sub-second frame
+// with RenderSweep() and copy the damaged area to a stand-in for the window, like WM_PAINT
+static SweepBenchResult RunSweepCase(const BenchVariant& variant, p3clock::FrameSize size, double hz, double budget, double seconds) {
+    SweepBenchResult result;
+    result.variant = &variant;
+    result.size = size;
+    result.targetHz = hz;
+
+    p3clock::SoftClockRenderer renderer(variant.layout);
+    renderer.Resize(size.width, size.height);
+    p3clock::Framebuffer window;
+    window.Resize(size.width, size.height);
+    p3clock::FramePacer pacer(hz, budget);
+    std::vector<double> samples;
+    long long damagePixels = 0;
+
+    // The full repaint after WM_SIZE happens before the sweep starts
+    p3clock::ClockTime base = {10, 8, 0};
+    renderer.RenderSweep(base, 0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    clock_t cpuStart = clock();
+    pacer.Start(0.0);
+    for (;;) {
+        double now = p3clock::MsSince(start);
+        if (now >= seconds * 1000.0) {
+            break;
+        }
+        p3clock::FrameSlot slot = pacer.OnWake(now);
+        double delayMs = slot.delayMs;
+        if (slot.render) {
+            int elapsedMs = (int)now;
+            p3clock::ClockTime t = p3clock::AddSeconds(base, elapsedMs / 1000);
+            p3clock::DamageList damage = renderer.RenderSweep(t, elapsedMs % 1000);
+            p3clock::DamageRect present = {0, 0, 0, 0};
+            if (damage.full) {
+                present.right = size.width;
+                present.bottom = size.height;
+            }
+            for (int i = 0; i < damage.count; ++i) {
+                present = p3clock::Union(present, damage.rects[i]);
+            }
+            // One BitBlt of the invalidated region's bounding box, as WM_PAINT gets in ps.rcPaint
+            p3clock::Blit(&window, present.left, present.top, renderer.Frame(), present.left, present.top,
+                          present.right - present.left, present.bottom - present.top);
+            damagePixels += p3clock::Area(present);
+            double end = p3clock::MsSince(start);
+            samples.push_back(end - now);
+            delayMs = pacer.EndFrame(end);
+        }
+        if (delayMs > 0.0) {
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(delayMs));
+        }
+    }
+    result.cpuMs = (double)(clock() - cpuStart) * 1000.0 / CLOCKS_PER_SEC;
+    result.wallMs = p3clock::MsSince(start);
+    result.pacer = pacer.Stats();
+    result.finalDivider = pacer.Divider();
+    result.frames = p3clock::SummarizeFrameTimes(samples);
+    result.damagePixelsPerFrame = samples.empty() ? 0.0 : (double)damagePixels / samples.size();
+    return result;
+}
+
+static int RunBenchSweep(int argc, char** argv) {
+    std::vector<const BenchVariant*> variants;
+    std::vector<p3clock::FrameSize> sizes;
+    std::vector<double> rates;
+    double seconds = 3.0, budget = 0.1;
+    const char* output = "-";
+
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--variant")) {
+            ok = false;
+            for (int v = 0; v < kBenchVariantCount; ++v) {
+                if (strcmp(value, kBenchVariants[v].name) == 0 && kBenchVariants[v].layout != p3clock::kLayoutDigital) {
+                    variants.push_back(&kBenchVariants[v]);
+                    ok = true;
+                }
+            }
+        } else if (args.Is("--size")) {
+            p3clock::FrameSize size;
+            ok = p3clock::ParseSize(value, &size.width, &size.height);
+            if (ok) sizes.push_back(size);
+        } else if (args.Is("--hz")) {
+            double hz = atof(value);
+            ok = hz >= 1.0 && hz <= 1000.0;
+            if (ok) rates.push_back(hz);
+        } else if (args.Is("--seconds")) {
+            seconds = atof(value);
+            ok = seconds > 0.0;
+        } else if (args.Is("--budget")) {
+            budget = atof(value);
+            ok = budget > 0.0 && budget <= 1.0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (variants.empty()) {
+        for (int v = 0; v < kBenchVariantCount; ++v) {
+            if (kBenchVariants[v].layout != p3clock::kLayoutDigital) variants.push_back(&kBenchVariants[v]);
+        }
+    }
+    if (sizes.empty()) {
+        p3clock::FrameSize defaults[2] = {{1920, 1080}, {3840, 2160}};
+        sizes.assign(defaults, defaults + 2);
+    }
+    if (rates.empty()) {
+        double defaults[3] = {60.0, 120.0, 240.0};
+        rates.assign(defaults, defaults + 3);
+    }
+
+    std::vector<SweepBenchResult> results;
+    for (size_t v = 0; v < variants.size(); ++v) {
+        for (size_t s = 0; s < sizes.size(); ++s) {
+            for (size_t h = 0; h < rates.size(); ++h) {
+                SweepBenchResult r = RunSweepCase(*variants[v], sizes[s], rates[h], budget, seconds);
+                double wallS = r.wallMs / 1000.0;
+                fprintf(stderr, "%-24s %5dx%-5d %5.0f Hz: %6.1f fps  %4llu dropped  %4llu late  "
+                        "%6.3f CPU ms/frame  %5.1f%% CPU  divider %d\n",
+                        r.variant->name, r.size.width, r.size.height, r.targetHz, r.pacer.frames / wallS,
+                        r.pacer.dropped, r.pacer.late, r.pacer.frames ? r.cpuMs / r.pacer.frames : 0.0,
+                        100.0 * r.cpuMs / r.wallMs, r.finalDivider);
+                results.push_back(r);
+            }
+        }
+    }
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "sweep");
+    json.Field("seconds", seconds);
+    json.Field("budget", budget);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const SweepBenchResult& r = results[i];
+        double frames = (double)r.pacer.frames;
+        json.BeginObject();
+        json.Field("variant", r.variant->name);
+        json.Field("width", r.size.width);
+        json.Field("height", r.size.height);
+        json.Field("target_hz", r.targetHz);
+        json.Field("frames", (long long)r.pacer.frames);
+        json.Field("sustained_fps", frames * 1000.0 / r.wallMs);
+        json.Field("dropped", (long long)r.pacer.dropped);
+        json.Field("late", (long long)r.pacer.late);
+        json.Field("final_divider", r.finalDivider);
+        json.Field("cpu_ms_per_frame", frames > 0 ? r.cpuMs / frames : 0.0);
+        json.Field("cpu_percent", 100.0 * r.cpuMs / r.wallMs);
+        json.Field("frame_mean_ms", r.frames.meanMs);
+        json.Field("frame_p50_ms", r.frames.p50Ms);
+        json.Field("frame_p99_ms", r.frames.p99Ms);
+        json.Field("frame_max_ms", r.frames.maxMs);
+        json.Field("damage_pixels_per_frame", r.damagePixelsPerFrame);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+struct LineBenchResult {
+    p3clock::SimdLevel kernel;
+    float width;
+    double ms;
+    long long pixels;     // Pixels evaluated
+    long long mismatches; // Pixels that differ from the scalar kernel's output
+    int maxDiff;          // Largest per-channel difference from the scalar kernel
+};
+
+// Draw the same pseudo-random lines with one kernel into a 1920x1080 buffer
+static void DrawBenchLines(p3clock::Framebuffer* fb, p3clock::SimdLevel kernel, float width, int lines,
+                           double* ms, long long* pixels) {
+    p3clock::Clear(fb, 0xFF102030u);
+    p3clock::DamageRect clip = {0, 0, fb->width, fb->height};
+    unsigned int seed = 12345;
+    *pixels = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < lines; ++i) {
+        float v[4];
+        for (int j = 0; j < 4; ++j) {
+            seed = seed * 1103515245u + 12345u;
+            v[j] = (float)((seed >> 8) % 100000) / 100000.0f;
+        }
+        *pixels += p3clock::DrawAALine(&fb->pixels[0], fb->width, clip, v[0] * fb->width, v[1] * fb->height,
+                                       v[2] * fb->width, v[3] * fb->height, width,
+                                       i & 1 ? p3clock::kArgbBlue : p3clock::kArgbGreen, kernel);
+    }
+    *ms = p3clock::MsSince(start);
+}
+
+static int RunBenchLine(int argc, char** argv) {
+    int lines = 2000;
+    const char* output = "-";
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--lines")) {
+            lines = atoi(value);
+            ok = lines > 0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    static const float kWidths[] = {1.0f, 3.0f, 5.0f, 12.0f};
+    p3clock::SimdLevel best = p3clock::ResolveSimdLevel(p3clock::kSimdAuto);
+    p3clock::Framebuffer reference, fb;
+    reference.Resize(1920, 1080);
+    fb.Resize(1920, 1080);
+
+    std::vector<LineBenchResult> results;
+    for (size_t w = 0; w < sizeof(kWidths) / sizeof(kWidths[0]); ++w) {
+        for (int k = p3clock::kSimdScalar; k <= best; ++k) {
+            LineBenchResult r;
+            r.kernel = static_cast<p3clock::SimdLevel>(k);
+            r.width = kWidths[w];
+            p3clock::Framebuffer* target = k == p3clock::kSimdScalar ? &reference : &fb;
+            DrawBenchLines(target, r.kernel, r.width, lines, &r.ms, &r.pixels);
+            r.mismatches = 0;
+            r.maxDiff = 0;
+            for (size_t i = 0; i < target->pixels.size(); ++i) {
+                p3clock::Argb a = target->pixels[i], b = reference.pixels[i];
+                if (a == b) continue;
+                r.mismatches++;
+                for (int shift = 0; shift < 32; shift += 8) {
+                    int diff = abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+                    if (diff > r.maxDiff) r.maxDiff = diff;
+                }
+            }
+            fprintf(stderr, "%-6s width %5.1f  %9.1f Mpixel/s  %lld mismatches (max diff %d)\n",
+                    p3clock::kSimdLevelNames[k], r.width, r.pixels / (r.ms * 1000.0), r.mismatches, r.maxDiff);
+            results.push_back(r);
+        }
+    }
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "line");
+    json.Field("lines", lines);
+    json.Field("best_kernel", p3clock::kSimdLevelNames[best]);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const LineBenchResult& r = results[i];
+        json.BeginObject();
+        json.Field("kernel", p3clock::kSimdLevelNames[r.kernel]);
+        json.Field("width", (double)r.width);
+        json.Field("ms", r.ms);
+        json.Field("pixels", r.pixels);
+        json.Field("mpixels_per_s", r.ms > 0.0 ? r.pixels / (r.ms * 1000.0) : 0.0);
+        json.Field("mismatches", r.mismatches);
+        json.Field("max_channel_diff", r.maxDiff);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+struct CircleBenchResult {
+    p3clock::SimdLevel kernel;
+    float radius;
+    float width; // Ring width, 0 for a disc
+    double ms;
+    long long pixels;     // Pixels written or evaluated
+    long long mismatches; // Pixels that differ from the scalar kernel's output
+};
+
+// Draw `rings` rings with one kernel, centered in the buffer and alternating colors
+static void DrawBenchRings(p3clock::Framebuffer* fb, p3clock::SimdLevel kernel, float radius, float width, int rings,
+                           double* ms, long long* pixels) {
+    p3clock::Clear(fb, 0xFF102030u);
+    p3clock::DamageRect clip = {0, 0, fb->width, fb->height};
+    float inner = width > 0.0f ? radius - width : 0.0f;
+    *pixels = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rings; ++i) {
+        // Sub-pixel offsets so every ring hits the pixel grid differently
+        float cx = fb->width * 0.5f + (i % 7) * 0.13f;
+        float cy = fb->height * 0.5f + (i % 5) * 0.19f;
+        *pixels += p3clock::DrawAARing(&fb->pixels[0], fb->width, clip, cx, cy, radius, inner,
+                                       i & 1 ? p3clock::kArgbBlue : p3clock::kArgbGreen, kernel);
+    }
+    *ms = p3clock::MsSince(start);
+}
+
+static int RunBenchCircle(int argc, char** argv) {
+    int rings = 20;
+    const char* output = "-";
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--rings")) {
+            rings = atoi(value);
+            ok = rings > 0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    // Face radii of the moni layout at 1080p, 4K and 8K, plus one larger than an 8K screen
+    static const float kBenchRadii[] = {520.0f, 1060.0f, 2140.0f, 4000.0f};
+    static const float kBenchWidths[] = {2.0f, 0.0f};
+
+    p3clock::SimdLevel best = p3clock::ResolveSimdLevel(p3clock::kSimdAuto);
+    p3clock::Framebuffer reference, fb;
+    reference.Resize(7680, 4320);
+    fb.Resize(7680, 4320);
+
+    std::vector<CircleBenchResult> results;
+    for (size_t r = 0; r < sizeof(kBenchRadii) / sizeof(kBenchRadii[0]); ++r) {
+        for (size_t w = 0; w < sizeof(kBenchWidths) / sizeof(kBenchWidths[0]); ++w) {
+            for (int k = p3clock::kSimdScalar; k <= best; ++k) {
+                CircleBenchResult b;
+                b.kernel = static_cast<p3clock::SimdLevel>(k);
+                b.radius = kBenchRadii[r];
+                b.width = kBenchWidths[w];
+                p3clock::Framebuffer* target = k == p3clock::kSimdScalar ? &reference : &fb;
+                DrawBenchRings(target, b.kernel, b.radius, b.width, rings, &b.ms, &b.pixels);
+                b.mismatches = 0;
+                for (size_t i = 0; i < target->pixels.size(); ++i) {
+                    if (target->pixels[i] != reference.pixels[i]) b.mismatches++;
+                }
+                fprintf(stderr, "%-6s radius %6.0f %-5s  %8.3f ms/ring  %9.1f Mpixel/s  %lld mismatches\n",
+                        p3clock::kSimdLevelNames[k], b.radius, b.width > 0.0f ? "ring" : "disc",
+                        b.ms / rings, b.pixels / (b.ms * 1000.0), b.mismatches);
+                results.push_back(b);
+            }
+        }
+    }
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "circle");
+    json.Field("rings", rings);
+    json.Field("best_kernel", p3clock::kSimdLevelNames[best]);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const CircleBenchResult& b = results[i];
+        json.BeginObject();
+        json.Field("kernel", p3clock::kSimdLevelNames[b.kernel]);
+        json.Field("radius", (double)b.radius);
+        json.Field("width", (double)b.width);
+        json.Field("ms_per_ring", b.ms / rings);
+        json.Field("pixels", b.pixels);
+        json.Field("mpixels_per_s", b.ms > 0.0 ? b.pixels / (b.ms * 1000.0) : 0.0);
+        json.Field("mismatches", b.mismatches);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+// bench-time: local time on the host, the cached fast path against localtime_r + strftime
+struct HostClock {
+    long long MonotonicMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+    }
+
+    long long UtcMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+    }
+
+    int UtcOffsetMinutes() {
+        time_t now = time(NULL);
+        struct tm local;
+        localtime_r(&now, &local);
+        return (int)(local.tm_gmtoff / 60);
+    }
+};
+
+struct TimeReadBench {
+    double slowNs;   // localtime_r + strftime per read
+    double sourceNs; // TimeSource::Now() per read
+};
+
+static TimeReadBench BenchTimeReads(int reads) {
+    TimeReadBench b;
+    unsigned sink = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; ++i) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        struct tm local;
+        localtime_r(&ts.tv_sec, &local);
+        char text[16];
+        strftime(text, sizeof(text), "%H:%M:%S", &local);
+        sink += (unsigned)text[7];
+    }
+    b.slowNs = p3clock::MsSince(start) * 1e6 / reads;
+
+    HostClock host;
+    p3clock::TimeSource<HostClock> source(&host);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; ++i) {
+        sink += (unsigned)source.Now().text[7];
+    }
+    b.sourceNs = p3clock::MsSince(start) * 1e6 / reads;
+    if (sink == 1) fprintf(stderr, " "); // Keep the loops
+    return b;
+}
+
+static int RunBenchTime(int argc, char** argv) {
+    int reads = 1000000;
+    const char* output = "-";
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--reads")) {
+            reads = atoi(value);
+            ok = reads > 0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    TimeReadBench bench = BenchTimeReads(reads);
+    fprintf(stderr, "host clock: localtime_r + strftime %.1f ns/read, TimeSource %.1f ns/read\n",
+            bench.slowNs, bench.sourceNs);
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "time");
+    json.Field("reads", reads);
+    json.Field("localtime_strftime_ns", bench.slowNs);
+    json.Field("time_source_ns", bench.sourceNs);
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+struct TileBenchResult {
+    p3clock::FrameSize size;
+    int threads;
+    double faceBuildMs; // Face layer rebuilt in tiles (WM_SIZE, the color change at midnight)
+    p3clock::FrameTimeSummary frames;
+    double stealsPerFrame;
+    double allocationsPerFrame; // Heap allocations of RenderTiled(), pool included
+};
+
+static TileBenchResult RunTileCase(p3clock::ClockLayout layout, p3clock::FrameSize size, int threads, int frames) {
+    TileBenchResult result;
+    result.size = size;
+    result.threads = threads;
+
+    p3clock::TilePool pool(threads);
+    p3clock::SoftClockRenderer renderer(layout);
+    renderer.Resize(size.width, size.height);
+    p3clock::ClockTime t = {10, 8, 0};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    renderer.RenderTiled(t, &pool); // The first frame builds the face layer
+    result.faceBuildMs = p3clock::MsSince(start);
+
+    std::vector<double> samples;
+    samples.reserve(frames);
+    unsigned long long stealsBefore = pool.Stats().steals;
+    unsigned long long allocations = 0;
+    for (int i = 0; i < frames; ++i) {
+        t = p3clock::AddSeconds(t, 1);
+        unsigned long long allocationsBefore = p3clock::HeapAllocations();
+        start = std::chrono::steady_clock::now();
+        renderer.RenderTiled(t, &pool);
+        samples.push_back(p3clock::MsSince(start));
+        allocations += p3clock::HeapAllocations() - allocationsBefore;
+    }
+    result.frames = p3clock::SummarizeFrameTimes(samples);
+    result.stealsPerFrame = (double)(pool.Stats().steals - stealsBefore) / frames;
+    result.allocationsPerFrame = (double)allocations / frames;
+    return result;
+}
+
+static int RunBenchTiles(int argc, char** argv) {
+    p3clock::ClockLayout layout = p3clock::kLayoutAnalogDigital;
+    std::vector<p3clock::FrameSize> sizes;
+    std::vector<int> threadCounts;
+    int frames = 30;
+    const char* output = "-";
+
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--layout")) {
+            ok = p3clock::ParseClockLayout(value, &layout);
+        } else if (args.Is("--size")) {
+            p3clock::FrameSize size;
+            ok = p3clock::ParseSize(value, &size.width, &size.height);
+            if (ok) sizes.push_back(size);
+        } else if (args.Is("--threads")) {
+            int threads = atoi(value);
+            ok = threads > 0 && threads <= 256;
+            if (ok) threadCounts.push_back(threads);
+        } else if (args.Is("--frames")) {
+            frames = atoi(value);
+            ok = frames > 0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (sizes.empty()) {
+        p3clock::FrameSize defaults[2] = {{3840, 2160}, {7680, 4320}};
+        sizes.assign(defaults, defaults + 2);
+    }
+    int cores = (int)std::thread::hardware_concurrency();
+    if (cores < 1) cores = 1;
+    if (threadCounts.empty()) {
+        // 1, 2, 4 ... up to the core count, and the core count itself
+        for (int threads = 1; threads < cores; threads *= 2) {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(cores);
+    }
+
+    std::vector<TileBenchResult> results;
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        double baseMs = 0.0;
+        for (size_t c = 0; c < threadCounts.size(); ++c) {
+            TileBenchResult r = RunTileCase(layout, sizes[s], threadCounts[c], frames);
+            if (c == 0) baseMs = r.frames.meanMs;
+            fprintf(stderr, "%5dx%-5d %3d threads: %8.3f ms/frame  x%5.2f  face %8.3f ms  %6.1f steals/frame  "
+                    "%.1f allocs/frame\n", r.size.width, r.size.height, r.threads, r.frames.meanMs,
+                    baseMs / r.frames.meanMs, r.faceBuildMs, r.stealsPerFrame, r.allocationsPerFrame);
+            results.push_back(r);
+        }
+    }
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "tiles");
+    json.Field("layout", p3clock::kClockLayoutNames[layout]);
+    json.Field("tile_size", p3clock::kTileSize);
+    json.Field("cores", cores);
+    json.Field("frames", frames);
+    json.Key("results");
+    json.BeginArray();
+    double baseMs = 0.0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const TileBenchResult& r = results[i];
+        if (i == 0 || r.size.width != results[i - 1].size.width || r.size.height != results[i - 1].size.height) {
+            baseMs = r.frames.meanMs;
+        }
+        double speedup = r.frames.meanMs > 0.0 ? baseMs / r.frames.meanMs : 0.0;
+        json.BeginObject();
+        json.Field("width", r.size.width);
+        json.Field("height", r.size.height);
+        json.Field("threads", r.threads);
+        json.Field("tiles", p3clock::TileCount(r.size.width, r.size.height));
+        json.Field("frame_mean_ms", r.frames.meanMs);
+        json.Field("frame_p50_ms", r.frames.p50Ms);
+        json.Field("frame_p99_ms", r.frames.p99Ms);
+        json.Field("frame_max_ms", r.frames.maxMs);
+        json.Field("speedup", speedup);
+        json.Field("efficiency", speedup / r.threads);
+        json.Field("face_build_ms", r.faceBuildMs);
+        json.Field("steals_per_frame", r.stealsPerFrame);
+        json.Field("allocations_per_frame", r.allocationsPerFrame);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+// Zone i of a benchmark wall: whole-hour offsets from UTC-12 to UTC+14, then the same
+// hours again shifted by 15, 30 and 45 minutes
+static p3clock::WallZone BenchWallZone(int i) {
+    p3clock::WallZone zone;
+    zone.utcOffsetMinutes = (i % 27 - 12) * 60 + i / 27 % 4 * 15;
+    if (zone.utcOffsetMinutes > p3clock::kMaxWallOffsetMinutes) {
+        zone.utcOffsetMinutes -= 24 * 60;
+    }
+    p3clock::FormatUtcOffset(zone.utcOffsetMinutes, zone.label);
+    return zone;
+}
+
+static bool ParseZoneList(const char* text, std::vector<p3clock::WallZone>* zones) {
+    std::string list(text);
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(';', start);
+        if (end == std::string::npos) end = list.size();
+        p3clock::WallZone zone;
+        if (!p3clock::ParseWallZone(list.substr(start, end - start).c_str(), &zone)) {
+            return false;
+        }
+        zones->push_back(zone);
+        start = end + 1;
+    }
+    return true;
+}
+
+static int RunRenderWall(int argc, char** argv) {
+    p3clock::ClockLayout layout = p3clock::kLayoutAnalogDigital;
+    int width = 1600, height = 900;
+    p3clock::ClockTime start = {10, 8, 30};
+    std::vector<p3clock::WallZone> zones;
+    int cells = 0;
+    const char* output = "-";
+
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--layout")) {
+            ok = p3clock::ParseClockLayout(value, &layout);
+        } else if (args.Is("--size")) {
+            ok = p3clock::ParseSize(value, &width, &height);
+        } else if (args.Is("--time")) {
+            ok = p3clock::ParseTime(value, &start);
+        } else if (args.Is("--zones")) {
+            ok = ParseZoneList(value, &zones);
+        } else if (args.Is("--cells")) {
+            cells = atoi(value);
+            ok = cells > 0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (zones.empty() && cells == 0) {
+        cells = 8;
+    }
+    for (int i = (int)zones.size(); i < cells; ++i) {
+        zones.push_back(BenchWallZone(i));
+    }
+
+    p3clock::ClockWallRenderer wall(layout);
+    wall.SetZones(zones);
+    wall.Resize(width, height);
+    wall.Render(((start.hour * 60LL + start.minute) * 60 + start.second) * 1000);
+
+    bool toStdout = strcmp(output, "-") == 0;
+    FILE* out = toStdout ? stdout : fopen(output, "wb");
+    if (!out) {
+        fprintf(stderr, "p3timec-headless: cannot open %s\n", output);
+        return 1;
+    }
+    bool written = p3clock::WritePpm(wall.Frame(), out);
+    written = (toStdout ? fflush(out) == 0 : fclose(out) == 0) && written;
+    if (!written) {
+        fprintf(stderr, "p3timec-headless: write failed\n");
+        return 1;
+    }
+    return 0;
+}
+
+struct WallBenchResult {
+    int cells;
+    p3clock::WallGrid grid;
+    p3clock::FrameTimeSummary wall;     // Tick() and presenting its rectangles, for all cells
+    p3clock::FrameTimeSummary separate; // Render() and a full copy in one window per zone
+    double wallPixelsPerTick;
+    double separatePixelsPerTick;
+    size_t wallHeapBytes; // Live heap of the renderer(s) and window framebuffer(s)
+    size_t separateHeapBytes;
+};
+
+static WallBenchResult RunWallCase(p3clock::ClockLayout layout, p3clock::FrameSize size, int cells, int ticks) {
+    WallBenchResult result;
+    result.cells = cells;
+    std::vector<p3clock::WallZone> zones;
+    for (int i = 0; i < cells; ++i) {
+        zones.push_back(BenchWallZone(i));
+    }
+    // 10:08:00 UTC onward, like bench; the zones cross midnight at different ticks
+    long long startMs = (10 * 60 + 8) * 60 * 1000LL;
+
+    {
+        size_t liveBefore = p3clock::HeapLiveBytes();
+        p3clock::ClockWallRenderer wall(layout);
+        wall.SetZones(zones);
+        wall.Resize(size.width, size.height);
+        p3clock::Framebuffer window;
+        window.Resize(size.width, size.height);
+        wall.Render(startMs);
+        p3clock::Blit(&window, 0, 0, wall.Frame(), 0, 0, size.width, size.height);
+        result.grid = wall.Grid();
+
+        std::vector<double> samples;
+        samples.reserve(ticks);
+        long long pixels = 0;
+        for (int i = 1; i <= ticks; ++i) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            const std::vector<p3clock::DamageRect>& damage = wall.Tick(startMs + i * 1000LL);
+            // One copy per invalidated rectangle, as WM_PAINT walks the update region
+            for (size_t d = 0; d < damage.size(); ++d) {
+                const p3clock::DamageRect& r = damage[d];
+                p3clock::Blit(&window, r.left, r.top, wall.Frame(), r.left, r.top, r.right - r.left, r.bottom - r.top);
+                pixels += p3clock::Area(r);
+            }
+            samples.push_back(p3clock::MsSince(start));
+        }
+        result.wall = p3clock::SummarizeFrameTimes(samples);
+        result.wallPixelsPerTick = (double)pixels / ticks;
+        result.wallHeapBytes = p3clock::HeapLiveBytes() - liveBefore;
+    }
+
+    {
+        // Today: one window, renderer and back buffer per zone, each repainted in full
+        size_t liveBefore = p3clock::HeapLiveBytes();
+        int cellWidth = result.grid.cellWidth, cellHeight = result.grid.cellHeight;
+        std::vector<p3clock::SoftClockRenderer*> renderers;
+        std::vector<p3clock::Framebuffer> windows(cells);
+        for (int i = 0; i < cells; ++i) {
+            renderers.push_back(new p3clock::SoftClockRenderer(layout));
+            renderers[i]->Resize(cellWidth, cellHeight);
+            renderers[i]->Render(p3clock::ZoneTime(startMs, zones[i].utcOffsetMinutes));
+            windows[i].Resize(cellWidth, cellHeight);
+        }
+        std::vector<double> samples;
+        samples.reserve(ticks);
+        for (int i = 1; i <= ticks; ++i) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int c = 0; c < cells; ++c) {
+                renderers[c]->Render(p3clock::ZoneTime(startMs + i * 1000LL, zones[c].utcOffsetMinutes));
+                p3clock::Blit(&windows[c], 0, 0, renderers[c]->Frame(), 0, 0, cellWidth, cellHeight);
+            }
+            samples.push_back(p3clock::MsSince(start));
+        }
+        result.separate = p3clock::SummarizeFrameTimes(samples);
+        result.separatePixelsPerTick = (double)cells * cellWidth * cellHeight;
+        result.separateHeapBytes = p3clock::HeapLiveBytes() - liveBefore;
+        for (int i = 0; i < cells; ++i) {
+            delete renderers[i];
+        }
+    }
+    return result;
+}
+
+static int RunBenchWall(int argc, char** argv) {
+    p3clock::ClockLayout layout = p3clock::kLayoutAnalogDigital;
+    p3clock::FrameSize size = {1920, 1080};
+    std::vector<int> counts;
+    int ticks = 600;
+    const char* output = "-";
+
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--layout")) {
+            ok = p3clock::ParseClockLayout(value, &layout);
+        } else if (args.Is("--size")) {
+            ok = p3clock::ParseSize(value, &size.width, &size.height);
+        } else if (args.Is("--cells")) {
+            int cells = atoi(value);
+            ok = cells > 0;
+            if (ok) counts.push_back(cells);
+        } else if (args.Is("--ticks")) {
+            ticks = atoi(value);
+            ok = ticks > 0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (counts.empty()) {
+        int defaults[5] = {1, 4, 16, 64, 256};
+        counts.assign(defaults, defaults + 5);
+    }
+
+    std::vector<WallBenchResult> results;
+    for (size_t c = 0; c < counts.size(); ++c) {
+        WallBenchResult r = RunWallCase(layout, size, counts[c], ticks);
+        fprintf(stderr, "%4d cells %3dx%-3d in %dx%d: wall %7.3f ms/tick %9.0f px  separate %8.3f ms/tick %9.0f px  "
+                "heap %6.1f / %7.1f MiB\n",
+                r.cells, r.grid.cellWidth, r.grid.cellHeight, size.width, size.height, r.wall.meanMs,
+                r.wallPixelsPerTick, r.separate.meanMs, r.separatePixelsPerTick,
+                r.wallHeapBytes / 1048576.0, r.separateHeapBytes / 1048576.0);
+        results.push_back(r);
+    }
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "wall");
+    json.Field("layout", p3clock::kClockLayoutNames[layout]);
+    json.Field("width", size.width);
+    json.Field("height", size.height);
+    json.Field("ticks", ticks);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const WallBenchResult& r = results[i];
+        json.BeginObject();
+        json.Field("cells", r.cells);
+        json.Field("columns", r.grid.columns);
+        json.Field("rows", r.grid.rows);
+        json.Field("cell_width", r.grid.cellWidth);
+        json.Field("cell_height", r.grid.cellHeight);
+        json.Field("wall_mean_ms", r.wall.meanMs);
+        json.Field("wall_p50_ms", r.wall.p50Ms);
+        json.Field("wall_p99_ms", r.wall.p99Ms);
+        json.Field("wall_max_ms", r.wall.maxMs);
+        json.Field("wall_pixels_per_tick", r.wallPixelsPerTick);
+        json.Field("wall_heap_bytes", (long long)r.wallHeapBytes);
+        json.Field("separate_mean_ms", r.separate.meanMs);
+        json.Field("separate_p99_ms", r.separate.p99Ms);
+        json.Field("separate_pixels_per_tick", r.separatePixelsPerTick);
+        json.Field("separate_heap_bytes", (long long)r.separateHeapBytes);
+        json.Field("speedup", r.wall.meanMs > 0.0 ? r.separate.meanMs / r.wall.meanMs : 0.0);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+static int RunBenchResize(int argc, char** argv) {
+    std::vector<p3clock::ClockLayout> layouts;
+    const char* tracePath = NULL;
+    int events = 1000;
+    double hz = 60.0;
+    const char* output = "-";
+
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--layout")) {
+            p3clock::ClockLayout layout;
+            ok = p3clock::ParseClockLayout(value, &layout);
+            if (ok) layouts.push_back(layout);
+        } else if (args.Is("--trace")) {
+            tracePath = value;
+        } else if (args.Is("--events")) {
+            events = atoi(value);
+            ok = events > 0;
+        } else if (args.Is("--hz")) {
+            hz = atof(value);
+            ok = hz > 0.0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (layouts.empty()) {
+        for (int i = 0; i < p3clock::kLayoutCount; ++i) {
+            layouts.push_back(static_cast<p3clock::ClockLayout>(i));
+        }
+    }
+    std::vector<p3clock::ResizeEvent> trace;
+    if (tracePath) {
+        if (!p3clock::ReadResizeTrace(tracePath, &trace)) {
+            fprintf(stderr, "p3timec-headless: cannot read resize trace %s\n", tracePath);
+            return 2;
+        }
+    } else {
+        trace = p3clock::RecordedDrag(events);
+    }
+
+    std::vector<p3clock::ResizeCaseResult> results;
+    for (size_t l = 0; l < layouts.size(); ++l) {
+        p3clock::ResizeCaseResult r = p3clock::RunResizeCase(layouts[l], trace, hz);
+        fprintf(stderr, "%-9s before: %4lld rebuilds %8.1f ms %4lld fonts  after: %4lld rebuilds %8.1f ms "
+                "%4lld fonts %4lld measured  again: %3lld fonts %lld measured  toggle: %lld fonts  "
+                "fill %.2f (was %.2f)\n",
+                p3clock::kClockLayoutNames[r.layout],
+                r.before.rebuilds, r.before.rebuildMs, r.before.fontCreates,
+                r.after.rebuilds, r.after.rebuildMs, r.after.fontCreates, r.after.measurements,
+                r.replay.fontCreates, r.replay.measurements, r.toggle.fontCreates,
+                r.fill.meanFillFitted, r.fill.meanFillHeuristic);
+        results.push_back(r);
+    }
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "resize");
+    json.Field("trace", tracePath ? tracePath : "recorded-drag");
+    json.Field("events", (long long)trace.size());
+    json.Field("hz", hz);
+    json.Field("font_fit_bucket", p3clock::kFontFitBucket);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const p3clock::ResizeCaseResult& r = results[i];
+        json.BeginObject();
+        json.Field("layout", p3clock::kClockLayoutNames[r.layout]);
+        p3clock::WriteResizeRun(&json, "before", r.before);
+        p3clock::WriteResizeRun(&json, "after", r.after);
+        p3clock::WriteResizeRun(&json, "again", r.replay);
+        p3clock::WriteResizeRun(&json, "toggle", r.toggle);
+        json.Field("speedup", r.after.rebuildMs > 0.0 ? r.before.rebuildMs / r.after.rebuildMs : 0.0);
+        json.Key("fill");
+        json.BeginObject();
+        json.Field("sizes", r.fill.sizes);
+        json.Field("clipped_fitted", r.fill.clippedFitted);
+        json.Field("clipped_heuristic", r.fill.clippedHeuristic);
+        json.Field("min_fitted", r.fill.minFillFitted);
+        json.Field("mean_fitted", r.fill.meanFillFitted);
+        json.Field("min_heuristic", r.fill.minFillHeuristic);
+        json.Field("mean_heuristic", r.fill.meanFillHeuristic);
+        json.EndObject();
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+// bench-trace: the phase tracer on the software renderer and its cost
+struct SteadyTraceClock {
+    double NowMs() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+typedef p3clock::PaintTracer<SteadyTraceClock, true> HeadlessTracer;
+
+struct PhaseSummary {
+    int events;
+    double meanMs;
+    double p99Ms;
+    double totalMs;
+};
+
+static int RunBenchTrace(int argc, char** argv) {
+    p3clock::ClockLayout layout = p3clock::kLayoutAnalogDigital;
+    int width = 1920, height = 1080;
+    int frames = 300;
+    const char* tracePath = NULL;
+    const char* output = "-";
+
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--layout")) {
+            ok = p3clock::ParseClockLayout(value, &layout);
+        } else if (args.Is("--size")) {
+            ok = p3clock::ParseSize(value, &width, &height);
+        } else if (args.Is("--frames")) {
+            frames = atoi(value);
+            ok = frames > 0;
+        } else if (args.Is("--trace")) {
+            tracePath = value;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    // Traced frames, starting just before 01:00:00 so the face is rebuilt once (green to blue).
+    // "present" copies the frame like the final BitBlt of the double-buffered programs.
+    SteadyTraceClock clock;
+    HeadlessTracer* tracer = new HeadlessTracer(&clock);
+    p3clock::SoftClockRenderer renderer(layout);
+    p3clock::Framebuffer window;
+    {
+        p3clock::ScopedPhase<HeadlessTracer> phase(tracer, p3clock::kPhaseResize);
+        renderer.Resize(width, height);
+        window.Resize(width, height);
+    }
+    p3clock::ClockTime start = {0, 59, 50};
+    for (int f = 0; f < frames; ++f) {
+        p3clock::ScopedPhase<HeadlessTracer> frame(tracer, p3clock::kPhaseFrame);
+        renderer.Render(p3clock::AddSeconds(start, f), tracer);
+        p3clock::ScopedPhase<HeadlessTracer> present(tracer, p3clock::kPhasePresent);
+        p3clock::Blit(&window, 0, 0, renderer.Frame(), 0, 0, width, height);
+    }
+
+    std::vector<p3clock::PhaseEvent> events(p3clock::kPaintTraceCapacity);
+    int eventCount = tracer->Ring().Snapshot(&events[0], p3clock::kPaintTraceCapacity);
+    PhaseSummary phases[p3clock::kPaintPhaseCount];
+    for (int p = 0; p < p3clock::kPaintPhaseCount; ++p) {
+        std::vector<double> samples;
+        for (int k = 0; k < eventCount; ++k) {
+            if (events[k].phase == p) samples.push_back(events[k].durationMs);
+        }
+        p3clock::FrameTimeSummary s = p3clock::SummarizeFrameTimes(samples);
+        phases[p].events = s.frames;
+        phases[p].meanMs = s.meanMs;
+        phases[p].p99Ms = s.p99Ms;
+        phases[p].totalMs = s.meanMs * s.frames;
+    }
+    double frameTotalMs = phases[p3clock::kPhaseFrame].totalMs;
+    for (int p = 0; p < p3clock::kPaintPhaseCount; ++p) {
+        if (phases[p].events == 0) continue;
+        fprintf(stderr, "%-10s %5d events  mean %8.4f ms  p99 %8.4f ms  %5.1f%% of frame time\n",
+                p3clock::kPaintPhaseNames[p], phases[p].events, phases[p].meanMs, phases[p].p99Ms,
+                p == p3clock::kPhaseFrame || frameTotalMs <= 0.0 ? 100.0 : phases[p].totalMs / frameTotalMs * 100.0);
+    }
+    char hud[64];
+    if (tracer->FrameTimes().FormatHud(hud, sizeof(hud))) {
+        fprintf(stderr, "HUD: %s\n", hud);
+    }
+
+    // Cost of tracing: the same frames untraced (NullPaintTracer) and traced, interleaved
+    std::vector<double> plainSamples, tracedSamples;
+    for (int f = 0; f < frames; ++f) {
+        p3clock::ClockTime t = p3clock::AddSeconds(start, f + 20); // Past the rebuild
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        renderer.Render(t);
+        plainSamples.push_back(p3clock::MsSince(begin));
+        begin = std::chrono::steady_clock::now();
+        renderer.Render(t, tracer);
+        tracedSamples.push_back(p3clock::MsSince(begin));
+    }
+    double plainMs = p3clock::SummarizeFrameTimes(plainSamples).p50Ms;
+    double tracedMs = p3clock::SummarizeFrameTimes(tracedSamples).p50Ms;
+    // One phase on its own: two clock reads and a ring slot. A separate tracer keeps these out of the trace.
+    const int kTimedScopes = 1000000;
+    HeadlessTracer* scratch = new HeadlessTracer(&clock);
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kTimedScopes; ++i) {
+        p3clock::ScopedPhase<HeadlessTracer> phase(scratch, p3clock::kPhaseHands);
+    }
+    double nsPerEvent = p3clock::MsSince(begin) * 1e6 / kTimedScopes;
+    delete scratch;
+    fprintf(stderr, "untraced %.4f ms/frame, traced %.4f ms/frame, %.0f ns per traced phase\n", plainMs, tracedMs,
+            nsPerEvent);
+
+    if (tracePath) {
+        FILE* trace = fopen(tracePath, "w");
+        bool written = trace && tracer->WriteChromeTrace(trace);
+        if (!trace || fclose(trace) != 0 || !written) {
+            fprintf(stderr, "p3timec-headless: cannot write %s\n", tracePath);
+            delete tracer;
+            return 1;
+        }
+    }
+    delete tracer;
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "trace");
+    json.Field("layout", p3clock::kClockLayoutNames[layout]);
+    json.Field("width", width);
+    json.Field("height", height);
+    json.Field("frames", frames);
+    json.Key("results");
+    json.BeginArray();
+    for (int p = 0; p < p3clock::kPaintPhaseCount; ++p) {
+        json.BeginObject();
+        json.Field("phase", p3clock::kPaintPhaseNames[p]);
+        json.Field("events", phases[p].events);
+        json.Field("mean_ms", phases[p].meanMs);
+        json.Field("p99_ms", phases[p].p99Ms);
+        json.Field("share", frameTotalMs > 0.0 ? phases[p].totalMs / frameTotalMs : 0.0);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.Key("overhead");
+    json.BeginObject();
+    json.Field("untraced_frame_ms", plainMs);
+    json.Field("traced_frame_ms", tracedMs);
+    json.Field("ns_per_phase", nsPerEvent);
+    json.EndObject();
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+// bench-pixels: the paints of DibBackend, ClockCore through PixelPainter, timed on Linux. A tick
+// paint draws the damaged rectangles into the back buffer and copies them to the screen, which is
+// the single BitBlt of the Win32 build; a full paint does the same for the whole client area.
+struct PixelBenchResult {
+    const char* name;
+    p3clock::FrameSize size;
+    p3clock::FrameTimeSummary tick;
+    p3clock::FrameTimeSummary full;
+    double tickPixels;           // Mean paint rectangle area of a tick
+    double tickAllocations;      // Heap allocations per tick paint
+    double fullMegapixelsPerSec; // Client area pixels drawn and presented per second on full paints
+};
+
+template <class Layout>
+static PixelBenchResult RunPixelBenchCase(const char* name, p3clock::FrameSize size, int ticks, int frames) {
+    typedef p3clock::ClockCore<Layout, p3clock::BufferedPresentation, p3clock::SimBackend> Core;
+    PixelBenchResult r;
+    r.name = name;
+    r.size = size;
+    // 10:08:00 UTC on 2026-06-01: the color stays the same, so the face is built once
+    p3clock::CoreSimClock clock(1780272000000LL + 10LL * 3600000 + 8 * 60000, 0);
+    p3clock::SimBackend backend(&clock, Core::EraseBackground());
+    Core core(&backend, &clock, 0);
+    core.Create();
+    backend.SetClientSize(size.width, size.height);
+    core.Size(size.width, size.height, false);
+    core.Paint();
+
+    std::vector<double> samples;
+    samples.reserve(ticks);
+    double pixels = 0.0;
+    unsigned long long allocationsBefore = p3clock::HeapAllocations();
+    for (int i = 0; i < ticks; ++i) {
+        clock.Step(backend.timerArmed && backend.timerDueMs > clock.elapsedMs ? backend.timerDueMs - clock.elapsedMs : 1000);
+        backend.timerArmed = false;
+        core.Timer();
+        if (!backend.HasInvalid()) {
+            continue;
+        }
+        long long paintsBefore = backend.paints;
+        double fractionBefore = backend.paintedFraction;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        core.Paint();
+        samples.push_back(p3clock::MsSince(start));
+        if (backend.paints > paintsBefore) {
+            pixels += (backend.paintedFraction - fractionBefore) * size.width * size.height;
+        }
+    }
+    r.tickAllocations = samples.empty() ? 0.0 : (double)(p3clock::HeapAllocations() - allocationsBefore) / samples.size();
+    r.tickPixels = samples.empty() ? 0.0 : pixels / samples.size();
+    r.tick = p3clock::SummarizeFrameTimes(samples);
+
+    samples.clear();
+    for (int i = 0; i < frames; ++i) {
+        backend.InvalidateAll();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        core.Paint();
+        samples.push_back(p3clock::MsSince(start));
+    }
+    r.full = p3clock::SummarizeFrameTimes(samples);
+    r.fullMegapixelsPerSec = r.full.meanMs > 0.0 ? size.width * (double)size.height / r.full.meanMs / 1000.0 : 0.0;
+    return r;
+}
+
+static int RunBenchPixels(int argc, char** argv) {
+    std::vector<p3clock::FrameSize> sizes;
+    int ticks = 600;
+    int frames = 30;
+    const char* output = "-";
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--size")) {
+            p3clock::FrameSize size;
+            ok = p3clock::ParseSize(value, &size.width, &size.height);
+            if (ok) {
+                sizes.push_back(size);
+            }
+        } else if (args.Is("--ticks")) {
+            ticks = atoi(value);
+            ok = ticks > 0;
+        } else if (args.Is("--frames")) {
+            frames = atoi(value);
+            ok = frames > 0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (sizes.empty()) {
+        sizes.assign(kFrameSizes, kFrameSizes + 3); // 8K full paints take seconds and say nothing new
+    }
+
+    using namespace p3clock;
+    std::vector<PixelBenchResult> results;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        results.push_back(RunPixelBenchCase<DigitalLayoutPolicy>("p3timec-32-2", sizes[i], ticks, frames));
+        results.push_back(RunPixelBenchCase<AnalogDigitalLayoutPolicy>("p3timec-32-moni-1", sizes[i], ticks, frames));
+        results.push_back(RunPixelBenchCase<AnalogLayoutPolicy>("p3timec-32-moni-only-1", sizes[i], ticks, frames));
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+        const PixelBenchResult& r = results[i];
+        fprintf(stderr, "%-22s %4dx%-4d tick %7.3f ms (p99 %7.3f) %9.0f px %4.1f allocs  full %8.3f ms %7.1f Mpx/s\n",
+                r.name, r.size.width, r.size.height, r.tick.meanMs, r.tick.p99Ms, r.tickPixels, r.tickAllocations,
+                r.full.meanMs, r.fullMegapixelsPerSec);
+    }
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "pixels");
+    json.Field("ticks", ticks);
+    json.Field("frames", frames);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const PixelBenchResult& r = results[i];
+        json.BeginObject();
+        json.Field("variant", r.name);
+        json.Field("width", r.size.width);
+        json.Field("height", r.size.height);
+        json.Field("tick_paints", r.tick.frames);
+        json.Field("tick_mean_ms", r.tick.meanMs);
+        json.Field("tick_p50_ms", r.tick.p50Ms);
+        json.Field("tick_p99_ms", r.tick.p99Ms);
+        json.Field("tick_pixels", r.tickPixels);
+        json.Field("tick_allocations", r.tickAllocations);
+        json.Field("full_mean_ms", r.full.meanMs);
+        json.Field("full_p99_ms", r.full.p99Ms);
+        json.Field("full_megapixels_per_sec", r.fullMegapixelsPerSec);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+struct CompositeBenchResult {
+    const char* content;
+    p3clock::SimdLevel kernel;
+    int opacity;
+    double ms;                // Per pass over the whole frame
+    double megapixelsPerSec;
+    double speedup;           // Against the scalar kernel on the same content and opacity
+    long long mismatches;     // Pixels that differ from the scalar kernel's
+};
+
+// ComposeOverlay over the whole frame, `passes` times, the frame a fade step composes
+static double TimeComposite(const p3clock::Framebuffer& layer, p3clock::Framebuffer* frame, int opacity,
+                            p3clock::SimdLevel kernel, int passes) {
+    p3clock::DamageRect all = {0, 0, layer.width, layer.height};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < passes; ++i) {
+        p3clock::ComposeOverlay(p3clock::ViewOf(frame), p3clock::ViewOf(layer), all, 0x66000000u, opacity, kernel);
+    }
+    return p3clock::MsSince(start) / passes;
+}
+
+static int RunBenchComposite(int argc, char** argv) {
+    p3clock::FrameSize size = {1920, 1080};
+    int passes = 50;
+    const char* output = "-";
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--size")) {
+            ok = p3clock::ParseSize(value, &size.width, &size.height);
+        } else if (args.Is("--passes")) {
+            passes = atoi(value);
+            ok = passes > 0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    using namespace p3clock;
+    SimdLevel best = ResolveSimdLevel(kSimdAuto);
+    // The moni overlay at 10:08:30 (mostly transparent, opaque strokes, anti-aliased edges)
+    // and random premultiplied pixels (every pixel blended)
+    Framebuffer layers[2];
+    const char* const kContentNames[2] = {"overlay", "random"};
+    PixelPainter painter(kArgbTransparent);
+    ClockTime t = {10, 8, 30};
+    p3clock::DrawOverlayLayer(&painter, kLayoutAnalogDigital, size, t, &layers[0]);
+    layers[1].Resize(size.width, size.height);
+    uint32_t seed = 2026;
+    for (size_t i = 0; i < layers[1].pixels.size(); ++i) {
+        Argb c = p3clock::RandomPremultiplied(&seed);
+        layers[1].pixels[i] = c ? c : 0x80404040u;
+    }
+
+    static const int kBenchOpacities[] = {255, 217}; // Opaque, and the default /overlay
+    std::vector<CompositeBenchResult> results;
+    Framebuffer reference, frame;
+    reference.Resize(size.width, size.height);
+    frame.Resize(size.width, size.height);
+    for (int c = 0; c < 2; ++c) {
+        for (int o = 0; o < 2; ++o) {
+            double scalarMs = 0.0;
+            for (int k = kSimdScalar; k <= best; ++k) {
+                CompositeBenchResult r;
+                r.content = kContentNames[c];
+                r.kernel = static_cast<SimdLevel>(k);
+                r.opacity = kBenchOpacities[o];
+                Framebuffer* target = k == kSimdScalar ? &reference : &frame;
+                TimeComposite(layers[c], target, r.opacity, r.kernel, 1); // Warm up
+                r.ms = TimeComposite(layers[c], target, r.opacity, r.kernel, passes);
+                if (k == kSimdScalar) {
+                    scalarMs = r.ms;
+                }
+                r.megapixelsPerSec = r.ms > 0.0 ? size.width * (double)size.height / r.ms / 1000.0 : 0.0;
+                r.speedup = r.ms > 0.0 ? scalarMs / r.ms : 0.0;
+                r.mismatches = 0;
+                for (size_t i = 0; i < target->pixels.size(); ++i) {
+                    if (target->pixels[i] != reference.pixels[i]) r.mismatches++;
+                }
+                fprintf(stderr, "%-7s opacity %3d %-6s %8.3f ms %8.1f Mpx/s %5.2fx  %lld mismatches\n", r.content,
+                        r.opacity, kSimdLevelNames[k], r.ms, r.megapixelsPerSec, r.speedup, r.mismatches);
+                results.push_back(r);
+            }
+        }
+    }
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "composite");
+    json.Field("width", size.width);
+    json.Field("height", size.height);
+    json.Field("passes", passes);
+    json.Field("best_kernel", kSimdLevelNames[best]);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const CompositeBenchResult& r = results[i];
+        json.BeginObject();
+        json.Field("content", r.content);
+        json.Field("kernel", kSimdLevelNames[r.kernel]);
+        json.Field("opacity", r.opacity);
+        json.Field("ms", r.ms);
+        json.Field("megapixels_per_sec", r.megapixelsPerSec);
+        json.Field("speedup", r.speedup);
+        json.Field("mismatches", r.mismatches);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+// stream: the clock as raw video for ffmpeg or OBS, through a fixed buffer pool and a writer thread
+enum StreamFormat { kStreamY4m, kStreamRgba };
+
+static const char* const kStreamFormatNames[] = {"y4m", "rgba"};
+
+static volatile sig_atomic_t g_streamStop = 0;
+
+static void StopStream(int) {
+    g_streamStop = 1;
+}
+
+static bool ParseSimdLevel(const char* text, p3clock::SimdLevel* level) {
+    if (strcmp(text, "auto") == 0) {
+        *level = p3clock::kSimdAuto;
+        return true;
+    }
+    for (int k = p3clock::kSimdScalar; k <= p3clock::kSimdAvx2; ++k) {
+        if (strcmp(text, p3clock::kSimdLevelNames[k]) == 0) {
+            *level = static_cast<p3clock::SimdLevel>(k);
+            return true;
+        }
+    }
+    return false;
+}
+
+const size_t kStreamSampleWindow = 4096;
+
+static void RecordStreamSample(std::vector<double>* samples, long long frame, double ms) {
+    if (samples->size() < kStreamSampleWindow) {
+        samples->push_back(ms);
+    } else {
+        (*samples)[(size_t)(frame % kStreamSampleWindow)] = ms;
+    }
+}
+
+static p3clock::YuvPlanes I420PlanesOf(unsigned char* frame, int width, int height) {
+    p3clock::YuvPlanes planes = {frame, frame + (size_t)width * height,
+                                 frame + (size_t)width * height + (size_t)(width / 2) * (height / 2), width, width / 2};
+    return planes;
+}
+
+static int RunStream(int argc, char** argv) {
+    p3clock::ClockLayout layout = p3clock::kLayoutAnalogDigital;
+    p3clock::FrameSize size = {1280, 720};
+    int fps = 30;
+    StreamFormat format = kStreamY4m;
+    long long frames = 0;
+    bool live = true;
+    p3clock::ClockTime start = {0, 0, 0};
+    bool sweep = true;
+    int buffers = 4;
+    p3clock::SimdLevel kernel = p3clock::kSimdAuto;
+    const char* statsPath = NULL;
+    const char* output = "-";
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--layout")) {
+            ok = p3clock::ParseClockLayout(value, &layout);
+        } else if (args.Is("--size")) {
+            ok = p3clock::ParseSize(value, &size.width, &size.height) && size.width % 2 == 0 && size.height % 2 == 0;
+        } else if (args.Is("--fps")) {
+            fps = atoi(value);
+            ok = fps >= 1 && fps <= 240;
+        } else if (args.Is("--format")) {
+            if (strcmp(value, "y4m") == 0) {
+                format = kStreamY4m;
+            } else if (strcmp(value, "rgba") == 0) {
+                format = kStreamRgba;
+            } else {
+                ok = false;
+            }
+        } else if (args.Is("--frames")) {
+            frames = atoll(value);
+            ok = frames >= 0;
+        } else if (args.Is("--time")) {
+            ok = p3clock::ParseTime(value, &start);
+            live = false;
+        } else if (args.Is("--hands")) {
+            ok = strcmp(value, "sweep") == 0 || strcmp(value, "tick") == 0;
+            sweep = strcmp(value, "sweep") == 0;
+        } else if (args.Is("--buffers")) {
+            buffers = atoi(value);
+            ok = buffers >= 2 && buffers <= 64;
+        } else if (args.Is("--kernel")) {
+            ok = ParseSimdLevel(value, &kernel);
+        } else if (args.Is("--stats")) {
+            statsPath = value;
+            ok = strcmp(value, "-") != 0; // stdout may be the stream
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+
+    using namespace p3clock;
+    bool toStdout = strcmp(output, "-") == 0;
+    FILE* out = toStdout ? stdout : fopen(output, "wb"); // A named pipe blocks here until a reader opens it
+    if (!out) {
+        fprintf(stderr, "p3timec-headless: cannot open %s\n", output);
+        return 1;
+    }
+#if defined(SIGPIPE)
+    signal(SIGPIPE, SIG_IGN); // A reader that goes away is a failed write, not the end of the process
+#endif
+    signal(SIGINT, StopStream);
+    signal(SIGTERM, StopStream);
+
+    size_t pixels = (size_t)size.width * size.height;
+    size_t frameBytes = format == kStreamY4m ? pixels + pixels / 2 : pixels * 4;
+    if (format == kStreamY4m) {
+        fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XYSCSS=420JPEG XCOLORRANGE=LIMITED\n", size.width,
+                size.height, fps);
+    }
+    SoftClockRenderer renderer(layout);
+    renderer.Resize(size.width, size.height);
+    FrameStream stream(out, frameBytes, buffers, format == kStreamY4m ? "FRAME\n" : "");
+
+    // Which content each pool buffer holds: unchanged frames are copied from the previous one, or
+    // left alone when the pool hands back that same buffer, instead of converted again
+    std::vector<long long> bufferVersion(stream.Buffers(), -1);
+    long long version = 0;
+    ClockTime shown = start;
+    const unsigned char* previous = NULL;
+    long long previousVersion = -1;
+
+    HostClock host;
+    TimeSource<HostClock> source(&host);
+    // Times of the last kStreamSampleWindow frames, in rings, so a stream that runs for days stays
+    // at the memory it started with
+    std::vector<double> renderSamples, convertSamples;
+    renderSamples.reserve(kStreamSampleWindow);
+    convertSamples.reserve(kStreamSampleWindow);
+    long long unchanged = 0;
+    long long late = 0;
+    double periodMs = 1000.0 / fps;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    unsigned long long allocationsBefore = p3clock::HeapAllocations();
+    long long frame = 0;
+    for (; (frames == 0 || frame < frames) && !g_streamStop; ++frame) {
+        if (live) {
+            std::chrono::steady_clock::time_point due =
+                begin + std::chrono::microseconds((long long)(frame * periodMs * 1000.0));
+            if (std::chrono::steady_clock::now() > due + std::chrono::microseconds((long long)(periodMs * 1000.0))) {
+                late++; // More than a frame behind: render and convert take longer than the frame period
+            }
+            std::this_thread::sleep_until(due);
+        }
+        LocalTime t;
+        if (live) {
+            t = source.Now();
+        } else {
+            long long ms = frame * 1000 / fps;
+            t.time = p3clock::AddSeconds(start, (int)(ms / 1000 % 86400));
+            t.millisecond = (int)(ms % 1000);
+        }
+
+        // Sweep: redraw what the hands and digits damaged; tick: a full frame when the second changes
+        std::chrono::steady_clock::time_point renderStart = std::chrono::steady_clock::now();
+        bool changed;
+        if (sweep) {
+            DamageList damage = renderer.RenderSweep(t.time, t.millisecond);
+            changed = damage.full || damage.count > 0;
+        } else {
+            changed = version == 0 || !SameTime(t.time, shown);
+            if (changed) {
+                renderer.Render(t.time);
+                shown = t.time;
+            }
+        }
+        RecordStreamSample(&renderSamples, frame, p3clock::MsSince(renderStart));
+        if (changed) {
+            version++;
+        }
+
+        unsigned char* buffer = stream.Acquire(!live);
+        if (!buffer) {
+            if (stream.Stats().failed) {
+                break;
+            }
+            continue; // Dropped: the writer still has every buffer
+        }
+        int index = stream.Index(buffer);
+        std::chrono::steady_clock::time_point convertStart = std::chrono::steady_clock::now();
+        if (bufferVersion[index] == version) {
+            unchanged++;
+        } else if (previous && previousVersion == version) {
+            memcpy(buffer, previous, frameBytes); // Only the writer reads `previous`, and only the renderer writes
+            unchanged++;
+        } else if (format == kStreamY4m) {
+            ArgbToI420(ViewOf(renderer.Frame()), I420PlanesOf(buffer, size.width, size.height), kernel);
+        } else {
+            ArgbToRgba(ViewOf(renderer.Frame()), buffer);
+        }
+        RecordStreamSample(&convertSamples, frame, p3clock::MsSince(convertStart));
+        bufferVersion[index] = version;
+        previous = buffer;
+        previousVersion = version;
+        stream.Submit(buffer);
+    }
+    double allocationsPerFrame = frame ? (double)(p3clock::HeapAllocations() - allocationsBefore) / frame : 0.0;
+    bool written = stream.Finish();
+    double seconds = p3clock::MsSince(begin) / 1000.0;
+    if (!toStdout && fclose(out) != 0) {
+        written = false;
+    }
+
+    FrameStreamStats stats = stream.Stats();
+    FrameTimeSummary render = SummarizeFrameTimes(renderSamples);
+    FrameTimeSummary convert = SummarizeFrameTimes(convertSamples);
+    double meanDepth = stats.produced ? (double)stats.depthSum / stats.produced : 0.0;
+    fprintf(stderr,
+            "stream %s %dx%d %d fps %s: %llu produced, %llu dropped, %llu written (%.1f MB), %lld late, %lld unchanged\n"
+            "  queue depth mean %.2f max %d of %d buffers, %.2f allocations per frame; render %.3f ms (p99 %.3f),"
+            " convert %.3f ms (p99 %.3f, %s); %.1f fps over %.1f s\n",
+            kClockLayoutNames[layout], size.width, size.height, fps, kStreamFormatNames[format], stats.produced,
+            stats.dropped, stats.written, stats.bytes / 1e6, late, unchanged, meanDepth, stats.maxDepth,
+            stream.Buffers(), allocationsPerFrame, render.meanMs, render.p99Ms, convert.meanMs, convert.p99Ms,
+            kSimdLevelNames[ResolveSimdLevel(kernel)], seconds > 0.0 ? stats.written / seconds : 0.0, seconds);
+    if (!written) {
+        fprintf(stderr, "p3timec-headless: write failed after %llu frames\n", stats.written);
+    }
+
+    if (statsPath) {
+        FILE* statsOut = fopen(statsPath, "w");
+        if (!statsOut) {
+            fprintf(stderr, "p3timec-headless: cannot open %s\n", statsPath);
+            return 1;
+        }
+        JsonWriter json(statsOut);
+        json.BeginObject();
+        json.Field("stream", kStreamFormatNames[format]);
+        json.Field("layout", kClockLayoutNames[layout]);
+        json.Field("width", size.width);
+        json.Field("height", size.height);
+        json.Field("fps", fps);
+        json.Field("live", live);
+        json.Field("kernel", kSimdLevelNames[ResolveSimdLevel(kernel)]);
+        json.Field("buffers", stream.Buffers());
+        json.Field("frames_produced", (long long)stats.produced);
+        json.Field("frames_dropped", (long long)stats.dropped);
+        json.Field("frames_written", (long long)stats.written);
+        json.Field("frames_late", late);
+        json.Field("frames_unchanged", unchanged);
+        json.Field("bytes", (long long)stats.bytes);
+        json.Field("queue_depth_mean", meanDepth);
+        json.Field("queue_depth_max", stats.maxDepth);
+        json.Field("allocations_per_frame", allocationsPerFrame);
+        json.Field("render_mean_ms", render.meanMs);
+        json.Field("render_p99_ms", render.p99Ms);
+        json.Field("convert_mean_ms", convert.meanMs);
+        json.Field("convert_p99_ms", convert.p99Ms);
+        json.Field("seconds", seconds);
+        json.Field("write_failed", !written);
+        json.EndObject();
+        json.Finish();
+        if (fclose(statsOut) != 0) {
+            fprintf(stderr, "p3timec-headless: write failed\n");
+            return 1;
+        }
+    }
+    return written ? 0 : 1;
+}
+
+struct YuvBenchResult {
+    const char* content;
+    p3clock::FrameSize size;
+    p3clock::SimdLevel kernel;
+    double ms;               // Per frame
+    double megapixelsPerSec;
+    double speedup;          // Against scalar on the same frame
+    long long mismatches;    // Bytes that differ from the scalar kernel's
+};
+
+// bench-yuv: the stream's RGB to I420 stage with each kernel, on a rendered frame and on noise
+static int RunBenchYuv(int argc, char** argv) {
+    std::vector<p3clock::FrameSize> sizes;
+    int passes = 50;
+    const char* output = "-";
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--size")) {
+            p3clock::FrameSize size;
+            ok = p3clock::ParseSize(value, &size.width, &size.height) && size.width % 2 == 0 && size.height % 2 == 0;
+            if (ok) {
+                sizes.push_back(size);
+            }
+        } else if (args.Is("--passes")) {
+            passes = atoi(value);
+            ok = passes > 0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (sizes.empty()) {
+        p3clock::FrameSize defaults[] = {{1280, 720}, {1920, 1080}, {3840, 2160}};
+        sizes.assign(defaults, defaults + 3);
+    }
+
+    using namespace p3clock;
+    SimdLevel best = ResolveSimdLevel(kSimdAuto);
+    const char* const kContentNames[2] = {"clock", "noise"};
+    std::vector<YuvBenchResult> results;
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        p3clock::FrameSize size = sizes[s];
+        size_t frameBytes = (size_t)size.width * size.height * 3 / 2;
+        Framebuffer frames[2];
+        SoftClockRenderer renderer(kLayoutAnalogDigital);
+        renderer.Resize(size.width, size.height);
+        ClockTime t = {10, 8, 30};
+        renderer.Render(t);
+        frames[0] = renderer.Frame();
+        frames[1].Resize(size.width, size.height);
+        uint32_t seed = 2026;
+        for (size_t i = 0; i < frames[1].pixels.size(); ++i) {
+            frames[1].pixels[i] = 0xFF000000u | p3clock::NextRandom(&seed);
+        }
+        std::vector<unsigned char> reference(frameBytes), actual(frameBytes);
+        for (int c = 0; c < 2; ++c) {
+            double scalarMs = 0.0;
+            for (int k = kSimdScalar; k <= best; ++k) {
+                YuvBenchResult r;
+                r.content = kContentNames[c];
+                r.size = size;
+                r.kernel = static_cast<SimdLevel>(k);
+                std::vector<unsigned char>& target = k == kSimdScalar ? reference : actual;
+                YuvPlanes planes = I420PlanesOf(&target[0], size.width, size.height);
+                ArgbToI420(ViewOf(frames[c]), planes, r.kernel); // Warm up
+                std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+                for (int p = 0; p < passes; ++p) {
+                    ArgbToI420(ViewOf(frames[c]), planes, r.kernel);
+                }
+                r.ms = p3clock::MsSince(begin) / passes;
+                if (k == kSimdScalar) {
+                    scalarMs = r.ms;
+                }
+                r.megapixelsPerSec = r.ms > 0.0 ? size.width * (double)size.height / r.ms / 1000.0 : 0.0;
+                r.speedup = r.ms > 0.0 ? scalarMs / r.ms : 0.0;
+                r.mismatches = 0;
+                for (size_t i = 0; i < frameBytes; ++i) {
+                    if (target[i] != reference[i]) r.mismatches++;
+                }
+                fprintf(stderr, "%-5s %4dx%-4d %-6s %8.3f ms %8.1f Mpx/s %5.2fx  %lld mismatches\n", r.content,
+                        size.width, size.height, kSimdLevelNames[k], r.ms, r.megapixelsPerSec, r.speedup, r.mismatches);
+                results.push_back(r);
+            }
+        }
+    }
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "yuv");
+    json.Field("passes", passes);
+    json.Field("best_kernel", kSimdLevelNames[best]);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const YuvBenchResult& r = results[i];
+        json.BeginObject();
+        json.Field("content", r.content);
+        json.Field("width", r.size.width);
+        json.Field("height", r.size.height);
+        json.Field("kernel", kSimdLevelNames[r.kernel]);
+        json.Field("ms", r.ms);
+        json.Field("megapixels_per_sec", r.megapixelsPerSec);
+        json.Field("speedup", r.speedup);
+        json.Field("mismatches", r.mismatches);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+struct TtyBenchResult {
+    p3clock::ClockLayout layout;
+    int cols;
+    int rows;
+    long long fullBytes;     // The first frame: clear and every cell
+    double bytesPerTick;     // Mean over the ticks after it
+    double p99BytesPerTick;
+    long long maxBytesPerTick;
+    double cellsPerTick;
+    double runsPerTick;      // Cursor moves
+    double writesPerTick;    // One write() per tick that changed anything
+    double savedPercent;     // Against drawing the whole screen every tick
+    double encodeUs;         // Mean per tick
+    double allocationsPerTick;
+};
+
+static TtyBenchResult RunTtyCase(p3clock::ClockLayout layout, int cols, int rows, p3clock::ClockTime start, int ticks) {
+    using namespace p3clock;
+    TtyBenchResult r;
+    r.layout = layout;
+    r.cols = cols;
+    r.rows = rows;
+    SoftClockRenderer renderer(layout);
+    renderer.Resize(cols, rows * 2);
+    TtyScreen screen;
+    screen.Resize(cols, rows);
+    std::string out;
+    renderer.Render(start);
+    screen.Encode(renderer.Frame(), &out);
+    r.fullBytes = (long long)out.size();
+    out.reserve(out.size() * 2); // As the program's buffer is after its first full frame
+
+    std::vector<double> bytes;
+    bytes.reserve(ticks);
+    long long cells = 0, runs = 0, writes = 0, total = 0;
+    r.maxBytesPerTick = 0;
+    double encodeMs = 0.0;
+    unsigned long long allocations = 0;
+    for (int i = 1; i <= ticks; ++i) {
+        renderer.Render(p3clock::AddSeconds(start, i));
+        out.clear();
+        unsigned long long allocationsBefore = p3clock::HeapAllocations();
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        TtyEncodeStats stats = screen.Encode(renderer.Frame(), &out);
+        encodeMs += p3clock::MsSince(begin);
+        allocations += p3clock::HeapAllocations() - allocationsBefore;
+        cells += stats.cells;
+        runs += stats.runs;
+        total += stats.bytes;
+        writes += stats.bytes > 0 ? 1 : 0;
+        bytes.push_back((double)stats.bytes);
+        r.maxBytesPerTick = std::max(r.maxBytesPerTick, stats.bytes);
+    }
+    std::sort(bytes.begin(), bytes.end());
+    r.bytesPerTick = (double)total / ticks;
+    r.p99BytesPerTick = Percentile(bytes, 99.0);
+    r.cellsPerTick = (double)cells / ticks;
+    r.runsPerTick = (double)runs / ticks;
+    r.writesPerTick = (double)writes / ticks;
+    r.savedPercent = r.fullBytes ? 100.0 * (1.0 - r.bytesPerTick / r.fullBytes) : 0.0;
+    r.encodeUs = encodeMs * 1000.0 / ticks;
+    r.allocationsPerTick = (double)allocations / ticks;
+    return r;
+}
+
+// bench-tty: what p3timec-tty writes per tick, against redrawing the whole screen
+static int RunBenchTty(int argc, char** argv) {
+    std::vector<p3clock::FrameSize> sizes;
+    std::vector<p3clock::ClockLayout> layouts;
+    p3clock::ClockTime start = {23, 59, 0};
+    int ticks = 120;
+    const char* output = "-";
+    p3clock::CommandArgs args("p3timec-headless", argc, argv, PrintUsage);
+    while (args.Next()) {
+        const char* value = args.Value();
+        bool ok = true;
+        if (args.Is("--size")) {
+            p3clock::FrameSize size;
+            ok = p3clock::ParseSize(value, &size.width, &size.height);
+            if (ok) {
+                sizes.push_back(size);
+            }
+        } else if (args.Is("--layout")) {
+            p3clock::ClockLayout layout;
+            ok = p3clock::ParseClockLayout(value, &layout);
+            if (ok) {
+                layouts.push_back(layout);
+            }
+        } else if (args.Is("--time")) {
+            ok = p3clock::ParseTime(value, &start);
+        } else if (args.Is("--ticks")) {
+            ticks = atoi(value);
+            ok = ticks > 0;
+        } else if (args.Is("-o")) {
+            output = value;
+        } else {
+            args.Unknown();
+        }
+        args.Check(ok);
+    }
+    if (args.Stopped()) {
+        return args.Status();
+    }
+    if (sizes.empty()) {
+        p3clock::FrameSize defaults[] = {{80, 24}, {120, 40}, {200, 60}};
+        sizes.assign(defaults, defaults + 3);
+    }
+    if (layouts.empty()) {
+        layouts.push_back(p3clock::kLayoutDigital);
+        layouts.push_back(p3clock::kLayoutAnalogDigital);
+    }
+
+    using namespace p3clock;
+    std::vector<TtyBenchResult> results;
+    for (size_t l = 0; l < layouts.size(); ++l) {
+        for (size_t s = 0; s < sizes.size(); ++s) {
+            TtyBenchResult r = RunTtyCase(layouts[l], sizes[s].width, sizes[s].height, start, ticks);
+            fprintf(stderr,
+                    "%-9s %3dx%-3d full %7lld B, per tick %7.0f B (p99 %6.0f, max %6lld), %6.1f cells, %5.1f runs, "
+                    "%.2f writes, %5.1f%% saved, encode %6.1f us, %.2f allocations\n",
+                    kClockLayoutNames[r.layout], r.cols, r.rows, r.fullBytes, r.bytesPerTick,
+                    r.p99BytesPerTick, r.maxBytesPerTick, r.cellsPerTick, r.runsPerTick, r.writesPerTick,
+                    r.savedPercent, r.encodeUs, r.allocationsPerTick);
+            results.push_back(r);
+        }
+    }
+
+    p3clock::JsonOutput out("p3timec-headless");
+    if (!out.Open(output)) {
+        return 1;
+    }
+    p3clock::JsonWriter& json = out.Json();
+    json.BeginObject();
+    json.Field("benchmark", "tty");
+    json.Field("ticks", ticks);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const TtyBenchResult& r = results[i];
+        json.BeginObject();
+        json.Field("layout", kClockLayoutNames[r.layout]);
+        json.Field("cols", r.cols);
+        json.Field("rows", r.rows);
+        json.Field("full_bytes", r.fullBytes);
+        json.Field("bytes_per_tick", r.bytesPerTick);
+        json.Field("p99_bytes_per_tick", r.p99BytesPerTick);
+        json.Field("max_bytes_per_tick", r.maxBytesPerTick);
+        json.Field("cells_per_tick", r.cellsPerTick);
+        json.Field("runs_per_tick", r.runsPerTick);
+        json.Field("writes_per_tick", r.writesPerTick);
+        json.Field("saved_percent", r.savedPercent);
+        json.Field("encode_us", r.encodeUs);
+        json.Field("allocations_per_tick", r.allocationsPerTick);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    if (!out.Close()) {
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    // The first argument may name a command; "render" is the default
+    if (argc > 1 && strcmp(argv[1], "bench-tty") == 0) {
+        return RunBenchTty(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "stream") == 0) {
+        return RunStream(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-yuv") == 0) {
+        return RunBenchYuv(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-composite") == 0) {
+        return RunBenchComposite(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-pixels") == 0) {
+        return RunBenchPixels(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-trace") == 0) {
+        return RunBenchTrace(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-resize") == 0) {
+        return RunBenchResize(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-tiles") == 0) {
+        return RunBenchTiles(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "render-wall") == 0) {
+        return RunRenderWall(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-wall") == 0) {
+        return RunBenchWall(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-time") == 0) {
+        return RunBenchTime(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-circle") == 0) {
+        return RunBenchCircle(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-sweep") == 0) {
+        return RunBenchSweep(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench-line") == 0) {
+        return RunBenchLine(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        return RunBench(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "render") == 0) {
+        return RunRender(argc - 2, argv + 2);
+    }
+    return RunRender(argc - 1, argv + 1);
+}
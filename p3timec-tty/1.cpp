@@ -0,0 +1,219 @@
+// Terminal P3 clock: the p3timec and p3timec-32-moni layouts in a text terminal
+// (Linux console, xterm, an SSH session) for machines without a desktop.
+// The software renderer in p3clock draws a frame of one pixel per column and
+// two per row, scaled to the terminal, and TtyScreen (p3clock/tty_frame.h)
+// sends only the cells that changed since the last second as truecolor ANSI.
+// POSIX; builds with e.g.
+//     g++ -O2 -o p3timec-tty p3timec-tty/1.cpp
+//
+// q or Ctrl+C quits. A summary of what was written goes to stderr on exit.
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <string>
+
+#include "../p3clock/soft_clock.h"     // Clock layouts drawn by the software renderer
+#include "../p3clock/tick_scheduler.h" // Second-aligned wakeups
+#include "../p3clock/time_source.h"    // Local time from the monotonic clock
+#include "../p3clock/tty_frame.h"      // Frames as diff-only ANSI text
+
+using namespace p3clock;
+
+const int kDefaultCols = 80; // When the output is not a terminal that reports its size
+const int kDefaultRows = 24;
+
+static volatile sig_atomic_t g_quit = 0;
+static volatile sig_atomic_t g_resized = 0;
+
+static void OnQuitSignal(int) { g_quit = 1; }
+static void OnResizeSignal(int) { g_resized = 1; }
+
+struct HostClock {
+    long long MonotonicMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+    }
+
+    long long UtcMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+    }
+
+    int UtcOffsetMinutes() {
+        time_t now = time(NULL);
+        struct tm local;
+        localtime_r(&now, &local);
+        return (int)(local.tm_gmtoff / 60);
+    }
+};
+
+struct TtyRunStats {
+    unsigned long long frames;  // Frames encoded, the first and every resize included
+    unsigned long long redraws; // Full frames (start and resizes)
+    unsigned long long writes;  // write() calls
+    unsigned long long bytes;
+    unsigned long long cells;
+};
+
+static void PrintUsage(FILE* out) {
+    fprintf(out,
+            "usage: p3timec-tty [--layout digital|moni|moni-only]\n"
+            "  --layout   digital is p3timec, moni is p3timec-32-moni, moni-only is\n"
+            "             p3timec-32-moni-only (default digital)\n"
+            "Needs a terminal with 24-bit color and UTF-8. q or Ctrl+C quits.\n");
+}
+
+static void TerminalSize(int* cols, int* rows) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 0) {
+        *cols = ws.ws_col;
+        *rows = ws.ws_row;
+    } else {
+        *cols = kDefaultCols;
+        *rows = kDefaultRows;
+    }
+}
+
+// Everything in one write() where the terminal takes it, so a tick is one syscall
+static bool WriteAll(const std::string& text, TtyRunStats* stats) {
+    const char* p = text.data();
+    size_t left = text.size();
+    while (left > 0) {
+        ssize_t n = write(STDOUT_FILENO, p, left);
+        stats->writes++;
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        left -= (size_t)n;
+        stats->bytes += (unsigned long long)n;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    ClockLayout layout = kLayoutDigital;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            PrintUsage(stdout);
+            return 0;
+        }
+        if (strcmp(arg, "--layout") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "%s needs a value\n", arg);
+                return 2;
+            }
+            const char* value = argv[++i];
+            if (!ParseClockLayout(value, &layout)) {
+                fprintf(stderr, "bad value for %s: %s\n", arg, value);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            PrintUsage(stderr);
+            return 2;
+        }
+    }
+
+    // Keystrokes are read one at a time and not echoed over the clock; signals still work
+    struct termios saved;
+    bool raw = isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved) == 0;
+    if (raw) {
+        struct termios mode = saved;
+        mode.c_lflag &= ~(ICANON | ECHO);
+        mode.c_cc[VMIN] = 0;
+        mode.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &mode);
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = OnQuitSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGHUP, &action, NULL);
+    action.sa_handler = OnResizeSignal; // No SA_RESTART: the resize wakes poll() at once
+    sigaction(SIGWINCH, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    TtyRunStats stats = {0, 0, 0, 0, 0};
+    std::string out;
+    WriteAll("\x1b[?1049h\x1b[?25l", &stats); // Alternate screen, cursor hidden
+
+    SoftClockRenderer renderer(layout);
+    TtyScreen screen;
+    HostClock host;
+    TimeSource<HostClock> source(&host);
+    TickScheduler scheduler;
+    ClockTime shown = {0, 0, 0};
+    bool resize = true;
+    bool ok = true;
+    while (!g_quit && ok) {
+        if (g_resized) {
+            g_resized = 0;
+            resize = true; // Several SIGWINCH during a drag end up as one redraw here
+        }
+        if (resize) {
+            int cols, rows;
+            TerminalSize(&cols, &rows);
+            screen.Resize(cols, rows);
+            renderer.Resize(cols, rows * 2);
+        }
+
+        LocalTime now = source.Now();
+        Tick tick = scheduler.OnTick(now.ms);
+        if (resize || (tick.present && !SameTime(now.time, shown))) {
+            renderer.Render(now.time);
+            out.clear();
+            TtyEncodeStats encoded = screen.Encode(renderer.Frame(), &out);
+            ok = out.empty() || WriteAll(out, &stats);
+            stats.frames++;
+            stats.cells += (unsigned long long)encoded.cells;
+            if (resize) {
+                stats.redraws++;
+            }
+            shown = now.time;
+            resize = false;
+        }
+
+        // Sleep until the next second, a key, or a signal
+        struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+        int ready = poll(&input, raw ? 1 : 0, tick.delayMs);
+        if (ready > 0 && (input.revents & POLLIN)) {
+            char keys[16];
+            ssize_t n = read(STDIN_FILENO, keys, sizeof(keys));
+            for (ssize_t k = 0; k < n; ++k) {
+                if (keys[k] == 'q' || keys[k] == 'Q') {
+                    g_quit = 1;
+                }
+            }
+        }
+    }
+
+    WriteAll("\x1b[0m\x1b[?25h\x1b[?1049l", &stats); // Colors, cursor and the screen as they were
+    if (raw) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    }
+
+    fprintf(stderr, "p3timec-tty: %llu frames (%llu full), %llu writes, %llu bytes, %.0f bytes and %.1f cells per frame\n",
+            stats.frames, stats.redraws, stats.writes, stats.bytes, stats.frames ? (double)stats.bytes / stats.frames : 0.0,
+            stats.frames ? (double)stats.cells / stats.frames : 0.0);
+    if (!ok) {
+        fprintf(stderr, "write failed\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,288 @@
+#include <windows.h>
+#include <tchar.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "../p3clock/clock_wall.h"     // Grid of clocks drawn by the software renderer
+#include "../p3clock/resize_coalescer.h" // One rebuild per frame during a drag-resize
+#include "../p3clock/tick_scheduler.h" // Second-aligned timer
+#include "../p3clock/visibility.h"     // Idle while minimized, covered or locked
+#include "../p3clock-win32/window_backend.h" // Tick timer, session lock, UTC clock, DebugView lines
+
+#define WINDOW_CLASS_NAME _T("P3ClockWallWindowClass")
+
+// One clock per zone ("/zone:+9,Tokyo" on the command line), all drawn into the wall's
+// framebuffer, which is the back buffer for the whole window. Lives in WinMain.
+p3clock::ClockWallRenderer* g_wall = NULL;
+p3clock::TickScheduler g_tickScheduler; // Re-arms the timer for the next second boundary (UTC)
+
+// Minimized, fully covered or session locked: no ticks and no painting until the clock can be seen again
+p3clock::VisibilityTracker g_visibility;
+
+// WM_SIZE only records the size; WM_PAINT lays out the grid for the latest one
+p3clock::ResizeCoalescer g_resize;
+
+// Update region of a WM_PAINT, kept between paints so ticks do not allocate
+std::vector<BYTE> g_regionData;
+
+// Copy one rectangle of the wall's framebuffer to the window. The rows are handed over as a
+// top-down DIB of exactly that many rows, which sidesteps the bottom-up source origin rules.
+void PresentRect(HDC hdc, const RECT* rect) {
+    const p3clock::Framebuffer& frame = g_wall->Frame();
+    RECT r = *rect;
+    if (r.right > frame.width) r.right = frame.width;
+    if (r.bottom > frame.height) r.bottom = frame.height;
+    if (r.left < 0) r.left = 0;
+    if (r.top < 0) r.top = 0;
+    if (r.right <= r.left || r.bottom <= r.top) {
+        return;
+    }
+    BITMAPINFO bmi;
+    memset(&bmi, 0, sizeof(bmi));
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = frame.width;
+    bmi.bmiHeader.biHeight = -(r.bottom - r.top); // Negative height: top-down rows
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    SetDIBitsToDevice(hdc, r.left, r.top, r.right - r.left, r.bottom - r.top, r.left, 0, 0, r.bottom - r.top,
+                      frame.Row(r.top), &bmi, DIB_RGB_COLORS);
+}
+
+// Invalidate the rectangles the last tick redrew, one per changed digit run or hand slice
+void InvalidateWallDamage(HWND hwnd, const std::vector<p3clock::DamageRect>& damage) {
+    for (size_t i = 0; i < damage.size(); ++i) {
+        RECT rect = {damage[i].left, damage[i].top, damage[i].right, damage[i].bottom};
+        InvalidateRect(hwnd, &rect, FALSE);
+    }
+}
+
+// Size of the wall and its shared face / glyph cache, for DebugView or the debugger's output window
+void ReportWallStats() {
+    const p3clock::WallGrid& grid = g_wall->Grid();
+    const p3clock::ResizeStats& resize = g_resize.Stats();
+    p3clock::DebugLine line;
+    line.Append(_T("P3 Clock wall: %d clocks, %d x %d cells of %d x %d, %lu KB shared face and glyph cache, ")
+                _T("%lu WM_SIZE, %lu layouts\n"),
+                g_wall->CellCount(), grid.columns, grid.rows, grid.cellWidth, grid.cellHeight,
+                (unsigned long)(g_wall->SharedCacheBytes() / 1024),
+                (unsigned long)resize.events, (unsigned long)resize.rebuilds);
+    line.Output();
+}
+
+// Wakeups per minute in each visibility state, for DebugView or the debugger's output window
+void ReportVisibilityStats() {
+    long long nowMs = p3clock::UtcNowMs();
+    p3clock::DebugLine line;
+    line.Append(_T("P3 Clock idle:"));
+    for (int i = 0; i < p3clock::kVisibilityStateCount; ++i) {
+        p3clock::VisibilityState state = static_cast<p3clock::VisibilityState>(i);
+        line.Append(_T(" %hs %.1f/min (%lu s)"), p3clock::kVisibilityStateNames[i],
+                    g_visibility.WakeupsPerMinute(state, nowMs),
+                    (unsigned long)(g_visibility.TimeInStateMs(state, nowMs) / 1000));
+    }
+    line.Append(_T("\n"));
+    line.Output();
+}
+
+// Stop ticking when the clock becomes hidden. When it can be seen again, paint one catch-up frame at
+// the current time right away and tick again from the next second boundary.
+void ApplyVisibility(HWND hwnd, p3clock::VisibilityAction action) {
+    if (action == p3clock::kVisibilityNoChange) {
+        return;
+    }
+    if (action == p3clock::kVisibilitySuspend) {
+        KillTimer(hwnd, p3clock::kTickTimerId);
+    } else {
+        long long nowMs = p3clock::UtcNowMs();
+        g_wall->Render(nowMs);
+        p3clock::ArmTickTimer(hwnd, g_tickScheduler.Start(nowMs));
+        InvalidateRect(hwnd, NULL, FALSE);
+    }
+    ReportVisibilityStats();
+}
+
+LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+    switch (uMsg) {
+        case WM_CREATE: {
+            g_visibility.Start(p3clock::UtcNowMs());
+            p3clock::WatchSessionLock(hwnd, TRUE);
+            // Fire the first tick right after the next wall-clock second boundary
+            p3clock::ArmTickTimer(hwnd, g_tickScheduler.Start(p3clock::UtcNowMs()));
+            break;
+        }
+
+        case WM_SIZE: {
+            int windowWidth = LOWORD(lParam);
+            int windowHeight = HIWORD(lParam);
+
+            // Minimized: stop ticking until restored (the framebuffer is kept for the restore)
+            ApplyVisibility(hwnd, g_visibility.SetMinimized(wParam == SIZE_MINIMIZED, p3clock::UtcNowMs()));
+
+            // Ensure valid window dimensions to prevent division by zero or invalid drawing
+            if (windowWidth < 1 || windowHeight < 1) {
+                break;
+            }
+
+            // Laid out once in the next WM_PAINT, however many WM_SIZE arrive before it
+            g_resize.OnSize(windowWidth, windowHeight);
+            InvalidateRect(hwnd, NULL, FALSE);
+            break;
+        }
+
+        case WM_ERASEBKGND:
+            // Every pixel comes from the wall's framebuffer, so there is nothing to erase
+            return TRUE;
+
+        case WM_TIMER: {
+            g_visibility.CountWakeup();
+            if (!g_visibility.Visible()) {
+                KillTimer(hwnd, p3clock::kTickTimerId); // A tick that was already queued when the clock was hidden
+                break;
+            }
+            // Covered by other windows: stop until a WM_PAINT shows part of it again
+            if (p3clock::IsClientAreaCovered(hwnd)) {
+                ApplyVisibility(hwnd, g_visibility.SetOccluded(true, p3clock::UtcNowMs()));
+                break;
+            }
+
+            // Re-arm for the next second boundary on every tick, which cancels any drift
+            long long nowMs = p3clock::UtcNowMs();
+            p3clock::Tick tick = g_tickScheduler.OnTick(nowMs);
+            p3clock::ArmTickTimer(hwnd, tick.delayMs);
+            if (!tick.present) {
+                break; // Woke up just before the boundary: the second has not changed yet
+            }
+
+            // Every clock redraws what changed in its own cell; only those rectangles are invalidated
+            InvalidateWallDamage(hwnd, g_wall->Tick(nowMs));
+            break;
+        }
+
+        case WM_PAINT: {
+            // Part of the window was uncovered: tick again, starting with this paint
+            ApplyVisibility(hwnd, g_visibility.SetOccluded(false, p3clock::UtcNowMs()));
+
+            // New grid and cell size for the latest WM_SIZE: the shared glyph atlas is rebuilt
+            // for it, then every cell drawn once
+            int newWidth, newHeight;
+            if (g_resize.TakePending(&newWidth, &newHeight)) {
+                g_wall->Resize(newWidth, newHeight);
+                g_wall->Render(p3clock::UtcNowMs());
+            }
+
+            // The update region after a tick is a little of every cell, and its bounding box is
+            // nearly the whole window, so copy its rectangles one by one instead of ps.rcPaint
+            HRGN update = CreateRectRgn(0, 0, 0, 0);
+            int kind = update ? GetUpdateRgn(hwnd, update, FALSE) : ERROR;
+            DWORD size = kind == COMPLEXREGION ? GetRegionData(update, 0, NULL) : 0;
+            if (size > g_regionData.size()) {
+                g_regionData.resize(size);
+            }
+            RGNDATA* region = NULL;
+            if (size && GetRegionData(update, size, (RGNDATA*)&g_regionData[0])) {
+                region = (RGNDATA*)&g_regionData[0];
+            }
+            if (update) {
+                DeleteObject(update);
+            }
+
+            PAINTSTRUCT ps;
+            HDC hdc = BeginPaint(hwnd, &ps);
+            if (region) {
+                const RECT* rects = (const RECT*)region->Buffer;
+                for (DWORD i = 0; i < region->rdh.nCount; ++i) {
+                    PresentRect(hdc, &rects[i]);
+                }
+            } else {
+                PresentRect(hdc, &ps.rcPaint);
+            }
+            EndPaint(hwnd, &ps);
+            break;
+        }
+
+        case WM_WTSSESSION_CHANGE: {
+            // Nobody can see the clock while the session is locked
+            if (wParam == WTS_SESSION_LOCK || wParam == WTS_SESSION_UNLOCK) {
+                ApplyVisibility(hwnd, g_visibility.SetLocked(wParam == WTS_SESSION_LOCK, p3clock::UtcNowMs()));
+            }
+            break;
+        }
+
+        case WM_DESTROY: {
+            KillTimer(hwnd, p3clock::kTickTimerId); // Stop timer
+            // Stop the session notifications
+            p3clock::WatchSessionLock(hwnd, FALSE);
+            ReportVisibilityStats();
+            ReportWallStats();
+            PostQuitMessage(0); // Post quit message
+            break;
+        }
+
+        default:
+            // Handle all other messages
+            return DefWindowProc(hwnd, uMsg, wParam, lParam);
+    }
+    return 0;
+}
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    // Register window class
+    WNDCLASSEX wc;
+    memset(&wc, 0, sizeof(WNDCLASSEX));
+    wc.cbSize        = sizeof(WNDCLASSEX);
+    wc.lpfnWndProc   = WindowProc;
+    wc.hInstance     = hInstance;
+    wc.hIcon         = LoadIcon(NULL, IDI_APPLICATION); // Load a standard application icon
+    wc.hIconSm       = LoadIcon(NULL, IDI_APPLICATION); // Use the same standard icon for small icon
+    wc.hCursor       = LoadCursor(NULL, IDC_ARROW);
+    wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1); // Window background brush (recommended even with WM_ERASEBKGND)
+    wc.lpszClassName = WINDOW_CLASS_NAME;
+
+    if (!RegisterClassEx(&wc)) {
+        MessageBox(NULL, _T("Window registration failed!"), _T("Error"), MB_ICONERROR | MB_OK);
+        return 0;
+    }
+
+    p3clock::ClockLayout layout;
+    std::vector<p3clock::WallZone> zones;
+    p3clock::ParseWallOptions(lpCmdLine, &layout, &zones);
+    p3clock::ClockWallRenderer wall(layout);
+    wall.SetZones(zones);
+    g_wall = &wall;
+
+    // Create window
+    HWND hwnd = CreateWindowEx(
+        0,                  // Extended window style
+        WINDOW_CLASS_NAME,  // Window class name
+        _T("P3 Clock Wall"),// Window title
+        WS_OVERLAPPEDWINDOW,// Window style: overlapped window (standard resizable window)
+        CW_USEDEFAULT,      // Initial X position (system default)
+        CW_USEDEFAULT,      // Initial Y position (system default)
+        1600,               // Initial width (two columns of moni-1 sized cells)
+        900,                // Initial height
+        NULL,               // Parent window handle
+        NULL,               // Menu handle
+        hInstance,          // Application instance handle
+        NULL                // Creation parameters
+    );
+
+    if (!hwnd) {
+        MessageBox(NULL, _T("Window creation failed!"), _T("Error"), MB_ICONERROR | MB_OK);
+        return 0;
+    }
+
+    // Show and update window
+    ShowWindow(hwnd, nCmdShow);
+    UpdateWindow(hwnd);
+
+    // Message loop
+    MSG msg;
+    while (GetMessage(&msg, NULL, 0, 0)) {
+        TranslateMessage(&msg); // Translate virtual-key messages
+        DispatchMessage(&msg);  // Dispatch message to window procedure
+    }
+
+    return (int)msg.wParam;
+}
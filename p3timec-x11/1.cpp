@@ -0,0 +1,319 @@
+// X11 P3 clock: the layouts of the Win32 programs in a native X window on
+// Linux and other X11 systems, drawn by the same ClockCore and PixelPainter
+// as the DIB build (p3clock-x11/x11_backend.h) and presented from a
+// MIT-SHM XImage, or with XPutImage where shared memory is not available
+// (a remote display). Builds with e.g.
+//     g++ -O2 -o p3timec-x11 p3timec-x11/1.cpp -lXext -lX11
+//
+// "p3timec-x11 bench" times presenting full frames at 1080p and 4K with and
+// without MIT-SHM. Both run under Xvfb, e.g.
+//     xvfb-run -s "-screen 0 3840x2160x24" ./p3timec-x11 bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "../p3clock-x11/clock_window.h" // Event loop and X11 backend of ClockCore
+#include "../p3clock/bench_stats.h"      // Frame time summaries, JSON output
+#include "../p3clock/soft_clock.h"       // Frames for the present benchmark
+
+using namespace p3clock;
+
+static void PrintUsage(FILE* out) {
+    fprintf(out,
+        "usage: p3timec-x11 [options]\n"
+        "       p3timec-x11 bench [options]\n"
+        "\n"
+        "Shows the clock in an X window. H toggles the paint HUD, T writes the\n"
+        "paint trace (with -DP3CLOCK_PAINT_TRACE=1), q or Esc quits\n"
+        "  --layout NAME   digital (p3timec), moni (p3timec-32-moni) or moni-only\n"
+        "                  (p3timec-32-moni-only). Default: moni\n"
+        "  --size WxH      initial window size. Default: 800x400, 400x400 for\n"
+        "                  moni-only\n"
+        "  --sweep[=HZ]    analog layouts: move the second hand continuously at HZ\n"
+        "                  frames per second (60 to 240). Default: 60\n"
+        "  --hud           show the paint HUD from the start\n"
+        "  --no-shm        present with XPutImage even when MIT-SHM is available\n"
+        "  --seconds N     quit after N seconds. Default: run until closed\n"
+        "\n"
+        "bench: open a window per size and time presenting full frames, from the\n"
+        "request until the server has copied the pixels (XSync), with MIT-SHM and\n"
+        "with XPutImage. The X screen has to be at least as large as the frames\n"
+        "  --size WxH      frame size (repeatable). Default: 1920x1080 and 3840x2160\n"
+        "  --frames N      frames presented per case. Default: 120\n"
+        "  --no-shm        only XPutImage\n"
+        "  -o PATH         JSON output, '-' for stdout. Default: -\n");
+}
+
+static bool ParseSize(const char* text, int* width, int* height) {
+    return sscanf(text, "%dx%d", width, height) == 2 && *width > 0 && *height > 0 && *width <= 16384 &&
+           *height <= 16384;
+}
+
+static double NowMs() {
+    PosixClock clock;
+    return clock.NowMs();
+}
+
+struct PresentBenchResult {
+    int width;
+    int height;
+    bool shared;
+    FrameTimeSummary present;
+    double megapixelsPerSec;
+};
+
+// Present `frames` full frames of a window at the surface's size, each a new second of the clock
+static PresentBenchResult RunPresentCase(Display* display, Window window, GC gc, X11Surface* surface,
+                                         int completionType, int frames) {
+    PresentBenchResult r;
+    r.width = surface->width;
+    r.height = surface->height;
+    r.shared = surface->shared;
+    SoftClockRenderer renderer(kLayoutAnalogDigital);
+    renderer.Resize(surface->width, surface->height);
+    PixelView image = MakePixelView(surface->bits, surface->width, surface->height, surface->stride);
+    DamageRect all = {0, 0, surface->width, surface->height};
+    std::vector<double> samples;
+    samples.reserve(frames);
+    ClockTime t = {10, 8, 0};
+    for (int i = -2; i < frames; ++i) { // Two frames to warm up
+        t.second = (i + 2) % 60;
+        renderer.Render(t);
+        WaitX11Surface(display, completionType, surface);
+        Blit(image, 0, 0, ViewOf(renderer.Frame()), 0, 0, surface->width, surface->height);
+        double start = NowMs();
+        PutX11Surface(display, window, gc, surface, all);
+        XSync(display, False);
+        double ms = NowMs() - start;
+        if (i >= 0) {
+            samples.push_back(ms);
+        }
+    }
+    WaitX11Surface(display, completionType, surface);
+    r.present = SummarizeFrameTimes(samples);
+    r.megapixelsPerSec = r.present.meanMs > 0.0 ? r.width * (double)r.height / r.present.meanMs / 1000.0 : 0.0;
+    return r;
+}
+
+struct BenchSize {
+    int width;
+    int height;
+};
+
+static int RunBench(int argc, char** argv) {
+    std::vector<BenchSize> sizes;
+    int frames = 120;
+    bool shm = true;
+    const char* output = "-";
+    for (int i = 0; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            PrintUsage(stdout);
+            return 0;
+        }
+        if (strcmp(arg, "--no-shm") == 0) {
+            shm = false;
+            continue;
+        }
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) {
+            fprintf(stderr, "p3timec-x11: %s needs a value\n", arg);
+            return 2;
+        }
+        bool ok = false;
+        if (strcmp(arg, "--size") == 0) {
+            BenchSize size;
+            ok = ParseSize(value, &size.width, &size.height);
+            if (ok) {
+                sizes.push_back(size);
+            }
+        } else if (strcmp(arg, "--frames") == 0) {
+            frames = atoi(value);
+            ok = frames > 0;
+        } else if (strcmp(arg, "-o") == 0) {
+            output = value;
+            ok = true;
+        } else {
+            fprintf(stderr, "p3timec-x11: unknown option %s\n", arg);
+            PrintUsage(stderr);
+            return 2;
+        }
+        if (!ok) {
+            fprintf(stderr, "p3timec-x11: bad value for %s: %s\n", arg, value);
+            return 2;
+        }
+        ++i;
+    }
+    if (sizes.empty()) {
+        BenchSize defaults[] = {{1920, 1080}, {3840, 2160}};
+        sizes.assign(defaults, defaults + 2);
+    }
+
+    Display* display = XOpenDisplay(NULL);
+    if (!display) {
+        fprintf(stderr, "p3timec-x11: cannot open display %s\n", XDisplayName(NULL));
+        return 1;
+    }
+    bool hasShm = XShmQueryExtension(display) != False;
+    int completionType = hasShm ? XShmGetEventBase(display) + ShmCompletion : -1;
+    int screen = DefaultScreen(display);
+    fprintf(stderr, "display %s, screen %dx%d, MIT-SHM %s\n", XDisplayString(display), DisplayWidth(display, screen),
+            DisplayHeight(display, screen), hasShm ? "available" : "not available");
+
+    std::vector<PresentBenchResult> results;
+    bool failed = false;
+    for (size_t s = 0; s < sizes.size() && !failed; ++s) {
+        XVisualInfo visual;
+        Window window = CreateArgbWindow(display, "P3 Clock bench", sizes[s].width, sizes[s].height, &visual);
+        if (!window) {
+            fprintf(stderr, "p3timec-x11: no 24-bit TrueColor visual with 32-bit pixels\n");
+            failed = true;
+            break;
+        }
+        XMapWindow(display, window);
+        XEvent event;
+        XWindowEvent(display, window, ExposureMask, &event); // Mapped and viewable
+        GC gc = XCreateGC(display, window, 0, NULL);
+        for (int mode = 0; mode < 2; ++mode) {
+            bool shared = mode == 0;
+            if (shared && !(shm && hasShm)) {
+                continue;
+            }
+            X11Surface surface = NoX11Surface();
+            if (!ResizeX11Surface(display, visual.visual, visual.depth, &surface, sizes[s].width, sizes[s].height,
+                                  shared)) {
+                fprintf(stderr, "p3timec-x11: no memory for a %dx%d image\n", sizes[s].width, sizes[s].height);
+                failed = true;
+                break;
+            }
+            if (shared && !surface.shared) {
+                fprintf(stderr, "%4dx%-4d MIT-SHM   segment refused, skipped\n", sizes[s].width, sizes[s].height);
+                FreeX11Surface(display, &surface);
+                continue;
+            }
+            PresentBenchResult r = RunPresentCase(display, window, gc, &surface, completionType, frames);
+            FreeX11Surface(display, &surface);
+            fprintf(stderr, "%4dx%-4d %-9s present %7.3f ms (p50 %7.3f, p99 %7.3f, max %7.3f) %8.1f Mpx/s\n",
+                    r.width, r.height, r.shared ? "MIT-SHM" : "XPutImage", r.present.meanMs, r.present.p50Ms,
+                    r.present.p99Ms, r.present.maxMs, r.megapixelsPerSec);
+            results.push_back(r);
+        }
+        XFreeGC(display, gc);
+        XDestroyWindow(display, window);
+    }
+    XCloseDisplay(display);
+    if (failed) {
+        return 1;
+    }
+
+    bool toStdout = strcmp(output, "-") == 0;
+    FILE* out = toStdout ? stdout : fopen(output, "w");
+    if (!out) {
+        fprintf(stderr, "p3timec-x11: cannot open %s\n", output);
+        return 1;
+    }
+    JsonWriter json(out);
+    json.BeginObject();
+    json.Field("benchmark", "x11-present");
+    json.Field("frames", frames);
+    json.Field("mit_shm", hasShm);
+    json.Key("results");
+    json.BeginArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const PresentBenchResult& r = results[i];
+        json.BeginObject();
+        json.Field("width", r.width);
+        json.Field("height", r.height);
+        json.Field("path", r.shared ? "mit-shm" : "xputimage");
+        json.Field("mean_ms", r.present.meanMs);
+        json.Field("p50_ms", r.present.p50Ms);
+        json.Field("p99_ms", r.present.p99Ms);
+        json.Field("max_ms", r.present.maxMs);
+        json.Field("megapixels_per_sec", r.megapixelsPerSec);
+        json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+    json.Finish();
+    bool written = toStdout ? fflush(out) == 0 : fclose(out) == 0;
+    if (!written) {
+        fprintf(stderr, "p3timec-x11: write failed\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        return RunBench(argc - 2, argv + 2);
+    }
+
+    ClockLayout layout = kLayoutAnalogDigital;
+    X11WindowOptions options;
+    options.title = "P3 Clock";
+    options.width = 0;
+    options.height = 0;
+    options.sweepHz = 0;
+    options.hud = false;
+    options.shm = true;
+    options.seconds = 0;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            PrintUsage(stdout);
+            return 0;
+        }
+        if (strncmp(arg, "--sweep", 7) == 0 && (arg[7] == '\0' || arg[7] == '=')) {
+            options.sweepHz = ParseSweepOption(arg);
+            continue;
+        }
+        if (strcmp(arg, "--hud") == 0) {
+            options.hud = true;
+            continue;
+        }
+        if (strcmp(arg, "--no-shm") == 0) {
+            options.shm = false;
+            continue;
+        }
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--layout") != 0 && strcmp(arg, "--size") != 0 && strcmp(arg, "--seconds") != 0) {
+            fprintf(stderr, "p3timec-x11: unknown option %s\n", arg);
+            PrintUsage(stderr);
+            return 2;
+        }
+        if (!value) {
+            fprintf(stderr, "p3timec-x11: %s needs a value\n", arg);
+            return 2;
+        }
+        bool ok;
+        if (strcmp(arg, "--layout") == 0) {
+            ok = ParseClockLayout(value, &layout);
+        } else if (strcmp(arg, "--size") == 0) {
+            ok = ParseSize(value, &options.width, &options.height);
+        } else {
+            options.seconds = atoi(value);
+            ok = options.seconds > 0;
+        }
+        if (!ok) {
+            fprintf(stderr, "p3timec-x11: bad value for %s: %s\n", arg, value);
+            return 2;
+        }
+        ++i;
+    }
+    if (!options.width) {
+        options.width = layout == kLayoutAnalog ? 400 : 800; // One clock, or two side by side
+        options.height = 400;
+    }
+
+    // Every layout is double buffered: the image is the back buffer, as in the DIB build
+    switch (layout) {
+        case kLayoutDigital:
+            return X11ClockWindow<DigitalLayoutPolicy, BufferedPresentation>::Run(options);
+        case kLayoutAnalog:
+            return X11ClockWindow<AnalogLayoutPolicy, BufferedPresentation>::Run(options);
+        default:
+            return X11ClockWindow<AnalogDigitalLayoutPolicy, BufferedPresentation>::Run(options);
+    }
+}
@@ -0,0 +1,50 @@
+#!/bin/sh
+# Runs p3timec-x11 for a few seconds under Xvfb, once presenting with MIT-SHM
+# and once with --no-shm (XPutImage), every layout, and fails if a run does not
+# exit cleanly. Skips with exit 0 where Xvfb is not installed. From the top of
+# the tree:
+#     sh p3timec-x11/xvfb_smoke.sh [SECONDS]
+
+seconds=${1:-5}
+if ! command -v Xvfb >/dev/null 2>&1; then
+    echo "xvfb_smoke: skipped, no Xvfb"
+    exit 0
+fi
+
+out=${TMPDIR:-/tmp}/p3timec-x11-smoke.$$
+mkdir -p "$out" || exit 1
+g++ -O2 -o "$out/p3timec-x11" p3timec-x11/1.cpp -lXext -lX11 || exit 1
+
+# The first free display from :99 up
+display=99
+while [ -e "/tmp/.X11-unix/X$display" ] || [ -e "/tmp/.X$display-lock" ]; do
+    display=$((display + 1))
+done
+Xvfb ":$display" -screen 0 1280x720x24 -nolisten tcp >"$out/xvfb.log" 2>&1 &
+xvfb=$!
+trap 'kill $xvfb 2>/dev/null; rm -rf "$out"' EXIT INT TERM
+tries=0
+while [ ! -e "/tmp/.X11-unix/X$display" ]; do
+    tries=$((tries + 1))
+    if [ $tries -gt 50 ] || ! kill -0 $xvfb 2>/dev/null; then
+        echo "xvfb_smoke: Xvfb :$display did not start"
+        cat "$out/xvfb.log"
+        exit 1
+    fi
+    sleep 0.1
+done
+
+failed=0
+for layout in digital moni moni-only; do
+    for present in "" --no-shm; do
+        DISPLAY=":$display" timeout $((seconds + 10)) "$out/p3timec-x11" --layout $layout --seconds "$seconds" $present
+        status=$?
+        if [ $status -eq 0 ]; then
+            echo "ok    $layout ${present:-shm}"
+        else
+            echo "FAIL  $layout ${present:-shm} (exit $status)"
+            failed=1
+        fi
+    done
+done
+exit $failed